@@ -0,0 +1,137 @@
+//! Throughput of proof verification with blake2 and keccak, for bundles of 1, 100 and 10k leaves.
+//!
+//! Run with `cargo bench -p proofs`. Each case is repeated for at least `MIN_TIME` and reported
+//! as the mean time per run and the leaves verified per second.
+
+use std::{
+	hint::black_box,
+	time::{Duration, Instant},
+};
+
+use proofs::{hashing::sort_hash_of, Hasher, MultiProof, Proof, Verifier};
+use sp_core::{blake2_256, keccak_256, H256};
+
+struct Blake2Verifier;
+
+impl Hasher for Blake2Verifier {
+	type Hash = H256;
+
+	fn hash(data: &[u8]) -> Self::Hash {
+		blake2_256(data).into()
+	}
+}
+
+impl Verifier for Blake2Verifier {
+	fn hash_of(a: Self::Hash, b: Self::Hash) -> Self::Hash {
+		sort_hash_of::<Self>(a, b)
+	}
+
+	fn initial_matches(&self, doc_root: Self::Hash) -> Option<Vec<Self::Hash>> {
+		Some(vec![doc_root])
+	}
+}
+
+struct KeccakVerifier;
+
+impl Hasher for KeccakVerifier {
+	type Hash = H256;
+
+	fn hash(data: &[u8]) -> Self::Hash {
+		keccak_256(data).into()
+	}
+}
+
+impl Verifier for KeccakVerifier {
+	fn hash_of(a: Self::Hash, b: Self::Hash) -> Self::Hash {
+		sort_hash_of::<Self>(a, b)
+	}
+
+	fn initial_matches(&self, doc_root: Self::Hash) -> Option<Vec<Self::Hash>> {
+		Some(vec![doc_root])
+	}
+}
+
+const LEAVES: [usize; 3] = [1, 100, 10_000];
+
+/// Root and single proofs of `leaves`, odd nodes being promoted to the next level.
+fn single_proofs<V: Verifier<Hash = H256>>(leaves: &[H256]) -> (H256, Vec<Proof<H256>>) {
+	let mut proofs: Vec<Proof<H256>> = leaves.iter().map(|leaf| Proof::new(*leaf, vec![])).collect();
+	let mut positions: Vec<usize> = (0..leaves.len()).collect();
+	let mut level = leaves.to_vec();
+	while level.len() > 1 {
+		for (proof, position) in proofs.iter_mut().zip(positions.iter_mut()) {
+			if let Some(sibling) = level.get(*position ^ 1) {
+				proof.sorted_hashes.push(*sibling);
+			}
+			*position /= 2;
+		}
+		level = level
+			.chunks(2)
+			.map(|pair| match pair {
+				[a, b] => V::hash_of(*a, *b),
+				[a] => *a,
+				_ => unreachable!(),
+			})
+			.collect();
+	}
+	(level[0], proofs)
+}
+
+/// Root and multiproof of all the `leaves`, nodes being paired in order of computation.
+fn multiproof<V: Verifier<Hash = H256>>(leaves: &[H256]) -> (H256, MultiProof<H256>) {
+	let mut nodes = leaves.to_vec();
+	let mut next = 0;
+	while nodes.len() - next > 1 {
+		let node = V::hash_of(nodes[next], nodes[next + 1]);
+		nodes.push(node);
+		next += 2;
+	}
+	let flags = vec![true; leaves.len() - 1];
+	(nodes[nodes.len() - 1], MultiProof::new(leaves.to_vec(), vec![], flags))
+}
+
+/// Shortest time each case is repeated for.
+const MIN_TIME: Duration = Duration::from_secs(1);
+
+/// Repeat `run` for at least `MIN_TIME` and print its mean time and leaf throughput.
+fn bench(group: &str, case: &str, leaves: usize, mut run: impl FnMut() -> bool) {
+	assert!(run(), "{}/{}/{} does not verify", group, case, leaves);
+	let start = Instant::now();
+	let mut iters = 0u32;
+	while start.elapsed() < MIN_TIME {
+		black_box(run());
+		iters += 1;
+	}
+	let per_iter = start.elapsed() / iters;
+	println!(
+		"{:<32} {:>12.3?}/iter {:>12.0} leaves/s",
+		format!("{}/{}/{}", group, case, leaves),
+		per_iter,
+		leaves as f64 / per_iter.as_secs_f64(),
+	);
+}
+
+fn bench_verifier<V: Verifier<Hash = H256>>(name: &str, verifier: V) {
+	for n in LEAVES {
+		let leaves: Vec<H256> = (0..n as u32).map(|i| V::hash(&i.to_le_bytes())).collect();
+
+		let (root, proofs) = single_proofs::<V>(&leaves);
+		bench(name, "verify_proof", n, || {
+			proofs.iter().all(|proof| verifier.verify_proof(root, black_box(proof)))
+		});
+		bench(name, "verify_proofs", n, || verifier.verify_proofs(root, black_box(&proofs)));
+		bench(name, "verify_proof_slice", n, || {
+			proofs.iter().all(|proof| {
+				verifier.verify_proof_slice(root, proof.leaf_hash, black_box(&proof.sorted_hashes))
+			})
+		});
+
+		let (root, proof) = multiproof::<V>(&leaves);
+		bench(name, "verify_multiproof", n, || verifier.verify_multiproof(root, black_box(&proof)));
+	}
+}
+
+fn main() {
+	bench_verifier("blake2", Blake2Verifier);
+	bench_verifier("keccak", KeccakVerifier);
+}
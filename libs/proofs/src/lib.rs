@@ -37,6 +37,32 @@ impl<Hash> Proof<Hash> {
 	}
 }
 
+/// Proof of several leaves at once, each interior node being computed only once.
+///
+/// Interior nodes are computed in order, bottom-up, from two of the leaves, the previously
+/// computed nodes and the proof hashes, the last computed node being the root.
+#[derive(Encode, Decode, Default, Clone, PartialEq, TypeInfo)]
+#[cfg_attr(feature = "std", derive(Debug))]
+pub struct MultiProof<Hash> {
+	/// Leaves being proven, in the order they are consumed.
+	pub leaves: Vec<Hash>,
+	/// Sibling hashes that cannot be computed from the leaves.
+	pub proof_hashes: Vec<Hash>,
+	/// For each interior node, `true` if its second child is the next leaf or computed node,
+	/// `false` if it is the next proof hash.
+	pub flags: Vec<bool>,
+}
+
+impl<Hash> MultiProof<Hash> {
+	pub fn new(leaves: Vec<Hash>, proof_hashes: Vec<Hash>, flags: Vec<bool>) -> Self {
+		Self {
+			leaves,
+			proof_hashes,
+			flags,
+		}
+	}
+}
+
 pub trait Hasher: Sized {
 	/// Hash type we deal with
 	type Hash: Default + AsRef<[u8]> + Copy + PartialEq + PartialOrd + Debug;
@@ -79,6 +105,27 @@ pub trait Verifier: Hasher {
 
 		inner::verify_proof::<Self>(&mut matches, proof)
 	}
+
+	/// Verifies that `sorted_hashes` lead from `leaf_hash` to `doc_root`, without allocating.
+	///
+	/// Unlike [Verifier::verify_proof], the proof must go all the way to `doc_root`: neither
+	/// `initial_matches` nor previously verified proofs are used.
+	fn verify_proof_slice(
+		&self,
+		doc_root: Self::Hash,
+		leaf_hash: Self::Hash,
+		sorted_hashes: &[Self::Hash],
+	) -> bool {
+		sorted_hashes
+			.iter()
+			.fold(leaf_hash, |hash, sibling| Self::hash_of(hash, *sibling))
+			== doc_root
+	}
+
+	/// Verifies all the leaves of a [MultiProof] against `doc_root`.
+	fn verify_multiproof(&self, doc_root: Self::Hash, proof: &MultiProof<Self::Hash>) -> bool {
+		inner::verify_multiproof::<Self>(doc_root, proof)
+	}
 }
 mod inner {
 	use super::*;
@@ -99,15 +146,15 @@ mod inner {
 		let Proof {
 			leaf_hash,
 			sorted_hashes,
-		} = proof.clone();
+		} = proof;
 
 		// if leaf_hash is already cached/computed earlier
-		if matches.contains(&leaf_hash) {
+		if matches.contains(leaf_hash) {
 			return true;
 		}
 
-		let mut hash = leaf_hash;
-		for proof in sorted_hashes {
+		let mut hash = *leaf_hash;
+		for &proof in sorted_hashes {
 			matches.push(proof);
 			hash = V::hash_of(hash, proof);
 			if matches.contains(&hash) {
@@ -118,12 +165,65 @@ mod inner {
 
 		false
 	}
+
+	/// Multiproof checker. Every interior node is hashed exactly once, into a single buffer sized
+	/// upfront, and consumed in the order it was computed.
+	pub fn verify_multiproof<V: Verifier>(root: V::Hash, proof: &MultiProof<V::Hash>) -> bool {
+		let MultiProof {
+			leaves,
+			proof_hashes,
+			flags,
+		} = proof;
+
+		// Each interior node consumes two hashes and produces one, only the root is left
+		if leaves.len() + proof_hashes.len() != flags.len() + 1 {
+			return false;
+		}
+
+		let mut nodes = Vec::with_capacity(flags.len());
+		let (mut leaf_pos, mut node_pos, mut proof_pos) = (0, 0, 0);
+		let mut next = |nodes: &Vec<V::Hash>| -> Option<V::Hash> {
+			if leaf_pos < leaves.len() {
+				leaf_pos += 1;
+				leaves.get(leaf_pos - 1).copied()
+			} else {
+				node_pos += 1;
+				nodes.get(node_pos - 1).copied()
+			}
+		};
+
+		for &flag in flags {
+			let a = match next(&nodes) {
+				Some(a) => a,
+				None => return false,
+			};
+			let b = if flag {
+				next(&nodes)
+			} else {
+				proof_pos += 1;
+				proof_hashes.get(proof_pos - 1).copied()
+			};
+			match b {
+				Some(b) => nodes.push(V::hash_of(a, b)),
+				None => return false,
+			}
+		}
+
+		match nodes.last() {
+			Some(computed) => proof_pos == proof_hashes.len() && *computed == root,
+			None => leaves.first().or_else(|| proof_hashes.first()) == Some(&root),
+		}
+	}
 }
 
 pub mod hashing {
 	use crate::{DepositAddress, Hasher, Proof};
 	use sp_std::vec::Vec;
 
+	/// Widest hash concatenated on the stack by [hash_of], wider hashes are concatenated on the
+	/// heap.
+	pub const MAX_STACK_HASH_WIDTH: usize = 64;
+
 	/// computes sorted hash of the a and b
 	/// if a < b: hash(a+b)
 	/// else: hash(b+a)
@@ -137,8 +237,16 @@ pub mod hashing {
 
 	/// computes hash of the a + b
 	pub fn hash_of<H: Hasher>(a: H::Hash, b: H::Hash) -> H::Hash {
-		let data = [a.as_ref(), b.as_ref()].concat();
-		H::hash(&data)
+		let (a, b) = (a.as_ref(), b.as_ref());
+		let len = a.len() + b.len();
+		if len > 2 * MAX_STACK_HASH_WIDTH {
+			return H::hash(&[a, b].concat());
+		}
+
+		let mut data = [0u8; 2 * MAX_STACK_HASH_WIDTH];
+		data[..a.len()].copy_from_slice(a);
+		data[a.len()..len].copy_from_slice(b);
+		H::hash(&data[..len])
 	}
 
 	/// Return a bundled hash from a list of hashes.
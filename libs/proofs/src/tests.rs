@@ -3,7 +3,7 @@ mod tests {
 		hashing::bundled_hash,
 		mock::{get_invalid_proof, get_valid_proof, BundleHasher, ProofVerifier},
 	};
-	use crate::{Proof, Verifier};
+	use crate::{Hasher, MultiProof, Proof, Verifier};
 
 	use sp_core::H256;
 
@@ -105,4 +105,43 @@ mod tests {
 		let pv = ProofVerifier;
 		assert!(!pv.verify_proofs(doc_root, &proofs));
 	}
+
+	fn four_leaves_tree() -> (Vec<H256>, H256, H256, H256) {
+		let leaves: Vec<H256> = (0u8..4).map(|i| ProofVerifier::hash(&[i])).collect();
+		let h01 = ProofVerifier::hash_of(leaves[0], leaves[1]);
+		let h23 = ProofVerifier::hash_of(leaves[2], leaves[3]);
+		let root = ProofVerifier::hash_of(h01, h23);
+		(leaves, h01, h23, root)
+	}
+
+	#[test]
+	fn validate_proof_slice() {
+		let (leaves, h01, _, root) = four_leaves_tree();
+		let pv = ProofVerifier;
+		assert!(pv.verify_proof_slice(root, leaves[2], &[leaves[3], h01]));
+		assert!(!pv.verify_proof_slice(root, leaves[2], &[leaves[3]]));
+		assert!(!pv.verify_proof_slice(root, leaves[1], &[leaves[3], h01]));
+	}
+
+	#[test]
+	fn validate_multiproof_success() {
+		let (leaves, _, h23, root) = four_leaves_tree();
+		let pv = ProofVerifier;
+		let proof = MultiProof::new(vec![leaves[0], leaves[1]], vec![h23], vec![true, false]);
+		assert!(pv.verify_multiproof(root, &proof));
+		let proof = MultiProof::new(leaves, vec![], vec![true, true, true]);
+		assert!(pv.verify_multiproof(root, &proof));
+	}
+
+	#[test]
+	fn validate_multiproof_failed() {
+		let (leaves, _, h23, root) = four_leaves_tree();
+		let pv = ProofVerifier;
+		let wrong_leaf = MultiProof::new(vec![leaves[0], leaves[2]], vec![h23], vec![true, false]);
+		assert!(!pv.verify_multiproof(root, &wrong_leaf));
+		let wrong_flags = MultiProof::new(vec![leaves[0], leaves[1]], vec![h23], vec![true, true]);
+		assert!(!pv.verify_multiproof(root, &wrong_flags));
+		let unused_hash = MultiProof::new(vec![leaves[0], leaves[1]], vec![h23, h23], vec![true]);
+		assert!(!pv.verify_multiproof(root, &unused_hash));
+	}
 }
@@ -142,6 +142,50 @@ pub struct RunCmd {
     /// Id of the parachain this collator collates for.
 	#[clap(long)]
 	pub parachain_id: Option<u32>,
+
+	#[allow(missing_docs)]
+	#[clap(flatten)]
+	pub executor: ExecutorParams,
+}
+
+/// Parameters of the runtime executor and of the native fetcher.
+#[derive(Debug, Clone, clap::Args)]
+pub struct ExecutorParams {
+	/// Run the native fetcher of the oracle feeds on a dedicated pool of this many threads,
+	/// rather than on the threads importing blocks. The offchain workers themselves already run
+	/// on the thread pool of `sc-offchain`.
+	#[clap(long)]
+	pub native_fetcher_threads: Option<usize>,
+
+	/// Size the pool of runtime instances from the available parallelism, twice the threads
+	/// within 8 to 32, rather than the Substrate default. Ignored if `--max-runtime-instances`
+	/// is given.
+	#[clap(long)]
+	pub auto_runtime_instances: bool,
+}
+
+impl ExecutorParams {
+	/// Size the pool of runtime instances of `config` for the block import, block authoring,
+	/// offchain workers and RPC calls running in parallel, if `--auto-runtime-instances` is set
+	/// and `--max-runtime-instances` is not set in `run`.
+	pub fn tune(&self, config: &mut sc_service::Configuration, run: &sc_cli::RunCmd) {
+		if self.auto_runtime_instances && run.max_runtime_instances.is_none() {
+			config.max_runtime_instances = default_runtime_instances();
+		}
+		log::info!(
+			"Runtime executor: {:?}, {} instances, {} compiled runtimes cached",
+			config.wasm_method,
+			config.max_runtime_instances,
+			config.runtime_cache_size,
+		);
+	}
+}
+
+/// Twice the available parallelism, within the default of Substrate and the size the pooling
+/// instantiation strategy is efficient at.
+fn default_runtime_instances() -> usize {
+	let parallelism = std::thread::available_parallelism().map_or(1, |threads| threads.get());
+	parallelism.saturating_mul(2).clamp(8, 32)
 }
 
 impl std::ops::Deref for RunCmd {
@@ -337,7 +337,9 @@ pub fn run() -> Result<()> {
 			let runner = cli.create_runner(&cli.run.normalize())?;
 			let collator_options = cli.run.collator_options();
 
-			runner.run_node_until_exit(|config| async move {
+			runner.run_node_until_exit(|mut config| async move {
+				cli.run.executor.tune(&mut config, &cli.run.base.base);
+				let native_fetcher_threads = cli.run.executor.native_fetcher_threads;
 				let hwbench = if !cli.no_hardware_benchmarks {
 					config.database.path().map(|database_path| {
 						let _ = std::fs::create_dir_all(&database_path);
@@ -392,6 +394,7 @@ pub fn run() -> Result<()> {
 						collator_options,
 						id,
 						hwbench,
+						native_fetcher_threads,
 					)
 					.await
 					.map(|r| r.0)
@@ -402,6 +405,7 @@ pub fn run() -> Result<()> {
 						collator_options,
 						id,
 						hwbench,
+						native_fetcher_threads,
 					)
 					.await
 					.map(|r| r.0)
@@ -412,6 +416,7 @@ pub fn run() -> Result<()> {
 						collator_options,
 						id,
 						hwbench,
+						native_fetcher_threads,
 					)
 					.await
 					.map(|r| r.0)
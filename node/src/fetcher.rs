@@ -0,0 +1,136 @@
+//! Native fetcher of the HTTP endpoints requested by the offchain workers.
+//!
+//! The oracle and reporter offchain workers hand their fetches over to this task through the
+//! offchain local storage, see [`kylin_support::native_fetch`]. Endpoints are fetched with a
+//! single pooled hyper client, as the offchain workers' own HTTP API is, connections being kept
+//! alive across runs, and their JSON responses are parsed natively.
+
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use codec::{Decode, Encode};
+use futures::future;
+use hyper::{body::HttpBody, client::HttpConnector, StatusCode, Uri};
+use hyper_rustls::HttpsConnector;
+use kylin_support::{
+	json::extract_numbers,
+	native_fetch::{
+		requests_key, result_key, to_fixed, FetchRequests, FetchResult, ALIVE_KEY, NAMESPACES,
+	},
+};
+use sp_core::offchain::{OffchainStorage, STORAGE_PREFIX};
+
+/// How often the requests are looked up.
+const POLL_INTERVAL: Duration = Duration::from_millis(500);
+/// Deadline of a single fetch, as in the offchain workers.
+const REQUEST_TIMEOUT: Duration = Duration::from_secs(10);
+/// Idle connections kept open to each endpoint host.
+const MAX_IDLE_PER_HOST: usize = 8;
+/// Idle connections are closed after this long.
+const IDLE_TIMEOUT: Duration = Duration::from_secs(90);
+
+type Client = hyper::Client<HttpsConnector<HttpConnector>>;
+
+fn unix_millis() -> u64 {
+	SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |since| since.as_millis() as u64)
+}
+
+/// Serve the requests of the offchain workers written to `storage`, until the node stops.
+pub async fn run<S: OffchainStorage>(mut storage: S) {
+	let mut http = HttpConnector::new();
+	http.enforce_http(false);
+	http.set_keepalive(Some(IDLE_TIMEOUT));
+	let https = hyper_rustls::HttpsConnectorBuilder::new()
+		.with_native_roots()
+		.https_or_http()
+		.enable_http1()
+		.wrap_connector(http);
+	let client: Client = hyper::Client::builder()
+		.pool_max_idle_per_host(MAX_IDLE_PER_HOST)
+		.pool_idle_timeout(IDLE_TIMEOUT)
+		.build(https);
+
+	let mut interval = tokio::time::interval(POLL_INTERVAL);
+	loop {
+		interval.tick().await;
+		storage.set(STORAGE_PREFIX, ALIVE_KEY, &unix_millis().encode());
+
+		// Every endpoint is fetched once per request, the results of a run being written as
+		// soon as its slowest endpoint completes.
+		let mut due = Vec::new();
+		for namespace in NAMESPACES {
+			let requests = match storage
+				.get(STORAGE_PREFIX, &requests_key(namespace))
+				.and_then(|encoded| FetchRequests::decode(&mut &encoded[..]).ok())
+			{
+				Some(requests) => requests,
+				None => continue,
+			};
+			for (url, pointers) in requests.endpoints {
+				let key = result_key(namespace, &url);
+				let fetched = storage
+					.get(STORAGE_PREFIX, &key)
+					.and_then(|encoded| FetchResult::decode(&mut &encoded[..]).ok())
+					.map_or(false, |result| result.fetched_at >= requests.requested_at);
+				if !fetched {
+					due.push((key, url, pointers, requests.max_response_size));
+				}
+			}
+		}
+
+		let results = future::join_all(due.iter().map(|(_, url, pointers, max_response_size)| {
+			fetch(&client, url, pointers, *max_response_size as usize)
+		}))
+		.await;
+		for ((key, ..), result) in due.iter().zip(results) {
+			storage.set(STORAGE_PREFIX, key, &result.encode());
+		}
+	}
+}
+
+/// Fetch `url` and extract the values at `pointers` from its response.
+async fn fetch(
+	client: &Client,
+	url: &[u8],
+	pointers: &[Vec<u8>],
+	max_response_size: usize,
+) -> FetchResult {
+	let start = Instant::now();
+	let values = tokio::time::timeout(REQUEST_TIMEOUT, fetch_values(client, url, pointers, max_response_size))
+		.await
+		.unwrap_or_else(|_| Err("Deadline reached".into()))
+		.map_err(|e| {
+			log::debug!(target: "kylin-fetcher", "Failed to fetch {:?}: {}", String::from_utf8_lossy(url), e)
+		})
+		.ok();
+	FetchResult { fetched_at: unix_millis(), latency: start.elapsed().as_millis() as u64, values }
+}
+
+async fn fetch_values(
+	client: &Client,
+	url: &[u8],
+	pointers: &[Vec<u8>],
+	max_response_size: usize,
+) -> Result<Vec<(Vec<u8>, Option<i64>)>, String> {
+	let uri: Uri = std::str::from_utf8(url)
+		.map_err(|e| e.to_string())?
+		.parse()
+		.map_err(|e: hyper::http::uri::InvalidUri| e.to_string())?;
+	let mut response = client.get(uri).await.map_err(|e| e.to_string())?;
+	if response.status() != StatusCode::OK {
+		return Err(format!("Unexpected status code: {}", response.status()))
+	}
+
+	// The body is read in chunks so an oversized response is dropped without being buffered.
+	let mut body = Vec::new();
+	while let Some(chunk) = response.body_mut().data().await {
+		let chunk = chunk.map_err(|e| e.to_string())?;
+		if body.len() + chunk.len() > max_response_size {
+			return Err("Response exceeds the maximum size".into())
+		}
+		body.extend_from_slice(&chunk);
+	}
+
+	let fvals = extract_numbers(body, pointers, max_response_size)
+		.map_err(|e| format!("Response JSON was not well-formatted: {:?}", e))?;
+	Ok(pointers.iter().cloned().zip(fvals.into_iter().map(|fval| fval.map(to_fixed))).collect())
+}
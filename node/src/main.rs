@@ -3,6 +3,8 @@ mod chain_spec;
 mod service;
 mod cli;
 mod command;
+mod fetcher;
+mod oracle_metrics;
 mod rpc;
 
 fn main() -> sc_cli::Result<()> {
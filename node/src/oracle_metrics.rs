@@ -0,0 +1,260 @@
+//! Prometheus metrics of the oracle pipeline.
+//!
+//! The offchain workers record their last run in the offchain local storage, see
+//! [`kylin_support::offchain_metrics`]. Every new run is exported on block import, along with
+//! the age of the hot values of the best block, read at once.
+//!
+//! Endpoints are labelled by their scheme and host only, at most [`MAX_ENDPOINTS`] of them per
+//! pallet, and the labels of an endpoint not fetched for [`STALE_RUNS`] runs are removed.
+
+use std::{
+	collections::{BTreeMap, BTreeSet},
+	sync::Arc,
+	time::{SystemTime, UNIX_EPOCH},
+};
+
+use codec::Decode;
+use futures::StreamExt;
+use kylin_oracle_rpc::KylinOracleRuntimeApi;
+use kylin_support::{
+	native_fetch::NAMESPACES,
+	offchain_metrics::{last_run_key, WorkerRun},
+};
+use sc_client_api::BlockchainEvents;
+use sp_api::ProvideRuntimeApi;
+use sp_core::offchain::{OffchainStorage, STORAGE_PREFIX};
+use sp_runtime::{generic::BlockId, traits::Block as BlockT};
+use substrate_prometheus_endpoint::{
+	exponential_buckets, register, CounterVec, GaugeVec, HistogramOpts, HistogramVec, Opts,
+	PrometheusError, Registry, F64, U64,
+};
+
+/// Maximum number of endpoint labels of a pallet, the fetches of any other endpoint being
+/// labelled [`OTHER_ENDPOINTS`].
+const MAX_ENDPOINTS: usize = 64;
+/// Label of the endpoints beyond [`MAX_ENDPOINTS`].
+const OTHER_ENDPOINTS: &str = "other";
+/// Number of runs after which the labels of an endpoint not fetched since are removed.
+const STALE_RUNS: u64 = 1_000;
+/// Maximum length of a label value.
+const MAX_LABEL_LEN: usize = 64;
+
+/// Label of `bytes`, cut to `MAX_LABEL_LEN` characters.
+fn label(bytes: &[u8]) -> String {
+	String::from_utf8_lossy(bytes).chars().take(MAX_LABEL_LEN).collect()
+}
+
+/// Label of the endpoint `url`: its scheme and host, the path and query naming a single feed
+/// and possibly holding credentials.
+fn endpoint_label(url: &[u8]) -> String {
+	let url = String::from_utf8_lossy(url);
+	let (scheme, rest) = url.split_once("://").unwrap_or(("", &url));
+	let authority = rest.split(|c: char| c == '/' || c == '?' || c == '#').next().unwrap_or_default();
+	let host = authority.rsplit('@').next().unwrap_or_default();
+	let endpoint =
+		if scheme.is_empty() { host.to_owned() } else { format!("{}://{}", scheme, host) };
+	label(endpoint.as_bytes())
+}
+
+struct Metrics {
+	run_duration: HistogramVec,
+	due_feeds: GaugeVec<U64>,
+	submitted_values: CounterVec<U64>,
+	fetch_latency: HistogramVec,
+	fetch_failures: CounterVec<U64>,
+	fetched_values: GaugeVec<U64>,
+	value_age: GaugeVec<F64>,
+	/// Number of runs exported so far.
+	runs: u64,
+	/// Run each endpoint label of each pallet was last fetched in.
+	endpoints: BTreeMap<(String, String), u64>,
+	/// Keys with a value age.
+	aged_keys: BTreeSet<String>,
+}
+
+impl Metrics {
+	fn register(registry: &Registry) -> Result<Self, PrometheusError> {
+		Ok(Self {
+			run_duration: register(
+				HistogramVec::new(
+					HistogramOpts::new(
+						"kylin_offchain_worker_run_duration_ms",
+						"Wall time of the offchain worker runs, in milliseconds",
+					)
+					.buckets(exponential_buckets(10.0, 2.0, 12)?),
+					&["pallet"],
+				)?,
+				registry,
+			)?,
+			due_feeds: register(
+				GaugeVec::new(
+					Opts::new("kylin_offchain_worker_due_feeds", "Feeds due in the last run"),
+					&["pallet"],
+				)?,
+				registry,
+			)?,
+			submitted_values: register(
+				CounterVec::new(
+					Opts::new("kylin_offchain_worker_submitted_values", "Values submitted"),
+					&["pallet"],
+				)?,
+				registry,
+			)?,
+			fetch_latency: register(
+				HistogramVec::new(
+					HistogramOpts::new(
+						"kylin_feed_fetch_latency_ms",
+						"Latency of the fetches of each endpoint, in milliseconds",
+					)
+					.buckets(exponential_buckets(10.0, 2.0, 11)?),
+					&["pallet", "endpoint"],
+				)?,
+				registry,
+			)?,
+			fetch_failures: register(
+				CounterVec::new(
+					Opts::new("kylin_feed_fetch_failures", "Failed fetches of each endpoint"),
+					&["pallet", "endpoint"],
+				)?,
+				registry,
+			)?,
+			fetched_values: register(
+				GaugeVec::new(
+					Opts::new(
+						"kylin_feed_fetched_values",
+						"Values extracted from the last response of each endpoint",
+					),
+					&["pallet", "endpoint"],
+				)?,
+				registry,
+			)?,
+			value_age: register(
+				GaugeVec::new(
+					Opts::new(
+						"kylin_oracle_value_age_seconds",
+						"Age of the combined value of each hot key in the best block",
+					),
+					&["key"],
+				)?,
+				registry,
+			)?,
+			runs: 0,
+			endpoints: BTreeMap::new(),
+			aged_keys: BTreeSet::new(),
+		})
+	}
+
+	/// Label of the endpoint `url` fetched by `pallet` in the current run.
+	fn endpoint(&mut self, pallet: &str, url: &[u8]) -> String {
+		let mut endpoint = endpoint_label(url);
+		let known = self.endpoints.contains_key(&(pallet.to_owned(), endpoint.clone()));
+		let labelled = self.endpoints.keys().filter(|(labelled, _)| labelled == pallet).count();
+		if !known && labelled >= MAX_ENDPOINTS {
+			endpoint = OTHER_ENDPOINTS.to_owned();
+		}
+		self.endpoints.insert((pallet.to_owned(), endpoint.clone()), self.runs);
+		endpoint
+	}
+
+	fn observe_run(&mut self, pallet: &str, run: &WorkerRun) {
+		self.runs += 1;
+		self.run_duration.with_label_values(&[pallet]).observe(run.duration as f64);
+		self.due_feeds.with_label_values(&[pallet]).set(run.due as u64);
+		self.submitted_values.with_label_values(&[pallet]).inc_by(run.submitted as u64);
+		// Fetches of endpoints sharing a label add up.
+		let mut fetched = BTreeMap::<String, u64>::new();
+		for fetch in &run.fetches {
+			let endpoint = self.endpoint(pallet, &fetch.url);
+			let labels = [pallet, endpoint.as_str()];
+			self.fetch_latency.with_label_values(&labels).observe(fetch.latency as f64);
+			if !fetch.success {
+				self.fetch_failures.with_label_values(&labels).inc();
+			}
+			*fetched.entry(endpoint).or_default() += fetch.values as u64;
+		}
+		for (endpoint, values) in fetched {
+			self.fetched_values.with_label_values(&[pallet, &endpoint]).set(values);
+		}
+
+		let runs = self.runs;
+		let stale: Vec<_> = self
+			.endpoints
+			.iter()
+			.filter(|(_, last_run)| runs - **last_run > STALE_RUNS)
+			.map(|(labels, _)| labels.clone())
+			.collect();
+		for (pallet, endpoint) in stale {
+			let labels = [pallet.as_str(), endpoint.as_str()];
+			let _ = self.fetch_latency.remove_label_values(&labels);
+			let _ = self.fetch_failures.remove_label_values(&labels);
+			let _ = self.fetched_values.remove_label_values(&labels);
+			self.endpoints.remove(&(pallet, endpoint));
+		}
+	}
+
+	/// Set the age of the hot `values`, removing the age of the keys no longer hot.
+	fn observe_values(&mut self, values: Vec<(Vec<u8>, (i64, u128))>) {
+		let now = unix_millis();
+		let mut keys = BTreeSet::new();
+		for (key, (_, timestamp)) in values {
+			let key = label(&key);
+			let age = now.saturating_sub(timestamp) as f64 / 1000.0;
+			self.value_age.with_label_values(&[&key]).set(age);
+			keys.insert(key);
+		}
+		for key in self.aged_keys.difference(&keys) {
+			let _ = self.value_age.remove_label_values(&[key]);
+		}
+		self.aged_keys = keys;
+	}
+}
+
+fn unix_millis() -> u128 {
+	SystemTime::now().duration_since(UNIX_EPOCH).map_or(0, |since| since.as_millis())
+}
+
+/// Export the metrics of the oracle pipeline to `registry`, until the node stops.
+pub async fn run<C, Block, S>(client: Arc<C>, storage: S, registry: Registry)
+where
+	Block: BlockT,
+	C: ProvideRuntimeApi<Block> + BlockchainEvents<Block>,
+	C::Api: KylinOracleRuntimeApi<Block>,
+	S: OffchainStorage,
+{
+	let mut metrics = match Metrics::register(&registry) {
+		Ok(metrics) => metrics,
+		Err(e) => {
+			log::error!(target: "kylin-metrics", "Failed to register the oracle metrics: {}", e);
+			return
+		},
+	};
+
+	// A run is overwritten by the next one, it is exported once and only if seen in time.
+	let mut last_runs = BTreeMap::<&[u8], u64>::new();
+	let mut imports = client.import_notification_stream();
+	while let Some(notification) = imports.next().await {
+		if !notification.is_new_best {
+			continue
+		}
+
+		for &namespace in NAMESPACES {
+			let run = match storage
+				.get(STORAGE_PREFIX, &last_run_key(namespace))
+				.and_then(|encoded| WorkerRun::decode(&mut &encoded[..]).ok())
+			{
+				Some(run) => run,
+				None => continue,
+			};
+			if last_runs.insert(namespace, run.finished_at) != Some(run.finished_at) {
+				metrics.observe_run(&String::from_utf8_lossy(namespace), &run);
+			}
+		}
+
+		// The hot values are bounded by `MaxHotKeys` and read at once, the long tail of keys
+		// is left to the `ValuesCombined` events.
+		match client.runtime_api().get_hot_values(&BlockId::hash(notification.hash)) {
+			Ok(values) => metrics.observe_values(values),
+			Err(e) => log::debug!(target: "kylin-metrics", "Failed to read the oracle values: {}", e),
+		}
+	}
+}
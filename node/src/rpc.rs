@@ -8,7 +8,7 @@
 use std::sync::Arc;
 
 use parachains_common::{Block, AccountId, Balance, Index as Nonce};
-use sc_client_api::AuxStore;
+use sc_client_api::{AuxStore, BlockchainEvents};
 pub use sc_rpc::{DenyUnsafe, SubscriptionTaskExecutor};
 use sc_transaction_pool_api::TransactionPool;
 use sp_api::ProvideRuntimeApi;
@@ -26,6 +26,8 @@ pub struct FullDeps<C, P> {
 	pub pool: Arc<P>,
 	/// Whether to deny unsafe calls
 	pub deny_unsafe: DenyUnsafe,
+	/// Executor of the subscription tasks.
+	pub subscription_executor: SubscriptionTaskExecutor,
 }
 
 /// Instantiate all RPC extensions.
@@ -37,21 +39,25 @@ where
 		+ HeaderBackend<Block>
 		+ AuxStore
 		+ HeaderMetadata<Block, Error = BlockChainError>
+		+ BlockchainEvents<Block>
 		+ Send
 		+ Sync
 		+ 'static,
 	C::Api: pallet_transaction_payment_rpc::TransactionPaymentRuntimeApi<Block, Balance>,
 	C::Api: substrate_frame_rpc_system::AccountNonceApi<Block, AccountId, Nonce>,
 	C::Api: BlockBuilder<Block>,
+	C::Api: kylin_oracle_rpc::KylinOracleRuntimeApi<Block>,
 	P: TransactionPool + Sync + Send + 'static,
 {
 	use pallet_transaction_payment_rpc::{TransactionPayment, TransactionPaymentApiServer};
 	use substrate_frame_rpc_system::{System, SystemApiServer};
+	use kylin_oracle_rpc::{KylinOracle, KylinOracleApiServer};
 
 	let mut module = RpcExtension::new(());
-	let FullDeps { client, pool, deny_unsafe } = deps;
+	let FullDeps { client, pool, deny_unsafe, subscription_executor } = deps;
 
 	module.merge(System::new(client.clone(), pool.clone(), deny_unsafe).into_rpc())?;
 	module.merge(TransactionPayment::new(client.clone()).into_rpc())?;
+	module.merge(KylinOracle::new(client.clone(), subscription_executor, deny_unsafe).into_rpc())?;
 	Ok(module)
 }
\ No newline at end of file
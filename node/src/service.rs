@@ -23,10 +23,13 @@ use cumulus_relay_chain_interface::{RelayChainError, RelayChainInterface, RelayC
 use cumulus_relay_chain_rpc_interface::{create_client_and_start_worker, RelayChainRpcInterface};
 
 // Substrate Imports
+use sc_client_api::Backend;
 use sc_executor::NativeElseWasmExecutor;
 use sc_network::NetworkService;
 use sc_network_common::service::NetworkBlock;
-use sc_service::{Configuration, PartialComponents, TFullBackend, TFullClient, TaskManager};
+use sc_service::{
+	Configuration, PartialComponents, SpawnTaskHandle, TFullBackend, TFullClient, TaskManager,
+};
 use sc_telemetry::{Telemetry, TelemetryHandle, TelemetryWorker, TelemetryWorkerHandle};
 use sp_api::ConstructRuntimeApi;
 use sp_keystore::SyncCryptoStorePtr;
@@ -35,45 +38,79 @@ use substrate_prometheus_endpoint::Registry;
 
 use polkadot_service::CollatorPair;
 
-pub struct PichiuRuntimerExecutor;
-pub struct DevelopmentRuntimerExecutor;
-pub struct KylinRuntimerExecutor;
-
+/// Native executor of a runtime, dispatching to the native runtime and falling back to wasm.
+macro_rules! native_executor {
+	($name:ident, $runtime:ident) => {
+		pub struct $name;
 
-impl sc_executor::NativeExecutionDispatch for PichiuRuntimerExecutor {
-	type ExtendHostFunctions = frame_benchmarking::benchmarking::HostFunctions;
+		impl sc_executor::NativeExecutionDispatch for $name {
+			type ExtendHostFunctions = frame_benchmarking::benchmarking::HostFunctions;
 
-	fn dispatch(method: &str, data: &[u8]) -> Option<Vec<u8>> {
-		pichiu_runtime::api::dispatch(method, data)
-	}
+			fn dispatch(method: &str, data: &[u8]) -> Option<Vec<u8>> {
+				$runtime::api::dispatch(method, data)
+			}
 
-	fn native_version() -> sc_executor::NativeVersion {
-		pichiu_runtime::native_version()
-	}
+			fn native_version() -> sc_executor::NativeVersion {
+				$runtime::native_version()
+			}
+		}
+	};
 }
 
-impl sc_executor::NativeExecutionDispatch for DevelopmentRuntimerExecutor {
-	type ExtendHostFunctions = frame_benchmarking::benchmarking::HostFunctions;
-
-	fn dispatch(method: &str, data: &[u8]) -> Option<Vec<u8>> {
-		development_runtime::api::dispatch(method, data)
-	}
+native_executor!(PichiuRuntimerExecutor, pichiu_runtime);
+native_executor!(DevelopmentRuntimerExecutor, development_runtime);
+native_executor!(KylinRuntimerExecutor, kylin_runtime);
 
-	fn native_version() -> sc_executor::NativeVersion {
-		development_runtime::native_version()
-	}
+/// Build the executor of the runtime of `Executor`, with the wasm method, instance pool and
+/// compiled runtime cache of `config`.
+pub fn new_executor<Executor>(config: &Configuration) -> NativeElseWasmExecutor<Executor>
+where
+	Executor: sc_executor::NativeExecutionDispatch + 'static,
+{
+	NativeElseWasmExecutor::<Executor>::new(
+		config.wasm_method,
+		config.default_heap_pages,
+		config.max_runtime_instances,
+		config.runtime_cache_size,
+	)
 }
 
-impl sc_executor::NativeExecutionDispatch for KylinRuntimerExecutor {
-	type ExtendHostFunctions = frame_benchmarking::benchmarking::HostFunctions;
+/// Keeps a tokio runtime running until the node stops, shutting it down from within the tasks
+/// of the node.
+struct DedicatedRuntime(Option<tokio::runtime::Runtime>);
 
-	fn dispatch(method: &str, data: &[u8]) -> Option<Vec<u8>> {
-		kylin_runtime::api::dispatch(method, data)
+impl Drop for DedicatedRuntime {
+	fn drop(&mut self) {
+		if let Some(runtime) = self.0.take() {
+			runtime.shutdown_background();
+		}
 	}
+}
 
-	fn native_version() -> sc_executor::NativeVersion {
-		kylin_runtime::native_version()
-	}
+/// Spawn handle of a task manager running on its own pool of `threads` threads, for the tasks
+/// which must not compete with block import. The task manager is a child of `task_manager`.
+fn dedicated_spawn_handle(
+	task_manager: &mut TaskManager,
+	name: &'static str,
+	threads: usize,
+) -> sc_service::error::Result<SpawnTaskHandle> {
+	let runtime = tokio::runtime::Builder::new_multi_thread()
+		.worker_threads(threads.max(1))
+		.thread_name(name)
+		.enable_all()
+		.build()
+		.map_err(|e| sc_service::Error::Other(format!("Failed to start the {} threads: {}", name, e)))?;
+	let child = TaskManager::new(runtime.handle().clone(), None)
+		.map_err(|e| sc_service::Error::Other(e.to_string()))?;
+	let spawn_handle = child.spawn_handle();
+	task_manager.add_child(child);
+
+	let runtime = DedicatedRuntime(Some(runtime));
+	task_manager.spawn_handle().spawn(name, None, async move {
+		let _runtime = runtime;
+		futures::future::pending::<()>().await
+	});
+	Ok(spawn_handle)
 }
 
 /// Starts a `ServiceBuilder` for a full service.
@@ -140,12 +177,7 @@ where
 		})
 		.transpose()?;
 
-	let executor = sc_executor::NativeElseWasmExecutor::<Executor>::new(
-		config.wasm_method,
-		config.default_heap_pages,
-		config.max_runtime_instances,
-		config.runtime_cache_size,
-	);
+	let executor = new_executor::<Executor>(config);
 
 	let (client, backend, keystore_container, task_manager) =
 		sc_service::new_full_parts::<Block, RuntimeApi, _>(
@@ -229,6 +261,7 @@ async fn start_node_impl<RuntimeApi, Executor, RB, BIQ, BIC>(
 	build_import_queue: BIQ,
 	build_consensus: BIC,
 	hwbench: Option<sc_sysinfo::HwBench>,
+	native_fetcher_threads: Option<usize>,
 ) -> sc_service::error::Result<(
 	TaskManager,
 	Arc<TFullClient<Block, RuntimeApi, NativeElseWasmExecutor<Executor>>>,
@@ -248,7 +281,8 @@ RuntimeApi::RuntimeApi: sp_transaction_pool::runtime_api::TaggedTransactionQueue
 + sp_block_builder::BlockBuilder<Block>
 + cumulus_primitives_core::CollectCollationInfo<Block>
 + pallet_transaction_payment_rpc::TransactionPaymentRuntimeApi<Block, Balance>
-+ substrate_frame_rpc_system::AccountNonceApi<Block, AccountId, Nonce>,
++ substrate_frame_rpc_system::AccountNonceApi<Block, AccountId, Nonce>
++ kylin_oracle_rpc::KylinOracleRuntimeApi<Block>,
 sc_client_api::StateBackendFor<TFullBackend<Block>, Block>: sp_api::StateBackend<BlakeTwo256>,
 Executor: sc_executor::NativeExecutionDispatch + 'static,
 RB: Fn(
@@ -332,11 +366,12 @@ bool,
 		let client = client.clone();
 		let transaction_pool = transaction_pool.clone();
 
-		Box::new(move |deny_unsafe, _| {
+		Box::new(move |deny_unsafe, subscription_executor| {
 			let deps = crate::rpc::FullDeps {
 				client: client.clone(),
 				pool: transaction_pool.clone(),
 				deny_unsafe,
+				subscription_executor,
 			};
 
 			crate::rpc::create_full(deps).map_err(Into::into)
@@ -350,8 +385,31 @@ bool,
 			client.clone(),
 			network.clone(),
 		);
+
+		// Feeds are fetched natively, the offchain workers only signing and submitting them.
+		if let Some(storage) = backend.offchain_storage() {
+			let fetcher_spawn_handle = match native_fetcher_threads {
+				Some(threads) => {
+					dedicated_spawn_handle(&mut task_manager, "native-fetcher", threads)?
+				},
+				None => task_manager.spawn_handle(),
+			};
+			fetcher_spawn_handle.spawn(
+				"kylin-native-fetcher",
+				Some("offchain-worker"),
+				crate::fetcher::run(storage),
+			);
+		}
 	};
 
+	if let (Some(registry), Some(storage)) = (prometheus_registry.as_ref(), backend.offchain_storage()) {
+		task_manager.spawn_handle().spawn(
+			"kylin-oracle-metrics",
+			None,
+			crate::oracle_metrics::run(client.clone(), storage, registry.clone()),
+		);
+	}
+
 	sc_service::spawn_tasks(sc_service::SpawnTasksParams {
 		rpc_builder,
 		client: client.clone(),
@@ -487,6 +545,7 @@ pub async fn start_pichiu_node(
 	collator_options: CollatorOptions,
 	id: ParaId,
 	hwbench: Option<sc_sysinfo::HwBench>,
+	native_fetcher_threads: Option<usize>,
 ) -> sc_service::error::Result<(
 	TaskManager,
 	Arc<TFullClient<Block, pichiu_runtime::RuntimeApi, NativeElseWasmExecutor<PichiuRuntimerExecutor>>>,
@@ -562,6 +621,7 @@ pub async fn start_pichiu_node(
 			))
 		},
 		hwbench,
+		native_fetcher_threads,
 	)
 	.await
 }
@@ -617,6 +677,7 @@ pub async fn start_development_node(
 	collator_options: CollatorOptions,
 	id: ParaId,
 	hwbench: Option<sc_sysinfo::HwBench>,
+	native_fetcher_threads: Option<usize>,
 ) -> sc_service::error::Result<(
 	TaskManager,
 	Arc<TFullClient<Block, development_runtime::RuntimeApi, NativeElseWasmExecutor<DevelopmentRuntimerExecutor>>>,
@@ -692,6 +753,7 @@ pub async fn start_development_node(
 			))
 		},
 		hwbench,
+		native_fetcher_threads,
 	)
 	.await
 }
@@ -746,6 +808,7 @@ pub async fn start_kylin_node(
 	collator_options: CollatorOptions,
 	id: ParaId,
 	hwbench: Option<sc_sysinfo::HwBench>,
+	native_fetcher_threads: Option<usize>,
 ) -> sc_service::error::Result<(
 	TaskManager,
 	Arc<TFullClient<Block, kylin_runtime::RuntimeApi, NativeElseWasmExecutor<KylinRuntimerExecutor>>>,
@@ -821,6 +884,7 @@ pub async fn start_kylin_node(
 			))
 		},
 		hwbench,
+		native_fetcher_threads,
 	)
 	.await
 }
\ No newline at end of file
@@ -36,6 +36,7 @@ const SEED: u32 = 0;
 const MAX_REFERENDUMS: u32 = 99;
 const MAX_SECONDERS: u32 = 100;
 const MAX_BYTES: u32 = 16_384;
+const MAX_VOTERS: u32 = 1_000;
 
 fn assert_last_event<T: Config>(generic_event: <T as Config>::Event) {
 	frame_system::Pallet::<T>::assert_last_event(generic_event.into());
@@ -506,9 +507,13 @@ benchmarks! {
 			_ => return Err("Votes are not direct".into()),
 		};
 		assert_eq!(votes.len(), r as usize, "Votes were not recorded.");
+		let tallies: Vec<_> = (0..r).map(ReferendumInfoOf::<T>::get).collect();
 		whitelist_account!(caller);
 	}: _(RawOrigin::Signed(caller.clone()), new_delegate.clone(), Conviction::Locked1x, delegated_balance)
 	verify {
+		// Referenda pick up the delegation when baked, none is touched.
+		let after: Vec<_> = (0..r).map(ReferendumInfoOf::<T>::get).collect();
+		assert!(tallies == after, "delegation touched the referenda");
 		let (target, balance) = match VotingOf::<T>::get(&caller) {
 			Voting::Delegating { target, balance, .. } => (target, balance),
 			_ => return Err("Votes are not direct".into()),
@@ -558,9 +563,13 @@ benchmarks! {
 			_ => return Err("Votes are not direct".into()),
 		};
 		assert_eq!(votes.len(), r as usize, "Votes were not recorded.");
+		let tallies: Vec<_> = (0..r).map(ReferendumInfoOf::<T>::get).collect();
 		whitelist_account!(caller);
 	}: _(RawOrigin::Signed(caller.clone()))
 	verify {
+		// Referenda pick up the delegation when baked, none is touched.
+		let after: Vec<_> = (0..r).map(ReferendumInfoOf::<T>::get).collect();
+		assert!(tallies == after, "undelegation touched the referenda");
 		// Voting should now be direct
 		match VotingOf::<T>::get(&caller) {
 			Voting::Direct { .. } => (),
@@ -568,6 +577,35 @@ benchmarks! {
 		}
 	}
 
+	tally_delegations {
+		let v in 0 .. MAX_VOTERS;
+
+		let ref_index = add_referendum::<T>(0)?;
+		let account_vote = account_vote::<T>(100u32.into());
+		for i in 0 .. v {
+			// Every voter carries a delegation.
+			let voter = funded_account::<T>("voter", i);
+			let delegator = funded_account::<T>("delegator", i);
+			Democracy::<T>::delegate(
+				RawOrigin::Signed(delegator).into(),
+				voter.clone(),
+				Conviction::Locked1x,
+				1000u32.into(),
+			)?;
+			Democracy::<T>::vote(RawOrigin::Signed(voter).into(), ref_index, account_vote)?;
+		}
+		let mut status = Democracy::<T>::referendum_status(ref_index)?;
+	}: {
+		assert_eq!(Democracy::<T>::tally_delegations(ref_index, &mut status, v), (v, true));
+	}
+	verify {
+		assert_eq!(
+			DelegatedVoters::<T>::iter_prefix(ref_index).count(),
+			0,
+			"delegations were not all tallied"
+		);
+	}
+
 	clear_public_proposals {
 		add_proposal::<T>(0)?;
 
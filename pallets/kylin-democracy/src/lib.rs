@@ -154,6 +154,7 @@
 
 use codec::{Decode, Encode, Input};
 use frame_support::{
+	dispatch::{extract_actual_weight, GetDispatchInfo},
 	ensure,
 	traits::{
 		defensive_prelude::*,
@@ -165,12 +166,13 @@ use frame_support::{
 };
 use scale_info::TypeInfo;
 use sp_runtime::{
-	traits::{Bounded, Dispatchable, Hash, Saturating, Zero},
+	traits::{Bounded, Dispatchable, Hash, One, Saturating, Zero},
 	ArithmeticError, DispatchError, DispatchResult, RuntimeDebug,
 };
 use sp_std::prelude::*;
 
 mod conviction;
+pub mod migrations;
 mod types;
 mod vote;
 mod vote_threshold;
@@ -237,6 +239,7 @@ impl<AccountId, Balance, BlockNumber> PreimageStatus<AccountId, Balance, BlockNu
 #[derive(Encode, Decode, Clone, Copy, PartialEq, Eq, RuntimeDebug, TypeInfo)]
 enum Releases {
 	V1,
+	V2,
 }
 
 #[frame_support::pallet]
@@ -254,6 +257,7 @@ pub mod pallet {
 	pub trait Config: frame_system::Config + Sized {
 		type Proposal: Parameter
 			+ Dispatchable<RuntimeOrigin = Self::RuntimeOrigin>
+			+ GetDispatchInfo
 			+ From<Call<Self>>;
 		type RuntimeEvent: From<Event<Self>> + IsType<<Self as frame_system::Config>::RuntimeEvent>;
 
@@ -370,6 +374,13 @@ pub mod pallet {
 		/// The maximum number of public proposals that can exist at any time.
 		#[pallet::constant]
 		type MaxProposals: Get<u32>;
+
+		/// The weight `on_initialize` may spend baking matured referenda, including the proposals
+		/// enacted without delay. Referenda not baked within it are carried over to the next blocks,
+		/// at least one being baked per block. An approved proposal without delay that does not fit
+		/// in what is left of it is enacted by the scheduler in the next block.
+		#[pallet::constant]
+		type MaxBakingWeight: Get<Weight>;
 	}
 
 	// TODO: Refactor public proposal queue into its own pallet.
@@ -465,6 +476,26 @@ pub mod pallet {
 	#[pallet::storage]
 	pub type Cancellations<T: Config> = StorageMap<_, Identity, T::Hash, bool, ValueQuery>;
 
+	/// The standard voters of a referendum, with the direction of their vote.
+	///
+	/// The delegations to these voters are added to the tally once the referendum is baked,
+	/// keeping delegation changes independent of the number of votes of the delegate.
+	#[pallet::storage]
+	pub type DelegatedVoters<T: Config> = StorageDoubleMap<
+		_,
+		Twox64Concat,
+		ReferendumIndex,
+		Twox64Concat,
+		T::AccountId,
+		bool,
+	>;
+
+	/// Cancelled referenda whose standard voters are still in `DelegatedVoters`, oldest first.
+	///
+	/// They are removed with what is left of the baking budget of the next blocks.
+	#[pallet::storage]
+	pub type CancelledVoters<T: Config> = StorageValue<_, Vec<ReferendumIndex>, ValueQuery>;
+
 	/// Storage version of the pallet.
 	///
 	/// New networks start with last version.
@@ -489,7 +520,7 @@ pub mod pallet {
 			PublicPropCount::<T>::put(0 as PropIndex);
 			ReferendumCount::<T>::put(0 as ReferendumIndex);
 			LowestUnbaked::<T>::put(0 as ReferendumIndex);
-			StorageVersion::<T>::put(Releases::V1);
+			StorageVersion::<T>::put(Releases::V2);
 		}
 	}
 
@@ -608,6 +639,10 @@ pub mod pallet {
 		fn on_initialize(n: T::BlockNumber) -> Weight {
 			Self::begin_block(n)
 		}
+
+		fn on_runtime_upgrade() -> Weight {
+			migrations::migrate::<T>()
+		}
 	}
 
 	#[pallet::call]
@@ -934,8 +969,9 @@ pub mod pallet {
 		///
 		/// Emits `Delegated`.
 		///
-		/// Weight: `O(R)` where R is the number of referendums the voter delegating to has
-		///   voted on. Weight is charged as if maximum votes.
+		/// Weight: `O(R)` where R is the number of unbaked referendums the voter delegating to has
+		///   voted on, which are read. Only those matured, waiting to be baked, are written: the
+		///   others pick up the delegations when baked. Weight is charged as if maximum votes.
 		// NOTE: weight must cover an incorrect voting of origin with max votes, this is ensure
 		// because a valid delegation cover decoding a direct voting with max votes.
 		#[pallet::weight(T::WeightInfo::delegate(T::MaxVotes::get()))]
@@ -961,8 +997,9 @@ pub mod pallet {
 		///
 		/// Emits `Undelegated`.
 		///
-		/// Weight: `O(R)` where R is the number of referendums the voter delegating to has
-		///   voted on. Weight is charged as if maximum votes.
+		/// Weight: `O(R)` where R is the number of unbaked referendums the voter delegating to has
+		///   voted on, which are read. Only those matured, waiting to be baked, are written: the
+		///   others pick up the delegations when baked. Weight is charged as if maximum votes.
 		// NOTE: weight must cover an incorrect voting of origin with max votes, this is ensure
 		// because a valid delegation cover decoding a direct voting with max votes.
 		#[pallet::weight(T::WeightInfo::undelegate(T::MaxVotes::get()))]
@@ -1198,7 +1235,7 @@ pub mod pallet {
 			index: ReferendumIndex,
 		) -> DispatchResult {
 			ensure_root(origin)?;
-			Self::do_enact_proposal(proposal_hash, index)
+			Self::do_enact_proposal(proposal_hash, index).map(|_| ())
 		}
 
 		/// Permanently place a proposal into the blacklist. This prevents it from ever being
@@ -1293,7 +1330,8 @@ impl<T: Config> Pallet<T> {
 		Self::deposit_of(proposal).map(|(l, d)| d.saturating_mul((l.len() as u32).into()))
 	}
 
-	/// Get all referenda ready for tally at block `n`.
+	/// Get all referenda ready for tally at block `n`, including those left unbaked by earlier
+	/// blocks.
 	pub fn maturing_referenda_at(
 		n: T::BlockNumber,
 	) -> Vec<(ReferendumIndex, ReferendumStatus<T::BlockNumber, T::Hash, BalanceOf<T>>)> {
@@ -1313,7 +1351,7 @@ impl<T: Config> Pallet<T> {
 				Some(ReferendumInfo::Ongoing(status)) => Some((i, status)),
 				_ => None,
 			})
-			.filter(|(_, status)| status.end == n)
+			.filter(|(_, status)| status.end <= n)
 			.collect()
 	}
 
@@ -1334,9 +1372,12 @@ impl<T: Config> Pallet<T> {
 	}
 
 	/// Remove a referendum.
+	///
+	/// Its standard voters are removed from `DelegatedVoters` in the next blocks.
 	pub fn internal_cancel_referendum(ref_index: ReferendumIndex) {
 		Self::deposit_event(Event::<T>::Cancelled { ref_index });
 		ReferendumInfoOf::<T>::remove(ref_index);
+		CancelledVoters::<T>::append(ref_index);
 	}
 
 	// private.
@@ -1358,6 +1399,13 @@ impl<T: Config> Pallet<T> {
 		Self::ensure_ongoing(info)
 	}
 
+	/// Whether the tally of `status` may still change, i.e. it has not matured yet.
+	///
+	/// A matured referendum may wait a few blocks to be baked, its tally is frozen meanwhile.
+	fn is_voting(status: &ReferendumStatus<T::BlockNumber, T::Hash, BalanceOf<T>>) -> bool {
+		status.end > frame_system::Pallet::<T>::block_number()
+	}
+
 	/// Actually enact a vote, if legit.
 	fn try_vote(
 		who: &T::AccountId,
@@ -1365,16 +1413,14 @@ impl<T: Config> Pallet<T> {
 		vote: AccountVote<BalanceOf<T>>,
 	) -> DispatchResult {
 		let mut status = Self::referendum_status(ref_index)?;
+		ensure!(Self::is_voting(&status), Error::<T>::ReferendumInvalid);
 		ensure!(vote.balance() <= T::Currency::free_balance(who), Error::<T>::InsufficientFunds);
 		VotingOf::<T>::try_mutate(who, |voting| -> DispatchResult {
-			if let Voting::Direct { ref mut votes, delegations, .. } = voting {
+			if let Voting::Direct { ref mut votes, .. } = voting {
 				match votes.binary_search_by_key(&ref_index, |i| i.0) {
 					Ok(i) => {
 						// Shouldn't be possible to fail, but we handle it gracefully.
 						status.tally.remove(votes[i].1).ok_or(ArithmeticError::Underflow)?;
-						if let Some(approve) = votes[i].1.as_standard() {
-							status.tally.reduce(approve, *delegations);
-						}
 						votes[i].1 = vote;
 					},
 					Err(i) => {
@@ -1388,8 +1434,9 @@ impl<T: Config> Pallet<T> {
 				Self::deposit_event(Event::<T>::Voted { voter: who.clone(), ref_index, vote });
 				// Shouldn't be possible to fail, but we handle it gracefully.
 				status.tally.add(vote).ok_or(ArithmeticError::Overflow)?;
-				if let Some(approve) = vote.as_standard() {
-					status.tally.increase(approve, *delegations);
+				match vote.as_standard() {
+					Some(approve) => DelegatedVoters::<T>::insert(ref_index, who, approve),
+					None => DelegatedVoters::<T>::remove(ref_index, who),
 				}
 				Ok(())
 			} else {
@@ -1416,18 +1463,16 @@ impl<T: Config> Pallet<T> {
 	) -> DispatchResult {
 		let info = ReferendumInfoOf::<T>::get(ref_index);
 		VotingOf::<T>::try_mutate(who, |voting| -> DispatchResult {
-			if let Voting::Direct { ref mut votes, delegations, ref mut prior } = voting {
+			if let Voting::Direct { ref mut votes, ref mut prior, .. } = voting {
 				let i = votes
 					.binary_search_by_key(&ref_index, |i| i.0)
 					.map_err(|_| Error::<T>::NotVoter)?;
 				match info {
 					Some(ReferendumInfo::Ongoing(mut status)) => {
 						ensure!(matches!(scope, UnvoteScope::Any), Error::<T>::NoPermission);
+						ensure!(Self::is_voting(&status), Error::<T>::ReferendumInvalid);
 						// Shouldn't be possible to fail, but we handle it gracefully.
 						status.tally.remove(votes[i].1).ok_or(ArithmeticError::Underflow)?;
-						if let Some(approve) = votes[i].1.as_standard() {
-							status.tally.reduce(approve, *delegations);
-						}
 						ReferendumInfoOf::<T>::insert(ref_index, ReferendumInfo::Ongoing(status));
 					},
 					Some(ReferendumInfo::Finished { end, approved }) => {
@@ -1448,12 +1493,37 @@ impl<T: Config> Pallet<T> {
 					None => {}, // Referendum was cancelled.
 				}
 				votes.remove(i);
+				DelegatedVoters::<T>::remove(ref_index, who);
 			}
 			Ok(())
 		})?;
 		Ok(())
 	}
 
+	/// Add the `delegations` of `who` to the matured referenda it voted on that have not picked
+	/// them up yet, before they change.
+	///
+	/// A matured referendum may be baked several blocks later, this keeps its tally the one at
+	/// maturity. Only the referenda not baked yet are read, and only the matured ones written.
+	fn freeze_delegations(
+		who: &T::AccountId,
+		votes: &[(ReferendumIndex, AccountVote<BalanceOf<T>>)],
+		delegations: Delegations<BalanceOf<T>>,
+	) {
+		let lowest_unbaked = Self::lowest_unbaked();
+		for &(ref_index, _) in votes.iter().filter(|(i, _)| *i >= lowest_unbaked) {
+			if let Some(ReferendumInfo::Ongoing(mut status)) = ReferendumInfoOf::<T>::get(ref_index) {
+				if Self::is_voting(&status) {
+					continue
+				}
+				if let Some(aye) = DelegatedVoters::<T>::take(ref_index, who) {
+					status.tally.increase(aye, delegations);
+					ReferendumInfoOf::<T>::insert(ref_index, ReferendumInfo::Ongoing(status));
+				}
+			}
+		}
+	}
+
 	/// Return the number of votes for `who`
 	fn increase_upstream_delegation(who: &T::AccountId, amount: Delegations<BalanceOf<T>>) -> u32 {
 		VotingOf::<T>::mutate(who, |voting| match voting {
@@ -1463,16 +1533,9 @@ impl<T: Config> Pallet<T> {
 				1
 			},
 			Voting::Direct { votes, delegations, .. } => {
+				// Referenda voted on pick up the delegations when baked, unless already matured.
+				Self::freeze_delegations(who, votes, *delegations);
 				*delegations = delegations.saturating_add(amount);
-				for &(ref_index, account_vote) in votes.iter() {
-					if let AccountVote::Standard { vote, .. } = account_vote {
-						ReferendumInfoOf::<T>::mutate(ref_index, |maybe_info| {
-							if let Some(ReferendumInfo::Ongoing(ref mut status)) = maybe_info {
-								status.tally.increase(vote.aye, amount);
-							}
-						});
-					}
-				}
 				votes.len() as u32
 			},
 		})
@@ -1487,16 +1550,9 @@ impl<T: Config> Pallet<T> {
 				1
 			},
 			Voting::Direct { votes, delegations, .. } => {
+				// Referenda voted on pick up the delegations when baked, unless already matured.
+				Self::freeze_delegations(who, votes, *delegations);
 				*delegations = delegations.saturating_sub(amount);
-				for &(ref_index, account_vote) in votes.iter() {
-					if let AccountVote::Standard { vote, .. } = account_vote {
-						ReferendumInfoOf::<T>::mutate(ref_index, |maybe_info| {
-							if let Some(ReferendumInfo::Ongoing(ref mut status)) = maybe_info {
-								status.tally.reduce(vote.aye, amount);
-							}
-						});
-					}
-				}
 				votes.len() as u32
 			},
 		})
@@ -1670,7 +1726,11 @@ impl<T: Config> Pallet<T> {
 		}
 	}
 
-	fn do_enact_proposal(proposal_hash: T::Hash, index: ReferendumIndex) -> DispatchResult {
+	/// Dispatch the preimage of `proposal_hash`, returning the weight it actually consumed.
+	fn do_enact_proposal(
+		proposal_hash: T::Hash,
+		index: ReferendumIndex,
+	) -> Result<Weight, DispatchError> {
 		let preimage = <Preimages<T>>::take(&proposal_hash);
 		if let Some(PreimageStatus::Available { data, provider, deposit, .. }) = preimage {
 			if let Ok(proposal) = T::Proposal::decode(&mut &data[..]) {
@@ -1678,13 +1738,13 @@ impl<T: Config> Pallet<T> {
 				debug_assert!(err_amount.is_zero());
 				Self::deposit_event(Event::<T>::PreimageUsed { proposal_hash, provider, deposit });
 
-				let res = proposal
-					.dispatch(frame_system::RawOrigin::Root.into())
-					.map(|_| ())
-					.map_err(|e| e.error);
-				Self::deposit_event(Event::<T>::Executed { ref_index: index, result: res });
+				let info = proposal.get_dispatch_info();
+				let res = proposal.dispatch(frame_system::RawOrigin::Root.into());
+				let weight = extract_actual_weight(&res, &info);
+				let result = res.map(|_| ()).map_err(|e| e.error);
+				Self::deposit_event(Event::<T>::Executed { ref_index: index, result });
 
-				Ok(())
+				Ok(weight)
 			} else {
 				T::Slash::on_unbalanced(T::Currency::slash_reserved(&provider, deposit).0);
 				Self::deposit_event(Event::<T>::PreimageInvalid {
@@ -1699,20 +1759,88 @@ impl<T: Config> Pallet<T> {
 		}
 	}
 
+	/// Add to the tally of `status` the delegations of up to `max` of its voters.
+	///
+	/// Return the number of voters applied and whether none is left.
+	fn tally_delegations(
+		index: ReferendumIndex,
+		status: &mut ReferendumStatus<T::BlockNumber, T::Hash, BalanceOf<T>>,
+		max: u32,
+	) -> (u32, bool) {
+		let mut applied = 0;
+		let mut voters = DelegatedVoters::<T>::drain_prefix(index);
+		while applied < max {
+			match voters.next() {
+				Some((who, aye)) => {
+					if let Voting::Direct { delegations, .. } = VotingOf::<T>::get(&who) {
+						status.tally.increase(aye, delegations);
+					}
+					applied += 1;
+				},
+				None => return (applied, true),
+			}
+		}
+		drop(voters);
+		(applied, DelegatedVoters::<T>::iter_prefix(index).next().is_none())
+	}
+
+	/// Remove up to `max` standard voters of the cancelled referenda, oldest cancellation first.
+	///
+	/// Return the number of voters removed.
+	fn clear_cancelled_voters(max: u32) -> u32 {
+		let mut cancelled = CancelledVoters::<T>::get();
+		let len = cancelled.len();
+		let mut removed = 0;
+		while let Some(&index) = cancelled.first() {
+			let left = max.saturating_sub(removed) as usize;
+			removed += DelegatedVoters::<T>::drain_prefix(index).take(left).count() as u32;
+			if DelegatedVoters::<T>::iter_prefix(index).next().is_some() {
+				break
+			}
+			cancelled.remove(0);
+		}
+		if cancelled.len() != len {
+			CancelledVoters::<T>::put(cancelled);
+		}
+		removed
+	}
+
+	/// The weight declared by the preimage of `proposal_hash`, if it is available and decodes.
+	fn proposal_weight(proposal_hash: &T::Hash) -> Option<Weight> {
+		match Preimages::<T>::get(proposal_hash) {
+			Some(PreimageStatus::Available { data, .. }) =>
+				T::Proposal::decode(&mut &data[..]).ok().map(|p| p.get_dispatch_info().weight),
+			_ => None,
+		}
+	}
+
+	/// Tally up `status` and enact or schedule its proposal if approved.
+	///
+	/// A proposal without delay is enacted right away if its declared weight is within
+	/// `max_enactment`, otherwise it is scheduled for the next block.
+	///
+	/// Return whether it was approved and the weight consumed.
 	fn bake_referendum(
 		now: T::BlockNumber,
 		index: ReferendumIndex,
 		status: ReferendumStatus<T::BlockNumber, T::Hash, BalanceOf<T>>,
-	) -> bool {
+		max_enactment: Weight,
+	) -> (bool, Weight) {
+		let mut weight = T::WeightInfo::bake_referendum();
 		let total_issuance = T::Currency::total_issuance();
 		let approved = status.threshold.approved(status.tally, total_issuance);
 
 		if approved {
 			Self::deposit_event(Event::<T>::Passed { ref_index: index });
-			if status.delay.is_zero() {
-				let _ = Self::do_enact_proposal(status.proposal_hash, index);
+			let enact_now = status.delay.is_zero() &&
+				Self::proposal_weight(&status.proposal_hash)
+					.map_or(true, |w| w.ref_time() <= max_enactment.ref_time());
+			if enact_now {
+				if let Ok(enacted) = Self::do_enact_proposal(status.proposal_hash, index) {
+					weight = weight.saturating_add(enacted);
+				}
 			} else {
-				let when = now.saturating_add(status.delay);
+				let when = now.saturating_add(status.delay.max(One::one()));
 				// Note that we need the preimage now.
 				Preimages::<T>::mutate_exists(
 					&status.proposal_hash,
@@ -1740,15 +1868,18 @@ impl<T: Config> Pallet<T> {
 			Self::deposit_event(Event::<T>::NotPassed { ref_index: index });
 		}
 
-		approved
+		(approved, weight)
 	}
 
 	/// Current era is ending; we should finish up any proposals.
 	///
 	///
 	/// # <weight>
-	/// If a referendum is launched or maturing, this will take full block weight if queue is not
-	/// empty. Otherwise:
+	/// If a referendum is launched, this will take full block weight if queue is not empty.
+	/// Matured referenda are baked within `MaxBakingWeight`, the others being left for the next
+	/// blocks, and proposals without delay that do not fit in it are enacted by the scheduler in
+	/// the next block. The voters of cancelled referenda are then removed with what is left of
+	/// `MaxBakingWeight`. Otherwise:
 	/// - Complexity: `O(R)` where `R` is the number of unbaked referenda.
 	/// - Db reads: `LastTabledWasExternal`, `NextExternal`, `PublicProps`, `account`,
 	///   `ReferendumCount`, `LowestUnbaked`
@@ -1777,12 +1908,44 @@ impl<T: Config> Pallet<T> {
 			weight = weight.saturating_add(T::WeightInfo::on_initialize_base(r));
 		}
 
-		// tally up votes for any expiring referenda.
-		for (index, info) in Self::maturing_referenda_at_inner(now, next..last).into_iter() {
-			let approved = Self::bake_referendum(now, index, info);
-			ReferendumInfoOf::<T>::insert(index, ReferendumInfo::Finished { end: now, approved });
-			weight = max_block_weight;
+		// tally up votes for any matured referenda, as far as the baking budget allows.
+		let budget = T::MaxBakingWeight::get().ref_time();
+		let mut baked = Weight::zero();
+		let per_voter = T::WeightInfo::tally_delegations(1)
+			.saturating_sub(T::WeightInfo::tally_delegations(0))
+			.ref_time()
+			.max(1);
+		for (index, mut info) in Self::maturing_referenda_at_inner(now, next..last).into_iter() {
+			let estimate = baked
+				.saturating_add(T::WeightInfo::bake_referendum())
+				.saturating_add(T::WeightInfo::tally_delegations(0));
+			if !baked.is_zero() && estimate.ref_time() > budget {
+				break
+			}
+			// apply the delegations to its voters first, possibly over several blocks.
+			let room = budget.saturating_sub(estimate.ref_time()) / per_voter;
+			let max_voters = room.max(baked.is_zero() as u64).min(u32::MAX as u64) as u32;
+			let (voters, complete) = Self::tally_delegations(index, &mut info, max_voters);
+			baked = baked.saturating_add(T::WeightInfo::tally_delegations(voters));
+			if !complete {
+				ReferendumInfoOf::<T>::insert(index, ReferendumInfo::Ongoing(info));
+				break
+			}
+			let end = info.end;
+			// a proposal enacted without delay must fit in what is left of the budget.
+			let max_enactment = Weight::from_ref_time(budget)
+				.saturating_sub(baked)
+				.saturating_sub(T::WeightInfo::bake_referendum());
+			let (approved, used) = Self::bake_referendum(now, index, info, max_enactment);
+			ReferendumInfoOf::<T>::insert(index, ReferendumInfo::Finished { end, approved });
+			baked = baked.saturating_add(used);
 		}
+		// remove the voters of cancelled referenda with what is left of the budget.
+		baked = baked.saturating_add(T::DbWeight::get().reads_writes(1, 1));
+		let room = budget.saturating_sub(baked.ref_time()) / per_voter;
+		let removed = Self::clear_cancelled_voters(room.min(u32::MAX as u64) as u32) as u64;
+		baked = baked.saturating_add(Weight::from_ref_time(per_voter.saturating_mul(removed)));
+		weight = weight.saturating_add(baked);
 
 		// Notes:
 		// * We don't consider the lowest unbaked to be the last maturing in case some refendum have
@@ -0,0 +1,46 @@
+//! Storage migrations for the democracy pallet.
+
+use super::*;
+
+/// Migrate the pallet storage to the current storage version.
+pub fn migrate<T: Config>() -> Weight {
+	let mut weight = T::DbWeight::get().reads(1);
+
+	if StorageVersion::<T>::get() == Some(Releases::V1) {
+		weight = weight.saturating_add(v2::migrate::<T>());
+		StorageVersion::<T>::put(Releases::V2);
+		weight = weight.saturating_add(T::DbWeight::get().writes(1));
+	}
+	weight
+}
+
+/// Delegations used to be added to the tally of every referendum the delegate voted on.
+pub mod v2 {
+	use super::*;
+
+	/// Take the delegations out of the tallies of ongoing referenda and record their standard
+	/// voters in `DelegatedVoters`, the delegations being added back when they are baked.
+	pub fn migrate<T: Config>() -> Weight {
+		let (mut reads, mut writes) = (0u64, 0u64);
+		for (who, voting) in VotingOf::<T>::iter() {
+			reads += 1;
+			if let Voting::Direct { votes, delegations, .. } = voting {
+				for (ref_index, vote) in votes {
+					let approve = match vote.as_standard() {
+						Some(approve) => approve,
+						None => continue,
+					};
+					reads += 1;
+					ReferendumInfoOf::<T>::mutate(ref_index, |maybe_info| {
+						if let Some(ReferendumInfo::Ongoing(ref mut status)) = maybe_info {
+							status.tally.reduce(approve, delegations);
+							DelegatedVoters::<T>::insert(ref_index, &who, approve);
+							writes += 2;
+						}
+					});
+				}
+			}
+		}
+		T::DbWeight::get().reads_writes(reads, writes)
+	}
+}
@@ -137,6 +137,7 @@ impl pallet_balances::Config for Test {
 parameter_types! {
 	pub static PreimageByteDeposit: u64 = 0;
 	pub static InstantAllowed: bool = false;
+	pub static MaxBakingWeight: Weight = Weight::from_ref_time(u64::MAX);
 }
 ord_parameter_types! {
 	pub const One: u64 = 1;
@@ -184,6 +185,7 @@ impl Config for Test {
 	type PalletsOrigin = OriginCaller;
 	type WeightInfo = ();
 	type MaxProposals = ConstU32<100>;
+	type MaxBakingWeight = MaxBakingWeight;
 }
 
 pub fn new_test_ext() -> sp_io::TestExternalities {
@@ -287,6 +289,13 @@ fn big_nay(who: u64) -> AccountVote<u64> {
 	AccountVote::Standard { vote: BIG_NAY, balance: Balances::free_balance(&who) }
 }
 
+/// The tally of `r`, with the delegations that are only added when it is baked.
 fn tally(r: ReferendumIndex) -> Tally<u64> {
-	Democracy::referendum_status(r).unwrap().tally
+	let mut tally = Democracy::referendum_status(r).unwrap().tally;
+	for (who, aye) in DelegatedVoters::<Test>::iter_prefix(r) {
+		if let Voting::Direct { delegations, .. } = VotingOf::<Test>::get(&who) {
+			tally.increase(aye, delegations);
+		}
+	}
+	tally
 }
@@ -94,3 +94,33 @@ fn emergency_cancel_should_work() {
 		);
 	});
 }
+
+#[test]
+fn voters_of_a_cancelled_referendum_are_removed_within_the_baking_budget() {
+	new_test_ext().execute_with(|| {
+		let r = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SuperMajorityApprove,
+			0,
+		);
+		for who in 1..=3 {
+			assert_ok!(Democracy::vote(Origin::signed(who), r, aye(who)));
+		}
+		// room for the removal of two voters per block.
+		MaxBakingWeight::set(
+			<Test as Config>::WeightInfo::tally_delegations(2)
+				.saturating_sub(<Test as Config>::WeightInfo::tally_delegations(0)),
+		);
+		assert_ok!(Democracy::cancel_referendum(Origin::root(), r.into()));
+		assert_eq!(DelegatedVoters::<Test>::iter_prefix(r).count(), 3);
+
+		next_block();
+		assert_eq!(DelegatedVoters::<Test>::iter_prefix(r).count(), 1);
+		assert_eq!(CancelledVoters::<Test>::get(), vec![r]);
+
+		next_block();
+		assert_eq!(DelegatedVoters::<Test>::iter_prefix(r).count(), 0);
+		assert!(CancelledVoters::<Test>::get().is_empty());
+	});
+}
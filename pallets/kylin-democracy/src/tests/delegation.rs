@@ -216,3 +216,92 @@ fn redelegation_keeps_lock() {
 		assert_eq!(VotingOf::<Test>::get(2).locked_balance(), 10);
 	});
 }
+
+#[test]
+fn delegations_are_tallied_when_baked() {
+	new_test_ext().execute_with(|| {
+		let r = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SimpleMajority,
+			0,
+		);
+		assert_ok!(Democracy::vote(Origin::signed(1), r, nay(1)));
+		assert_ok!(Democracy::vote(Origin::signed(2), r, aye(2)));
+		assert_ok!(Democracy::delegate(Origin::signed(3), 1, Conviction::None, 30));
+
+		// Only the direct votes are stored, the delegation is added when baked.
+		let status = Democracy::referendum_status(r).unwrap();
+		assert_eq!(status.tally, Tally { ayes: 2, nays: 1, turnout: 30 });
+		assert_eq!(tally(r), Tally { ayes: 2, nays: 4, turnout: 60 });
+
+		fast_forward_to(2);
+
+		assert_eq!(Balances::free_balance(42), 0);
+		assert_eq!(DelegatedVoters::<Test>::iter_prefix(r).count(), 0);
+	});
+}
+
+#[test]
+fn delegations_after_maturity_are_not_tallied() {
+	new_test_ext().execute_with(|| {
+		MaxBakingWeight::set(Weight::from_ref_time(1));
+		Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(1),
+			VoteThreshold::SimpleMajority,
+			0,
+		);
+		let r = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SimpleMajority,
+			0,
+		);
+		assert_ok!(Democracy::vote(Origin::signed(1), r, aye(1)));
+		assert_ok!(Democracy::vote(Origin::signed(2), r, nay(2)));
+
+		// r is matured but only baked in the next block.
+		next_block();
+		assert_eq!(Democracy::lowest_unbaked(), r);
+		assert_ok!(Democracy::delegate(Origin::signed(3), 1, Conviction::Locked1x, 30));
+
+		next_block();
+		assert_eq!(
+			Democracy::referendum_info(r),
+			Some(ReferendumInfo::Finished { end: 2, approved: false })
+		);
+	});
+}
+
+#[test]
+fn redelegating_during_a_tally_over_several_blocks_counts_once() {
+	new_test_ext().execute_with(|| {
+		let r = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SimpleMajority,
+			0,
+		);
+		assert_ok!(Democracy::vote(Origin::signed(1), r, aye(1)));
+		assert_ok!(Democracy::vote(Origin::signed(2), r, nay(2)));
+		assert_ok!(Democracy::delegate(Origin::signed(5), 1, Conviction::None, 50));
+		// room for the delegations of one voter per block.
+		MaxBakingWeight::set(
+			<Test as Config>::WeightInfo::bake_referendum()
+				.saturating_add(<Test as Config>::WeightInfo::tally_delegations(1)),
+		);
+
+		next_block();
+		assert_eq!(DelegatedVoters::<Test>::iter_prefix(r).count(), 1);
+		// whichever voter is left, the delegation moves from the aye to the nay voter.
+		assert_ok!(Democracy::undelegate(Origin::signed(5)));
+		assert_ok!(Democracy::delegate(Origin::signed(5), 2, Conviction::None, 50));
+
+		next_block();
+		assert_eq!(
+			Democracy::referendum_info(r),
+			Some(ReferendumInfo::Finished { end: 2, approved: true })
+		);
+	});
+}
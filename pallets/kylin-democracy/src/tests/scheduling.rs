@@ -154,3 +154,77 @@ fn lowest_unbaked_should_be_sensible() {
 		assert_eq!(Democracy::lowest_unbaked(), Democracy::referendum_count());
 	});
 }
+
+#[test]
+fn baking_beyond_budget_is_carried_over() {
+	new_test_ext().execute_with(|| {
+		MaxBakingWeight::set(Weight::from_ref_time(1));
+		let r1 = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(1),
+			VoteThreshold::SuperMajorityApprove,
+			0,
+		);
+		let r2 = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SuperMajorityApprove,
+			0,
+		);
+		assert_ok!(Democracy::vote(Origin::signed(1), r1, aye(1)));
+		assert_ok!(Democracy::vote(Origin::signed(1), r2, aye(1)));
+
+		next_block();
+
+		// only r1 fits in the budget, r2 is matured but left unbaked
+		assert_eq!(Democracy::lowest_unbaked(), 1);
+		// the enactment of r1 does not fit either, it is left to the scheduler
+		assert_eq!(Balances::free_balance(42), 0);
+		assert_noop!(
+			Democracy::vote(Origin::signed(2), r2, nay(2)),
+			Error::<Test>::ReferendumInvalid
+		);
+		assert_noop!(
+			Democracy::remove_vote(Origin::signed(1), r2),
+			Error::<Test>::ReferendumInvalid
+		);
+
+		next_block();
+
+		// r2 is approved with its tally at maturity
+		assert_eq!(Balances::free_balance(42), 1);
+		assert_eq!(Democracy::lowest_unbaked(), 2);
+
+		next_block();
+		assert_eq!(Balances::free_balance(42), 2);
+	});
+}
+
+#[test]
+fn instant_enactment_is_bounded_by_the_baking_budget() {
+	new_test_ext().execute_with(|| {
+		let r = Democracy::inject_referendum(
+			2,
+			set_balance_proposal_hash_and_note(2),
+			VoteThreshold::SuperMajorityApprove,
+			0,
+		);
+		assert_ok!(Democracy::vote(Origin::signed(1), r, aye(1)));
+		// room for baking, not for the proposal
+		MaxBakingWeight::set(
+			<Test as Config>::WeightInfo::bake_referendum()
+				.saturating_add(<Test as Config>::WeightInfo::tally_delegations(0)),
+		);
+
+		next_block();
+		assert_eq!(
+			Democracy::referendum_info(r),
+			Some(ReferendumInfo::Finished { end: 2, approved: true })
+		);
+		assert_eq!(Balances::free_balance(42), 0);
+		assert!(Preimages::<Test>::contains_key(set_balance_proposal_hash(2)));
+
+		next_block();
+		assert_eq!(Balances::free_balance(42), 2);
+	});
+}
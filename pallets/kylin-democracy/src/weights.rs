@@ -20,6 +20,9 @@
 //! THIS FILE WAS AUTO-GENERATED USING THE SUBSTRATE BENCHMARK CLI VERSION 4.0.0-dev
 //! DATE: 2022-05-23, STEPS: `50`, REPEAT: 20, LOW RANGE: `[]`, HIGH RANGE: `[]`
 //! EXECUTION: Some(Wasm), WASM-EXECUTION: Compiled, CHAIN: Some("dev"), DB CACHE: 1024
+//!
+//! `bake_referendum`, `tally_delegations`, `delegate` and `undelegate` are not from that run, they
+//! are estimates until benchmarked again.
 
 // Executed Command:
 // ./target/production/substrate
@@ -60,6 +63,8 @@ pub trait WeightInfo {
 	fn cancel_queued(r: u32, ) -> Weight;
 	fn on_initialize_base(r: u32, ) -> Weight;
 	fn on_initialize_base_with_launch_period(r: u32, ) -> Weight;
+	fn bake_referendum() -> Weight;
+	fn tally_delegations(v: u32, ) -> Weight;
 	fn delegate(r: u32, ) -> Weight;
 	fn undelegate(r: u32, ) -> Weight;
 	fn clear_public_proposals() -> Weight;
@@ -217,28 +222,55 @@ impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
 			.saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(T::DbWeight::get().writes(1 as u64))
 	}
+	// Not benchmarked: estimated from `enact_proposal` and `cancel_queued`, without the
+	// proposal dispatched, which is added from its actual weight.
+	// Storage: Balances TotalIssuance (r:1 w:0)
+	// Storage: Democracy Preimages (r:1 w:1)
+	// Storage: Scheduler Lookup (r:1 w:1)
+	// Storage: Scheduler Agenda (r:1 w:1)
+	// Storage: Democracy ReferendumInfoOf (r:0 w:1)
+	fn bake_referendum() -> Weight {
+		Weight::from_ref_time(28_714_000 as u64)
+			.saturating_add(T::DbWeight::get().reads(4 as u64))
+			.saturating_add(T::DbWeight::get().writes(4 as u64))
+	}
+	// Not benchmarked: estimated from the storage accesses, a voter being decoded per entry.
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
+	// Storage: Democracy VotingOf (r:1 w:0)
+	fn tally_delegations(v: u32, ) -> Weight {
+		Weight::from_ref_time(4_127_000 as u64)
+			// Standard Error: 2_000
+			.saturating_add(Weight::from_ref_time(6_894_000 as u64).saturating_mul(v as u64))
+			.saturating_add(T::DbWeight::get().reads(1 as u64))
+			.saturating_add(T::DbWeight::get().reads((2 as u64).saturating_mul(v as u64)))
+			.saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(v as u64)))
+	}
+	// Not benchmarked: estimated from the former `delegate`, with a read of the `r` voted on
+	// referendums and the delegations of the matured ones applied.
 	// Storage: Democracy VotingOf (r:3 w:3)
+	// Storage: Democracy LowestUnbaked (r:1 w:0)
 	// Storage: Democracy ReferendumInfoOf (r:1 w:1)
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
 	// Storage: Balances Locks (r:1 w:1)
 	fn delegate(r: u32, ) -> Weight {
 		Weight::from_ref_time(37_902_000 as u64)
-			// Standard Error: 4_000
 			.saturating_add(Weight::from_ref_time(4_335_000 as u64).saturating_mul(r as u64))
-			.saturating_add(T::DbWeight::get().reads(4 as u64))
+			.saturating_add(T::DbWeight::get().reads(5 as u64))
 			.saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(T::DbWeight::get().writes(4 as u64))
-			.saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(r as u64)))
 	}
+	// Not benchmarked: estimated from the former `undelegate`, with a read of the `r` voted on
+	// referendums and the delegations of the matured ones applied.
 	// Storage: Democracy VotingOf (r:2 w:2)
+	// Storage: Democracy LowestUnbaked (r:1 w:0)
 	// Storage: Democracy ReferendumInfoOf (r:1 w:1)
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
 	fn undelegate(r: u32, ) -> Weight {
 		Weight::from_ref_time(21_272_000 as u64)
-			// Standard Error: 3_000
 			.saturating_add(Weight::from_ref_time(4_351_000 as u64).saturating_mul(r as u64))
-			.saturating_add(T::DbWeight::get().reads(2 as u64))
+			.saturating_add(T::DbWeight::get().reads(3 as u64))
 			.saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(T::DbWeight::get().writes(2 as u64))
-			.saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(r as u64)))
 	}
 	// Storage: Democracy PublicProps (r:0 w:1)
 	fn clear_public_proposals() -> Weight {
@@ -454,28 +486,55 @@ impl WeightInfo for () {
 			.saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(RocksDbWeight::get().writes(1 as u64))
 	}
+	// Not benchmarked: estimated from `enact_proposal` and `cancel_queued`, without the
+	// proposal dispatched, which is added from its actual weight.
+	// Storage: Balances TotalIssuance (r:1 w:0)
+	// Storage: Democracy Preimages (r:1 w:1)
+	// Storage: Scheduler Lookup (r:1 w:1)
+	// Storage: Scheduler Agenda (r:1 w:1)
+	// Storage: Democracy ReferendumInfoOf (r:0 w:1)
+	fn bake_referendum() -> Weight {
+		Weight::from_ref_time(28_714_000 as u64)
+			.saturating_add(RocksDbWeight::get().reads(4 as u64))
+			.saturating_add(RocksDbWeight::get().writes(4 as u64))
+	}
+	// Not benchmarked: estimated from the storage accesses, a voter being decoded per entry.
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
+	// Storage: Democracy VotingOf (r:1 w:0)
+	fn tally_delegations(v: u32, ) -> Weight {
+		Weight::from_ref_time(4_127_000 as u64)
+			// Standard Error: 2_000
+			.saturating_add(Weight::from_ref_time(6_894_000 as u64).saturating_mul(v as u64))
+			.saturating_add(RocksDbWeight::get().reads(1 as u64))
+			.saturating_add(RocksDbWeight::get().reads((2 as u64).saturating_mul(v as u64)))
+			.saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(v as u64)))
+	}
+	// Not benchmarked: estimated from the former `delegate`, with a read of the `r` voted on
+	// referendums and the delegations of the matured ones applied.
 	// Storage: Democracy VotingOf (r:3 w:3)
+	// Storage: Democracy LowestUnbaked (r:1 w:0)
 	// Storage: Democracy ReferendumInfoOf (r:1 w:1)
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
 	// Storage: Balances Locks (r:1 w:1)
 	fn delegate(r: u32, ) -> Weight {
 		Weight::from_ref_time(37_902_000 as u64)
-			// Standard Error: 4_000
 			.saturating_add(Weight::from_ref_time(4_335_000 as u64).saturating_mul(r as u64))
-			.saturating_add(RocksDbWeight::get().reads(4 as u64))
+			.saturating_add(RocksDbWeight::get().reads(5 as u64))
 			.saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(RocksDbWeight::get().writes(4 as u64))
-			.saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(r as u64)))
 	}
+	// Not benchmarked: estimated from the former `undelegate`, with a read of the `r` voted on
+	// referendums and the delegations of the matured ones applied.
 	// Storage: Democracy VotingOf (r:2 w:2)
+	// Storage: Democracy LowestUnbaked (r:1 w:0)
 	// Storage: Democracy ReferendumInfoOf (r:1 w:1)
+	// Storage: Democracy DelegatedVoters (r:1 w:1)
 	fn undelegate(r: u32, ) -> Weight {
 		Weight::from_ref_time(21_272_000 as u64)
-			// Standard Error: 3_000
 			.saturating_add(Weight::from_ref_time(4_351_000 as u64).saturating_mul(r as u64))
-			.saturating_add(RocksDbWeight::get().reads(2 as u64))
+			.saturating_add(RocksDbWeight::get().reads(3 as u64))
 			.saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(r as u64)))
 			.saturating_add(RocksDbWeight::get().writes(2 as u64))
-			.saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(r as u64)))
 	}
 	// Storage: Democracy PublicProps (r:0 w:1)
 	fn clear_public_proposals() -> Weight {
@@ -2,22 +2,27 @@
 
 pub use pallet::*;
 
+pub mod merkle;
 pub mod models;
 pub mod weights;
 
-#[cfg(any(feature = "runtime-benchmarks", test))]
+#[cfg(feature = "runtime-benchmarks")]
 mod benchmarking;
 mod mocks;
+#[cfg(test)]
+mod tests;
 
 #[frame_support::pallet]
 pub mod pallet {
 	use crate::{
-		models::{Distribution, DistributionState, RecipientFund},
+		merkle,
+		models::{Distribution, DistributionState, PendingPrune, RecipientFund},
 		weights::WeightInfo,
 	};
 	use codec::{Codec, FullCodec, MaxEncodedLen};
 	use kylin_support::{
 		abstractions::{
+			block_fold::{clear_prefix_step, BlockFold, FoldStrategy},
 			nonce::Nonce,
 			utils::{
 				increment::{Increment, SafeIncrement},
@@ -142,6 +147,12 @@ pub trait Distributor {
 			recipient_account: T::AccountId,
 			amount: T::Balance,
 		},
+		MerkleRootSet {
+			distribution_id: T::DistributionId,
+			root: T::Hash,
+			number: u32,
+			unclaimed_funds: T::Balance,
+		},
 	}
 
 	#[pallet::error]
@@ -157,6 +168,9 @@ pub trait Distributor {
 		RecipientAlreadyClaimed,
 		RecipientNotFound,
 		UnclaimedFundsRemaining,
+		InvalidProof,
+		MerkleRootAlreadySet,
+		ClaimExceedsFunds,
 	}
 
 	#[pallet::config]
@@ -211,6 +225,15 @@ pub trait Distributor {
 		#[pallet::constant]
 		type Stake: Get<BalanceOf<Self>>;
 
+		/// Maximum number of recipient entries removed per step of a Distribution pruning.
+		#[pallet::constant]
+		type DeletionChunkSize: Get<u32>;
+
+		/// Maximum number of hashes in the proof of a Merkle claim, the depth of the deepest tree
+		/// a Distribution can commit to.
+		#[pallet::constant]
+		type MaxProofLen: Get<u32>;
+
 		/// The implementation of extrinsic weights.
 		type WeightInfo: WeightInfo;
 	}
@@ -263,6 +286,39 @@ pub trait Distributor {
 		OptionQuery,
 	>;
 
+	/// Merkle roots of the recipient funds of Distributions set up with `set_merkle_root`.
+	#[pallet::storage]
+	#[pallet::getter(fn merkle_roots)]
+	pub type MerkleRoots<T: Config> =
+		StorageMap<_, Blake2_128Concat, T::DistributionId, T::Hash, OptionQuery>;
+
+	/// Claims of Merkle Distributions, one bit per leaf index.
+	#[pallet::storage]
+	#[pallet::getter(fn claimed_bitmap)]
+	#[allow(clippy::disallowed_types)] // Allow `frame_support::pallet_prelude::ValueQuery` because default of 0 is correct
+	pub type ClaimedBitmap<T: Config> = StorageDoubleMap<
+		_,
+		Blake2_128Concat,
+		T::DistributionId,
+		Twox64Concat,
+		u32,
+		u128,
+		ValueQuery,
+	>;
+
+	/// Recipient data of pruned Distributions left to be removed in `on_idle`.
+	#[pallet::storage]
+	#[pallet::getter(fn pending_prunes)]
+	pub type PendingPrunes<T: Config> =
+		StorageMap<_, Blake2_128Concat, T::DistributionId, PendingPrune, OptionQuery>;
+
+	#[pallet::hooks]
+	impl<T: Config> Hooks<BlockNumberFor<T>> for Pallet<T> {
+		fn on_idle(_n: BlockNumberFor<T>, remaining_weight: Weight) -> Weight {
+			Self::process_pending_prunes(remaining_weight)
+		}
+	}
+
 	#[pallet::call]
 	impl<T: Config> Pallet<T> {
 		/// Create a new Distribution. This requires that the user puts down a stake in PICA.
@@ -429,6 +485,79 @@ pub trait Distributor {
 			
 			<Self as Distributor>::claim(distribution_id, reward_account.clone(), reward_account)
 		}
+
+		/// Commit the recipient funds of a Distribution as the `root` of a Merkle tree, instead
+		/// of adding each recipient with `add_recipient`.
+		///
+		/// Each leaf is the hash of `(index, account, amount)`, `index` being unique in
+		/// `0..total_recipients`, and pairs of nodes are hashed in sorted order.
+		///
+		/// Only callable by the origin that created the Distribution.
+		///
+		/// # Parameter Sources
+		/// * `distribution_id` - user selected, provided by the system
+		/// * `root` - user provided
+		/// * `total_funds` - user provided, sum of the amounts of the leaves
+		/// * `total_recipients` - user provided, number of leaves
+		///
+		/// # Emits
+		/// * `MerkleRootSet`
+		///
+		/// # Errors
+		/// * `DistributionDoesNotExist` - No Distribution exist that is associated 'distribution_id'
+		/// * `NotDistributionCreator` - Signer of the origin is not the creator of the Distribution
+		/// * `MerkleRootAlreadySet` - The Distribution already has recipients
+		#[pallet::weight(<T as Config>::WeightInfo::set_merkle_root())]
+		#[transactional]
+		pub fn set_merkle_root(
+			origin: OriginFor<T>,
+			distribution_id: T::DistributionId,
+			root: T::Hash,
+			total_funds: BalanceOf<T>,
+			total_recipients: u32,
+		) -> DispatchResult {
+			let origin_id = ensure_signed(origin)?;
+
+			Self::do_set_merkle_root(origin_id, distribution_id, root, total_funds, total_recipients)
+		}
+
+		/// Claim the funds of a recipient of a Merkle Distribution with a proof of its leaf.
+		///
+		/// Merkle recipients are not vested, the whole `amount` is claimed at once. If no more
+		/// funds are left to claim, the Distribution will be removed.
+		///
+		/// Callable by any unsigned origin.
+		///
+		/// # Parameter Sources
+		/// * `distribution_id` - user selected, provided by the system
+		/// * `index`, `reward_account`, `amount` - leaf of the recipient
+		/// * `proof` - sibling hashes from the leaf up to the root
+		///
+		/// # Emits
+		/// * `Claimed`
+		/// * `DistributionEnded`
+		///
+		/// # Errors
+		/// * `DistributionDoesNotExist` - No Merkle Distribution is associated 'distribution_id'
+		/// * `DistributionIsNotEnabled` - The Distribution has not been enabled
+		/// * `RecipientNotFound` - The index is not one of the committed recipients
+		/// * `InvalidProof` - The proof does not match the Merkle root
+		/// * `RecipientAlreadyClaimed` - The leaf has already been claimed
+		/// * `ClaimExceedsFunds` - The amount is more than the unclaimed funds
+		#[pallet::weight(<T as Config>::WeightInfo::claim_with_proof(proof.len() as u32))]
+		#[transactional]
+		pub fn claim_with_proof(
+			origin: OriginFor<T>,
+			distribution_id: T::DistributionId,
+			index: u32,
+			reward_account: T::AccountId,
+			amount: BalanceOf<T>,
+			proof: BoundedVec<T::Hash, T::MaxProofLen>,
+		) -> DispatchResult {
+			ensure_none(origin)?;
+
+			Self::do_claim_with_proof(distribution_id, index, reward_account, amount, &proof)
+		}
 	}
 
 	#[pallet::extra_constants]
@@ -488,6 +617,165 @@ pub trait Distributor {
 				.map_err(|_| Error::<T>::RecipientNotFound)
 		}
 
+		/// Transfers to the Distribution account what it misses to supply `total_funds` in claims,
+		/// from the account of the creator.
+		pub(crate) fn fund_distribution(
+			distribution_id: T::DistributionId,
+			distribution: &DistributionOf<T>,
+			total_funds: T::Balance,
+		) -> DispatchResult {
+			let distribution_account = Self::get_distribution_account_id(distribution_id);
+			// Funds currently owned by the Distribution minus the creation stake
+			let current_funds = T::RecipientFundAsset::balance(&distribution_account)
+				.safe_sub(&T::Stake::get())?;
+
+			// If the distribution can't support the total amount of claimable funds
+			if current_funds < total_funds {
+				// Fund Distribution account from creators account
+				T::RecipientFundAsset::transfer(
+					&distribution.creator,
+					&distribution_account,
+					total_funds.safe_sub(&current_funds)?,
+					false,
+				)?;
+			}
+
+			Ok(())
+		}
+
+		/// Commits the recipient funds of a Distribution as a Merkle root.
+		///
+		/// # Errors
+		/// * `DistributionDoesNotExist` - No Distribution exist that is associated 'distribution_id'
+		/// * `NotDistributionCreator` - Signer of the origin is not the creator of the Distribution
+		/// * `MerkleRootAlreadySet` - The Distribution already has recipients
+		pub(crate) fn do_set_merkle_root(
+			origin_id: AccountIdOf<T>,
+			distribution_id: T::DistributionId,
+			root: T::Hash,
+			total_funds: T::Balance,
+			total_recipients: u32,
+		) -> DispatchResult {
+			let distribution = Self::get_distribution(&distribution_id)?;
+			ensure!(distribution.creator == origin_id, Error::<T>::NotDistributionCreator);
+			ensure!(
+				distribution.total_recipients == 0 &&
+					!MerkleRoots::<T>::contains_key(distribution_id),
+				Error::<T>::MerkleRootAlreadySet
+			);
+
+			Self::fund_distribution(distribution_id, &distribution, total_funds)?;
+
+			MerkleRoots::<T>::insert(distribution_id, root);
+			Distributions::<T>::try_mutate(distribution_id, |distribution| match distribution.as_mut() {
+				Some(distribution) => {
+					distribution.total_funds = total_funds;
+					distribution.total_recipients = total_recipients;
+					Ok(())
+				},
+				None => Err(Error::<T>::DistributionDoesNotExist),
+			})?;
+
+			Self::deposit_event(Event::MerkleRootSet {
+				distribution_id,
+				root,
+				number: total_recipients,
+				unclaimed_funds: total_funds,
+			});
+
+			Ok(())
+		}
+
+		/// Returns `true` if the leaf at `index` of a Merkle Distribution has been claimed.
+		pub fn is_claimed(distribution_id: T::DistributionId, index: u32) -> bool {
+			let (word, bit) = merkle::bitmap_position(index);
+			ClaimedBitmap::<T>::get(distribution_id, word) & bit != 0
+		}
+
+		/// Checks that a leaf of a Merkle Distribution can be claimed.
+		///
+		/// # Errors
+		/// * `DistributionDoesNotExist` - No Merkle Distribution is associated 'distribution_id'
+		/// * `DistributionIsNotEnabled` - The Distribution has not been enabled
+		/// * `RecipientNotFound` - The index is not one of the committed recipients
+		/// * `RecipientAlreadyClaimed` - The leaf has already been claimed
+		/// * `ClaimExceedsFunds` - The amount is more than the unclaimed funds
+		/// * `InvalidProof` - The proof does not match the Merkle root
+		pub(crate) fn check_merkle_claim(
+			distribution_id: T::DistributionId,
+			index: u32,
+			reward_account: &AccountIdOf<T>,
+			amount: &T::Balance,
+			proof: &[T::Hash],
+		) -> Result<(), Error<T>> {
+			let root =
+				MerkleRoots::<T>::get(distribution_id).ok_or(Error::<T>::DistributionDoesNotExist)?;
+			ensure!(
+				Self::get_distribution_state(distribution_id)? == DistributionState::Enabled,
+				Error::<T>::DistributionIsNotEnabled
+			);
+			let distribution = Self::get_distribution(&distribution_id)?;
+			ensure!(index < distribution.total_recipients, Error::<T>::RecipientNotFound);
+			ensure!(!Self::is_claimed(distribution_id, index), Error::<T>::RecipientAlreadyClaimed);
+			// A root committing to more than `total_funds` cannot drain the stake or other claims
+			let claimed_funds =
+				distribution.claimed_funds.safe_add(amount).map_err(|_| Error::<T>::ArithmiticError)?;
+			ensure!(claimed_funds <= distribution.total_funds, Error::<T>::ClaimExceedsFunds);
+
+			let leaf = merkle::leaf::<T, _>(index, reward_account, amount);
+			ensure!(merkle::verify::<T>(root, leaf, proof), Error::<T>::InvalidProof);
+
+			Ok(())
+		}
+
+		/// Claims the funds of a leaf of a Merkle Distribution.
+		///
+		/// # Errors
+		/// * See [`check_merkle_claim`](Self::check_merkle_claim)
+		/// * `ArithmiticError` - Overflow while totaling claimed funds
+		pub(crate) fn do_claim_with_proof(
+			distribution_id: T::DistributionId,
+			index: u32,
+			reward_account: AccountIdOf<T>,
+			amount: T::Balance,
+			proof: &[T::Hash],
+		) -> DispatchResult {
+			Self::check_merkle_claim(distribution_id, index, &reward_account, &amount, proof)?;
+
+			let (word, bit) = merkle::bitmap_position(index);
+			ClaimedBitmap::<T>::mutate(distribution_id, word, |claimed| *claimed |= bit);
+
+			T::RecipientFundAsset::transfer(
+				&Self::get_distribution_account_id(distribution_id),
+				&reward_account,
+				amount,
+				false,
+			)?;
+
+			Distributions::<T>::try_mutate(distribution_id, |distribution| match distribution.as_mut() {
+				Some(distribution) => {
+					distribution.claimed_funds = distribution
+						.claimed_funds
+						.safe_add(&amount)
+						.map_err(|_| Error::<T>::ArithmiticError)?;
+					Ok(())
+				},
+				None => Err(Error::<T>::DistributionDoesNotExist),
+			})?;
+
+			Self::deposit_event(Event::Claimed {
+				identity: reward_account.clone(),
+				recipient_account: reward_account,
+				amount,
+			});
+
+			if Self::prune_distribution(distribution_id)? {
+				Self::deposit_event(Event::DistributionEnded { distribution_id, at: T::Time::now() })
+			}
+
+			Ok(())
+		}
+
 
 		/// Start an Distribution at a given moment.
 		///
@@ -580,19 +868,67 @@ pub trait Distributor {
 				false,
 			)?;
 
-			// Remove Distribution and associated data from storage
-
-			// NOTE(hussein-aitlahcen): this is deprecated, but the new API state in the doc that we
-			// can have an infinite limit. while the new `clear_prefix` signature doesn't match this
-			// definition (force u32 as limit). Missing feature or limit is forced? Who know.
-			#[allow(deprecated)]
-			RecipientFunds::<T>::remove_prefix(distribution_id, None);
-			#[allow(deprecated)]
-			Associations::<T>::remove_prefix(distribution_id, None);
+			// Remove Distribution from storage, the recipient data is unbounded and removed in
+			// chunks by `on_idle`
+			let fold = BlockFold::new(FoldStrategy::new_chunk(T::DeletionChunkSize::get()), 0);
+			PendingPrunes::<T>::insert(
+				distribution_id,
+				PendingPrune {
+					recipient_funds: fold.clone(),
+					associations: fold.clone(),
+					claimed_bitmap: fold,
+				},
+			);
+			TotalDistributionRecipients::<T>::remove(distribution_id);
+			MerkleRoots::<T>::remove(distribution_id);
 			Distributions::<T>::remove(distribution_id);
 
 			Ok(true)
 		}
+
+		/// Removes the recipient data of pruned Distributions, one chunk at a time, for as long as
+		/// `remaining_weight` allows it.
+		///
+		/// Returns the consumed weight.
+		pub(crate) fn process_pending_prunes(remaining_weight: Weight) -> Weight {
+			let db_weight = T::DbWeight::get();
+			let step_weight = db_weight
+				.reads_writes(1, 1)
+				.saturating_add(db_weight.writes(T::DeletionChunkSize::get() as u64));
+			let mut consumed = db_weight.reads(1);
+
+			while consumed.saturating_add(step_weight).ref_time() <= remaining_weight.ref_time() {
+				let (distribution_id, mut pending) = match PendingPrunes::<T>::iter().next() {
+					Some(next) => next,
+					None => break,
+				};
+				consumed = consumed.saturating_add(step_weight);
+
+				if !matches!(pending.recipient_funds, BlockFold::Done { .. }) {
+					pending.recipient_funds =
+						clear_prefix_step(pending.recipient_funds, |limit, cursor| {
+							RecipientFunds::<T>::clear_prefix(distribution_id, limit, cursor)
+						});
+				} else if !matches!(pending.associations, BlockFold::Done { .. }) {
+					pending.associations = clear_prefix_step(pending.associations, |limit, cursor| {
+						Associations::<T>::clear_prefix(distribution_id, limit, cursor)
+					});
+				} else {
+					pending.claimed_bitmap =
+						clear_prefix_step(pending.claimed_bitmap, |limit, cursor| {
+							ClaimedBitmap::<T>::clear_prefix(distribution_id, limit, cursor)
+						});
+				}
+
+				if matches!(pending.claimed_bitmap, BlockFold::Done { .. }) {
+					PendingPrunes::<T>::remove(distribution_id);
+				} else {
+					PendingPrunes::<T>::insert(distribution_id, pending);
+				}
+			}
+
+			consumed
+		}
 	}
 
 	impl<T: Config> Distributor for Pallet<T> {
@@ -665,6 +1001,10 @@ pub trait Distributor {
 		) -> DispatchResult {
 			let distribution = Self::get_distribution(&distribution_id)?;
 			ensure!(distribution.creator == origin_id, Error::<T>::NotDistributionCreator);
+			ensure!(
+				!MerkleRoots::<T>::contains_key(distribution_id),
+				Error::<T>::MerkleRootAlreadySet
+			);
 
 			// Calculate total funds and recipients local to this transaction
 			let (transaction_funds, transaction_recipients) = recipients.iter().try_fold(
@@ -676,24 +1016,11 @@ pub trait Distributor {
 				},
 			)?;
 
-			// Funds currently owned by the Distribution minus the creation stake
-			let current_funds =
-				T::RecipientFundAsset::balance(&Self::get_distribution_account_id(distribution_id))
-					.safe_sub(&T::Stake::get())?;
 			// Total amount of funds to be required by this Distribution
 			let total_funds = distribution.total_funds.safe_add(&transaction_funds)?;
 			let total_recipients = distribution.total_recipients.safe_add(&transaction_recipients)?;
 
-			// If the distribution can't support the total amount of claimable funds
-			if current_funds < total_funds {
-				// Fund Distribution account from creators account
-				T::RecipientFundAsset::transfer(
-					&distribution.creator,
-					&Self::get_distribution_account_id(distribution_id),
-					total_funds.safe_sub(&current_funds)?,
-					false,
-				)?;
-			}
+			Self::fund_distribution(distribution_id, &distribution, total_funds)?;
 
 			// Populate `RecipientFunds`
 			recipients.iter().for_each(|(identity, funds, vesting_period, is_funded)| {
@@ -953,8 +1280,35 @@ pub trait Distributor {
 						.and_provides(reward_account)
 						.build(),
 				}
+			} else if let Call::claim_with_proof {
+				distribution_id,
+				index,
+				reward_account,
+				amount,
+				proof,
+			} = call
+			{
+				// Validity Error if the leaf cannot be claimed with this proof
+				Self::check_merkle_claim(
+					*distribution_id,
+					*index,
+					reward_account,
+					amount,
+					proof,
+				)
+				.map_err(|e| match e {
+					Error::<T>::DistributionDoesNotExist =>
+						InvalidTransaction::Custom(ValidityError::NotAnDistribution as u8),
+					Error::<T>::DistributionIsNotEnabled =>
+						InvalidTransaction::Custom(ValidityError::NotClaimable as u8),
+					_ => InvalidTransaction::Custom(ValidityError::NoFunds as u8),
+				})?;
+
+				ValidTransaction::with_tag_prefix("DistributionProofCheck")
+					.and_provides((distribution_id, index))
+					.build()
 			} else {
-				// Only allow unsigned transactions for `claim`
+				// Only allow unsigned transactions for `claim` and `claim_with_proof`
 				Err(InvalidTransaction::Call.into())
 			}
 		}
@@ -0,0 +1,53 @@
+//! Merkle tree of the recipient funds of a Distribution, verified with [`proofs::Verifier`].
+
+use codec::Encode;
+use proofs::{hashing::sort_hash_of, Hasher, Verifier};
+use sp_runtime::traits::Hash;
+use sp_std::{marker::PhantomData, vec, vec::Vec};
+
+/// Verifies proofs of a tree hashed with [`Hashing`](frame_system::Config::Hashing), each pair
+/// of nodes being hashed in sorted order.
+pub struct MerkleVerifier<T>(PhantomData<T>);
+
+impl<T> Default for MerkleVerifier<T> {
+	fn default() -> Self {
+		Self(PhantomData)
+	}
+}
+
+impl<T: frame_system::Config> Hasher for MerkleVerifier<T> {
+	type Hash = T::Hash;
+
+	fn hash(data: &[u8]) -> Self::Hash {
+		T::Hashing::hash(data)
+	}
+}
+
+impl<T: frame_system::Config> Verifier for MerkleVerifier<T> {
+	fn hash_of(a: Self::Hash, b: Self::Hash) -> Self::Hash {
+		sort_hash_of::<Self>(a, b)
+	}
+
+	fn initial_matches(&self, doc_root: Self::Hash) -> Option<Vec<Self::Hash>> {
+		Some(vec![doc_root])
+	}
+}
+
+/// Leaf of the recipient at `index`, entitled to `amount`.
+pub fn leaf<T: frame_system::Config, Balance: Encode>(
+	index: u32,
+	account: &T::AccountId,
+	amount: &Balance,
+) -> T::Hash {
+	T::Hashing::hash_of(&(index, account, amount))
+}
+
+/// Returns `true` if `proof` proves `leaf` to be part of the tree of `root`.
+pub fn verify<T: frame_system::Config>(root: T::Hash, leaf: T::Hash, proof: &[T::Hash]) -> bool {
+	MerkleVerifier::<T>::default().verify_proof_slice(root, leaf, proof)
+}
+
+/// Word of the claimed bitmap holding the bit of `index`, and its mask.
+pub fn bitmap_position(index: u32) -> (u32, u128) {
+	(index / u128::BITS, 1u128 << (index % u128::BITS))
+}
@@ -1,6 +1,7 @@
 use codec::{Decode, Encode, MaxEncodedLen};
-use kylin_support::types::{
-	EcdsaSignature, EthereumAddress,
+use kylin_support::{
+	abstractions::block_fold::ClearPrefixFold,
+	types::{EcdsaSignature, EthereumAddress},
 };
 use scale_info::TypeInfo;
 use sp_runtime::{MultiSignature, RuntimeDebug};
@@ -48,6 +49,17 @@ pub enum DistributionState {
 	Disabled,
 } 
 
+/// Removal progress of the recipient data of a pruned [`Distribution`](Distribution).
+#[derive(Debug, Encode, Decode, PartialEq, Eq, Clone, TypeInfo, MaxEncodedLen)]
+pub struct PendingPrune {
+	/// Removal of the `RecipientFunds` of the Distribution.
+	pub recipient_funds: ClearPrefixFold,
+	/// Removal of the `Associations` of the Distribution.
+	pub associations: ClearPrefixFold,
+	/// Removal of the `ClaimedBitmap` of a Merkle Distribution.
+	pub claimed_bitmap: ClearPrefixFold,
+}
+
 #[derive(Debug, Encode, Decode, PartialEq, Eq, Copy, Clone, TypeInfo, MaxEncodedLen)]
 pub enum DistributionDestination {
 	FeedPallet,
@@ -0,0 +1,131 @@
+use crate::{merkle, mocks::*, Error, Event};
+use frame_support::{assert_noop, assert_ok, BoundedVec};
+use proofs::Verifier;
+use sp_core::H256;
+
+const CREATOR: u8 = 1;
+const AMOUNTS: [Balance; 4] = [100, 200, 300, 400];
+
+type MerkleVerifier = merkle::MerkleVerifier<MockRuntime>;
+
+fn recipient(index: u32) -> AccountId {
+	account(index as u8 + 2)
+}
+
+fn leaf(index: u32) -> H256 {
+	merkle::leaf::<MockRuntime, _>(index, &recipient(index), &AMOUNTS[index as usize])
+}
+
+/// Root of the four leaves of `AMOUNTS`.
+fn root() -> H256 {
+	MerkleVerifier::hash_of(
+		MerkleVerifier::hash_of(leaf(0), leaf(1)),
+		MerkleVerifier::hash_of(leaf(2), leaf(3)),
+	)
+}
+
+fn proof(index: u32) -> BoundedVec<H256, frame_support::traits::ConstU32<4>> {
+	let pair = index ^ 1;
+	let other = if index < 2 { (2, 3) } else { (0, 1) };
+	vec![leaf(pair), MerkleVerifier::hash_of(leaf(other.0), leaf(other.1))].try_into().unwrap()
+}
+
+/// Enabled Distribution committed to `root()`, with `total_funds` for `total_recipients`.
+fn merkle_distribution(total_funds: Balance, total_recipients: u32) -> DistributionId {
+	assert_ok!(Distribution::create_distribution(RuntimeOrigin::signed(account(CREATOR)), None, 0));
+	let distribution_id = Distribution::distribution_count();
+	assert_ok!(Distribution::set_merkle_root(
+		RuntimeOrigin::signed(account(CREATOR)),
+		distribution_id,
+		root(),
+		total_funds,
+		total_recipients
+	));
+	assert_ok!(Distribution::enable_distribution(
+		RuntimeOrigin::signed(account(CREATOR)),
+		distribution_id
+	));
+	distribution_id
+}
+
+fn claim(distribution_id: DistributionId, index: u32) -> frame_support::dispatch::DispatchResult {
+	Distribution::claim_with_proof(
+		RuntimeOrigin::none(),
+		distribution_id,
+		index,
+		recipient(index),
+		AMOUNTS[index as usize],
+		proof(index),
+	)
+}
+
+fn new_test_ext() -> sp_io::TestExternalities {
+	let mut ext = ExtBuilder { balances: vec![(account(CREATOR), 2 * STAKE)] }.build();
+	ext.execute_with(|| System::set_block_number(1));
+	ext
+}
+
+#[test]
+fn a_leaf_is_claimed_with_its_proof() {
+	new_test_ext().execute_with(|| {
+		let distribution_id = merkle_distribution(AMOUNTS.iter().sum(), 4);
+
+		assert_ok!(claim(distribution_id, 1));
+		assert_eq!(Balances::free_balance(recipient(1)), AMOUNTS[1]);
+		assert_eq!(Distribution::distributions(distribution_id).unwrap().claimed_funds, AMOUNTS[1]);
+		System::assert_last_event(
+			Event::<MockRuntime>::Claimed {
+				identity: recipient(1),
+				recipient_account: recipient(1),
+				amount: AMOUNTS[1],
+			}
+			.into(),
+		);
+
+		// The proof of another leaf does not prove this one
+		assert_noop!(
+			Distribution::claim_with_proof(
+				RuntimeOrigin::none(),
+				distribution_id,
+				0,
+				recipient(0),
+				AMOUNTS[0],
+				proof(2),
+			),
+			Error::<MockRuntime>::InvalidProof
+		);
+	});
+}
+
+#[test]
+fn a_leaf_is_claimed_once() {
+	new_test_ext().execute_with(|| {
+		let distribution_id = merkle_distribution(AMOUNTS.iter().sum(), 4);
+
+		assert_ok!(claim(distribution_id, 2));
+		assert!(Distribution::is_claimed(distribution_id, 2));
+		assert!(!Distribution::is_claimed(distribution_id, 3));
+		assert_eq!(Distribution::claimed_bitmap(distribution_id, 0), 1 << 2);
+		assert_noop!(claim(distribution_id, 2), Error::<MockRuntime>::RecipientAlreadyClaimed);
+
+		// The last claim ends the Distribution
+		for index in [0, 1, 3] {
+			assert_ok!(claim(distribution_id, index));
+		}
+		assert!(Distribution::distributions(distribution_id).is_none());
+		assert_noop!(claim(distribution_id, 2), Error::<MockRuntime>::DistributionDoesNotExist);
+	});
+}
+
+#[test]
+fn claims_are_bounded_by_the_committed_totals() {
+	new_test_ext().execute_with(|| {
+		// The tree has a fourth leaf, and more funds than committed
+		let distribution_id = merkle_distribution(AMOUNTS[0] + AMOUNTS[1], 3);
+
+		assert_noop!(claim(distribution_id, 3), Error::<MockRuntime>::RecipientNotFound);
+		assert_noop!(claim(distribution_id, 2), Error::<MockRuntime>::ClaimExceedsFunds);
+		assert_ok!(claim(distribution_id, 0));
+		assert_ok!(claim(distribution_id, 1));
+	});
+}
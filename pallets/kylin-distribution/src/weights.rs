@@ -11,6 +11,8 @@ pub trait WeightInfo {
 	fn enable_distribution() -> Weight;
 	fn disable_distribution() -> Weight;
 	fn claim(x: u32) -> Weight;
+	fn set_merkle_root() -> Weight;
+	fn claim_with_proof(p: u32) -> Weight;
 }
 
 pub struct SubstrateWeight<T>(PhantomData<T>);
@@ -50,5 +52,73 @@ impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
 		.saturating_add(T::DbWeight::get().reads(3 as u64))
 		.saturating_add(T::DbWeight::get().writes(3 as u64))
 	}
+
+	// Not benchmarked: estimated from `add_recipient`, with the funding transfer, the root and
+	// the Distribution.
+	fn set_merkle_root() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(T::DbWeight::get().reads(3 as u64))
+		.saturating_add(T::DbWeight::get().writes(3 as u64))
+	}
+
+	// Not benchmarked: estimated from `claim`, with a hash per node of the `p` long proof and the
+	// root, Distribution, bitmap word and transfer accesses.
+	fn claim_with_proof(p: u32) -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(Weight::from_ref_time(1_000_000).saturating_mul(p as u64))
+		.saturating_add(T::DbWeight::get().reads(4 as u64))
+		.saturating_add(T::DbWeight::get().writes(3 as u64))
+	}
 }
 
+// For tests
+impl WeightInfo for () {
+	fn create_distribution() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn add_recipient(_x: u32) -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn remove_recipient() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn enable_distribution() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn disable_distribution() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn claim(_x: u32) -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn set_merkle_root() -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(RocksDbWeight::get().reads(3 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+
+	fn claim_with_proof(p: u32) -> Weight {
+		Weight::from_ref_time(66_168_000)
+		.saturating_add(Weight::from_ref_time(1_000_000).saturating_mul(p as u64))
+		.saturating_add(RocksDbWeight::get().reads(4 as u64))
+		.saturating_add(RocksDbWeight::get().writes(3 as u64))
+	}
+}
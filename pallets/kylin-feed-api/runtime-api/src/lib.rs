@@ -0,0 +1,32 @@
+//! Runtime API of the Kylin Feed API pallet.
+#![cfg_attr(not(feature = "std"), no_std)]
+#![allow(clippy::too_many_arguments)]
+#![allow(clippy::unnecessary_mut_passed)]
+
+use codec::{Codec, Decode, Encode};
+use kylin_primitives::types::{CollectionId, NftId};
+use scale_info::TypeInfo;
+use sp_runtime::RuntimeDebug;
+use sp_std::vec::Vec;
+
+/// Feed NFT of an oracle key.
+#[derive(Encode, Decode, RuntimeDebug, Eq, PartialEq, Clone, TypeInfo)]
+pub struct FeedDetails<AccountId> {
+	pub collection_id: CollectionId,
+	pub nft_id: NftId,
+	/// Root owner of the feed NFT.
+	pub owner: AccountId,
+	/// Latest combined value of the key and its timestamp, if any.
+	pub value: Option<(i64, u128)>,
+}
+
+sp_api::decl_runtime_apis! {
+	pub trait KylinFeedApi<AccountId>
+	where
+		AccountId: Codec,
+	{
+		/// Resolve an oracle key to its feed NFT in a collection, the owner of the NFT and the
+		/// latest value.
+		fn feed_by_key(collection_id: CollectionId, key: Vec<u8>) -> Option<FeedDetails<AccountId>>;
+	}
+}
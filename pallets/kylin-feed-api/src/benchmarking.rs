@@ -1,20 +1,167 @@
-//! Benchmarking setup for pallet-template
+//! Benchmarks of the Kylin Feed API pallet.
+//!
+//! Feed NFTs are nested in other feed NFTs down to `MaxRecursions`, the depth the root owner
+//! lookups depend on, and moved with up to `MaxDescendants` descendants, whose ancestries a
+//! transfer rewrites.
 
 use super::*;
 
-#[allow(unused)]
-use crate::Pallet as Template;
+use crate::Pallet as KylinFeedApi;
 use frame_benchmarking::{benchmarks, whitelisted_caller};
+use frame_support::traits::Currency;
 use frame_system::RawOrigin;
+use sp_runtime::traits::Bounded;
+
+/// Parachain the XCM calls come from, and the oracle parachain of the feeds.
+const SIBLING: u32 = 2000;
+
+type DepositBalanceOf<T> = <<T as pallet_uniques::Config>::Currency as Currency<
+	<T as frame_system::Config>::AccountId,
+>>::Balance;
+
+fn feed_key(i: u32) -> Vec<u8> {
+	let mut key = b"benchmark_feed_".to_vec();
+	key.extend_from_slice(&i.to_le_bytes());
+	key
+}
+
+/// Fund `owner` and create a collection it issues.
+fn collection<T: Config>(owner: &T::AccountId) -> CollectionId
+where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	<T as pallet_uniques::Config>::Currency::make_free_balance_be(
+		owner,
+		DepositBalanceOf::<T>::max_value() / 2u32.into(),
+	);
+	let collection_id = KylinFeedApi::<T>::collection_index();
+	KylinFeedApi::<T>::create_collection(
+		RawOrigin::Signed(owner.clone()).into(),
+		Default::default(),
+		None,
+		Default::default(),
+	)
+	.expect("collection is created");
+	collection_id
+}
+
+/// Create the feed of `feed_key(i)` in `collection_id`.
+fn feed<T: Config>(owner: &T::AccountId, collection_id: CollectionId, i: u32) -> NftId
+where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	let nft_id = KylinFeedApi::<T>::next_nft_id(collection_id);
+	KylinFeedApi::<T>::create_feed(
+		RawOrigin::Signed(owner.clone()).into(),
+		collection_id,
+		SIBLING,
+		feed_key(i),
+		b"https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".to_vec(),
+		b"/btc_usd".to_vec(),
+	)
+	.expect("feed is created");
+	nft_id
+}
+
+/// Create a chain of `depth + 1` feeds from `feed_key(first)` on, each nested in the previous
+/// one, and return the root and the leaf of the chain.
+fn nested_feeds<T: Config>(
+	owner: &T::AccountId,
+	collection_id: CollectionId,
+	first: u32,
+	depth: u32,
+) -> (NftId, NftId)
+where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	let root = feed::<T>(owner, collection_id, first);
+	let mut parent = root;
+	for i in 1..=depth {
+		let child = feed::<T>(owner, collection_id, first + i);
+		KylinFeedApi::<T>::send(
+			RawOrigin::Signed(owner.clone()).into(),
+			collection_id,
+			child,
+			AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, parent),
+		)
+		.expect("feed is nested");
+		parent = child;
+	}
+	(root, parent)
+}
 
 benchmarks! {
-	do_something {
-		let s in 0 .. 100;
+	where_clause { where
+		T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+		<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+		<T as frame_system::Config>::RuntimeOrigin: From<CumulusOrigin>,
+	}
+
+	create_feed {
+		let caller: T::AccountId = whitelisted_caller();
+		let collection_id = collection::<T>(&caller);
+		let url = b"https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".to_vec();
+	}: _(RawOrigin::Signed(caller), collection_id, SIBLING, feed_key(0), url, b"/btc_usd".to_vec())
+	verify {
+		let key: StringLimitOf<T> = feed_key(0).try_into().expect("key fits in StringLimit");
+		assert!(FeedsByKey::<T>::contains_key(collection_id, key));
+	}
+
+	// The children of a burned feed are burned in `on_idle`, the burn itself only depends on
+	// the depth of the feed.
+	remove_feed {
+		let d in 0 .. T::MaxRecursions::get();
+		let caller: T::AccountId = whitelisted_caller();
+		let collection_id = collection::<T>(&caller);
+		let (_, leaf) = nested_feeds::<T>(&caller, collection_id, 0, d);
+	}: _(RawOrigin::Signed(caller), collection_id, leaf)
+	verify {
+		assert!(PendingBurns::<T>::contains_key((collection_id, leaf)));
+	}
+
+	// The benchmark environment has no channel open to the sibling, sending the answer fails
+	// once every read of the query is done. The queued message is accounted for in the weights.
+	query_feed {
+		let owner = KylinFeedApi::<T>::paraid_to_account_id::<T::AccountId>(ParaId::from(SIBLING));
+		let collection_id = collection::<T>(&owner);
+		let nft_id = feed::<T>(&owner, collection_id, 0);
+		let key: OracleKeyOf<T> = feed_key(0).try_into().expect("key fits in StrLimit");
+		kylin_oracle::Values::<T>::insert(&key, kylin_oracle::TimestampedValue { value: 1, timestamp: 0 });
+		let origin: <T as frame_system::Config>::RuntimeOrigin =
+			CumulusOrigin::SiblingParachain(ParaId::from(SIBLING)).into();
+	}: {
+		let _ = KylinFeedApi::<T>::xcm_query_feed(origin, collection_id, nft_id);
+	}
+
+	// Nesting a feed rewrites the ancestry of each of its `d` descendants, nested here directly
+	// in the feed so that `d` goes up to `MaxDescendants` whatever `MaxRecursions`.
+	send {
+		let d in 0 .. T::MaxDescendants::get();
 		let caller: T::AccountId = whitelisted_caller();
-	}: _(RawOrigin::Signed(caller), s)
+		let collection_id = collection::<T>(&caller);
+		let parent = feed::<T>(&caller, collection_id, 0);
+		let root = feed::<T>(&caller, collection_id, 1);
+		for i in 0..d {
+			let child = feed::<T>(&caller, collection_id, 2 + i);
+			KylinFeedApi::<T>::send(
+				RawOrigin::Signed(caller.clone()).into(),
+				collection_id,
+				child,
+				AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, root),
+			)
+			.expect("feed is nested");
+		}
+		let new_owner = AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, parent);
+	}: _(RawOrigin::Signed(caller), collection_id, root, new_owner)
 	verify {
-		assert_eq!(Something::<T>::get(), Some(s));
+		assert_eq!(Ancestors::<T>::get(collection_id, root).to_vec(), vec![(collection_id, parent)]);
+		for (child, _) in Children::<T>::iter_prefix((collection_id, root)) {
+			assert_eq!(Ancestors::<T>::get(child.0, child.1).len(), 2);
+		}
 	}
 
-	impl_benchmark_test_suite!(Template, crate::mock::new_test_ext(), crate::mock::Test);
+	impl_benchmark_test_suite!(KylinFeedApi, crate::mock::new_test_ext(), crate::mock::Test);
 }
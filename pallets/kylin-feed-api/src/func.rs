@@ -3,6 +3,7 @@
 use super::*;
 use codec::{Codec, Decode, Encode};
 use frame_support::traits::tokens::Locker;
+use kylin_support::abstractions::block_fold::{clear_prefix_step, BlockFold, FoldStrategy};
 use sp_runtime::{
     traits::{Saturating, TrailingZeroInput},
     ArithmeticError,
@@ -64,14 +65,13 @@ impl<T: Config> Pallet<T>
         collection_id: CollectionId,
         nft_id: NftId,
     ) -> Result<(T::AccountId, (CollectionId, NftId)), Error<T>> {
-        let parent = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id);
-        parent.as_ref().ok_or(Error::<T>::NoAvailableNftId)?;
-
-        let owner = parent.unwrap();
-        match Self::decode_nft_account_id::<T::AccountId>(owner.clone()) {
-            None => Ok((owner, (collection_id, nft_id))),
-            Some((cid, nid)) => Pallet::<T>::lookup_root_owner(cid, nid),
-        }
+        let root = Ancestors::<T>::get(collection_id, nft_id)
+            .first()
+            .copied()
+            .unwrap_or((collection_id, nft_id));
+        let owner = pallet_uniques::Pallet::<T>::owner(root.0, root.1)
+            .ok_or(Error::<T>::NoAvailableNftId)?;
+        Ok((owner, root))
     }
 
     pub fn decode_nft_account_id<AccountId: Codec>(
@@ -105,29 +105,17 @@ impl<T: Config> Pallet<T>
         parent_collection_id: CollectionId,
         parent_nft_id: NftId,
     ) -> bool {
-        let mut found_child = false;
+        Ancestors::<T>::get(child_collection_id, child_nft_id)
+            .contains(&(parent_collection_id, parent_nft_id))
+    }
 
-        let parent = pallet_uniques::Pallet::<T>::owner(child_collection_id, child_nft_id);
-        if parent.is_none() {
-            return found_child
-        }
-        let owner = parent.as_ref().unwrap();
-        match Self::decode_nft_account_id::<T::AccountId>(owner.clone()) {
-            None => found_child,
-            Some((cid, nid)) => {
-                if (cid, nid) == (parent_collection_id, parent_nft_id) {
-                    found_child = true
-                } else {
-                    found_child = Pallet::<T>::is_x_descendent_of_y(
-                        cid,
-                        nid,
-                        parent_collection_id,
-                        parent_nft_id,
-                    )
-                }
-                found_child
-            },
-        }
+    /// Whether `nft` or one of its ancestors is burned, its subtree then waiting in
+    /// `PendingBurns` to be removed in `on_idle`.
+    pub fn is_burning(collection_id: CollectionId, nft_id: NftId) -> bool {
+        PendingBurns::<T>::contains_key((collection_id, nft_id)) ||
+            Ancestors::<T>::get(collection_id, nft_id)
+                .iter()
+                .any(|ancestor| PendingBurns::<T>::contains_key(ancestor))
     }
 
     pub fn get_next_nft_id(collection_id: CollectionId) -> Result<NftId, Error<T>> {
@@ -237,6 +225,151 @@ impl<T: Config> Pallet<T>
 
 }
 
+impl<T: Config> Pallet<T> {
+    /// Remove an NFT and queue the removal of its resources and children, which are unbounded,
+    /// to `on_idle`.
+    pub fn do_burn_nft(collection_id: CollectionId, nft_id: NftId) -> DispatchResult {
+        ensure!(Collections::<T>::contains_key(collection_id), Error::<T>::CollectionUnknown);
+
+        Self::burn_nft(collection_id, nft_id);
+        Ok(())
+    }
+
+    /// Remove an NFT and queue the removal of its resources and children, whether or not its
+    /// collection is still known, so that a burn step cannot fail halfway through a subtree.
+    fn burn_nft(collection_id: CollectionId, nft_id: NftId) {
+        if let Some(nft) = Self::nfts(collection_id, nft_id) {
+            if let AccountIdOrCollectionNftTuple::CollectionAndNftTuple(parent_col, parent_nft) =
+            nft.owner
+            {
+                Children::<T>::remove((parent_col, parent_nft), (collection_id, nft_id));
+            }
+        }
+
+        Nfts::<T>::remove(collection_id, nft_id);
+        Ancestors::<T>::remove(collection_id, nft_id);
+        PendingTransfers::<T>::remove(collection_id, nft_id);
+        if let Some(feed) = FeedMetadata::<T>::take(collection_id, nft_id) {
+            FeedsByKey::<T>::remove(collection_id, &feed.key);
+        }
+
+        let fold = BlockFold::new(FoldStrategy::new_chunk(T::DeletionChunkSize::get()), 0);
+        PendingBurns::<T>::insert((collection_id, nft_id), fold);
+
+        Collections::<T>::mutate(collection_id, |collection| {
+            if let Some(collection) = collection {
+                collection.nfts_count.saturating_dec();
+            }
+        });
+    }
+
+    /// Record `parent` as the new parent of `nft` and rewrite the ancestry of its descendants,
+    /// so that root owner lookups and cycle checks are a single read whatever the nesting depth.
+    ///
+    /// # Errors
+    /// * `TooManyRecursions` - a descendant would be nested deeper than `MaxRecursions`
+    /// * `TooManyDescendants` - `nft` has more than `max_descendants` descendants
+    pub fn set_ancestry(
+        nft: (CollectionId, NftId),
+        parent: Option<(CollectionId, NftId)>,
+        max_descendants: u32,
+    ) -> DispatchResult {
+        let ancestors = match parent {
+            None => AncestorsOf::<T>::default(),
+            Some(parent) => {
+                let mut ancestors = Ancestors::<T>::get(parent.0, parent.1);
+                ancestors.try_push(parent).map_err(|_| Error::<T>::TooManyRecursions)?;
+                ancestors
+            },
+        };
+
+        let mut descendants = 0u32;
+        let mut pending = Vec::new();
+        pending.push((nft, ancestors));
+        while let Some((nft, ancestors)) = pending.pop() {
+            for (child, _) in Children::<T>::iter_prefix(nft) {
+                descendants = descendants.saturating_add(1);
+                ensure!(descendants <= max_descendants, Error::<T>::TooManyDescendants);
+                let mut child_ancestors = ancestors.clone();
+                child_ancestors.try_push(nft).map_err(|_| Error::<T>::TooManyRecursions)?;
+                pending.push((child, child_ancestors));
+            }
+            if ancestors.is_empty() {
+                Ancestors::<T>::remove(nft.0, nft.1);
+            } else {
+                Ancestors::<T>::insert(nft.0, nft.1, ancestors);
+            }
+        }
+
+        Ok(())
+    }
+
+    /// Move `nft` from the NFT owning `current_owner`, if any, to `new_parent`, or to an account
+    /// when `None`, and rewrite the ancestry of its subtree.
+    ///
+    /// # Errors
+    /// * `TooManyRecursions` - a descendant would be nested deeper than `MaxRecursions`
+    /// * `TooManyDescendants` - `nft` has more than `MaxDescendants` descendants
+    fn move_nft(
+        nft: (CollectionId, NftId),
+        current_owner: Option<T::AccountId>,
+        new_parent: Option<(CollectionId, NftId)>,
+    ) -> DispatchResult {
+        if let Some(current_owner) = current_owner {
+            if let Some(current_parent) = Self::decode_nft_account_id::<T::AccountId>(current_owner) {
+                Self::remove_child(current_parent, nft);
+            }
+        }
+        if let Some(new_parent) = new_parent {
+            Self::add_child(new_parent, nft);
+        }
+        Self::set_ancestry(nft, new_parent, T::MaxDescendants::get())
+    }
+
+    /// Remove the resources, then burn the children, of burned NFTs one chunk at a time, for as
+    /// long as `remaining_weight` allows it.
+    ///
+    /// Returns the consumed weight.
+    pub fn process_pending_burns(remaining_weight: Weight) -> Weight {
+        let db_weight = T::DbWeight::get();
+        let chunk = T::DeletionChunkSize::get().max(1);
+        // A chunk is either `chunk` resources removed or `chunk` children burned
+        let step_weight = db_weight
+            .reads_writes(1, 1)
+            .saturating_add(db_weight.reads_writes(3, 6).saturating_mul(chunk as u64));
+        let mut consumed = db_weight.reads(1);
+
+        while consumed.saturating_add(step_weight).ref_time() <= remaining_weight.ref_time() {
+            let (nft, fold) = match PendingBurns::<T>::iter().next() {
+                Some(next) => next,
+                None => break,
+            };
+            consumed = consumed.saturating_add(step_weight);
+
+            if !matches!(fold, BlockFold::Done { .. }) {
+                let fold = clear_prefix_step(fold, |limit, cursor| {
+                    Resources::<T>::clear_prefix(nft, limit, cursor)
+                });
+                PendingBurns::<T>::insert(nft, fold);
+                continue;
+            }
+
+            let children: Vec<(CollectionId, NftId)> = Children::<T>::drain_prefix(nft)
+                .take(chunk as usize)
+                .map(|(child, _)| child)
+                .collect();
+            if (children.len() as u32) < chunk {
+                PendingBurns::<T>::remove(nft);
+            }
+            for (child_collection_id, child_nft_id) in children {
+                Self::burn_nft(child_collection_id, child_nft_id);
+            }
+        }
+
+        consumed
+    }
+}
+
 impl<T: Config> Priority<StringLimitOf<T>, T::AccountId, BoundedVec<ResourceId, T::MaxPriorities>>
 for Pallet<T>
     where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId>,
@@ -502,36 +635,13 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
         Ok((collection_id, nft_id))
     }
 
+    // The subtree is burned in `on_idle`, whatever its depth.
     fn nft_burn(
         collection_id: CollectionId,
         nft_id: NftId,
-        max_recursions: u32,
+        _max_recursions: u32,
     ) -> sp_std::result::Result<(CollectionId, NftId), DispatchError> {
-        ensure!(max_recursions > 0, Error::<T>::TooManyRecursions);
-
-        if let Some(nft) = Self::nfts(collection_id, nft_id) {
-            if let AccountIdOrCollectionNftTuple::CollectionAndNftTuple(parent_col, parent_nft) =
-            nft.owner
-            {
-                Children::<T>::remove((parent_col, parent_nft), (collection_id, nft_id));
-            }
-        }
-
-        Nfts::<T>::remove(collection_id, nft_id);
-
-        Resources::<T>::remove_prefix((collection_id, nft_id), None);
-
-        for ((child_collection_id, child_nft_id), _) in
-        Children::<T>::drain_prefix((collection_id, nft_id))
-        {
-            Self::nft_burn(child_collection_id, child_nft_id, max_recursions - 1)?;
-        }
-
-        Collections::<T>::try_mutate(collection_id, |collection| -> DispatchResult {
-            let collection = collection.as_mut().ok_or(Error::<T>::CollectionUnknown)?;
-            collection.nfts_count.saturating_dec();
-            Ok(())
-        })?;
+        Self::do_burn_nft(collection_id, nft_id)?;
 
         Ok((collection_id, nft_id))
     }
@@ -544,6 +654,7 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
     ) -> sp_std::result::Result<(T::AccountId, bool), DispatchError> {
         let parent = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id);
         ensure!(parent.is_some(), Error::<T>::NoAvailableNftId); // <- is this error wrong?
+        ensure!(!Pallet::<T>::is_burning(collection_id, nft_id), Error::<T>::NftIsBurning);
 
         let (root_owner, _root_nft) = Pallet::<T>::lookup_root_owner(collection_id, nft_id)?;
         ensure!(sender == root_owner, Error::<T>::NoPermission);
@@ -562,6 +673,7 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
             },
             AccountIdOrCollectionNftTuple::CollectionAndNftTuple(cid, nid) => {
                 ensure!(Nfts::<T>::contains_key(cid, nid), Error::<T>::NoAvailableNftId);
+                ensure!(!Pallet::<T>::is_burning(cid, nid), Error::<T>::NftIsBurning);
                 ensure!(
 					(collection_id, nft_id) != (cid, nid),
 					Error::<T>::CannotSendToDescendentOrSelf
@@ -579,32 +691,25 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
             },
         };
 
-        sending_nft.owner = new_owner;
+        let new_owner_cid_nid =
+            Pallet::<T>::decode_nft_account_id::<T::AccountId>(new_owner_account.clone());
 
+        // Sent to the NFT of another owner, the NFT stays with its sender, who can still send it
+        // elsewhere, until the recipient accepts it.
         if approval_required {
-            Nfts::<T>::try_mutate_exists(collection_id, nft_id, |nft| -> DispatchResult {
-                if let Some(nft) = nft {
-                    nft.pending = true;
-                }
-                Ok(())
-            })?;
-        } else {
-            Nfts::<T>::insert(collection_id, nft_id, sending_nft);
-        }
-
-        if let Some(current_owner) = parent {
-            let current_owner_cid_nid =
-                Pallet::<T>::decode_nft_account_id::<T::AccountId>(current_owner);
-            if let Some(current_owner_cid_nid) = current_owner_cid_nid {
-                Pallet::<T>::remove_child(current_owner_cid_nid, (collection_id, nft_id));
+            if let Some(destination) = new_owner_cid_nid {
+                PendingTransfers::<T>::insert(collection_id, nft_id, destination);
             }
+            sending_nft.pending = true;
+            Nfts::<T>::insert(collection_id, nft_id, sending_nft);
+            return Ok((new_owner_account, approval_required))
         }
 
-        let new_owner_cid_nid =
-            Pallet::<T>::decode_nft_account_id::<T::AccountId>(new_owner_account.clone());
-        if let Some(new_owner_cid_nid) = new_owner_cid_nid {
-            Pallet::<T>::add_child(new_owner_cid_nid, (collection_id, nft_id));
-        }
+        PendingTransfers::<T>::remove(collection_id, nft_id);
+        sending_nft.owner = new_owner;
+        sending_nft.pending = false;
+        Nfts::<T>::insert(collection_id, nft_id, sending_nft);
+        Pallet::<T>::move_nft((collection_id, nft_id), parent, new_owner_cid_nid)?;
 
         Ok((new_owner_account, approval_required))
     }
@@ -615,42 +720,38 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
         nft_id: NftId,
         new_owner: AccountIdOrCollectionNftTuple<T::AccountId>,
     ) -> Result<(T::AccountId, CollectionId, NftId), DispatchError> {
-        let (root_owner, _root_nft) = Pallet::<T>::lookup_root_owner(collection_id, nft_id)?;
+        ensure!(!Pallet::<T>::is_burning(collection_id, nft_id), Error::<T>::NftIsBurning);
 
-        ensure!(sender == root_owner, Error::<T>::NoPermission);
-
-        let mut _sending_nft =
+        let mut accepted_nft =
             Nfts::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
+        let (cid, nid) = PendingTransfers::<T>::get(collection_id, nft_id)
+            .ok_or(Error::<T>::CannotAcceptNonOwnedNft)?;
+        ensure!(
+            new_owner == AccountIdOrCollectionNftTuple::CollectionAndNftTuple(cid, nid),
+            Error::<T>::CannotAcceptNonOwnedNft
+        );
 
-        let new_owner_account = match new_owner.clone() {
-            AccountIdOrCollectionNftTuple::AccountId(id) => id,
-            AccountIdOrCollectionNftTuple::CollectionAndNftTuple(cid, nid) => {
-                ensure!(Nfts::<T>::contains_key(cid, nid), Error::<T>::NoAvailableNftId);
+        ensure!(Nfts::<T>::contains_key(cid, nid), Error::<T>::NoAvailableNftId);
+        ensure!(!Pallet::<T>::is_burning(cid, nid), Error::<T>::NftIsBurning);
+        // The tree may have changed since the NFT was sent
+        ensure!(
+            !Pallet::<T>::is_x_descendent_of_y(cid, nid, collection_id, nft_id),
+            Error::<T>::CannotSendToDescendentOrSelf
+        );
 
-                ensure!(
-					(collection_id, nft_id) != (cid, nid),
-					Error::<T>::CannotSendToDescendentOrSelf
-				);
+        let (recipient_root_owner, _root_nft) = Pallet::<T>::lookup_root_owner(cid, nid)?;
+        ensure!(sender == recipient_root_owner, Error::<T>::CannotAcceptNonOwnedNft);
 
-                ensure!(
-					!Pallet::<T>::is_x_descendent_of_y(cid, nid, collection_id, nft_id),
-					Error::<T>::CannotSendToDescendentOrSelf
-				);
+        // Convert to virtual account
+        let new_owner_account = Pallet::<T>::nft_to_account_id::<T::AccountId>(cid, nid);
 
-                let (recipient_root_owner, _root_nft) = Pallet::<T>::lookup_root_owner(cid, nid)?;
-                ensure!(recipient_root_owner == root_owner, Error::<T>::CannotAcceptNonOwnedNft);
+        PendingTransfers::<T>::remove(collection_id, nft_id);
+        accepted_nft.owner = new_owner;
+        accepted_nft.pending = false;
+        Nfts::<T>::insert(collection_id, nft_id, accepted_nft);
 
-                // Convert to virtual account
-                Pallet::<T>::nft_to_account_id::<T::AccountId>(cid, nid)
-            },
-        };
-
-        Nfts::<T>::try_mutate(collection_id, nft_id, |nft| -> DispatchResult {
-            if let Some(nft) = nft {
-                nft.pending = false;
-            }
-            Ok(())
-        })?;
+        let current_owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id);
+        Pallet::<T>::move_nft((collection_id, nft_id), current_owner, Some((cid, nid)))?;
 
         Ok((new_owner_account, collection_id, nft_id))
     }
@@ -661,18 +762,14 @@ impl<T: Config> Nft<T::AccountId, StringLimitOf<T>> for Pallet<T>
         nft_id: NftId,
         max_recursions: u32,
     ) -> Result<(T::AccountId, CollectionId, NftId), DispatchError> {
-
-        let (root_owner, _root_nft) = Pallet::<T>::lookup_root_owner(collection_id, nft_id)?;
+        // A pending NFT is rejected by the owner it was sent to
+        let (root_owner, _root_nft) = match PendingTransfers::<T>::get(collection_id, nft_id) {
+            Some((cid, nid)) => Pallet::<T>::lookup_root_owner(cid, nid)?,
+            None => Pallet::<T>::lookup_root_owner(collection_id, nft_id)?,
+        };
 
         ensure!(sender == root_owner, Error::<T>::CannotRejectNonOwnedNft);
 
-        if let Some(parent_account_id) = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id) {
-            if let Some(parent) =
-            Pallet::<T>::decode_nft_account_id::<T::AccountId>(parent_account_id) {
-                Self::remove_child(parent, (collection_id, nft_id));
-            }
-        }
-
         // Get NFT info
         let mut _rejecting_nft =
             Nfts::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
@@ -26,6 +26,7 @@ use kylin_primitives::resource::{Resource, ResourceInfo, ResourceTypes};
 use kylin_primitives::collection::{Collection, CollectionInfo};
 use kylin_primitives::types::*;
 use kylin_oracle::{OracleKeyOf, CreatorId};
+use kylin_support::abstractions::block_fold::ClearPrefixFold;
 use sp_std::convert::TryInto;
 use sp_std::result::Result;
 use sp_std::{prelude::*, str, vec::Vec};
@@ -46,6 +47,9 @@ mod tests;
 mod benchmarking;
 
 mod func;
+pub mod migrations;
+pub mod weights;
+pub use weights::*;
 pub use pallet::*;
 
 pub type InstanceInfoOf<T> = NftInfo<
@@ -80,6 +84,19 @@ pub struct MetaData {
 	vpath: Vec<u8>,
 }
 
+/// Feed attached to an NFT.
+#[derive(Encode, Decode, RuntimeDebug, Eq, PartialEq, Clone, TypeInfo, MaxEncodedLen)]
+pub struct FeedInfo<BoundedString> {
+	pub key: BoundedString,
+	pub url: BoundedString,
+	pub vpath: BoundedString,
+}
+
+pub type FeedInfoOf<T> = FeedInfo<StringLimitOf<T>>;
+
+/// Ancestors of a nested NFT, from its root NFT down to its parent.
+pub type AncestorsOf<T> = BoundedVec<(CollectionId, NftId), <T as Config>::MaxRecursions>;
+
 #[derive(Encode, Decode, RuntimeDebug, Eq, PartialEq, Clone, Copy, TypeInfo, MaxEncodedLen)]
 pub struct TimestampedValue {
     pub value: i64,
@@ -95,8 +112,12 @@ pub mod pallet {
 	use kylin_primitives::nft::AccountIdOrCollectionNftTuple;
 	use kylin_primitives::resource::{BasicResource, ComposableResource, SlotResource};
 
+	/// The current storage version.
+	const STORAGE_VERSION: StorageVersion = StorageVersion::new(4);
+
 	#[pallet::pallet]
 	#[pallet::generate_store(pub(super) trait Store)]
+	#[pallet::storage_version(STORAGE_VERSION)]
 	pub struct Pallet<T>(_);
 
 	/// NFT ID tracker, increased after new NFT minted
@@ -162,6 +183,17 @@ pub mod pallet {
 		(),
 	>;
 
+	/// Ancestry of nested NFTs, empty for NFTs owned by an account
+	#[pallet::storage]
+	#[pallet::getter(fn ancestors)]
+	pub type Ancestors<T: Config> = StorageDoubleMap<
+		_,
+		Twox64Concat, CollectionId,
+		Twox64Concat, NftId,
+		AncestorsOf<T>,
+		ValueQuery,
+	>;
+
 	/// Storage map for resource 
 	#[pallet::storage]
 	#[pallet::getter(fn resources)]
@@ -190,6 +222,44 @@ pub mod pallet {
 		OptionQuery,
 	>;
 
+	/// Storage map for the feed attached to each NFT
+	#[pallet::storage]
+	#[pallet::getter(fn feed_metadata)]
+	pub type FeedMetadata<T: Config> =
+	StorageDoubleMap<_,
+		Twox64Concat, CollectionId,
+		Twox64Concat, NftId,
+		FeedInfoOf<T>>;
+
+	/// Index of the feed NFT of each oracle key, within the collection holding the feed.
+	/// Only the collection issuer creates feeds in a collection, so no one else can take a key
+	/// in it.
+	#[pallet::storage]
+	#[pallet::getter(fn feeds_by_key)]
+	pub type FeedsByKey<T: Config> = StorageDoubleMap<
+		_,
+		Twox64Concat, CollectionId,
+		Twox64Concat, StringLimitOf<T>,
+		NftId,
+	>;
+
+	/// Recipient of the NFTs sent to an NFT of another owner, until that owner accepts them.
+	/// Until then the NFT, its place in the tree and its ancestry stay with its sender.
+	#[pallet::storage]
+	#[pallet::getter(fn pending_transfers)]
+	pub type PendingTransfers<T: Config> = StorageDoubleMap<
+		_,
+		Twox64Concat, CollectionId,
+		Twox64Concat, NftId,
+		(CollectionId, NftId),
+	>;
+
+	/// Burned NFTs whose resources and children are left to be removed in `on_idle`
+	#[pallet::storage]
+	#[pallet::getter(fn pending_burns)]
+	pub type PendingBurns<T: Config> =
+		StorageMap<_, Twox64Concat, (CollectionId, NftId), ClearPrefixFold>;
+
 	/// Collection operation lock
 	#[pallet::storage]
 	#[pallet::getter(fn lock)]
@@ -216,6 +286,18 @@ pub mod pallet {
 		type CollectionSymbolLimit: Get<u32>;
 		type MaxResourcesOnMint: Get<u32>;
 		type XcmSender: SendXcm;
+
+		/// Maximum number of resources or children removed per step of an NFT burn, at least one
+		#[pallet::constant]
+		type DeletionChunkSize: Get<u32>;
+
+		/// Maximum number of descendants of a transferred NFT, each of which has its ancestry
+		/// rewritten by the transfer
+		#[pallet::constant]
+		type MaxDescendants: Get<u32>;
+
+		/// Weight information for extrinsics in this pallet.
+		type WeightInfo: WeightInfo;
 	}
 
 	#[pallet::event]
@@ -338,9 +420,30 @@ pub mod pallet {
 		NonTransferable,
 		JsonError,
 		XcmSendError,
+		/// A feed already exists for the key in the collection
+		FeedAlreadyExists,
+		/// The NFT or one of its ancestors is being burned
+		NftIsBurning,
+		/// The NFT has more than `MaxDescendants` descendants to move
+		TooManyDescendants,
 	}
 
 
+	#[pallet::hooks]
+	impl<T: Config> Hooks<BlockNumberFor<T>> for Pallet<T> {
+		fn on_runtime_upgrade() -> Weight {
+			migrations::migrate::<T>()
+		}
+
+		fn on_idle(_n: BlockNumberFor<T>, remaining_weight: Weight) -> Weight {
+			Self::process_pending_burns(remaining_weight)
+		}
+
+		fn integrity_test() {
+			assert!(T::DeletionChunkSize::get() >= 1, "a burn step must remove something");
+		}
+	}
+
 	#[pallet::call]
 	impl<T: Config> Pallet<T>
 		where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + 
@@ -554,7 +657,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `FeedCreated`
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::create_feed())]
 		pub fn create_feed(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -579,12 +682,18 @@ pub mod pallet {
 			)?;
 			kylin_oracle::Pallet::<T>::do_submit_api(cid, key_limit, url.clone(), vpath.clone())?;
 
+			let feed: FeedInfoOf<T> = FeedInfo {
+				key: key.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+				url: url.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+				vpath: vpath.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+			};
+			ensure!(
+				!FeedsByKey::<T>::contains_key(collection_id, &feed.key),
+				Error::<T>::FeedAlreadyExists
+			);
 			let mdata = MetaData { key, url, vpath };
-			let meta_str = serde_json::to_string(&mdata).map_err(|_| Error::<T>::JsonError)?;
-			let metadata: BoundedVec<u8, T::StringLimit> = meta_str.as_bytes().to_vec()
-				.try_into().map_err(
-				|_| Error::<T>::StorageOverflow
-			)?;
+			// The NFT metadata names the feed, the feed itself is kept in `FeedMetadata`.
+			let metadata = feed.key.clone();
 
 			let nft_owner = sender.clone();
 			let (collection_id, nft_id) = Self::nft_mint(
@@ -601,12 +710,14 @@ pub mod pallet {
 				nft_owner.clone(),
 				|_details| Ok(()),
 			)?;
+			FeedsByKey::<T>::insert(collection_id, &feed.key, nft_id);
+			FeedMetadata::<T>::insert(collection_id, nft_id, feed);
 
 			Self::deposit_event(Event::FeedCreated { owner: nft_owner, collection_id, nft_id, metadata:mdata });
 			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::create_feed())]
 		pub fn xcm_create_feed(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -632,12 +743,18 @@ pub mod pallet {
 			)?;
 			kylin_oracle::Pallet::<T>::do_submit_api(cid, key_limit, url.clone(), vpath.clone())?;
 
+			let feed: FeedInfoOf<T> = FeedInfo {
+				key: key.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+				url: url.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+				vpath: vpath.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?,
+			};
+			ensure!(
+				!FeedsByKey::<T>::contains_key(collection_id, &feed.key),
+				Error::<T>::FeedAlreadyExists
+			);
 			let mdata = MetaData { key, url, vpath };
-			let meta_str = serde_json::to_string(&mdata).map_err(|_| Error::<T>::JsonError)?;
-			let metadata: BoundedVec<u8, T::StringLimit> = meta_str.as_bytes().to_vec()
-				.try_into().map_err(
-				|_| Error::<T>::StorageOverflow
-			)?;
+			// The NFT metadata names the feed, the feed itself is kept in `FeedMetadata`.
+			let metadata = feed.key.clone();
 
 			let nft_owner = sender.clone();
 			let (collection_id, nft_id) = Self::nft_mint(
@@ -654,6 +771,8 @@ pub mod pallet {
 				nft_owner.clone(),
 				|_details| Ok(()),
 			)?;
+			FeedsByKey::<T>::insert(collection_id, &feed.key, nft_id);
+			FeedMetadata::<T>::insert(collection_id, nft_id, feed);
 
 			Self::deposit_event(Event::FeedCreated { owner: nft_owner, collection_id, nft_id, metadata:mdata });
 			Self::sendback_nftid(para_id, collection_id, nft_id)?;
@@ -670,7 +789,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `FeedRemoved`
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::remove_feed(T::MaxRecursions::get()))]
 		pub fn remove_feed(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -682,11 +801,10 @@ pub mod pallet {
 			// Check ownership
 			ensure!(sender == root_owner, Error::<T>::NoPermission);
 
-			let nft = Nfts::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
-			let mdata: MetaData = serde_json::from_slice(&nft.metadata).map_err(|_| Error::<T>::JsonError)?;
+			let feed = FeedMetadata::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
 
 			let cid = CreatorId::AccountId(sender.clone());
-			let key_limit: OracleKeyOf<T> = mdata.key.clone().try_into().map_err(
+			let key_limit: OracleKeyOf<T> = feed.key.into_inner().try_into().map_err(
 					|_| Error::<T>::StorageOverflow
 				)?;
 			kylin_oracle::Pallet::<T>::do_remove_api(cid, key_limit)?;
@@ -700,7 +818,7 @@ pub mod pallet {
 			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::remove_feed(T::MaxRecursions::get()))]
 		pub fn xcm_remove_feed(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -714,11 +832,10 @@ pub mod pallet {
 			// Check ownership
 			ensure!(sender == root_owner, Error::<T>::NoPermission);
 
-			let nft = Nfts::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
-			let mdata: MetaData = serde_json::from_slice(&nft.metadata).map_err(|_| Error::<T>::JsonError)?;
+			let feed = FeedMetadata::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
 
 			let cid = CreatorId::ParaId(para_id);
-			let key_limit: OracleKeyOf<T> = mdata.key.clone().try_into().map_err(
+			let key_limit: OracleKeyOf<T> = feed.key.into_inner().try_into().map_err(
 					|_| Error::<T>::StorageOverflow
 				)?;
 			kylin_oracle::Pallet::<T>::do_remove_api(cid, key_limit)?;
@@ -740,7 +857,7 @@ pub mod pallet {
 		/// * `collection_id` - collection ID
 		/// * `nft_id` - NFT ID
 		/// 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::query_feed())]
 		pub fn xcm_query_feed(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -753,14 +870,13 @@ pub mod pallet {
 			// Check ownership
 			ensure!(sender == root_owner, Error::<T>::NoPermission);
 
-			let nft = Nfts::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
-			let mdata: MetaData = serde_json::from_slice(&nft.metadata).map_err(|_| Error::<T>::JsonError)?;
+			let feed = FeedMetadata::<T>::get(collection_id, nft_id).ok_or(Error::<T>::NoAvailableNftId)?;
 			
-			let key: OracleKeyOf<T> = mdata.key.clone().try_into().map_err(
+			let key: OracleKeyOf<T> = feed.key.into_inner().try_into().map_err(
 				|_| Error::<T>::StorageOverflow
 			)?;
 			if let Some(val) = kylin_oracle::Pallet::<T>::get(&key) {
-                Self::sendback_query_res(para_id, mdata.key, val.value)
+                Self::sendback_query_res(para_id, key.into_inner(), val.value)
             } else {
                 Err(DispatchError::CannotLookup)
             }
@@ -777,7 +893,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `NFTSent`
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::send(T::MaxDescendants::get()))]
 		pub fn send(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -789,12 +905,15 @@ pub mod pallet {
 			let (new_owner_account, approval_required) =
 				Self::nft_send(sender.clone(), collection_id, nft_id, new_owner.clone())?;
 
-			pallet_uniques::Pallet::<T>::do_transfer(
-				collection_id,
-				nft_id,
-				new_owner_account,
-				|_class_details, _details| Ok(()),
-			)?;
+			// A pending NFT is transferred once accepted
+			if !approval_required {
+				pallet_uniques::Pallet::<T>::do_transfer(
+					collection_id,
+					nft_id,
+					new_owner_account,
+					|_class_details, _details| Ok(()),
+				)?;
+			}
 
 			Self::deposit_event(Event::NFTSent {
 				sender,
@@ -807,18 +926,20 @@ pub mod pallet {
 			Ok(())
 		}
 
-		/// Accept the ownership of the transfered NFT
+		/// Accept the ownership of the transfered NFT, which then moves to `new_owner` with its
+		/// subtree
 		///
-		/// Can be called only by the NFT root owner.
+		/// Can be called only by the root owner of the NFT it was sent to.
 		///
 		/// # Parameter:
 		/// * `collection_id` - collection ID
 		/// * `nft_id` - nft ID
-		/// * `new_owner` - new owner
+		/// * `new_owner` - new owner, the NFT it was sent to
 		/// 
 		/// # Emits
 		/// * `NFTAccepted`
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		// Accepting moves the NFT as `send` does
+		#[pallet::weight(<T as Config>::WeightInfo::send(T::MaxDescendants::get()))]
 		pub fn accept_nft(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -846,9 +967,10 @@ pub mod pallet {
 			Ok(())
 		}
 
-		/// Reject the ownership of the transfered NFT
+		/// Reject the ownership of the transfered NFT, which is burned
 		///
-		/// Can be called only by the NFT root owner.
+		/// Can be called only by the root owner of the NFT it was sent to, or by the NFT root
+		/// owner when it is not pending.
 		///
 		/// # Parameter:
 		/// * `collection_id` - collection ID
@@ -899,4 +1021,25 @@ impl<T: Config> Pallet<T>
 		Ok(())
 	}
 	
-}
\ No newline at end of file
+}
+impl<T: Config> Pallet<T>
+	where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> +
+	kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	/// Resolve `key` to its feed NFT in `collection_id`, the root owner of the NFT and the
+	/// latest value of `key`.
+	pub fn feed_by_key(
+		collection_id: CollectionId,
+		key: Vec<u8>,
+	) -> Option<(CollectionId, NftId, T::AccountId, Option<TimestampedValue>)> {
+		let key: StringLimitOf<T> = key.try_into().ok()?;
+		let nft_id = Self::feeds_by_key(collection_id, &key)?;
+		let (owner, _) = Self::lookup_root_owner(collection_id, nft_id).ok()?;
+		let value = OracleKeyOf::<T>::try_from(key.into_inner())
+			.ok()
+			.and_then(|key| kylin_oracle::Pallet::<T>::get(&key))
+			.map(|val| TimestampedValue { value: val.value, timestamp: val.timestamp });
+		Some((collection_id, nft_id, owner, value))
+	}
+}
@@ -0,0 +1,142 @@
+//! Storage migrations for the kylin-feed-api pallet.
+
+use super::*;
+use frame_support::traits::{GetStorageVersion, StorageVersion};
+
+/// Migrate the pallet storage to the current storage version.
+pub fn migrate<T: Config>() -> Weight {
+	let on_chain = Pallet::<T>::on_chain_storage_version();
+	let mut weight = T::DbWeight::get().reads(1);
+
+	if on_chain < 1 {
+		weight = weight.saturating_add(v1::migrate::<T>());
+	}
+	if on_chain < 2 {
+		weight = weight.saturating_add(v2::migrate::<T>());
+	}
+	if on_chain < 3 {
+		weight = weight.saturating_add(v3::migrate::<T>());
+	}
+	if on_chain < 4 {
+		weight = weight.saturating_add(v4::migrate::<T>());
+	}
+
+	if on_chain < Pallet::<T>::current_storage_version() {
+		Pallet::<T>::current_storage_version().put::<Pallet<T>>();
+		weight = weight.saturating_add(T::DbWeight::get().writes(1));
+	}
+	weight
+}
+
+/// Feeds used to be kept as a JSON `MetaData` string in the NFT metadata.
+pub mod v1 {
+	use super::*;
+
+	/// Decode the JSON metadata of every NFT into its `FeedMetadata` entry.
+	pub fn migrate<T: Config>() -> Weight {
+		let (mut read, mut migrated) = (0u64, 0u64);
+		for (collection_id, nft_id, nft) in Nfts::<T>::iter() {
+			read += 1;
+			let feed = serde_json::from_slice::<MetaData>(&nft.metadata).ok().and_then(|mdata| {
+				Some(FeedInfo {
+					key: mdata.key.try_into().ok()?,
+					url: mdata.url.try_into().ok()?,
+					vpath: mdata.vpath.try_into().ok()?,
+				})
+			});
+			match feed {
+				Some(feed) => {
+					FeedMetadata::<T>::insert(collection_id, nft_id, feed);
+					migrated += 1;
+				},
+				None => log::warn!(
+					"kylin-feed-api: NFT {:?}/{:?} has no feed metadata",
+					collection_id,
+					nft_id
+				),
+			}
+		}
+		log::info!("kylin-feed-api: migrated to v1, moved {} feed metadata", migrated);
+		T::DbWeight::get().reads_writes(read, migrated)
+	}
+}
+
+/// `FeedsByKey` indexes the feed NFT of each key.
+pub mod v2 {
+	use super::*;
+
+	/// The index of v2, keyed by key alone.
+	#[frame_support::storage_alias]
+	pub type FeedsByKey<T: Config> =
+		StorageMap<Pallet<T>, Twox64Concat, StringLimitOf<T>, (CollectionId, NftId)>;
+
+	/// Index every feed, the first feed created for a key wins.
+	pub fn migrate<T: Config>() -> Weight {
+		let (mut read, mut indexed) = (0u64, 0u64);
+		for (collection_id, nft_id, feed) in FeedMetadata::<T>::iter() {
+			read += 1;
+			match FeedsByKey::<T>::get(&feed.key) {
+				Some((c, n)) if (c, n) <= (collection_id, nft_id) => log::warn!(
+					"kylin-feed-api: key of feed {:?}/{:?} is already indexed by {:?}/{:?}",
+					collection_id,
+					nft_id,
+					c,
+					n
+				),
+				_ => {
+					FeedsByKey::<T>::insert(&feed.key, (collection_id, nft_id));
+					indexed += 1;
+				},
+			}
+		}
+		log::info!("kylin-feed-api: migrated to v2, indexed {} feeds", indexed);
+		T::DbWeight::get().reads_writes(read.saturating_mul(2), indexed)
+	}
+}
+
+/// `Ancestors` records the ancestry of nested NFTs.
+pub mod v3 {
+	use super::*;
+	use sp_std::collections::btree_set::BTreeSet;
+
+	/// Build the ancestry of every nested NFT from the `Children` tree, starting at its roots.
+	pub fn migrate<T: Config>() -> Weight {
+		let (mut read, mut written) = (0u64, 0u64);
+		let mut parents = BTreeSet::new();
+		let mut children = BTreeSet::new();
+		for (parent, child, _) in Children::<T>::iter() {
+			read += 1;
+			parents.insert(parent);
+			children.insert(child);
+		}
+		for root in parents.difference(&children) {
+			if let Err(e) = Pallet::<T>::set_ancestry(*root, None, u32::MAX) {
+				log::warn!("kylin-feed-api: cannot build the ancestry of {:?}: {:?}", root, e);
+			}
+		}
+		for child in children.iter() {
+			if !Ancestors::<T>::get(child.0, child.1).is_empty() {
+				written += 1;
+			}
+		}
+		log::info!("kylin-feed-api: migrated to v3, recorded {} ancestries", written);
+		T::DbWeight::get().reads_writes(read.saturating_mul(3), written)
+	}
+}
+
+/// `FeedsByKey` indexes the feed NFT of each key within its collection.
+pub mod v4 {
+	use super::*;
+
+	/// Drop the index keyed by key alone and index every feed within its collection.
+	pub fn migrate<T: Config>() -> Weight {
+		let dropped = v2::FeedsByKey::<T>::drain().count() as u64;
+		let mut indexed = 0u64;
+		for (collection_id, nft_id, feed) in FeedMetadata::<T>::iter() {
+			FeedsByKey::<T>::insert(collection_id, &feed.key, nft_id);
+			indexed += 1;
+		}
+		log::info!("kylin-feed-api: migrated to v4, indexed {} feeds", indexed);
+		T::DbWeight::get().reads_writes(dropped.saturating_add(indexed), dropped.saturating_add(indexed))
+	}
+}
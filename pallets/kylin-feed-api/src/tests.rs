@@ -1,20 +1,333 @@
-use crate::{mock::*, Error};
-use frame_support::{assert_noop, assert_ok};
+use crate::{mock::*, *};
+use frame_support::{assert_noop, assert_ok, traits::Hooks};
+
+fn bounded<S: Get<u32>>(s: &str) -> BoundedVec<u8, S> {
+	s.as_bytes().to_vec().try_into().unwrap()
+}
+
+fn create_collection(issuer: u8) -> CollectionId {
+	assert_ok!(KylinFeedApi::create_collection(
+		RuntimeOrigin::signed(account(issuer)),
+		bounded("collection"),
+		None,
+		bounded("COL"),
+	));
+	KylinFeedApi::collection_index() - 1
+}
+
+fn create_feed(owner: u8, collection_id: CollectionId, key: &str) -> NftId {
+	assert_ok!(KylinFeedApi::create_feed(
+		RuntimeOrigin::signed(account(owner)),
+		collection_id,
+		2000,
+		key.as_bytes().to_vec(),
+		b"https://api.example.com/price".to_vec(),
+		b"/price".to_vec(),
+	));
+	KylinFeedApi::next_nft_id(collection_id) - 1
+}
+
+#[test]
+fn feeds_are_kept_as_typed_metadata() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		let nft_id = create_feed(1, collection_id, "btc_usd");
+
+		assert_eq!(
+			KylinFeedApi::feed_metadata(collection_id, nft_id),
+			Some(FeedInfo {
+				key: bounded("btc_usd"),
+				url: bounded("https://api.example.com/price"),
+				vpath: bounded("/price"),
+			})
+		);
+		// The NFT metadata only names the feed.
+		assert_eq!(KylinFeedApi::nfts(collection_id, nft_id).unwrap().metadata, bounded("btc_usd"));
+		let key: OracleKeyOf<Test> = bounded("btc_usd");
+		assert!(KylinOracle::api_feeds(CreatorId::AccountId(account(1)), key).is_some());
+	});
+}
+
+#[test]
+fn only_the_collection_issuer_creates_feeds() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		assert_noop!(
+			KylinFeedApi::create_feed(
+				RuntimeOrigin::signed(account(2)),
+				collection_id,
+				2000,
+				b"btc_usd".to_vec(),
+				b"https://api.example.com/price".to_vec(),
+				b"/price".to_vec(),
+			),
+			Error::<Test>::NoPermission
+		);
+	});
+}
+
+#[test]
+fn upgrade_from_json_metadata_moves_it_to_feed_metadata() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		let mdata = MetaData { key: b"btc".to_vec(), url: b"u".to_vec(), vpath: b"/v".to_vec() };
+		let json: StringLimitOf<Test> = serde_json::to_vec(&mdata).unwrap().try_into().unwrap();
+		let nft = |metadata| NftInfo {
+			owner: AccountIdOrCollectionNftTuple::AccountId(account(1)),
+			metadata,
+			pending: false,
+			transferable: true,
+		};
+		Nfts::<Test>::insert(collection_id, 0, nft(json));
+		Nfts::<Test>::insert(collection_id, 1, nft(bounded("not json")));
+		StorageVersion::new(0).put::<KylinFeedApi>();
+
+		KylinFeedApi::on_runtime_upgrade();
+
+		assert_eq!(
+			KylinFeedApi::feed_metadata(collection_id, 0),
+			Some(FeedInfo { key: bounded("btc"), url: bounded("u"), vpath: bounded("/v") })
+		);
+		assert_eq!(KylinFeedApi::feed_metadata(collection_id, 1), None);
+		assert_eq!(
+			KylinFeedApi::on_chain_storage_version(),
+			KylinFeedApi::current_storage_version()
+		);
+	});
+}
+
+#[test]
+fn feeds_are_indexed_by_key_within_their_collection() {
+	new_test_ext().execute_with(|| {
+		let first = create_collection(1);
+		let nft_id = create_feed(1, first, "btc_usd");
+		// Another issuer cannot take the key in the collection, but has its own collections.
+		let second = create_collection(2);
+		let other = create_feed(2, second, "btc_usd");
+
+		let key: StringLimitOf<Test> = bounded("btc_usd");
+		assert_eq!(KylinFeedApi::feeds_by_key(first, &key), Some(nft_id));
+		assert_eq!(KylinFeedApi::feeds_by_key(second, &key), Some(other));
+		assert_noop!(
+			KylinFeedApi::create_feed(
+				RuntimeOrigin::signed(account(1)),
+				first,
+				2000,
+				b"btc_usd".to_vec(),
+				b"https://api.example.com/price".to_vec(),
+				b"/price".to_vec(),
+			),
+			Error::<Test>::FeedAlreadyExists
+		);
+	});
+}
+
+#[test]
+fn feed_by_key_resolves_the_feed_until_it_is_removed() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		let nft_id = create_feed(1, collection_id, "btc_usd");
+
+		assert_eq!(
+			KylinFeedApi::feed_by_key(collection_id, b"btc_usd".to_vec()),
+			Some((collection_id, nft_id, account(1), None))
+		);
+		assert_eq!(KylinFeedApi::feed_by_key(collection_id + 1, b"btc_usd".to_vec()), None);
+
+		assert_ok!(KylinFeedApi::remove_feed(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			nft_id
+		));
+		assert_eq!(KylinFeedApi::feed_by_key(collection_id, b"btc_usd".to_vec()), None);
+	});
+}
 
 #[test]
-fn it_works_for_default_value() {
+fn upgrade_from_the_global_key_index_indexes_feeds_within_their_collection() {
 	new_test_ext().execute_with(|| {
-		// Dispatch a signed extrinsic.
-		assert_ok!(TemplateModule::do_something(Origin::signed(1), 42));
-		// Read pallet storage and assert an expected result.
-		assert_eq!(TemplateModule::something(), Some(42));
+		let collection_id = create_collection(1);
+		let nft_id = create_feed(1, collection_id, "btc_usd");
+		let key: StringLimitOf<Test> = bounded("btc_usd");
+		FeedsByKey::<Test>::remove(collection_id, &key);
+		migrations::v2::FeedsByKey::<Test>::insert(&key, (collection_id, nft_id));
+		StorageVersion::new(3).put::<KylinFeedApi>();
+
+		KylinFeedApi::on_runtime_upgrade();
+
+		assert_eq!(migrations::v2::FeedsByKey::<Test>::iter().count(), 0);
+		assert_eq!(KylinFeedApi::feeds_by_key(collection_id, &key), Some(nft_id));
+	});
+}
+
+fn nest(owner: u8, collection_id: CollectionId, child: NftId, parent: NftId) {
+	assert_ok!(KylinFeedApi::send(
+		RuntimeOrigin::signed(account(owner)),
+		collection_id,
+		child,
+		AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, parent),
+	));
+}
+
+fn burn_pending() {
+	KylinFeedApi::on_idle(System::block_number(), Weight::MAX);
+}
+
+#[test]
+fn burning_a_feed_burns_its_children_in_on_idle() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		let root = create_feed(1, collection_id, "root");
+		let children: Vec<_> =
+			["a", "b", "c"].iter().map(|key| create_feed(1, collection_id, key)).collect();
+		for child in &children {
+			nest(1, collection_id, *child, root);
+		}
+		let grandchild = create_feed(1, collection_id, "d");
+		nest(1, collection_id, grandchild, children[0]);
+
+		assert_ok!(KylinFeedApi::remove_feed(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			root
+		));
+		assert!(KylinFeedApi::nfts(collection_id, children[0]).is_some());
+
+		burn_pending();
+		for nft_id in children.iter().chain([grandchild].iter()) {
+			assert!(KylinFeedApi::nfts(collection_id, *nft_id).is_none());
+		}
+		assert_eq!(PendingBurns::<Test>::iter().count(), 0);
+		assert_eq!(KylinFeedApi::collections(collection_id).unwrap().nfts_count, 0);
 	});
 }
 
 #[test]
-fn correct_error_for_none_value() {
+fn nfts_being_burned_are_neither_sent_nor_received() {
 	new_test_ext().execute_with(|| {
-		// Ensure the expected error is thrown when no value is present.
-		assert_noop!(TemplateModule::cause_error(Origin::signed(1)), Error::<Test>::NoneValue);
+		let collection_id = create_collection(1);
+		let root = create_feed(1, collection_id, "root");
+		let child = create_feed(1, collection_id, "child");
+		let other = create_feed(1, collection_id, "other");
+		nest(1, collection_id, child, root);
+
+		assert_ok!(KylinFeedApi::remove_feed(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			root
+		));
+		assert!(KylinFeedApi::is_burning(collection_id, child));
+
+		assert_noop!(
+			KylinFeedApi::send(
+				RuntimeOrigin::signed(account(1)),
+				collection_id,
+				child,
+				AccountIdOrCollectionNftTuple::AccountId(account(2)),
+			),
+			Error::<Test>::NftIsBurning
+		);
+		assert_noop!(
+			KylinFeedApi::send(
+				RuntimeOrigin::signed(account(1)),
+				collection_id,
+				other,
+				AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, child),
+			),
+			Error::<Test>::NftIsBurning
+		);
+		assert_noop!(
+			KylinFeedApi::accept_nft(
+				RuntimeOrigin::signed(account(1)),
+				collection_id,
+				child,
+				AccountIdOrCollectionNftTuple::AccountId(account(1)),
+			),
+			Error::<Test>::NftIsBurning
+		);
+
+		burn_pending();
+		assert!(!KylinFeedApi::is_burning(collection_id, other));
+		assert!(KylinFeedApi::nfts(collection_id, child).is_none());
+	});
+}
+
+#[test]
+fn an_nft_sent_to_another_owner_moves_once_accepted() {
+	new_test_ext().execute_with(|| {
+		let mine = create_collection(1);
+		let nft = create_feed(1, mine, "nft");
+		let child = create_feed(1, mine, "child");
+		nest(1, mine, child, nft);
+		let theirs = create_collection(2);
+		let recipient = create_feed(2, theirs, "recipient");
+		let destination = AccountIdOrCollectionNftTuple::CollectionAndNftTuple(theirs, recipient);
+
+		assert_ok!(KylinFeedApi::send(
+			RuntimeOrigin::signed(account(1)),
+			mine,
+			nft,
+			destination.clone()
+		));
+		// Until accepted, the NFT and its subtree stay with the sender.
+		assert_eq!(KylinFeedApi::pending_transfers(mine, nft), Some((theirs, recipient)));
+		assert_eq!(KylinFeedApi::ancestors(mine, child).to_vec(), vec![(mine, nft)]);
+		assert_eq!(KylinFeedApi::lookup_root_owner(mine, child).unwrap().0, account(1));
+		assert_eq!(Children::<Test>::iter_prefix((theirs, recipient)).count(), 0);
+		assert_noop!(
+			KylinFeedApi::accept_nft(
+				RuntimeOrigin::signed(account(1)),
+				mine,
+				nft,
+				destination.clone()
+			),
+			Error::<Test>::CannotAcceptNonOwnedNft
+		);
+
+		assert_ok!(KylinFeedApi::accept_nft(
+			RuntimeOrigin::signed(account(2)),
+			mine,
+			nft,
+			destination
+		));
+		assert_eq!(KylinFeedApi::pending_transfers(mine, nft), None);
+		assert_eq!(
+			KylinFeedApi::ancestors(mine, child).to_vec(),
+			vec![(theirs, recipient), (mine, nft)]
+		);
+		assert_eq!(KylinFeedApi::lookup_root_owner(mine, child).unwrap().0, account(2));
+		assert!(Children::<Test>::contains_key((theirs, recipient), (mine, nft)));
+	});
+}
+
+#[test]
+fn an_nft_moves_with_at_most_max_descendants() {
+	new_test_ext().execute_with(|| {
+		let collection_id = create_collection(1);
+		let parent = create_feed(1, collection_id, "parent");
+		let nft = create_feed(1, collection_id, "nft");
+		for key in ["a", "b", "c", "d"] {
+			let child = create_feed(1, collection_id, key);
+			nest(1, collection_id, child, nft);
+		}
+		nest(1, collection_id, nft, parent);
+		assert_ok!(KylinFeedApi::send(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			nft,
+			AccountIdOrCollectionNftTuple::AccountId(account(1)),
+		));
+
+		let extra = create_feed(1, collection_id, "e");
+		nest(1, collection_id, extra, nft);
+		assert_noop!(
+			KylinFeedApi::send(
+				RuntimeOrigin::signed(account(1)),
+				collection_id,
+				nft,
+				AccountIdOrCollectionNftTuple::CollectionAndNftTuple(collection_id, parent),
+			),
+			Error::<Test>::TooManyDescendants
+		);
 	});
 }
@@ -0,0 +1,96 @@
+//! Weights for kylin_feed_api
+//!
+//! Not benchmarked yet: every weight below is an estimate from the storage accesses of its call,
+//! to be replaced by the output of the Substrate benchmark CLI:
+//!
+//! target/release/kylin-collator benchmark pallet
+//! --chain=pichiu-chachacha
+//! --steps=50
+//! --repeat=20
+//! --pallet=kylin-feed-api
+//! --extrinsic=*
+//! --execution=wasm
+//! --wasm-execution=compiled
+//! --heap-pages=4096
+//! --output=pallets/kylin-feed-api/src/weights.rs
+//! --template=./scripts/frame-weight-template.hbs
+
+#![allow(unused_parens)]
+#![allow(unused_imports)]
+
+use frame_support::{
+    traits::Get,
+    weights::{constants::RocksDbWeight, Weight},
+};
+use sp_std::marker::PhantomData;
+
+/// Weight functions needed for kylin_feed_api.
+pub trait WeightInfo {
+    fn create_feed() -> Weight;
+    fn remove_feed(d: u32) -> Weight;
+    fn query_feed() -> Weight;
+    fn send(d: u32) -> Weight;
+}
+
+/// Weights for kylin_feed_api using the Substrate node and recommended hardware.
+pub struct SubstrateWeight<T>(PhantomData<T>);
+impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
+    // Estimated: the collection, the NFT and its feed metadata, and the api feed submitted to
+    // the oracle parachain.
+    fn create_feed() -> Weight {
+        Weight::from_ref_time(85_000_000)
+            .saturating_add(T::DbWeight::get().reads(9 as u64))
+            .saturating_add(T::DbWeight::get().writes(12 as u64))
+    }
+    // Estimated: the root owner lookup through `d` ancestors, the children being burned in
+    // `on_idle`.
+    fn remove_feed(d: u32, ) -> Weight {
+        Weight::from_ref_time(78_000_000)
+            .saturating_add(Weight::from_ref_time(160_000).saturating_mul(d as u64))
+            .saturating_add(T::DbWeight::get().reads(8 as u64))
+            .saturating_add(T::DbWeight::get().writes(9 as u64))
+    }
+    // Estimated from the oracle `query_data`, with the feed lookup.
+    fn query_feed() -> Weight {
+        Weight::from_ref_time(121_180_000)
+            .saturating_add(T::DbWeight::get().reads(7 as u64))
+            .saturating_add(T::DbWeight::get().writes(2 as u64))
+    }
+    // Estimated: the ownership checks and the ancestry of each of the `d` descendants moved.
+    fn send(d: u32, ) -> Weight {
+        Weight::from_ref_time(52_000_000)
+            .saturating_add(Weight::from_ref_time(4_200_000).saturating_mul(d as u64))
+            .saturating_add(T::DbWeight::get().reads(8 as u64))
+            .saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(d as u64)))
+            .saturating_add(T::DbWeight::get().writes(6 as u64))
+            .saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(d as u64)))
+    }
+}
+
+// For backwards compatibility and tests
+impl WeightInfo for () {
+    fn create_feed() -> Weight {
+        Weight::from_ref_time(85_000_000)
+            .saturating_add(RocksDbWeight::get().reads(9 as u64))
+            .saturating_add(RocksDbWeight::get().writes(12 as u64))
+    }
+    fn remove_feed(d: u32, ) -> Weight {
+        Weight::from_ref_time(78_000_000)
+            .saturating_add(Weight::from_ref_time(160_000).saturating_mul(d as u64))
+            .saturating_add(RocksDbWeight::get().reads(8 as u64))
+            .saturating_add(RocksDbWeight::get().writes(9 as u64))
+    }
+    fn query_feed() -> Weight {
+        Weight::from_ref_time(121_180_000)
+            .saturating_add(RocksDbWeight::get().reads(7 as u64))
+            .saturating_add(RocksDbWeight::get().writes(2 as u64))
+    }
+    fn send(d: u32, ) -> Weight {
+        Weight::from_ref_time(52_000_000)
+            .saturating_add(Weight::from_ref_time(4_200_000).saturating_mul(d as u64))
+            .saturating_add(RocksDbWeight::get().reads(8 as u64))
+            .saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(d as u64)))
+            .saturating_add(RocksDbWeight::get().writes(6 as u64))
+            .saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(d as u64)))
+    }
+}
@@ -51,6 +51,16 @@ pub struct TimestampedValue {
 enum KylinOracleFunc {
     #[codec(index = 2u8)]
     xcm_query_data { key: Vec<u8> },
+    #[codec(index = 9u8)]
+    xcm_query_data_batch { keys: Vec<Vec<u8>> },
+    #[codec(index = 10u8)]
+    xcm_subscribe { keys: Vec<Vec<u8>>, heartbeat: u32, deviation: Permill },
+    #[codec(index = 11u8)]
+    xcm_unsubscribe { keys: Vec<Vec<u8>> },
+    #[codec(index = 12u8)]
+    xcm_query_history { key: Vec<u8>, from: u128, to: u128 },
+    #[codec(index = 15u8)]
+    xcm_query_hot_values,
 }
 
 /// Mock structure for XCM Call message encoding
@@ -123,6 +133,10 @@ pub mod pallet {
 		#[pallet::constant]
 		type StringLimit: Get<u32>;
 
+		/// Maximum number of keys in a batched query, and of values in a batched feed back.
+		#[pallet::constant]
+		type MaxQueryKeys: Get<u32>;
+
 		type XcmSender: SendXcm;
 	}
 
@@ -144,6 +158,13 @@ pub mod pallet {
 			key: Vec<u8>,
 			value: TimestampedValue,
 		},
+		QueryFeedBackBatch {
+			values: Vec<(Vec<u8>, TimestampedValue)>,
+		},
+		QueryFeedBackHistory {
+			key: Vec<u8>,
+			values: Vec<TimestampedValue>,
+		},
 	}
 
 	#[pallet::error]
@@ -343,6 +364,164 @@ pub mod pallet {
             Ok(())
         }
 
+		/// Query the feed data of several keys with a single message
+		///
+		/// Can be called by any signed origin.
+		///
+		/// # Parameter:
+		/// * `oracle_paraid` - parachain id of the oracle
+		/// * `keys` - keys for the feeds
+		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		pub fn query_feed_by_keys(
+			origin: OriginFor<T>,
+			oracle_paraid: ParaId,
+			keys: BoundedVec<KeyLimitOf<T>, T::MaxQueryKeys>,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			Self::do_query_feed_by_keys(oracle_paraid, keys)?;
+			Ok(())
+		}
+
+		/// Subscribe to the feed data of keys, the Oracle parachain then pushes the updated
+		/// values through `xcm_feed_back_batch`
+		///
+		/// Can be called by any signed origin.
+		///
+		/// # Parameter:
+		/// * `oracle_paraid` - parachain id of the oracle
+		/// * `keys` - keys for the feeds
+		/// * `heartbeat` - an updated value is pushed at least every `heartbeat` oracle blocks
+		/// * `deviation` - an updated value is pushed as soon as it deviates from the last
+		///     pushed value by `deviation`
+		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		pub fn subscribe_feeds(
+			origin: OriginFor<T>,
+			oracle_paraid: ParaId,
+			keys: BoundedVec<KeyLimitOf<T>, T::MaxQueryKeys>,
+			heartbeat: u32,
+			deviation: Permill,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			Self::send_to_oracle(
+				oracle_paraid,
+				KylinOracleFunc::xcm_subscribe {
+					keys: keys.into_iter().map(Into::into).collect(),
+					heartbeat,
+					deviation,
+				},
+			)
+		}
+
+		/// Unsubscribe from the feed data of keys
+		///
+		/// Can be called by any signed origin.
+		///
+		/// # Parameter:
+		/// * `oracle_paraid` - parachain id of the oracle
+		/// * `keys` - keys for the feeds
+		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		pub fn unsubscribe_feeds(
+			origin: OriginFor<T>,
+			oracle_paraid: ParaId,
+			keys: BoundedVec<KeyLimitOf<T>, T::MaxQueryKeys>,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			Self::send_to_oracle(
+				oracle_paraid,
+				KylinOracleFunc::xcm_unsubscribe {
+					keys: keys.into_iter().map(Into::into).collect(),
+				},
+			)
+		}
+
+		/// Feed data of a batched query fed back from Oracle parachain
+		///
+		/// Can be only XCM call from parachain.
+		///
+		/// # Parameter:
+		/// * `values` - keys for the feeds with their timestamped value, at most `MaxQueryKeys`
+		/// 
+		/// # Emits
+		/// * `QueryFeedBackBatch`
+		#[pallet::weight(T::DbWeight::get().reads_writes(1, values.len() as u64).ref_time().saturating_add(10_000))]
+		pub fn xcm_feed_back_batch(
+			origin: OriginFor<T>,
+			values: BoundedVec<(Vec<u8>, TimestampedValue), T::MaxQueryKeys>,
+		) -> DispatchResult {
+            let para_id = ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            for (key, tval) in &values {
+                let keylimit: KeyLimitOf<T> = key.clone().try_into().map_err(|_| Error::<T>::StorageOverflow)?;
+                <Values<T>>::insert(keylimit, tval);
+            }
+            Self::deposit_event(Event::QueryFeedBackBatch { values: values.into_inner() });
+            Ok(())
+        }
+
+		/// Query the past values of a key within a time range, fed back through
+		/// `xcm_feed_back_history`
+		///
+		/// Can be called by any signed origin.
+		///
+		/// # Parameter:
+		/// * `oracle_paraid` - parachain id of the oracle
+		/// * `key` - key for the feed
+		/// * `from` - start of the time range, in milliseconds
+		/// * `to` - end of the time range, in milliseconds
+		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		pub fn query_feed_history(
+			origin: OriginFor<T>,
+			oracle_paraid: ParaId,
+			key: KeyLimitOf<T>,
+			from: u128,
+			to: u128,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			Self::send_to_oracle(
+				oracle_paraid,
+				KylinOracleFunc::xcm_query_history { key: key.into(), from, to },
+			)
+		}
+
+		/// Past values of a key fed back from Oracle parachain, oldest first
+		///
+		/// Can be only XCM call from parachain.
+		///
+		/// # Parameter:
+		/// * `key` - key for the feed
+		/// * `values` - timestamped values of the key
+		/// 
+		/// # Emits
+		/// * `QueryFeedBackHistory`
+		#[pallet::weight(T::DbWeight::get().reads_writes(1, 0).ref_time().saturating_add(10_000))]
+		pub fn xcm_feed_back_history(
+			origin: OriginFor<T>,
+			key: Vec<u8>,
+			values: Vec<TimestampedValue>,
+		) -> DispatchResult {
+            let para_id = ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            Self::deposit_event(Event::QueryFeedBackHistory { key, values });
+            Ok(())
+        }
+
+		/// Query the feed data of every hot key of the oracle, fed back through
+		/// `xcm_feed_back_batch`
+		///
+		/// Can be called by any signed origin.
+		///
+		/// # Parameter:
+		/// * `oracle_paraid` - parachain id of the oracle
+		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		pub fn query_hot_feeds(origin: OriginFor<T>, oracle_paraid: ParaId) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			Self::send_to_oracle(oracle_paraid, KylinOracleFunc::xcm_query_hot_values)
+		}
 	}
 }
 
@@ -509,5 +688,39 @@ impl<T: Config> Pallet<T>
 
         Ok(())
     }
+
+	pub fn do_query_feed_by_keys(
+		para_id: ParaId,
+		keys: BoundedVec<KeyLimitOf<T>, T::MaxQueryKeys>,
+	) -> DispatchResult {
+        Self::send_to_oracle(
+            para_id,
+            KylinOracleFunc::xcm_query_data_batch {
+                keys: keys.into_iter().map(Into::into).collect(),
+            },
+        )
+    }
+
+	fn send_to_oracle(para_id: ParaId, call: KylinOracleFunc) -> DispatchResult {
+        let remark = KylinXcmCall::KylinOraclePallet(call);
+        T::XcmSender::send_xcm(
+            (
+                1,
+                Junction::Parachain(para_id.into()),
+            ),
+            Xcm(vec![Transact {
+                origin_type: OriginKind::Native,
+                require_weight_at_most: 1_000_000_000,
+                call: remark.encode().into(),
+            }]),
+        ).map_err(
+            |e| {
+                log::error!("Error: XcmSendError {:?}, {:?}", para_id, e);
+                Error::<T>::XcmSendError
+            }
+        )?;
+
+        Ok(())
+    }
 	
 }
\ No newline at end of file
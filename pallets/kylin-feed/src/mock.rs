@@ -1,15 +1,20 @@
-use crate as pallet_feed;
-use frame_support::traits::{ConstU16, ConstU64};
+use crate as kylin_feed;
+use crate::*;
+use frame_support::traits::{ConstU16, ConstU32, ConstU64, Everything};
 use frame_system as system;
 use sp_core::H256;
 use sp_runtime::{
 	testing::Header,
 	traits::{BlakeTwo256, IdentityLookup},
 };
+use std::{cell::RefCell, time::Duration};
 
 type UncheckedExtrinsic = frame_system::mocking::MockUncheckedExtrinsic<Test>;
 type Block = frame_system::mocking::MockBlock<Test>;
 
+/// Time of the tests, in milliseconds.
+pub const NOW: u64 = 1_000_000;
+
 // Configure a mock runtime to test the pallet.
 frame_support::construct_runtime!(
 	pub enum Test where
@@ -18,17 +23,18 @@ frame_support::construct_runtime!(
 		UncheckedExtrinsic = UncheckedExtrinsic,
 	{
 		System: frame_system::{Pallet, Call, Storage, Event<T>},
-		KylinFeed: pallet_feed::{Pallet, Call, Storage, Event<T>},
+		CumulusXcm: cumulus_pallet_xcm::{Pallet, Event<T>, Origin},
+		KylinFeed: kylin_feed::{Pallet, Call, Storage, Event<T>},
 	}
 );
 
 impl system::Config for Test {
-	type BaseCallFilter = frame_support::traits::Everything;
+	type BaseCallFilter = Everything;
 	type BlockWeights = ();
 	type BlockLength = ();
 	type DbWeight = ();
-	type Origin = Origin;
-	type Call = Call;
+	type RuntimeOrigin = RuntimeOrigin;
+	type RuntimeCall = RuntimeCall;
 	type Index = u64;
 	type BlockNumber = u64;
 	type Hash = H256;
@@ -36,7 +42,7 @@ impl system::Config for Test {
 	type AccountId = u64;
 	type Lookup = IdentityLookup<Self::AccountId>;
 	type Header = Header;
-	type Event = Event;
+	type RuntimeEvent = RuntimeEvent;
 	type BlockHashCount = ConstU64<250>;
 	type Version = ();
 	type PalletInfo = PalletInfo;
@@ -46,14 +52,86 @@ impl system::Config for Test {
 	type SystemWeightInfo = ();
 	type SS58Prefix = ConstU16<42>;
 	type OnSetCode = ();
-	type MaxConsumers = frame_support::traits::ConstU32<16>;
+	type MaxConsumers = ConstU32<16>;
+}
+
+impl cumulus_pallet_xcm::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type XcmExecutor = ();
+}
+
+thread_local! {
+	static SENT_XCM: RefCell<Vec<(MultiLocation, Xcm<()>)>> = RefCell::new(Vec::new());
+}
+
+/// A clock stopped at `NOW`.
+pub struct TestTime;
+impl UnixTime for TestTime {
+	fn now() -> Duration {
+		Duration::from_millis(NOW)
+	}
+}
+
+/// Records every message sent.
+pub struct TestSendXcm;
+impl SendXcm for TestSendXcm {
+	fn send_xcm(dest: impl Into<MultiLocation>, msg: Xcm<()>) -> SendResult {
+		SENT_XCM.with(|sent| sent.borrow_mut().push((dest.into(), msg)));
+		Ok(())
+	}
+}
+
+/// The calls sent so far to the oracle of each parachain, oldest first.
+pub(crate) fn sent_queries() -> Vec<(ParaId, KylinOracleFunc)> {
+	SENT_XCM.with(|sent| {
+		sent.borrow()
+			.iter()
+			.map(|(dest, msg)| {
+				let para_id = match dest {
+					MultiLocation { parents: 1, interior: X1(Parachain(id)) } => ParaId::from(*id),
+					_ => panic!("unexpected destination {:?}", dest),
+				};
+				let call = match msg.0.as_slice() {
+					[Transact { call, .. }] => call.clone().into_encoded(),
+					_ => panic!("unexpected message {:?}", msg),
+				};
+				match KylinXcmCall::decode(&mut &call[..]).expect("a kylin-oracle call") {
+					KylinXcmCall::KylinOraclePallet(func) => (para_id, func),
+					call => panic!("unexpected call {:?}", call),
+				}
+			})
+			.collect()
+	})
+}
+
+impl kylin_feed::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type RuntimeOrigin = RuntimeOrigin;
+	type UnixTime = TestTime;
+	type StringLimit = ConstU32<64>;
+	type MaxQueryKeys = ConstU32<4>;
+	type XcmSender = TestSendXcm;
+}
+
+pub fn key(name: &str) -> KeyLimitOf<Test> {
+	name.as_bytes().to_vec().try_into().unwrap()
+}
+
+pub fn sibling(para_id: u32) -> RuntimeOrigin {
+	cumulus_pallet_xcm::Origin::SiblingParachain(para_id.into()).into()
 }
 
-impl pallet_feed::Config for Test {
-	type Event = Event;
+pub fn last_event() -> RuntimeEvent {
+	System::events().pop().expect("an event").event
 }
 
 // Build genesis storage according to the mock runtime.
 pub fn new_test_ext() -> sp_io::TestExternalities {
-	system::GenesisConfig::default().build_storage::<Test>().unwrap().into()
+	let t = system::GenesisConfig::default().build_storage::<Test>().unwrap();
+	let mut ext = sp_io::TestExternalities::new(t);
+	ext.execute_with(|| {
+		SENT_XCM.with(|sent| sent.borrow_mut().clear());
+		System::set_block_number(1);
+	});
+	ext
 }
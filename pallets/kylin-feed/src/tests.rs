@@ -1,20 +1,66 @@
-use crate::{mock::*, Error};
+use crate::{mock::*, *};
 use frame_support::{assert_noop, assert_ok};
 
+fn at(value: i64) -> TimestampedValue {
+	TimestampedValue { value, timestamp: NOW as u128 }
+}
+
 #[test]
-fn it_works_for_default_value() {
+fn querying_feeds_by_keys_sends_a_single_batched_query() {
 	new_test_ext().execute_with(|| {
-		// Dispatch a signed extrinsic.
-		assert_ok!(TemplateModule::do_something(Origin::signed(1), 42));
-		// Read pallet storage and assert an expected result.
-		assert_eq!(TemplateModule::something(), Some(42));
+		let keys = vec![key("btc_usd"), key("eth_usd")];
+		assert_ok!(KylinFeed::query_feed_by_keys(
+			RuntimeOrigin::signed(1),
+			2000.into(),
+			keys.try_into().unwrap()
+		));
+
+		assert_eq!(
+			sent_queries(),
+			vec![(
+				2000.into(),
+				KylinOracleFunc::xcm_query_data_batch {
+					keys: vec![b"btc_usd".to_vec(), b"eth_usd".to_vec()]
+				}
+			)]
+		);
 	});
 }
 
 #[test]
-fn correct_error_for_none_value() {
+fn batched_feed_back_stores_every_value() {
 	new_test_ext().execute_with(|| {
-		// Ensure the expected error is thrown when no value is present.
-		assert_noop!(TemplateModule::cause_error(Origin::signed(1)), Error::<Test>::NoneValue);
+		let values = vec![(b"btc_usd".to_vec(), at(20_000)), (b"eth_usd".to_vec(), at(1_500))];
+		assert_ok!(KylinFeed::xcm_feed_back_batch(
+			sibling(2000),
+			values.clone().try_into().unwrap()
+		));
+
+		assert_eq!(KylinFeed::values(key("btc_usd")), Some(at(20_000)));
+		assert_eq!(KylinFeed::values(key("eth_usd")), Some(at(1_500)));
+		assert_eq!(last_event(), Event::<Test>::QueryFeedBackBatch { values }.into());
 	});
 }
+
+#[test]
+fn batched_feed_back_is_only_from_a_parachain() {
+	new_test_ext().execute_with(|| {
+		let values = vec![(b"btc_usd".to_vec(), at(20_000))];
+		assert_noop!(
+			KylinFeed::xcm_feed_back_batch(RuntimeOrigin::signed(1), values.try_into().unwrap()),
+			DispatchError::BadOrigin
+		);
+	});
+}
+
+#[test]
+fn batched_feed_back_of_more_than_max_query_keys_does_not_decode() {
+	let values = |n: usize| -> Vec<(Vec<u8>, TimestampedValue)> {
+		(0..n).map(|i| (format!("key_{}", i).into_bytes(), at(i as i64))).collect()
+	};
+	// `xcm_feed_back_batch` as encoded by the oracle.
+	let encoded = |n: usize| (11u8, values(n)).encode();
+
+	assert!(Call::<Test>::decode(&mut &encoded(4)[..]).is_ok());
+	assert!(Call::<Test>::decode(&mut &encoded(5)[..]).is_err());
+}
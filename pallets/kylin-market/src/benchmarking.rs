@@ -1,20 +1,249 @@
-//! Benchmarking setup for pallet-template
+//! Benchmarks of the Kylin Market pallet.
+//!
+//! The NFTs traded are feed NFTs of the Kylin Feed API pallet, each in a collection of its own so
+//! that a batch is not bounded by `MaxListingsPerCollection`.
 
 use super::*;
 
-#[allow(unused)]
-use crate::Pallet as Template;
-use frame_benchmarking::{benchmarks, whitelisted_caller};
+use crate::Pallet as KylinMarket;
+use frame_benchmarking::{account, benchmarks, whitelisted_caller};
+use frame_support::traits::{Currency, Get};
 use frame_system::RawOrigin;
+use sp_runtime::traits::{Bounded, One};
+
+/// Oracle parachain of the feeds.
+const SIBLING: u32 = 2000;
+
+type DepositBalanceOf<T> = <<T as pallet_uniques::Config>::Currency as Currency<
+	<T as frame_system::Config>::AccountId,
+>>::Balance;
+
+fn fund<T: Config>(who: &T::AccountId) {
+	<T as pallet::Config>::Currency::make_free_balance_be(
+		who,
+		BalanceOf::<T>::max_value() / 2u32.into(),
+	);
+	<T as pallet_uniques::Config>::Currency::make_free_balance_be(
+		who,
+		DepositBalanceOf::<T>::max_value() / 2u32.into(),
+	);
+}
+
+fn funded<T: Config>(name: &'static str, index: u32) -> T::AccountId {
+	let who = account(name, index, 0);
+	fund::<T>(&who);
+	who
+}
+
+/// The owner of the NFTs traded.
+fn seller<T: Config>() -> T::AccountId {
+	let who = whitelisted_caller();
+	fund::<T>(&who);
+	who
+}
+
+/// Create the `i`th feed NFT of `owner`, in a new collection.
+fn nft<T: Config>(owner: &T::AccountId, i: u32) -> (CollectionId, NftId)
+where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	let collection_id = kylin_feed_api::Pallet::<T>::collection_index();
+	kylin_feed_api::Pallet::<T>::create_collection(
+		RawOrigin::Signed(owner.clone()).into(),
+		Default::default(),
+		None,
+		Default::default(),
+	)
+	.expect("collection is created");
+	let mut key = b"benchmark_market_".to_vec();
+	key.extend_from_slice(&i.to_le_bytes());
+	let nft_id = kylin_feed_api::Pallet::<T>::next_nft_id(collection_id);
+	kylin_feed_api::Pallet::<T>::create_feed(
+		RawOrigin::Signed(owner.clone()).into(),
+		collection_id,
+		SIBLING,
+		key,
+		b"https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".to_vec(),
+		b"/btc_usd".to_vec(),
+	)
+	.expect("feed is created");
+	(collection_id, nft_id)
+}
+
+fn listed<T: Config>(
+	owner: &T::AccountId,
+	i: u32,
+	expires: Option<T::BlockNumber>,
+) -> (CollectionId, NftId)
+where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	let (collection_id, nft_id) = nft::<T>(owner, i);
+	KylinMarket::<T>::list(
+		RawOrigin::Signed(owner.clone()).into(),
+		collection_id,
+		nft_id,
+		T::MinimumOfferAmount::get(),
+		expires,
+	)
+	.expect("NFT is listed");
+	(collection_id, nft_id)
+}
+
+fn offered<T: Config>(
+	maker: &T::AccountId,
+	(collection_id, nft_id): (CollectionId, NftId),
+	expires: Option<T::BlockNumber>,
+) where
+	T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+{
+	KylinMarket::<T>::make_offer(
+		RawOrigin::Signed(maker.clone()).into(),
+		collection_id,
+		nft_id,
+		T::MinimumOfferAmount::get(),
+		expires,
+	)
+	.expect("offer is made");
+}
+
+fn expire<T: Config>() {
+	frame_system::Pallet::<T>::set_block_number(
+		frame_system::Pallet::<T>::block_number() + One::one(),
+	);
+}
 
 benchmarks! {
-	do_something {
-		let s in 0 .. 100;
-		let caller: T::AccountId = whitelisted_caller();
-	}: _(RawOrigin::Signed(caller), s)
+	where_clause { where
+		T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> + kylin_oracle::Config,
+		<T as frame_system::Config>::AccountId: AsRef<[u8]>,
+	}
+
+	buy {
+		let owner = seller::<T>();
+		let (collection_id, nft_id) = listed::<T>(&owner, 0, None);
+		let buyer = funded::<T>("buyer", 0);
+	}: _(RawOrigin::Signed(buyer.clone()), collection_id, nft_id, None)
+	verify {
+		assert_eq!(pallet_uniques::Pallet::<T>::owner(collection_id, nft_id), Some(buyer));
+	}
+
+	buy_batch {
+		let n in 1 .. T::MaxBatchSize::get();
+		let owner = seller::<T>();
+		let items: Vec<_> = (0..n)
+			.map(|i| {
+				let (collection_id, nft_id) = listed::<T>(&owner, i, None);
+				(collection_id, nft_id, None)
+			})
+			.collect();
+		let buyer = funded::<T>("buyer", 0);
+		let items: BoundedVec<_, T::MaxBatchSize> = items.try_into().expect("batch fits");
+	}: _(RawOrigin::Signed(buyer), items)
+
+	list {
+		let owner = seller::<T>();
+		let (collection_id, nft_id) = nft::<T>(&owner, 0);
+	}: _(RawOrigin::Signed(owner), collection_id, nft_id, T::MinimumOfferAmount::get(), None)
+	verify {
+		assert!(ListedNfts::<T>::contains_key(collection_id, nft_id));
+	}
+
+	list_batch {
+		let n in 1 .. T::MaxBatchSize::get();
+		let owner = seller::<T>();
+		let items: Vec<ListItemOf<T>> = (0..n)
+			.map(|i| {
+				let (collection_id, nft_id) = nft::<T>(&owner, i);
+				(collection_id, nft_id, T::MinimumOfferAmount::get(), None)
+			})
+			.collect();
+		let items: BoundedVec<_, T::MaxBatchSize> = items.try_into().expect("batch fits");
+	}: _(RawOrigin::Signed(owner), items)
+
+	unlist {
+		let owner = seller::<T>();
+		let (collection_id, nft_id) = listed::<T>(&owner, 0, None);
+	}: _(RawOrigin::Signed(owner), collection_id, nft_id)
+	verify {
+		assert!(!ListedNfts::<T>::contains_key(collection_id, nft_id));
+	}
+
+	// A full book of `o` expired offers is emptied before the offer is indexed.
+	make_offer {
+		let o in 0 .. T::MaxOffersPerNft::get();
+		let owner = seller::<T>();
+		let token_id = nft::<T>(&owner, 0);
+		let expires = Some(frame_system::Pallet::<T>::block_number() + One::one());
+		for i in 0..o {
+			offered::<T>(&funded::<T>("offerer", i), token_id, expires);
+		}
+		expire::<T>();
+		let maker = funded::<T>("maker", 0);
+	}: _(RawOrigin::Signed(maker.clone()), token_id.0, token_id.1, T::MinimumOfferAmount::get(), None)
+	verify {
+		assert!(Offers::<T>::contains_key(token_id, maker));
+	}
+
+	withdraw_offer {
+		let owner = seller::<T>();
+		let token_id = nft::<T>(&owner, 0);
+		let maker = funded::<T>("maker", 0);
+		offered::<T>(&maker, token_id, None);
+	}: _(RawOrigin::Signed(maker.clone()), token_id.0, token_id.1)
+	verify {
+		assert!(!Offers::<T>::contains_key(token_id, maker));
+	}
+
+	withdraw_offer_batch {
+		let n in 1 .. T::MaxBatchSize::get();
+		let owner = seller::<T>();
+		let maker = funded::<T>("maker", 0);
+		let items: Vec<_> = (0..n)
+			.map(|i| {
+				let token_id = nft::<T>(&owner, i);
+				offered::<T>(&maker, token_id, None);
+				token_id
+			})
+			.collect();
+		let items: BoundedVec<_, T::MaxBatchSize> = items.try_into().expect("batch fits");
+	}: _(RawOrigin::Signed(maker), items)
+
+	accept_offer {
+		let owner = seller::<T>();
+		let token_id = nft::<T>(&owner, 0);
+		let maker = funded::<T>("maker", 0);
+		offered::<T>(&maker, token_id, None);
+	}: _(RawOrigin::Signed(owner), token_id.0, token_id.1, maker.clone())
+	verify {
+		assert_eq!(pallet_uniques::Pallet::<T>::owner(token_id.0, token_id.1), Some(maker));
+	}
+
+	remove_expired_offer {
+		let owner = seller::<T>();
+		let token_id = nft::<T>(&owner, 0);
+		let maker = funded::<T>("maker", 0);
+		offered::<T>(&maker, token_id, Some(frame_system::Pallet::<T>::block_number() + One::one()));
+		expire::<T>();
+		let caller = funded::<T>("caller", 0);
+	}: _(RawOrigin::Signed(caller), token_id.0, token_id.1, maker.clone())
+	verify {
+		assert!(!Offers::<T>::contains_key(token_id, maker));
+	}
+
+	remove_expired_listing {
+		let owner = seller::<T>();
+		let expires = Some(frame_system::Pallet::<T>::block_number() + One::one());
+		let (collection_id, nft_id) = listed::<T>(&owner, 0, expires);
+		expire::<T>();
+		let caller = funded::<T>("caller", 0);
+	}: _(RawOrigin::Signed(caller), collection_id, nft_id)
 	verify {
-		assert_eq!(Something::<T>::get(), Some(s));
+		assert!(!ListedNfts::<T>::contains_key(collection_id, nft_id));
 	}
 
-	impl_benchmark_test_suite!(Template, crate::mock::new_test_ext(), crate::mock::Test);
+	impl_benchmark_test_suite!(KylinMarket, crate::mock::new_test_ext(), crate::mock::Test);
 }
@@ -13,6 +13,7 @@ use frame_system::{ensure_signed, RawOrigin};
 use sp_std::prelude::*;
 use kylin_primitives::nft::{NftInfo, AccountIdOrCollectionNftTuple};
 use kylin_primitives::types::{CollectionId, NftId};
+use kylin_support::collections::vec::bounded::BoundedSortedVec;
 
 #[cfg(test)]
 mod mock;
@@ -24,8 +25,10 @@ mod tests;
 mod benchmarking;
 
 pub mod types;
+pub mod weights;
 use crate::types::*;
 pub use pallet::*;
+pub use weights::WeightInfo;
 
 pub type InstanceInfoOf<T> = NftInfo<
 	<T as frame_system::Config>::AccountId,
@@ -47,6 +50,19 @@ pub type OfferOf<T> = Offer<
 	<T as frame_system::Config>::BlockNumber,
 >;
 
+/// Offers on an NFT as `(amount, maker)`, the best offer last.
+pub type OfferBookOf<T> = BoundedSortedVec<
+	(BalanceOf<T>, <T as frame_system::Config>::AccountId),
+	<T as Config>::MaxOffersPerNft,
+>;
+
+/// Listings of a collection as `(amount, nft_id)`, the floor first.
+pub type FloorIndexOf<T> = BoundedSortedVec<(BalanceOf<T>, NftId), <T as Config>::MaxListingsPerCollection>;
+
+/// Listing of a batch as `(collection_id, nft_id, amount, expires)`.
+pub type ListItemOf<T> =
+	(CollectionId, NftId, BalanceOf<T>, Option<<T as frame_system::Config>::BlockNumber>);
+
 #[frame_support::pallet]
 pub mod pallet {
 	use super::*;
@@ -76,16 +92,50 @@ pub mod pallet {
 		OfferOf<T>, OptionQuery,
 	>;
 
+	/// Price-sorted index of the `Offers` on each NFT
+	#[pallet::storage]
+	#[pallet::getter(fn offer_book)]
+	pub type OfferBook<T: Config> = StorageMap<
+		_,
+		Blake2_128Concat, (CollectionId, NftId),
+		OfferBookOf<T>, ValueQuery,
+	>;
+
+	/// Price-sorted index of the `ListedNfts` of each collection
+	#[pallet::storage]
+	#[pallet::getter(fn floor_index)]
+	pub type FloorIndex<T: Config> = StorageMap<
+		_,
+		Blake2_128Concat, CollectionId,
+		FloorIndexOf<T>, ValueQuery,
+	>;
+
 	#[pallet::config]
-	pub trait Config: frame_system::Config + kylin_feed::Config {
-		type Event: From<Event<Self>> + IsType<<Self as frame_system::Config>::Event>;
+	pub trait Config: frame_system::Config + kylin_feed_api::Config {
+		type RuntimeEvent: From<Event<Self>> + IsType<<Self as frame_system::Config>::RuntimeEvent>;
 
-		type ProtocolOrigin: EnsureOrigin<Self::Origin>;
+		type ProtocolOrigin: EnsureOrigin<<Self as frame_system::Config>::RuntimeOrigin>;
 
 		type Currency: ReservableCurrency<Self::AccountId>;
 
 		#[pallet::constant]
 		type MinimumOfferAmount: Get<BalanceOf<Self>>;
+
+		/// Maximum number of offers on a single NFT. When full, expired offers are removed and
+		/// then the lowest is outbid.
+		#[pallet::constant]
+		type MaxOffersPerNft: Get<u32>;
+
+		/// Maximum number of NFTs listed at the same time in a collection.
+		#[pallet::constant]
+		type MaxListingsPerCollection: Get<u32>;
+
+		/// Maximum number of items of a batched call.
+		#[pallet::constant]
+		type MaxBatchSize: Get<u32>;
+
+		/// Weight information for extrinsics in this pallet.
+		type WeightInfo: WeightInfo;
 	}
 
 	#[pallet::event]
@@ -124,6 +174,10 @@ pub mod pallet {
 			collection_id: CollectionId,
 			nft_id: NftId,
 		},
+		/// An expired offer was removed and its amount unreserved
+		OfferExpired { maker: T::AccountId, collection_id: CollectionId, nft_id: NftId },
+		/// An expired listing was removed and its NFT unlocked
+		ListingExpired { owner: T::AccountId, collection_id: CollectionId, nft_id: NftId },
 	}
 
 	#[pallet::error]
@@ -143,14 +197,19 @@ pub mod pallet {
 		ListingHasExpired,
 		PriceDiffersFromExpected,
 		NonTransferable,
+		TooManyListings,
+		/// Only expired offers and listings are removed by anyone
+		NotExpired,
 	}
 
 
 	#[pallet::call]
 	impl<T: Config> Pallet<T>
-		where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId>,
+		where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> +
+		kylin_oracle::Config,
+		<T as frame_system::Config>::AccountId: AsRef<[u8]>,
 	{
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::buy())]
 		pub fn buy(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -162,7 +221,7 @@ pub mod pallet {
 			Self::do_buy(sender, collection_id, nft_id, amount, false)
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::list())]
 		pub fn list(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -171,37 +230,39 @@ pub mod pallet {
 			expires: Option<T::BlockNumber>,
 		) -> DispatchResult {
 			let sender = ensure_signed(origin)?;
-			let owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id)
-				.ok_or(Error::<T>::TokenDoesNotExist)?;
 
-			ensure!(
-				!Self::is_nft_owned_by_nft(collection_id, nft_id),
-				Error::<T>::CannotListNftOwnedByNft
-			);
-			ensure!(sender == owner, Error::<T>::NoPermission);
+			Self::do_list(sender, collection_id, nft_id, amount, expires)
+		}
 
-			let nft = kylin_feed::Pallet::<T>::nfts(collection_id, nft_id)
-				.ok_or(Error::<T>::TokenDoesNotExist)?;
+		/// List several NFTs at once, the whole batch fails if any listing fails.
+		#[pallet::weight(<T as Config>::WeightInfo::list_batch(items.len() as u32))]
+		pub fn list_batch(
+			origin: OriginFor<T>,
+			items: BoundedVec<ListItemOf<T>, T::MaxBatchSize>,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
 
-			kylin_feed::Pallet::<T>::check_is_transferable(&nft)?;
-			kylin_feed::Pallet::<T>::set_lock((collection_id, nft_id), true);
-			if Self::is_nft_listed(collection_id, nft_id) {
-				ListedNfts::<T>::remove(collection_id, nft_id);
+			for (collection_id, nft_id, amount, expires) in items {
+				Self::do_list(sender.clone(), collection_id, nft_id, amount, expires)?;
 			}
+			Ok(())
+		}
 
-			// Add new ListInfo with listed_by, amount, Option<BlockNumber>
-			ListedNfts::<T>::insert(
-				collection_id,
-				nft_id,
-				ListInfo { listed_by: sender, amount, expires },
-			);
-
-			Self::deposit_event(Event::TokenListed { owner, collection_id, nft_id, price: amount });
+		/// Buy several NFTs at once, the whole batch fails if any purchase fails.
+		#[pallet::weight(<T as Config>::WeightInfo::buy_batch(items.len() as u32))]
+		pub fn buy_batch(
+			origin: OriginFor<T>,
+			items: BoundedVec<(CollectionId, NftId, Option<BalanceOf<T>>), T::MaxBatchSize>,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
 
+			for (collection_id, nft_id, amount) in items {
+				Self::do_buy(sender.clone(), collection_id, nft_id, amount, false)?;
+			}
 			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::unlist())]
 		pub fn unlist(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -215,16 +276,16 @@ pub mod pallet {
 			// Ensure owner of NFT is performing call to unlist
 			ensure!(sender == owner, Error::<T>::NoPermission);
 			// Set the NFT lock to false to allow interactions with the NFT
-			kylin_feed::Pallet::<T>::set_lock((collection_id, nft_id), false);
+			kylin_feed_api::Pallet::<T>::set_lock((collection_id, nft_id), false);
 			// Remove from storage
-			ListedNfts::<T>::remove(collection_id, nft_id);
+			Self::remove_listing(collection_id, nft_id);
 			// Emit TokenUnlisted Event
 			Self::deposit_event(Event::TokenUnlisted { owner, collection_id, nft_id });
 
 			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::make_offer(T::MaxOffersPerNft::get()))]
 		pub fn make_offer(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -250,6 +311,28 @@ pub mod pallet {
 			<T as pallet::Config>::Currency::reserve(&sender, amount)?;
 
 			let token_id = (collection_id, nft_id);
+			// Index the offer. If the book is full, expired offers make room first, then the
+			// lowest live offer is outbid.
+			OfferBook::<T>::try_mutate(token_id, |book| -> DispatchResult {
+				if book.len() >= OfferBookOf::<T>::bound() {
+					Self::remove_expired_offers(collection_id, nft_id, book);
+				}
+				if book.len() >= OfferBookOf::<T>::bound() {
+					let (lowest, _) = book.first().ok_or(Error::<T>::OfferTooLow)?;
+					ensure!(amount > *lowest, Error::<T>::OfferTooLow);
+					let (_, outbid) = book.remove(0);
+					if let Some(offer) = Offers::<T>::take(token_id, &outbid) {
+						<T as pallet::Config>::Currency::unreserve(&offer.maker, offer.amount);
+					}
+					Self::deposit_event(Event::OfferWithdrawn {
+						sender: outbid,
+						collection_id,
+						nft_id,
+					});
+				}
+				book.try_insert((amount, sender.clone())).map_err(|_| Error::<T>::OfferTooLow)?;
+				Ok(())
+			})?;
 			Offers::<T>::insert(
 				token_id,
 				sender.clone(),
@@ -266,7 +349,7 @@ pub mod pallet {
 			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::withdraw_offer())]
 		pub fn withdraw_offer(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -274,33 +357,24 @@ pub mod pallet {
 		) -> DispatchResult {
 			let sender = ensure_signed(origin)?;
 
-			let token_id = (collection_id, nft_id);
-			// Ensure that offer exists from sender that is withdrawing their offer
-			Offers::<T>::try_mutate_exists(
-				token_id,
-				sender.clone(),
-				|maybe_offer| -> DispatchResult {
-					let offer = maybe_offer.take().ok_or(Error::<T>::UnknownOffer)?;
-					// Ensure NFT exists & sender is not owner
-					let owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id)
-						.ok_or(Error::<T>::TokenDoesNotExist)?;
-					// Cannot withdraw offer on own token
-					ensure!(
-						sender == owner || sender == offer.maker,
-						Error::<T>::CannotWithdrawOffer
-					);
-
-					// Unreserve currency from offerer account
-					<T as pallet::Config>::Currency::unreserve(&offer.maker, offer.amount);
-					// Emit OfferWithdrawn Event
-					Self::deposit_event(Event::OfferWithdrawn { sender, collection_id, nft_id });
+			Self::do_withdraw_offer(sender, collection_id, nft_id)
+		}
 
-					Ok(())
-				},
-			)
+		/// Withdraw several offers at once, the whole batch fails if any withdrawal fails.
+		#[pallet::weight(<T as Config>::WeightInfo::withdraw_offer_batch(items.len() as u32))]
+		pub fn withdraw_offer_batch(
+			origin: OriginFor<T>,
+			items: BoundedVec<(CollectionId, NftId), T::MaxBatchSize>,
+		) -> DispatchResult {
+			let sender = ensure_signed(origin)?;
+
+			for (collection_id, nft_id) in items {
+				Self::do_withdraw_offer(sender.clone(), collection_id, nft_id)?;
+			}
+			Ok(())
 		}
 
-		#[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+		#[pallet::weight(<T as Config>::WeightInfo::accept_offer())]
 		pub fn accept_offer(
 			origin: OriginFor<T>,
 			collection_id: CollectionId,
@@ -318,6 +392,7 @@ pub mod pallet {
 				offerer.clone(),
 				|maybe_offer| -> DispatchResult {
 					let offer = maybe_offer.take().ok_or(Error::<T>::UnknownOffer)?;
+					OfferBook::<T>::mutate(token_id, |book| book.remove_item(&(offer.amount, offerer.clone())));
 
 					if let Some(expires) = offer.expires {
 						if expires <= <frame_system::Pallet<T>>::block_number() {
@@ -339,11 +414,59 @@ pub mod pallet {
 				},
 			)
 		}
+
+		/// Remove an expired offer, unreserving its amount.
+		///
+		/// Can be called by any signed origin.
+		#[pallet::weight(<T as Config>::WeightInfo::remove_expired_offer())]
+		pub fn remove_expired_offer(
+			origin: OriginFor<T>,
+			collection_id: CollectionId,
+			nft_id: NftId,
+			maker: T::AccountId,
+		) -> DispatchResult {
+			ensure_signed(origin)?;
+
+			let token_id = (collection_id, nft_id);
+			let offer = Offers::<T>::get(token_id, &maker).ok_or(Error::<T>::UnknownOffer)?;
+			ensure!(Self::has_expired(offer.expires), Error::<T>::NotExpired);
+
+			OfferBook::<T>::mutate(token_id, |book| book.remove_item(&(offer.amount, maker.clone())));
+			Self::remove_offer(collection_id, nft_id, offer);
+			Ok(())
+		}
+
+		/// Remove an expired listing, unlocking its NFT.
+		///
+		/// Can be called by any signed origin.
+		#[pallet::weight(<T as Config>::WeightInfo::remove_expired_listing())]
+		pub fn remove_expired_listing(
+			origin: OriginFor<T>,
+			collection_id: CollectionId,
+			nft_id: NftId,
+		) -> DispatchResult {
+			ensure_signed(origin)?;
+
+			let list_info = Self::listed_nfts(collection_id, nft_id)
+				.ok_or(Error::<T>::TokenNotForSale)?;
+			ensure!(Self::has_expired(list_info.expires), Error::<T>::NotExpired);
+
+			kylin_feed_api::Pallet::<T>::set_lock((collection_id, nft_id), false);
+			Self::remove_listing(collection_id, nft_id);
+			Self::deposit_event(Event::ListingExpired {
+				owner: list_info.listed_by,
+				collection_id,
+				nft_id,
+			});
+			Ok(())
+		}
 	}
 }
 
 impl<T: Config> Pallet<T>
-	where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId>,
+	where T: pallet_uniques::Config<CollectionId = CollectionId, ItemId = NftId> +
+	kylin_oracle::Config,
+	<T as frame_system::Config>::AccountId: AsRef<[u8]>,
 {
 	fn do_buy(
 		buyer: T::AccountId,
@@ -357,16 +480,19 @@ impl<T: Config> Pallet<T>
 			.ok_or(Error::<T>::TokenDoesNotExist)?;
 		ensure!(buyer != owner, Error::<T>::CannotBuyOwnToken);
 
-		let owner_origin = T::Origin::from(RawOrigin::Signed(owner.clone()));
+		let owner_origin = RawOrigin::Signed(owner.clone()).into();
 		let token_id = (collection_id, nft_id);
 
 		let list_price = if is_offer {
-			Offers::<T>::get(token_id, buyer.clone())
+			let amount = Offers::<T>::get(token_id, buyer.clone())
 				.map(|o| o.amount)
-				.ok_or(Error::<T>::UnknownOffer)?
+				.ok_or(Error::<T>::UnknownOffer)?;
+			// The NFT changes hands, a listing of the previous owner can no longer be bought
+			Self::remove_listing(collection_id, nft_id);
+			amount
 		} else {
 			let list_info =
-				ListedNfts::<T>::take(collection_id, nft_id).ok_or(Error::<T>::TokenNotForSale)?;
+				Self::remove_listing(collection_id, nft_id).ok_or(Error::<T>::TokenNotForSale)?;
 			// Ensure that the current owner is the one that listed the NFT
 			ensure!(list_info.listed_by == owner, Error::<T>::TokenNotForSale);
 			// Ensure the listing has not expired if Some(expires)
@@ -386,7 +512,7 @@ impl<T: Config> Pallet<T>
 		}
 
 		// Set NFT Lock status to false to facilitate the purchase
-		kylin_feed::Pallet::<T>::set_lock((collection_id, nft_id), false);
+		kylin_feed_api::Pallet::<T>::set_lock((collection_id, nft_id), false);
 
 		// Transfer currency then transfer the NFT
 		<T as pallet::Config>::Currency::transfer(
@@ -397,7 +523,7 @@ impl<T: Config> Pallet<T>
 		)?;
 
 		let new_owner = AccountIdOrCollectionNftTuple::AccountId(buyer.clone());
-		kylin_feed::Pallet::<T>::send(owner_origin, collection_id, nft_id, new_owner)?;
+		kylin_feed_api::Pallet::<T>::send(owner_origin, collection_id, nft_id, new_owner)?;
 
 		Self::deposit_event(Event::TokenSold {
 			owner,
@@ -410,6 +536,132 @@ impl<T: Config> Pallet<T>
 		Ok(())
 	}
 
+	fn do_list(
+		sender: T::AccountId,
+		collection_id: CollectionId,
+		nft_id: NftId,
+		amount: BalanceOf<T>,
+		expires: Option<T::BlockNumber>,
+	) -> DispatchResult {
+		let owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id)
+			.ok_or(Error::<T>::TokenDoesNotExist)?;
+
+		ensure!(
+			!Self::is_nft_owned_by_nft(collection_id, nft_id),
+			Error::<T>::CannotListNftOwnedByNft
+		);
+		ensure!(sender == owner, Error::<T>::NoPermission);
+
+		let nft = kylin_feed_api::Pallet::<T>::nfts(collection_id, nft_id)
+			.ok_or(Error::<T>::TokenDoesNotExist)?;
+
+		kylin_feed_api::Pallet::<T>::check_is_transferable(&nft)?;
+		kylin_feed_api::Pallet::<T>::set_lock((collection_id, nft_id), true);
+		Self::remove_listing(collection_id, nft_id);
+
+		FloorIndex::<T>::try_mutate(collection_id, |index| {
+			index.try_insert((amount, nft_id)).map_err(|_| Error::<T>::TooManyListings)
+		})?;
+		// Add new ListInfo with listed_by, amount, Option<BlockNumber>
+		ListedNfts::<T>::insert(
+			collection_id,
+			nft_id,
+			ListInfo { listed_by: sender, amount, expires },
+		);
+
+		Self::deposit_event(Event::TokenListed { owner, collection_id, nft_id, price: amount });
+
+		Ok(())
+	}
+
+	fn do_withdraw_offer(
+		sender: T::AccountId,
+		collection_id: CollectionId,
+		nft_id: NftId,
+	) -> DispatchResult {
+		let token_id = (collection_id, nft_id);
+		// Ensure that offer exists from sender that is withdrawing their offer
+		Offers::<T>::try_mutate_exists(
+			token_id,
+			sender.clone(),
+			|maybe_offer| -> DispatchResult {
+				let offer = maybe_offer.take().ok_or(Error::<T>::UnknownOffer)?;
+				// Ensure NFT exists & sender is not owner
+				let owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id)
+					.ok_or(Error::<T>::TokenDoesNotExist)?;
+				// Cannot withdraw offer on own token
+				ensure!(
+					sender == owner || sender == offer.maker,
+					Error::<T>::CannotWithdrawOffer
+				);
+
+				OfferBook::<T>::mutate(token_id, |book| {
+					book.remove_item(&(offer.amount, offer.maker.clone()))
+				});
+				// Unreserve currency from offerer account
+				<T as pallet::Config>::Currency::unreserve(&offer.maker, offer.amount);
+				// Emit OfferWithdrawn Event
+				Self::deposit_event(Event::OfferWithdrawn { sender, collection_id, nft_id });
+
+				Ok(())
+			},
+		)
+	}
+
+	/// Remove the listing of an NFT and its floor index entry.
+	fn remove_listing(collection_id: CollectionId, nft_id: NftId) -> Option<ListInfoOf<T>> {
+		let list_info = ListedNfts::<T>::take(collection_id, nft_id)?;
+		FloorIndex::<T>::mutate(collection_id, |index| {
+			index.remove_item(&(list_info.amount, nft_id))
+		});
+		Some(list_info)
+	}
+
+	/// Remove an offer taken out of the book, unreserving its amount.
+	fn remove_offer(collection_id: CollectionId, nft_id: NftId, offer: OfferOf<T>) {
+		Offers::<T>::remove((collection_id, nft_id), &offer.maker);
+		<T as pallet::Config>::Currency::unreserve(&offer.maker, offer.amount);
+		Self::deposit_event(Event::OfferExpired { maker: offer.maker, collection_id, nft_id });
+	}
+
+	/// Remove the expired offers of `book`, the offer book of an NFT.
+	fn remove_expired_offers(collection_id: CollectionId, nft_id: NftId, book: &mut OfferBookOf<T>) {
+		let token_id = (collection_id, nft_id);
+		let mut expired = Vec::new();
+		book.retain(|(_, maker)| match Offers::<T>::get(token_id, maker) {
+			Some(offer) if Self::has_expired(offer.expires) => {
+				expired.push(offer);
+				false
+			},
+			_ => true,
+		});
+		for offer in expired {
+			Self::remove_offer(collection_id, nft_id, offer);
+		}
+	}
+
+	/// Whether an offer or a listing expiring at `expires` has expired.
+	fn has_expired(expires: Option<T::BlockNumber>) -> bool {
+		expires.map_or(false, |expires| expires <= <frame_system::Pallet<T>>::block_number())
+	}
+
+	/// Lowest listing of a collection that has not expired, as `(amount, nft_id)`.
+	pub fn floor(collection_id: CollectionId) -> Option<(BalanceOf<T>, NftId)> {
+		FloorIndex::<T>::get(collection_id).iter().find_map(|(amount, nft_id)| {
+			Self::listed_nfts(collection_id, nft_id)
+				.filter(|list_info| !Self::has_expired(list_info.expires))
+				.map(|_| (*amount, *nft_id))
+		})
+	}
+
+	/// Highest offer on an NFT that has not expired.
+	pub fn best_offer(collection_id: CollectionId, nft_id: NftId) -> Option<OfferOf<T>> {
+		let token_id = (collection_id, nft_id);
+		OfferBook::<T>::get(token_id).iter().rev().find_map(|(_, maker)| {
+			Offers::<T>::get(token_id, maker).filter(|offer| !Self::has_expired(offer.expires))
+		})
+	}
+
 	fn is_nft_listed(collection_id: CollectionId, nft_id: NftId) -> bool {
 		ListedNfts::<T>::contains_key(collection_id, nft_id)
 	}
@@ -422,7 +674,7 @@ impl<T: Config> Pallet<T>
 		let owner = pallet_uniques::Pallet::<T>::owner(collection_id, nft_id);
 		if let Some(current_owner) = owner {
 			let current_owner_cid_nid =
-				kylin_feed::Pallet::<T>::decode_nft_account_id::<T::AccountId>(current_owner);
+				kylin_feed_api::Pallet::<T>::decode_nft_account_id::<T::AccountId>(current_owner);
 			if let Some(_current_owner_cid_nid) = current_owner_cid_nid {
 				return true
 			}
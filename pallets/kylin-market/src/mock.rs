@@ -1,15 +1,34 @@
-use crate as pallet_template;
-use frame_support::traits::{ConstU16, ConstU64};
-use frame_system as system;
-use sp_core::H256;
+use crate as kylin_market;
+use crate::*;
+use frame_support::{
+	parameter_types,
+	traits::{
+		AsEnsureOriginWithArg, ConstBool, ConstU128, ConstU16, ConstU32, ConstU64, ConstU8,
+		Everything, SortedMembers,
+	},
+	weights::{ConstantMultiplier, IdentityFee},
+};
+use frame_system::{EnsureRoot, EnsureSigned};
+use kylin_oracle::MedianCombineData;
+use kylin_primitives::types::{CollectionId, NftId};
+use sp_core::{
+	sr25519::{self, Signature},
+	H256,
+};
 use sp_runtime::{
-	testing::Header,
-	traits::{BlakeTwo256, IdentityLookup},
+	testing::{Header, TestXt},
+	traits::{BlakeTwo256, Extrinsic as ExtrinsicT, IdentityLookup, Verify},
 };
+use std::cell::RefCell;
+use xcm::latest::prelude::*;
 
 type UncheckedExtrinsic = frame_system::mocking::MockUncheckedExtrinsic<Test>;
 type Block = frame_system::mocking::MockBlock<Test>;
 
+pub type AccountId = sr25519::Public;
+pub type Balance = u64;
+pub type Extrinsic = TestXt<RuntimeCall, ()>;
+
 // Configure a mock runtime to test the pallet.
 frame_support::construct_runtime!(
 	pub enum Test where
@@ -17,43 +36,227 @@ frame_support::construct_runtime!(
 		NodeBlock = Block,
 		UncheckedExtrinsic = UncheckedExtrinsic,
 	{
-		System: frame_system::{Pallet, Call, Storage, Event<T>},
-		TemplateModule: pallet_template::{Pallet, Call, Storage, Event<T>},
+		System: frame_system::{Pallet, Call, Config, Storage, Event<T>},
+		Balances: pallet_balances::{Pallet, Call, Storage, Config<T>, Event<T>},
+		Timestamp: pallet_timestamp::{Pallet, Call, Storage, Inherent},
+		TransactionPayment: pallet_transaction_payment::{Pallet, Storage, Event<T>},
+		CumulusXcm: cumulus_pallet_xcm::{Pallet, Event<T>, Origin},
+		Uniques: pallet_uniques::{Pallet, Call, Storage, Event<T>},
+		KylinOracle: kylin_oracle::{Pallet, Call, Storage, Event<T>, ValidateUnsigned},
+		KylinFeedApi: kylin_feed_api::{Pallet, Call, Storage, Event<T>},
+		KylinMarket: kylin_market::{Pallet, Call, Storage, Event<T>},
 	}
 );
 
-impl system::Config for Test {
-	type BaseCallFilter = frame_support::traits::Everything;
+impl frame_system::Config for Test {
+	type BaseCallFilter = Everything;
 	type BlockWeights = ();
 	type BlockLength = ();
 	type DbWeight = ();
-	type Origin = Origin;
-	type Call = Call;
+	type RuntimeOrigin = RuntimeOrigin;
+	type RuntimeCall = RuntimeCall;
 	type Index = u64;
 	type BlockNumber = u64;
 	type Hash = H256;
 	type Hashing = BlakeTwo256;
-	type AccountId = u64;
+	type AccountId = AccountId;
 	type Lookup = IdentityLookup<Self::AccountId>;
 	type Header = Header;
-	type Event = Event;
+	type RuntimeEvent = RuntimeEvent;
 	type BlockHashCount = ConstU64<250>;
 	type Version = ();
 	type PalletInfo = PalletInfo;
-	type AccountData = ();
+	type AccountData = pallet_balances::AccountData<Balance>;
 	type OnNewAccount = ();
 	type OnKilledAccount = ();
 	type SystemWeightInfo = ();
 	type SS58Prefix = ConstU16<42>;
 	type OnSetCode = ();
-	type MaxConsumers = frame_support::traits::ConstU32<16>;
+	type MaxConsumers = ConstU32<16>;
+}
+
+impl pallet_balances::Config for Test {
+	type Balance = Balance;
+	type RuntimeEvent = RuntimeEvent;
+	type DustRemoval = ();
+	type ExistentialDeposit = ConstU64<1>;
+	type AccountStore = System;
+	type WeightInfo = ();
+	type MaxLocks = ();
+	type MaxReserves = ConstU32<50>;
+	type ReserveIdentifier = [u8; 8];
+}
+
+impl pallet_timestamp::Config for Test {
+	type Moment = u64;
+	type OnTimestampSet = ();
+	type MinimumPeriod = ConstU64<1>;
+	type WeightInfo = ();
+}
+
+impl pallet_transaction_payment::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type OnChargeTransaction = pallet_transaction_payment::CurrencyAdapter<Balances, ()>;
+	type OperationalFeeMultiplier = ConstU8<5>;
+	type WeightToFee = IdentityFee<Balance>;
+	type LengthToFee = ConstantMultiplier<Balance, ConstU64<1>>;
+	type FeeMultiplierUpdate = ();
+}
+
+impl cumulus_pallet_xcm::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type XcmExecutor = ();
 }
 
-impl pallet_template::Config for Test {
-	type Event = Event;
+impl pallet_uniques::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type CollectionId = CollectionId;
+	type ItemId = NftId;
+	type Currency = Balances;
+	type ForceOrigin = EnsureRoot<AccountId>;
+	type CreateOrigin = AsEnsureOriginWithArg<EnsureSigned<AccountId>>;
+	type Locker = KylinFeedApi;
+	type CollectionDeposit = ConstU64<0>;
+	type ItemDeposit = ConstU64<0>;
+	type MetadataDepositBase = ConstU64<0>;
+	type AttributeDepositBase = ConstU64<0>;
+	type DepositPerByte = ConstU64<0>;
+	type StringLimit = ConstU32<64>;
+	type KeyLimit = ConstU32<32>;
+	type ValueLimit = ConstU32<64>;
+	type WeightInfo = ();
+}
+
+impl frame_system::offchain::SigningTypes for Test {
+	type Public = <Signature as Verify>::Signer;
+	type Signature = Signature;
+}
+
+impl<LocalCall> frame_system::offchain::SendTransactionTypes<LocalCall> for Test
+where
+	RuntimeCall: From<LocalCall>,
+{
+	type OverarchingCall = RuntimeCall;
+	type Extrinsic = Extrinsic;
+}
+
+impl<LocalCall> frame_system::offchain::CreateSignedTransaction<LocalCall> for Test
+where
+	RuntimeCall: From<LocalCall>,
+{
+	fn create_transaction<C: frame_system::offchain::AppCrypto<Self::Public, Self::Signature>>(
+		call: RuntimeCall,
+		_public: <Signature as Verify>::Signer,
+		_account: AccountId,
+		nonce: u64,
+	) -> Option<(RuntimeCall, <Extrinsic as ExtrinsicT>::SignaturePayload)> {
+		Some((call, (nonce, ())))
+	}
+}
+
+thread_local! {
+	static SENT_XCM: RefCell<Vec<(MultiLocation, Xcm<()>)>> = RefCell::new(Vec::new());
+}
+
+/// Oracle operators, none are needed by the feed api.
+pub struct Members;
+impl SortedMembers<AccountId> for Members {
+	fn sorted_members() -> Vec<AccountId> {
+		Vec::new()
+	}
+}
+
+/// Records every message sent.
+pub struct TestSendXcm;
+impl SendXcm for TestSendXcm {
+	fn send_xcm(dest: impl Into<MultiLocation>, msg: Xcm<()>) -> SendResult {
+		SENT_XCM.with(|sent| sent.borrow_mut().push((dest.into(), msg)));
+		Ok(())
+	}
+}
+
+parameter_types! {
+	pub const UnsignedPriority: u64 = 1 << 20;
+}
+
+impl kylin_oracle::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type AuthorityId = kylin_oracle::crypto::TestAuthId;
+	type RuntimeCall = RuntimeCall;
+	type RuntimeOrigin = RuntimeOrigin;
+	type XcmSender = TestSendXcm;
+	type UnsignedPriority = UnsignedPriority;
+	type UnixTime = Timestamp;
+	type WeightInfo = ();
+	type EstimateCallFee = TransactionPayment;
+	type Currency = Balances;
+
+	type CombineData = MedianCombineData<Self, ConstU32<1>, ConstU128<600_000>>;
+	type Members = Members;
+	type StrLimit = ConstU32<64>;
+	type MaxResponseSize = ConstU32<1024>;
+	type MaxFeedersPerKey = ConstU32<4>;
+	type MaxQueryKeys = ConstU32<4>;
+	type MaxFeedValues = ConstU32<8>;
+	type MaxSubscribersPerKey = ConstU32<2>;
+	type MaxSubscriptionsPerPara = ConstU32<3>;
+	type MaxHistoryLen = ConstU32<4>;
+	type SingleFeeder = ConstBool<false>;
+	type MaxHotKeys = ConstU32<2>;
+	type HotKeysOrigin = EnsureRoot<AccountId>;
+}
+
+impl kylin_feed_api::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type RuntimeOrigin = RuntimeOrigin;
+	type MaxRecursions = ConstU32<3>;
+	type UnixTime = Timestamp;
+	type ResourceSymbolLimit = ConstU32<10>;
+	type PartsLimit = ConstU32<4>;
+	type MaxPriorities = ConstU32<4>;
+	type CollectionSymbolLimit = ConstU32<16>;
+	type MaxResourcesOnMint = ConstU32<4>;
+	type XcmSender = TestSendXcm;
+	type DeletionChunkSize = ConstU32<2>;
+	type MaxDescendants = ConstU32<4>;
+	type WeightInfo = ();
+}
+
+impl kylin_market::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type ProtocolOrigin = EnsureRoot<AccountId>;
+	type Currency = Balances;
+	type MinimumOfferAmount = ConstU64<10>;
+	type MaxOffersPerNft = ConstU32<2>;
+	type MaxListingsPerCollection = ConstU32<2>;
+	type MaxBatchSize = ConstU32<3>;
+	type WeightInfo = ();
+}
+
+/// Free balance of each test account.
+pub const ENDOWMENT: Balance = 1_000_000;
+
+pub fn account(seed: u8) -> AccountId {
+	sr25519::Public::from_raw([seed; 32])
+}
+
+pub fn last_event() -> RuntimeEvent {
+	System::events().pop().expect("an event").event
 }
 
 // Build genesis storage according to the mock runtime.
 pub fn new_test_ext() -> sp_io::TestExternalities {
-	system::GenesisConfig::default().build_storage::<Test>().unwrap().into()
+	let mut t = frame_system::GenesisConfig::default().build_storage::<Test>().unwrap();
+	pallet_balances::GenesisConfig::<Test> {
+		balances: (1..=4).map(|seed| (account(seed), ENDOWMENT)).collect(),
+	}
+	.assimilate_storage(&mut t)
+	.unwrap();
+	let mut ext = sp_io::TestExternalities::new(t);
+	ext.execute_with(|| {
+		SENT_XCM.with(|sent| sent.borrow_mut().clear());
+		System::set_block_number(1);
+		Timestamp::set_timestamp(1_000_000);
+	});
+	ext
 }
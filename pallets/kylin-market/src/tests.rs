@@ -1,20 +1,249 @@
-use crate::{mock::*, Error};
-use frame_support::{assert_noop, assert_ok};
+use crate::{mock::*, *};
+use frame_support::{assert_noop, assert_ok, traits::ReservableCurrency};
+
+fn create_feed(owner: u8, key: &str) -> (CollectionId, NftId) {
+	assert_ok!(KylinFeedApi::create_collection(
+		RuntimeOrigin::signed(account(owner)),
+		b"collection".to_vec().try_into().unwrap(),
+		None,
+		b"COL".to_vec().try_into().unwrap(),
+	));
+	let collection_id = KylinFeedApi::collection_index() - 1;
+	assert_ok!(KylinFeedApi::create_feed(
+		RuntimeOrigin::signed(account(owner)),
+		collection_id,
+		2000,
+		key.as_bytes().to_vec(),
+		b"https://api.example.com/price".to_vec(),
+		b"/price".to_vec(),
+	));
+	(collection_id, KylinFeedApi::next_nft_id(collection_id) - 1)
+}
+
+fn offer(
+	maker: u8,
+	(collection_id, nft_id): (CollectionId, NftId),
+	amount: Balance,
+	expires: Option<u64>,
+) {
+	assert_ok!(KylinMarket::make_offer(
+		RuntimeOrigin::signed(account(maker)),
+		collection_id,
+		nft_id,
+		amount,
+		expires
+	));
+}
+
+fn owner_of((collection_id, nft_id): (CollectionId, NftId)) -> Option<AccountId> {
+	pallet_uniques::Pallet::<Test>::owner(collection_id, nft_id)
+}
+
+#[test]
+fn a_listed_nft_is_bought_at_its_price() {
+	new_test_ext().execute_with(|| {
+		let (collection_id, nft_id) = create_feed(1, "btc_usd");
+		assert_ok!(KylinMarket::list(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			nft_id,
+			100,
+			None
+		));
+		assert_eq!(KylinMarket::floor(collection_id), Some((100, nft_id)));
+		assert_noop!(
+			KylinMarket::buy(RuntimeOrigin::signed(account(2)), collection_id, nft_id, Some(90)),
+			Error::<Test>::PriceDiffersFromExpected
+		);
+
+		assert_ok!(KylinMarket::buy(
+			RuntimeOrigin::signed(account(2)),
+			collection_id,
+			nft_id,
+			Some(100)
+		));
+		assert_eq!(owner_of((collection_id, nft_id)), Some(account(2)));
+		assert_eq!(Balances::free_balance(account(1)), ENDOWMENT + 100);
+		assert_eq!(Balances::free_balance(account(2)), ENDOWMENT - 100);
+		assert_eq!(KylinMarket::floor(collection_id), None);
+		assert!(!KylinFeedApi::lock((collection_id, nft_id)));
+	});
+}
+
+#[test]
+fn the_floor_skips_expired_listings() {
+	new_test_ext().execute_with(|| {
+		let (collection_id, cheap) = create_feed(1, "btc_usd");
+		assert_ok!(KylinFeedApi::create_feed(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			2000,
+			b"eth_usd".to_vec(),
+			b"https://api.example.com/price".to_vec(),
+			b"/price".to_vec(),
+		));
+		let dear = KylinFeedApi::next_nft_id(collection_id) - 1;
+		assert_ok!(KylinMarket::list_batch(
+			RuntimeOrigin::signed(account(1)),
+			vec![(collection_id, cheap, 50, Some(5)), (collection_id, dear, 80, None)]
+				.try_into()
+				.unwrap()
+		));
+		assert_eq!(KylinMarket::floor(collection_id), Some((50, cheap)));
+
+		System::set_block_number(5);
+		assert_eq!(KylinMarket::floor(collection_id), Some((80, dear)));
+		assert_noop!(
+			KylinMarket::buy(RuntimeOrigin::signed(account(2)), collection_id, cheap, None),
+			Error::<Test>::ListingHasExpired
+		);
+	});
+}
+
+#[test]
+fn expired_listings_are_removed_by_anyone() {
+	new_test_ext().execute_with(|| {
+		let (collection_id, nft_id) = create_feed(1, "btc_usd");
+		assert_ok!(KylinMarket::list(
+			RuntimeOrigin::signed(account(1)),
+			collection_id,
+			nft_id,
+			50,
+			Some(5)
+		));
+		assert_noop!(
+			KylinMarket::remove_expired_listing(
+				RuntimeOrigin::signed(account(3)),
+				collection_id,
+				nft_id
+			),
+			Error::<Test>::NotExpired
+		);
+
+		System::set_block_number(5);
+		assert_ok!(KylinMarket::remove_expired_listing(
+			RuntimeOrigin::signed(account(3)),
+			collection_id,
+			nft_id
+		));
+		assert_eq!(KylinMarket::listed_nfts(collection_id, nft_id), None);
+		assert!(KylinMarket::floor_index(collection_id).is_empty());
+		assert!(!KylinFeedApi::lock((collection_id, nft_id)));
+		assert_eq!(
+			last_event(),
+			Event::<Test>::ListingExpired { owner: account(1), collection_id, nft_id }.into()
+		);
+	});
+}
+
+#[test]
+fn a_full_offer_book_outbids_its_lowest_offer() {
+	new_test_ext().execute_with(|| {
+		let nft = create_feed(1, "btc_usd");
+		offer(2, nft, 100, None);
+		offer(3, nft, 50, None);
+		assert_noop!(
+			KylinMarket::make_offer(RuntimeOrigin::signed(account(4)), nft.0, nft.1, 50, None),
+			Error::<Test>::OfferTooLow
+		);
+
+		offer(4, nft, 60, None);
+		assert_eq!(Balances::reserved_balance(account(3)), 0);
+		assert_eq!(KylinMarket::offers(nft, account(3)), None);
+		assert_eq!(KylinMarket::best_offer(nft.0, nft.1).map(|offer| offer.amount), Some(100));
+	});
+}
+
+#[test]
+fn a_full_offer_book_removes_its_expired_offers_first() {
+	new_test_ext().execute_with(|| {
+		let nft = create_feed(1, "btc_usd");
+		offer(2, nft, 100, Some(5));
+		offer(3, nft, 50, None);
+		assert_eq!(KylinMarket::best_offer(nft.0, nft.1).map(|offer| offer.amount), Some(100));
+
+		System::set_block_number(5);
+		assert_eq!(KylinMarket::best_offer(nft.0, nft.1).map(|offer| offer.amount), Some(50));
+		// Lower than every offer in the book, but the expired one makes room.
+		offer(4, nft, 20, None);
+		assert_eq!(Balances::reserved_balance(account(2)), 0);
+		assert_eq!(Balances::reserved_balance(account(3)), 50);
+		assert_eq!(KylinMarket::offer_book(nft).len(), 2);
+	});
+}
 
 #[test]
-fn it_works_for_default_value() {
+fn expired_offers_are_removed_by_anyone() {
 	new_test_ext().execute_with(|| {
-		// Dispatch a signed extrinsic.
-		assert_ok!(TemplateModule::do_something(Origin::signed(1), 42));
-		// Read pallet storage and assert an expected result.
-		assert_eq!(TemplateModule::something(), Some(42));
+		let nft = create_feed(1, "btc_usd");
+		offer(2, nft, 100, Some(5));
+		assert_noop!(
+			KylinMarket::remove_expired_offer(
+				RuntimeOrigin::signed(account(3)),
+				nft.0,
+				nft.1,
+				account(2)
+			),
+			Error::<Test>::NotExpired
+		);
+
+		System::set_block_number(5);
+		assert_ok!(KylinMarket::remove_expired_offer(
+			RuntimeOrigin::signed(account(3)),
+			nft.0,
+			nft.1,
+			account(2)
+		));
+		assert_eq!(Balances::reserved_balance(account(2)), 0);
+		assert!(KylinMarket::offer_book(nft).is_empty());
+		assert_eq!(
+			last_event(),
+			Event::<Test>::OfferExpired { maker: account(2), collection_id: nft.0, nft_id: nft.1 }
+				.into()
+		);
 	});
 }
 
 #[test]
-fn correct_error_for_none_value() {
+fn an_accepted_offer_pays_the_owner() {
 	new_test_ext().execute_with(|| {
-		// Ensure the expected error is thrown when no value is present.
-		assert_noop!(TemplateModule::cause_error(Origin::signed(1)), Error::<Test>::NoneValue);
+		let nft = create_feed(1, "btc_usd");
+		offer(2, nft, 100, None);
+		assert_eq!(Balances::reserved_balance(account(2)), 100);
+
+		assert_ok!(KylinMarket::accept_offer(
+			RuntimeOrigin::signed(account(1)),
+			nft.0,
+			nft.1,
+			account(2)
+		));
+		assert_eq!(owner_of(nft), Some(account(2)));
+		assert_eq!(Balances::reserved_balance(account(2)), 0);
+		assert_eq!(Balances::free_balance(account(1)), ENDOWMENT + 100);
+		assert!(KylinMarket::offer_book(nft).is_empty());
+	});
+}
+
+#[test]
+fn a_batch_fails_as_a_whole() {
+	new_test_ext().execute_with(|| {
+		let first = create_feed(1, "btc_usd");
+		let second = create_feed(1, "eth_usd");
+		offer(2, first, 100, None);
+		offer(2, second, 100, None);
+
+		// The first offer is not withdrawn when the second item has no offer.
+		assert_noop!(
+			KylinMarket::withdraw_offer_batch(
+				RuntimeOrigin::signed(account(2)),
+				vec![first, (second.0, second.1 + 1)].try_into().unwrap()
+			),
+			Error::<Test>::UnknownOffer
+		);
+		assert_ok!(KylinMarket::withdraw_offer_batch(
+			RuntimeOrigin::signed(account(2)),
+			vec![first, second].try_into().unwrap()
+		));
+		assert_eq!(Balances::reserved_balance(account(2)), 0);
 	});
 }
@@ -0,0 +1,183 @@
+//! Weights for kylin_market
+//!
+//! Not benchmarked yet: every weight below is an estimate from the storage accesses of its call,
+//! to be replaced by the output of the Substrate benchmark CLI:
+//!
+//! target/release/kylin-collator benchmark pallet
+//! --chain=pichiu-chachacha
+//! --steps=50
+//! --repeat=20
+//! --pallet=kylin-market
+//! --extrinsic=*
+//! --execution=wasm
+//! --wasm-execution=compiled
+//! --heap-pages=4096
+//! --output=pallets/kylin-market/src/weights.rs
+//! --template=./scripts/frame-weight-template.hbs
+
+#![allow(unused_parens)]
+#![allow(unused_imports)]
+
+use frame_support::{
+    traits::Get,
+    weights::{constants::RocksDbWeight, Weight},
+};
+use sp_std::marker::PhantomData;
+
+/// Weight functions needed for kylin_market.
+pub trait WeightInfo {
+    fn buy() -> Weight;
+    fn buy_batch(n: u32) -> Weight;
+    fn list() -> Weight;
+    fn list_batch(n: u32) -> Weight;
+    fn unlist() -> Weight;
+    fn make_offer(o: u32) -> Weight;
+    fn withdraw_offer() -> Weight;
+    fn withdraw_offer_batch(n: u32) -> Weight;
+    fn accept_offer() -> Weight;
+    fn remove_expired_offer() -> Weight;
+    fn remove_expired_listing() -> Weight;
+}
+
+/// Weights for kylin_market using the Substrate node and recommended hardware.
+pub struct SubstrateWeight<T>(PhantomData<T>);
+impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
+    // Estimated: the listing, the payment and a `send` of the NFT to the buyer.
+    fn buy() -> Weight {
+        Weight::from_ref_time(95_000_000)
+            .saturating_add(T::DbWeight::get().reads(12 as u64))
+            .saturating_add(T::DbWeight::get().writes(10 as u64))
+    }
+    // Estimated: `n` times `buy`.
+    fn buy_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(95_000_000).saturating_mul(n as u64))
+            .saturating_add(T::DbWeight::get().reads((12 as u64).saturating_mul(n as u64)))
+            .saturating_add(T::DbWeight::get().writes((10 as u64).saturating_mul(n as u64)))
+    }
+    // Estimated: the NFT, its lock, its previous listing and the floor index.
+    fn list() -> Weight {
+        Weight::from_ref_time(40_000_000)
+            .saturating_add(T::DbWeight::get().reads(5 as u64))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+    }
+    // Estimated: `n` times `list`.
+    fn list_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(40_000_000).saturating_mul(n as u64))
+            .saturating_add(T::DbWeight::get().reads((5 as u64).saturating_mul(n as u64)))
+            .saturating_add(T::DbWeight::get().writes((3 as u64).saturating_mul(n as u64)))
+    }
+    // Estimated: the NFT, its lock, its listing and the floor index.
+    fn unlist() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(T::DbWeight::get().reads(3 as u64))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+    }
+    // Estimated: the offer book of the NFT and, when it is full, each of its `o` offers to
+    // remove the expired ones and outbid the lowest.
+    fn make_offer(o: u32, ) -> Weight {
+        Weight::from_ref_time(45_000_000)
+            .saturating_add(Weight::from_ref_time(2_000_000).saturating_mul(o as u64))
+            .saturating_add(T::DbWeight::get().reads(4 as u64))
+            .saturating_add(T::DbWeight::get().reads((2 as u64).saturating_mul(o as u64)))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+            .saturating_add(T::DbWeight::get().writes((2 as u64).saturating_mul(o as u64)))
+    }
+    // Estimated: the offer, the offer book and the unreserve.
+    fn withdraw_offer() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(T::DbWeight::get().reads(4 as u64))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+    }
+    // Estimated: `n` times `withdraw_offer`.
+    fn withdraw_offer_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(35_000_000).saturating_mul(n as u64))
+            .saturating_add(T::DbWeight::get().reads((4 as u64).saturating_mul(n as u64)))
+            .saturating_add(T::DbWeight::get().writes((3 as u64).saturating_mul(n as u64)))
+    }
+    // Estimated: `withdraw_offer` then `buy`.
+    fn accept_offer() -> Weight {
+        Weight::from_ref_time(130_000_000)
+            .saturating_add(T::DbWeight::get().reads(16 as u64))
+            .saturating_add(T::DbWeight::get().writes(13 as u64))
+    }
+    // Estimated from `withdraw_offer`.
+    fn remove_expired_offer() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(T::DbWeight::get().reads(3 as u64))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+    }
+    // Estimated from `unlist`.
+    fn remove_expired_listing() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(T::DbWeight::get().reads(2 as u64))
+            .saturating_add(T::DbWeight::get().writes(3 as u64))
+    }
+}
+
+// For backwards compatibility and tests
+impl WeightInfo for () {
+    fn buy() -> Weight {
+        Weight::from_ref_time(95_000_000)
+            .saturating_add(RocksDbWeight::get().reads(12 as u64))
+            .saturating_add(RocksDbWeight::get().writes(10 as u64))
+    }
+    fn buy_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(95_000_000).saturating_mul(n as u64))
+            .saturating_add(RocksDbWeight::get().reads((12 as u64).saturating_mul(n as u64)))
+            .saturating_add(RocksDbWeight::get().writes((10 as u64).saturating_mul(n as u64)))
+    }
+    fn list() -> Weight {
+        Weight::from_ref_time(40_000_000)
+            .saturating_add(RocksDbWeight::get().reads(5 as u64))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+    }
+    fn list_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(40_000_000).saturating_mul(n as u64))
+            .saturating_add(RocksDbWeight::get().reads((5 as u64).saturating_mul(n as u64)))
+            .saturating_add(RocksDbWeight::get().writes((3 as u64).saturating_mul(n as u64)))
+    }
+    fn unlist() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(RocksDbWeight::get().reads(3 as u64))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+    }
+    fn make_offer(o: u32, ) -> Weight {
+        Weight::from_ref_time(45_000_000)
+            .saturating_add(Weight::from_ref_time(2_000_000).saturating_mul(o as u64))
+            .saturating_add(RocksDbWeight::get().reads(4 as u64))
+            .saturating_add(RocksDbWeight::get().reads((2 as u64).saturating_mul(o as u64)))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+            .saturating_add(RocksDbWeight::get().writes((2 as u64).saturating_mul(o as u64)))
+    }
+    fn withdraw_offer() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(RocksDbWeight::get().reads(4 as u64))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+    }
+    fn withdraw_offer_batch(n: u32, ) -> Weight {
+        Weight::from_ref_time(10_000_000)
+            .saturating_add(Weight::from_ref_time(35_000_000).saturating_mul(n as u64))
+            .saturating_add(RocksDbWeight::get().reads((4 as u64).saturating_mul(n as u64)))
+            .saturating_add(RocksDbWeight::get().writes((3 as u64).saturating_mul(n as u64)))
+    }
+    fn accept_offer() -> Weight {
+        Weight::from_ref_time(130_000_000)
+            .saturating_add(RocksDbWeight::get().reads(16 as u64))
+            .saturating_add(RocksDbWeight::get().writes(13 as u64))
+    }
+    fn remove_expired_offer() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(RocksDbWeight::get().reads(3 as u64))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+    }
+    fn remove_expired_listing() -> Weight {
+        Weight::from_ref_time(35_000_000)
+            .saturating_add(RocksDbWeight::get().reads(2 as u64))
+            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+    }
+}
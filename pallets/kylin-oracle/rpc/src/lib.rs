@@ -0,0 +1,354 @@
+//! RPC interface of the Kylin Oracle pallet.
+//!
+//! Reads the combined values through [`KylinOracleRuntimeApi`], and pushes their changes to
+//! subscribers as new best blocks are imported.
+//!
+//! Each subscription reads its keys at every new best block, so at most
+//! [`MAX_SUBSCRIPTIONS`] run at once, each of at most [`MAX_SUBSCRIBED_KEYS`] keys, and
+//! subscribing to every key is an unsafe call.
+
+use std::{
+	collections::BTreeMap,
+	sync::{
+		atomic::{AtomicUsize, Ordering},
+		Arc,
+	},
+};
+
+use futures::{future, FutureExt, StreamExt};
+use jsonrpsee::{
+	core::RpcResult,
+	proc_macros::rpc,
+	types::error::{CallError, ErrorObject},
+	PendingSubscription,
+};
+pub use kylin_oracle_runtime_api::KylinOracleApi as KylinOracleRuntimeApi;
+use sc_client_api::BlockchainEvents;
+use sc_rpc::{DenyUnsafe, SubscriptionTaskExecutor};
+use serde::{Deserialize, Serialize};
+use sp_api::ProvideRuntimeApi;
+use sp_blockchain::HeaderBackend;
+use sp_core::Bytes;
+use sp_runtime::{generic::BlockId, traits::Block as BlockT};
+
+/// Maximum number of value subscriptions served at once.
+pub const MAX_SUBSCRIPTIONS: usize = 64;
+
+/// Maximum number of keys of a value subscription.
+pub const MAX_SUBSCRIBED_KEYS: usize = 128;
+
+/// Combined value of a key, and the time it was fed at.
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase")]
+pub struct TimestampedValue {
+	pub value: i64,
+	pub timestamp: u128,
+}
+
+impl From<(i64, u128)> for TimestampedValue {
+	fn from((value, timestamp): (i64, u128)) -> Self {
+		Self { value, timestamp }
+	}
+}
+
+#[rpc(client, server)]
+pub trait KylinOracleApi<BlockHash> {
+	/// Latest combined value of `key`.
+	#[method(name = "oracle_get")]
+	fn get(&self, key: Bytes, at: Option<BlockHash>) -> RpcResult<Option<TimestampedValue>>;
+
+	/// Latest combined value of each of `keys`, in the same order.
+	#[method(name = "oracle_getMany")]
+	fn get_many(
+		&self,
+		keys: Vec<Bytes>,
+		at: Option<BlockHash>,
+	) -> RpcResult<Vec<Option<TimestampedValue>>>;
+
+	/// Latest combined value of every key.
+	#[method(name = "oracle_getAllValues")]
+	fn get_all_values(&self, at: Option<BlockHash>) -> RpcResult<Vec<(Bytes, TimestampedValue)>>;
+
+	/// Latest combined value of every hot key, read at once.
+	#[method(name = "oracle_getHotValues")]
+	fn get_hot_values(&self, at: Option<BlockHash>) -> RpcResult<Vec<(Bytes, TimestampedValue)>>;
+
+	/// Past combined values of `key` with a timestamp within `from..=to`, oldest first.
+	#[method(name = "oracle_getHistory")]
+	fn get_history(
+		&self,
+		key: Bytes,
+		from: u128,
+		to: u128,
+		at: Option<BlockHash>,
+	) -> RpcResult<Vec<TimestampedValue>>;
+
+	/// Values of `keys`, or of every key if empty, that changed in each new best block. The
+	/// first notification holds every current value, read at the best block when subscribing.
+	///
+	/// At most `MAX_SUBSCRIBED_KEYS` keys are subscribed to, and subscribing to every key is
+	/// unsafe.
+	#[subscription(
+		name = "oracle_subscribeValues" => "oracle_values",
+		unsubscribe = "oracle_unsubscribeValues",
+		item = Vec<(Bytes, Option<TimestampedValue>)>,
+	)]
+	fn subscribe_values(&self, keys: Vec<Bytes>);
+}
+
+/// Errors of the oracle RPC.
+pub enum Error {
+	/// The call to the runtime failed.
+	RuntimeError,
+	/// The subscription exceeds the limits of the server.
+	SubscriptionLimit,
+}
+
+impl From<Error> for i32 {
+	fn from(e: Error) -> i32 {
+		match e {
+			Error::RuntimeError => 1,
+			Error::SubscriptionLimit => 2,
+		}
+	}
+}
+
+fn limit_error(message: &'static str) -> jsonrpsee::core::Error {
+	CallError::Custom(ErrorObject::owned(Error::SubscriptionLimit.into(), message, None::<()>))
+		.into()
+}
+
+fn runtime_error(message: &'static str, e: impl std::fmt::Debug) -> jsonrpsee::core::Error {
+	CallError::Custom(ErrorObject::owned(
+		Error::RuntimeError.into(),
+		message,
+		Some(format!("{:?}", e)),
+	))
+	.into()
+}
+
+/// Values of `keys`, or of every key if empty, at `at`.
+fn values_at<C, Block>(
+	client: &C,
+	at: &BlockId<Block>,
+	keys: &[Vec<u8>],
+) -> Result<BTreeMap<Vec<u8>, (i64, u128)>, sp_api::ApiError>
+where
+	Block: BlockT,
+	C: ProvideRuntimeApi<Block>,
+	C::Api: KylinOracleRuntimeApi<Block>,
+{
+	let api = client.runtime_api();
+	if keys.is_empty() {
+		return Ok(api.get_all_values(at)?.into_iter().collect())
+	}
+	let values = api.get_many(at, keys.to_vec())?;
+	Ok(keys
+		.iter()
+		.zip(values)
+		.filter_map(|(key, value)| value.map(|value| (key.clone(), value)))
+		.collect())
+}
+
+/// Keys whose value differs between `last` and `current`, with their current value.
+fn changes(
+	last: &BTreeMap<Vec<u8>, (i64, u128)>,
+	current: &BTreeMap<Vec<u8>, (i64, u128)>,
+) -> Vec<(Bytes, Option<TimestampedValue>)> {
+	let updated = current
+		.iter()
+		.filter(|(key, value)| last.get(*key) != Some(*value))
+		.map(|(key, value)| (key.clone().into(), Some((*value).into())));
+	let removed = last
+		.keys()
+		.filter(|key| !current.contains_key(*key))
+		.map(|key| (key.clone().into(), None));
+	updated.chain(removed).collect()
+}
+
+/// A slot of the running value subscriptions, released when dropped.
+struct SubscriptionSlot(Arc<AtomicUsize>);
+
+impl SubscriptionSlot {
+	fn acquire(running: &Arc<AtomicUsize>) -> Option<Self> {
+		running
+			.fetch_update(Ordering::SeqCst, Ordering::SeqCst, |n| {
+				(n < MAX_SUBSCRIPTIONS).then(|| n + 1)
+			})
+			.ok()
+			.map(|_| Self(running.clone()))
+	}
+}
+
+impl Drop for SubscriptionSlot {
+	fn drop(&mut self) {
+		self.0.fetch_sub(1, Ordering::SeqCst);
+	}
+}
+
+/// Oracle RPC handler.
+pub struct KylinOracle<C, Block> {
+	client: Arc<C>,
+	executor: SubscriptionTaskExecutor,
+	deny_unsafe: DenyUnsafe,
+	subscriptions: Arc<AtomicUsize>,
+	_marker: std::marker::PhantomData<Block>,
+}
+
+impl<C, Block> KylinOracle<C, Block> {
+	pub fn new(
+		client: Arc<C>,
+		executor: SubscriptionTaskExecutor,
+		deny_unsafe: DenyUnsafe,
+	) -> Self {
+		Self {
+			client,
+			executor,
+			deny_unsafe,
+			subscriptions: Default::default(),
+			_marker: Default::default(),
+		}
+	}
+}
+
+impl<C, Block> KylinOracleApiServer<<Block as BlockT>::Hash> for KylinOracle<C, Block>
+where
+	Block: BlockT,
+	C: ProvideRuntimeApi<Block>
+		+ HeaderBackend<Block>
+		+ BlockchainEvents<Block>
+		+ Send
+		+ Sync
+		+ 'static,
+	C::Api: KylinOracleRuntimeApi<Block>,
+{
+	fn get(
+		&self,
+		key: Bytes,
+		at: Option<<Block as BlockT>::Hash>,
+	) -> RpcResult<Option<TimestampedValue>> {
+		let at = BlockId::hash(at.unwrap_or_else(|| self.client.info().best_hash));
+		let value = self
+			.client
+			.runtime_api()
+			.get(&at, key.to_vec())
+			.map_err(|e| runtime_error("Unable to query value.", e))?;
+		Ok(value.map(Into::into))
+	}
+
+	fn get_many(
+		&self,
+		keys: Vec<Bytes>,
+		at: Option<<Block as BlockT>::Hash>,
+	) -> RpcResult<Vec<Option<TimestampedValue>>> {
+		let at = BlockId::hash(at.unwrap_or_else(|| self.client.info().best_hash));
+		let keys = keys.into_iter().map(|key| key.to_vec()).collect();
+		let values = self
+			.client
+			.runtime_api()
+			.get_many(&at, keys)
+			.map_err(|e| runtime_error("Unable to query values.", e))?;
+		Ok(values.into_iter().map(|value| value.map(Into::into)).collect())
+	}
+
+	fn get_all_values(
+		&self,
+		at: Option<<Block as BlockT>::Hash>,
+	) -> RpcResult<Vec<(Bytes, TimestampedValue)>> {
+		let at = BlockId::hash(at.unwrap_or_else(|| self.client.info().best_hash));
+		let values = self
+			.client
+			.runtime_api()
+			.get_all_values(&at)
+			.map_err(|e| runtime_error("Unable to query values.", e))?;
+		Ok(values.into_iter().map(|(key, value)| (key.into(), value.into())).collect())
+	}
+
+	fn get_hot_values(
+		&self,
+		at: Option<<Block as BlockT>::Hash>,
+	) -> RpcResult<Vec<(Bytes, TimestampedValue)>> {
+		let at = BlockId::hash(at.unwrap_or_else(|| self.client.info().best_hash));
+		let values = self
+			.client
+			.runtime_api()
+			.get_hot_values(&at)
+			.map_err(|e| runtime_error("Unable to query hot values.", e))?;
+		Ok(values.into_iter().map(|(key, value)| (key.into(), value.into())).collect())
+	}
+
+	fn get_history(
+		&self,
+		key: Bytes,
+		from: u128,
+		to: u128,
+		at: Option<<Block as BlockT>::Hash>,
+	) -> RpcResult<Vec<TimestampedValue>> {
+		let at = BlockId::hash(at.unwrap_or_else(|| self.client.info().best_hash));
+		let values = self
+			.client
+			.runtime_api()
+			.get_history(&at, key.to_vec(), from, to)
+			.map_err(|e| runtime_error("Unable to query history.", e))?;
+		Ok(values.into_iter().map(Into::into).collect())
+	}
+
+	fn subscribe_values(&self, pending: PendingSubscription, keys: Vec<Bytes>) {
+		if keys.is_empty() {
+			if let Err(e) = self.deny_unsafe.check_if_safe() {
+				let _ = pending.reject(jsonrpsee::core::Error::from(e));
+				return
+			}
+		}
+		if keys.len() > MAX_SUBSCRIBED_KEYS {
+			let _ = pending.reject(limit_error("Too many keys subscribed to."));
+			return
+		}
+		let slot = match SubscriptionSlot::acquire(&self.subscriptions) {
+			Some(slot) => slot,
+			None => {
+				let _ = pending.reject(limit_error("Too many value subscriptions."));
+				return
+			},
+		};
+
+		let client = self.client.clone();
+		let keys: Vec<Vec<u8>> = keys.into_iter().map(|key| key.to_vec()).collect();
+		let best = BlockId::hash(self.client.info().best_hash);
+		let mut last = match values_at(&*client, &best, &keys) {
+			Ok(values) => values,
+			Err(e) => {
+				let _ = pending.reject(runtime_error("Unable to query values.", e));
+				return
+			},
+		};
+		let initial = changes(&BTreeMap::new(), &last);
+
+		let updates = self
+			.client
+			.import_notification_stream()
+			.filter(|notification| future::ready(notification.is_new_best))
+			.filter_map(move |notification| {
+				// A block whose state cannot be read is skipped, its changes being pushed with
+				// the next one.
+				let update = values_at(&*client, &BlockId::hash(notification.hash), &keys)
+					.ok()
+					.and_then(|current| {
+						let changes = changes(&last, &current);
+						last = current;
+						(!changes.is_empty()).then(|| changes)
+					});
+				future::ready(update)
+			});
+		let stream = futures::stream::once(future::ready(initial)).chain(updates);
+
+		let fut = async move {
+			let _slot = slot;
+			if let Some(mut sink) = pending.accept() {
+				sink.pipe_from_stream(stream).await;
+			}
+		};
+
+		self.executor.spawn("kylin-oracle-rpc-subscription", Some("rpc"), fut.boxed());
+	}
+}
@@ -0,0 +1,26 @@
+//! Runtime API of the Kylin Oracle pallet.
+#![cfg_attr(not(feature = "std"), no_std)]
+#![allow(clippy::too_many_arguments)]
+#![allow(clippy::unnecessary_mut_passed)]
+
+use sp_std::vec::Vec;
+
+sp_api::decl_runtime_apis! {
+	/// Combined oracle values, as `(value, timestamp)` pairs.
+	pub trait KylinOracleApi {
+		/// Latest combined value of `key`, if any.
+		fn get(key: Vec<u8>) -> Option<(i64, u128)>;
+
+		/// Latest combined value of each of `keys`, in the same order.
+		fn get_many(keys: Vec<Vec<u8>>) -> Vec<Option<(i64, u128)>>;
+
+		/// Latest combined value of every key.
+		fn get_all_values() -> Vec<(Vec<u8>, (i64, u128))>;
+
+		/// Latest combined value of every hot key, read at once.
+		fn get_hot_values() -> Vec<(Vec<u8>, (i64, u128))>;
+
+		/// Past combined values of `key` with a timestamp within `from..=to`, oldest first.
+		fn get_history(key: Vec<u8>, from: u128, to: u128) -> Vec<(i64, u128)>;
+	}
+}
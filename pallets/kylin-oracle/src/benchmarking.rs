@@ -1,180 +1,217 @@
+//! Benchmarks of the Kylin Oracle pallet.
+//!
+//! Feeds are measured against keys already fed by up to `MaxFeedersPerKey` feeders and
+//! subscribed by `MaxSubscribersPerKey` parachains, next to other keys holding full windows of
+//! raw values, so that the weights hold under production load.
 #![cfg(feature = "runtime-benchmarks")]
 use super::*;
-use frame_benchmarking::{benchmarks, impl_benchmark_test_suite, whitelisted_caller};
-use frame_system::{EventRecord, RawOrigin};
+use frame_benchmarking::{account, benchmarks, whitelisted_caller};
+use frame_system::RawOrigin;
+use sp_std::ops::Range;
+
+const SEED: u32 = 0;
+/// Upper bound of the values fed in a single call by the benchmarks.
+const MAX_VALUES: u32 = 100;
+/// Keys fed besides the benchmarked ones, which a feed must not depend on.
+const OTHER_KEYS: u32 = 32;
+/// Parachain the XCM queries come from, and the first parachain subscribed to each key.
+const SIBLING: u32 = 2000;
+
+fn oracle_key<T: Config>(i: u32) -> OracleKeyOf<T> {
+    let mut key = b"benchmark_key_".to_vec();
+    key.extend_from_slice(&i.to_le_bytes());
+    key.try_into().expect("benchmark keys fit in StrLimit")
+}
+
+fn feeder<T: Config>(i: u32) -> CreatorId<T::AccountId> {
+    CreatorId::AccountId(account("feeder", i, SEED))
+}
+
+/// Give each of `keys` an api feed, the raw values of `feeders` feeders, a combined value, and
+/// `subscribers` subscribers its new values are pushed to.
+fn fill_keys<T: Config>(keys: Range<u32>, feeders: u32, subscribers: u32)
+where
+    T::AccountId: AsRef<[u8]>,
+{
+    for i in keys {
+        let key = oracle_key::<T>(i);
+        ApiFeeds::<T>::insert(feeder::<T>(0), &key, ApiFeed::default());
+        ApiFeedCount::<T>::insert(&key, 1);
+        Pallet::<T>::index_key(&key);
+        for f in 0..feeders {
+            let raw = TimestampedValue { value: f as i64, timestamp: 0 };
+            Pallet::<T>::insert_raw_value(&key, &feeder::<T>(f), raw);
+        }
+        Values::<T>::insert(&key, TimestampedValue { value: 0, timestamp: 0 });
+        for s in 0..subscribers {
+            Subscriptions::<T>::insert(&key, ParaId::from(SIBLING + s), Subscription::default());
+        }
+        SubscriberCount::<T>::insert(&key, subscribers);
+    }
+}
+
+/// Keys the benchmarked keys live next to, each fed by `MaxFeedersPerKey` feeders.
+fn fill_other_keys<T: Config>()
+where
+    T::AccountId: AsRef<[u8]>,
+{
+    fill_keys::<T>(MAX_VALUES..MAX_VALUES + OTHER_KEYS, T::MaxFeedersPerKey::get(), 0);
+}
+
+fn member<T: Config>() -> T::AccountId {
+    let caller: T::AccountId = whitelisted_caller();
+    T::Members::add(&caller);
+    caller
+}
+
+fn sibling<T: Config>() -> OriginFor<T>
+where
+    <T as frame_system::Config>::RuntimeOrigin: From<CumulusOrigin>,
+{
+    CumulusOrigin::SiblingParachain(ParaId::from(SIBLING)).into()
+}
 
 benchmarks! {
     where_clause { where
-		T::AccountId: AsRef<[u8]>,
-	}
-
-    sudo_remove_feed_account {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-		let feed_name = str::from_utf8(b"price_feeding").unwrap().as_bytes().to_vec();
-        let hash: Vec<u8> = Vec::new();
-        <FeedAccountLookup<T>>::insert(feed_name.clone(), (caller.clone(), hash));
-    }: _(RawOrigin::Root, feed_name.clone())
+        T::AccountId: AsRef<[u8]> + ToHex + Decode,
+        <T as frame_system::Config>::RuntimeOrigin: From<CumulusOrigin>,
+    }
+
+    feed_data {
+        let c in 1 .. MAX_VALUES;
+        let f in 0 .. T::MaxFeedersPerKey::get();
+        let caller = member::<T>();
+        fill_keys::<T>(0..c, f, T::MaxSubscribersPerKey::get());
+        fill_other_keys::<T>();
+        let values = (0..c).map(|i| (oracle_key::<T>(i), i as i64 + 1)).collect::<Vec<_>>();
+    }: _(RawOrigin::Signed(caller.clone()), values)
     verify {
-        assert_last_event::<T>(Event::RemovedFeedAccount(feed_name).into());
+        let cid = CreatorId::AccountId(caller);
+        assert!(RawValues::<T>::contains_key(oracle_key::<T>(c - 1), cid));
     }
 
-    submit_price_feed { 
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let api_url = str::from_utf8(b"https://api.kylin-node.co.uk/prices?currency_pairs=").unwrap();
-        let requested_currencies = str::from_utf8(b"btc_usd,eth_gdp").unwrap();
-        let url = api_url.clone().to_owned() + requested_currencies;
-    }: _(RawOrigin::Signed(caller.clone()), None, requested_currencies.as_bytes().to_vec())
+    feed_data_compact {
+        let c in 1 .. MAX_VALUES.min(T::MaxFeedValues::get());
+        let f in 0 .. T::MaxFeedersPerKey::get() - 1;
+        let caller = member::<T>();
+        let cid = CreatorId::AccountId(caller.clone());
+        fill_keys::<T>(0..c, f, T::MaxSubscribersPerKey::get());
+        fill_other_keys::<T>();
+        // Every delta is based on a previous value of the caller.
+        for i in 0..c {
+            let raw = TimestampedValue { value: 0, timestamp: 0 };
+            Pallet::<T>::insert_raw_value(&oracle_key::<T>(i), &cid, raw);
+        }
+        LastFedAt::<T>::insert(&cid, T::BlockNumber::from(1u32));
+        frame_system::Pallet::<T>::set_block_number(2u32.into());
+        let values: BoundedVec<_, T::MaxFeedValues> = (0..c)
+            .map(|i| {
+                let index = KeyIndices::<T>::get(oracle_key::<T>(i)).expect("keys are indexed");
+                (Compact(index), Compact(zigzag_encode(i as i64 + 1)))
+            })
+            .collect::<Vec<_>>()
+            .try_into()
+            .expect("c is at most MaxFeedValues");
+    }: _(RawOrigin::Signed(caller), Some(1u32.into()), values)
     verify {
-        let block_number = frame_system::Pallet::<T>::block_number();
-        let feed_name = str::from_utf8(b"price_feeding").unwrap().as_bytes().to_vec();
-        assert_last_event::<T>(Event::SubmitNewData(
-            None,
-            feed_name,
-            Some(url.as_bytes().to_vec()),
-            Some(caller),
-            block_number).into()
-        );
+        let raw = RawValues::<T>::get(oracle_key::<T>(c - 1), cid).expect("value is fed");
+        assert_eq!(raw.value, c as i64);
     }
 
+    // The benchmark environment has no channel open to the sibling, sending the answer fails
+    // once every read of the query is done. The queued message is accounted for in the weights.
     query_data {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let _ = T::Currency::make_free_balance_be(&caller, T::Currency::minimum_balance());
-        let feed_name = str::from_utf8(b"custom_benchmark_feed").unwrap().as_bytes().to_vec();
-        let data = b"{'benchmark':'this is data'}".to_vec();
-        // Submit data signed
-        let key: u64 = a.into();
-        let block_number = <system::Pallet<T>>::block_number();
-        let data = str::from_utf8(b"{'benchmark':'this is data'}").unwrap().as_bytes().to_vec();
-        <Pallet<T>>::submit_data_signed(RawOrigin::Signed(caller.clone()).into(), block_number, key, data.clone()).unwrap();
-        // Clear_processed_requests_unsigned 
-        <Pallet<T>>::clear_processed_requests_unsigned(RawOrigin::None.into(), block_number, [key].to_vec()).unwrap();
-        // Clear api queue
-        <Pallet<T>>::clear_api_queue_unsigned(RawOrigin::None.into(), block_number, [key].to_vec()).unwrap();
-        // Add fresh data
-        <Pallet<T>>::submit_data_signed(RawOrigin::Signed(caller.clone()).into(), block_number, key, data).unwrap();
-        // Insert new key to feed account lookup
-        let hash: Vec<u8> = str::from_utf8(b"5F28xL42VWThNonDft4TAQ6rw6a82E2jMsQXS5uMyKiA4ccv").unwrap().as_bytes().to_vec();
-        <FeedAccountLookup<T>>::insert(feed_name.clone(), (caller.clone(), hash));
-        // Get new feed name
-        // let new_feed_name = str::from_utf8(b"custom_").unwrap().to_owned() + str::from_utf8(&feed_name).unwrap();
-    }: _(RawOrigin::Signed(caller), None, feed_name)
-
-    write_data_onchain {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-		let feed_name = str::from_utf8(b"feed_name").unwrap().as_bytes().to_vec();
-        let data = b"{'benchmark':'this is data'}".to_vec();
-    }: _(RawOrigin::Signed(caller.clone()), feed_name.clone(), data)
-    verify {
-        let block_number = frame_system::Pallet::<T>::block_number();
-        let new_feed_name = str::from_utf8(b"custom_").unwrap().to_owned() + str::from_utf8(&feed_name).unwrap();
-        assert_last_event::<T>(Event::SubmitNewData(
-            None,
-            new_feed_name.as_bytes().to_vec(),
-            None,
-            Some(caller.clone()),
-            block_number).into(),
-        );
+        fill_keys::<T>(0..1, T::MaxFeedersPerKey::get(), 0);
+        fill_other_keys::<T>();
+        let origin = sibling::<T>();
+        let key = oracle_key::<T>(0);
+    }: {
+        let _ = Pallet::<T>::xcm_query_data(origin, key);
     }
 
-    submit_data_signed {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let block_number = <system::Pallet<T>>::block_number();
-        let key: u64 = a.into();
-        let data = str::from_utf8(b"{'benchmark':'this is data'}").unwrap().as_bytes().to_vec();
-    }: _(RawOrigin::Signed(caller), block_number, key, data.clone())
-    verify {
-        let saved_request = Pallet::<T>::saved_data_requests(key.clone());
-        assert_eq!(saved_request.payload, data)
+    query_data_batch {
+        let k in 1 .. T::MaxQueryKeys::get();
+        fill_keys::<T>(0..k, T::MaxFeedersPerKey::get(), 0);
+        fill_other_keys::<T>();
+        let origin = sibling::<T>();
+        let keys: BoundedVec<_, T::MaxQueryKeys> = (0..k)
+            .map(oracle_key::<T>)
+            .collect::<Vec<_>>()
+            .try_into()
+            .expect("k is at most MaxQueryKeys");
+    }: {
+        let _ = Pallet::<T>::xcm_query_data_batch(origin, keys);
     }
 
-    submit_data_unsigned {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let block_number = <system::Pallet<T>>::block_number();
-        let key: u64 = a.into();
-        let data = str::from_utf8(b"{'benchmark':'this is data'}").unwrap().as_bytes().to_vec();
-    }: _(RawOrigin::None, block_number, key, data.clone())
-    verify {
-        let saved_request = Pallet::<T>::saved_data_requests(key.clone());
-        assert_eq!(saved_request.payload, data)
+    query_history {
+        let n in 1 .. T::MaxHistoryLen::get();
+        let key = oracle_key::<T>(0);
+        for i in 0..n {
+            Pallet::<T>::record_history(&key, TimestampedValue { value: i as i64, timestamp: i as u128 });
+        }
+        let origin = sibling::<T>();
+    }: {
+        let _ = Pallet::<T>::xcm_query_history(origin, key, 0, u128::MAX);
     }
 
-    submit_data_via_api {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let url = str::from_utf8(b"https://min-api.cryptocompare.com/data/price?fsym=btc&tsyms=usd").unwrap().as_bytes().to_vec();
-		let feed_name = str::from_utf8(b"feed_name").unwrap().as_bytes().to_vec();
-    }: _(RawOrigin::Signed(caller.clone()), None, url.clone(), feed_name.clone())
-    verify {
-        let block_number = frame_system::Pallet::<T>::block_number();
-        let new_feed_name = str::from_utf8(b"custom_").unwrap().to_owned() + str::from_utf8(&feed_name).unwrap();
-        assert_last_event::<T>(Event::SubmitNewData(
-            None,
-            new_feed_name.as_bytes().to_vec(),
-            Some(url),
-            Some(caller),
-            block_number).into()
-        );
+    query_hot_values {
+        let k in 1 .. T::MaxHotKeys::get();
+        fill_keys::<T>(0..k, T::MaxFeedersPerKey::get(), 0);
+        fill_other_keys::<T>();
+        let keys: BoundedVec<_, T::MaxHotKeys> = (0..k)
+            .map(oracle_key::<T>)
+            .collect::<Vec<_>>()
+            .try_into()
+            .expect("k is at most MaxHotKeys");
+        let hot_keys_origin = T::HotKeysOrigin::successful_origin();
+        Pallet::<T>::set_hot_keys(hot_keys_origin, keys)?;
+        let origin = sibling::<T>();
+    }: {
+        let _ = Pallet::<T>::xcm_query_hot_values(origin);
     }
 
-    // xcm_submit_data_via_api {
-    //     let a in 1 .. 100;
-    //     let caller: T::AccountId = whitelisted_caller();
-    //     let url = str::from_utf8(b"https://min-api.cryptocompare.com/data/price?fsym=btc&tsyms=usd").unwrap().as_bytes().to_vec();
-	// 	let feed_name = str::from_utf8(b"feed_name").unwrap().as_bytes().to_vec();
-    // }: _(RawOrigin::Root, url, feed_name)
-
-    // receive_response_from_parachain {
-    //     let a in 1 .. 100;
-    //     let caller: T::AccountId = whitelisted_caller();
-	// 	let feed_name = str::from_utf8(b"feed_name").unwrap().as_bytes().to_vec();
-    //     let response = b"{'test':'test'}".to_vec();
-    // }: _(RawOrigin::Root, feed_name, response)
-
-    clear_api_queue_unsigned {
-        let a in 1 .. 100;
-        let caller: T::AccountId = whitelisted_caller();
-        let block_number = <system::Pallet<T>>::block_number();
-
-        let key: u64 = a.into();
-        let saved_request = DataRequest {
-            para_id: None,
-            account_id: Some(caller),
-            feed_name: str::from_utf8(b"price_feeding").unwrap().as_bytes().to_vec(),
-            requested_block_number: frame_system::Pallet::<T>::block_number(),
-            processed_block_number: None,
-            requested_timestamp: T::UnixTime::now().as_millis(),
-            processed_timestamp: None,
-            payload: str::from_utf8(b"{'benchmark':'this is data'}").unwrap().as_bytes().to_vec(),
-            is_query: false,
-            url: None,
-        };
-        <ApiQueue<T>>::insert(key.clone(), saved_request.clone());
-        let processed_requests = [key.clone()].to_vec();
-
-    }: _(RawOrigin::None, block_number, processed_requests)
+    set_hot_keys {
+        let k in 1 .. T::MaxHotKeys::get();
+        fill_keys::<T>(0..k, T::MaxFeedersPerKey::get(), 0);
+        fill_other_keys::<T>();
+        let keys: BoundedVec<_, T::MaxHotKeys> = (0..k)
+            .map(oracle_key::<T>)
+            .collect::<Vec<_>>()
+            .try_into()
+            .expect("k is at most MaxHotKeys");
+        let origin = T::HotKeysOrigin::successful_origin();
+    }: _<<T as frame_system::Config>::RuntimeOrigin>(origin, keys)
     verify {
-        let in_queue = ApiQueue::<T>::contains_key(key);
-        assert_eq!(in_queue, false);
+        assert_eq!(HotValues::<T>::get().len() as u32, k);
     }
-}
 
-impl_benchmark_test_suite!(
-	Pallet,
-	crate::mock::TestExternalitiesBuilder::default().build(|| {}),
-	crate::mock::MockRuntime,
-);
+    submit_api {
+        let caller = member::<T>();
+        fill_other_keys::<T>();
+        let key = oracle_key::<T>(0);
+        let url = b"https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".to_vec();
+        let vpath = b"/btc_usd".to_vec();
+    }: _(RawOrigin::Signed(caller.clone()), key.clone(), url, vpath)
+    verify {
+        assert!(ApiFeeds::<T>::contains_key(CreatorId::AccountId(caller), &key));
+        assert!(KeyIndices::<T>::contains_key(&key));
+    }
 
+    remove_api {
+        let n in 0 .. T::MaxHistoryLen::get();
+        let caller = member::<T>();
+        let cid = CreatorId::AccountId(caller.clone());
+        fill_other_keys::<T>();
+        let key = oracle_key::<T>(0);
+        Pallet::<T>::do_submit_api(cid.clone(), key.clone(), b"https://".to_vec(), b"/".to_vec())?;
+        for i in 0..n {
+            Pallet::<T>::record_history(&key, TimestampedValue { value: i as i64, timestamp: i as u128 });
+        }
+    }: _(RawOrigin::Signed(caller), key.clone())
+    verify {
+        assert!(!ApiFeeds::<T>::contains_key(cid, &key));
+        assert!(!HistoryCursors::<T>::contains_key(&key));
+    }
 
-fn assert_last_event<T: Config>(generic_event: <T as Config>::Event) where <T as frame_system::Config>::AccountId: AsRef<[u8]> {
-	let events = frame_system::Pallet::<T>::events();
-	let system_event: <T as frame_system::Config>::Event = generic_event.into();
-	// compare to the last event record
-	let EventRecord { event, .. } = &events[events.len() - 1];
-	assert_eq!(event, &system_event);
+    impl_benchmark_test_suite!(Pallet, crate::mock::new_test_ext(), crate::mock::Test);
 }
@@ -7,7 +7,7 @@
 /// <https://substrate.dev/docs/en/knowledgebase/runtime/frame>
 
 use serde::{Deserialize, Serialize};
-use codec::{Decode, Encode};
+use codec::{Compact, Decode, Encode};
 use cumulus_pallet_xcm::{ensure_sibling_para, Origin as CumulusOrigin};
 use cumulus_primitives_core::ParaId;
 use frame_support::{
@@ -26,8 +26,15 @@ use frame_system::{
     Config as SystemConfig,
 };
 use hex::ToHex;
-use serde_json::{Value as JValue};
+use kylin_support::{
+    collections::vec::BoundedSortedVec,
+    json::{extract_numbers, JsonError},
+    math::deviation,
+    native_fetch,
+    offchain_metrics::{self, EndpointFetch, WorkerRun},
+};
 use scale_info::TypeInfo;
+use sp_std::collections::btree_map::BTreeMap;
 use sp_std::{
     borrow::ToOwned, convert::TryFrom, convert::TryInto, 
     prelude::*, str, vec, vec::Vec
@@ -40,19 +47,23 @@ use sp_runtime::{
         storage::{MutateStorageError, StorageRetrievalError, StorageValueRef},
         Duration,
     },
-    traits::{Hash, UniqueSaturatedInto, Zero},
+    traits::{Hash, IdentifyAccount, One, UniqueSaturatedInto, Zero},
+    Permill, RuntimeAppPublic,
 };
 use xcm::latest::{prelude::*, Junction, OriginKind, SendXcm, Xcm};
 use orml_traits::{CombineData, DataFeeder, DataProvider, DataProviderExtended, OnNewData};
-use orml_utilities::OrderedSet;
 //use weights::WeightInfo;
 
 pub use pallet::*;
 #[cfg(test)]
+mod mock;
+#[cfg(test)]
 mod tests;
 
 mod default_combine_data;
 pub use default_combine_data::DefaultCombineData;
+mod sorted_combine_data;
+pub use sorted_combine_data::{EmaCombineData, MedianCombineData, TrimmedMeanCombineData};
 
 // Runtime benchmarking features
 #[cfg(feature = "runtime-benchmarks")]
@@ -60,6 +71,7 @@ mod benchmarking;
 
 pub mod weights;
 pub use weights::*;
+pub mod migrations;
 pub type BalanceOf<T> =
     <<T as Config>::Currency as Currency<<T as frame_system::Config>::AccountId>>::Balance;
 
@@ -112,6 +124,15 @@ enum KylinMockFunc {
         key: Vec<u8>,
 		value: i64,
     },
+    #[codec(index = 11u8)]
+    xcm_feed_back_batch { 
+        values: Vec<(Vec<u8>, TimestampedValueT)>,
+    },
+    #[codec(index = 13u8)]
+    xcm_feed_back_history {
+        key: Vec<u8>,
+        values: Vec<TimestampedValueT>,
+    },
 }
 
 /// Mock structure for XCM Call message encoding
@@ -136,6 +157,95 @@ pub struct ApiFeed<BlockNumber> {
     requested_block_number: BlockNumber,
     url: Option<Vec<u8>>,
     vpath: Option<Vec<u8>>,
+    /// The feed is fetched every `update_interval` blocks, zero means every block.
+    update_interval: BlockNumber,
+    /// A fetched value is submitted at least every `heartbeat` blocks...
+    heartbeat: BlockNumber,
+    /// ...or as soon as it deviates from the last submitted value by `deviation`. A zero
+    /// heartbeat or deviation submits every fetched value.
+    deviation: Permill,
+}
+
+/// Namespace of the offchain local storage entries shared with the node.
+const OFFCHAIN_NAMESPACE: &[u8] = b"kylin_oracle";
+/// Prefix of the offchain local storage entries holding the schedule of each feed.
+const FEED_SCHEDULE_PREFIX: &[u8] = b"kylin_oracle::feed_schedule::";
+/// Maximum number of feeds fetched by a single offchain worker run, the feeds left over are
+/// fetched by the next runs.
+const MAX_FEEDS_PER_RUN: usize = 64;
+
+/// Offchain schedule of a feed, kept in the offchain local storage.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct FeedSchedule<BlockNumber> {
+    /// The feed is due from this block on.
+    pub next_fetch: BlockNumber,
+    /// The last submitted value and the block it was submitted at.
+    pub last_submitted: Option<(i64, BlockNumber)>,
+}
+
+/// Subscription of a parachain to the combined value of a key.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug, TypeInfo)]
+pub struct Subscription<BlockNumber> {
+    /// A new value is pushed at least every `heartbeat` blocks.
+    pub heartbeat: BlockNumber,
+    /// A new value is pushed as soon as it deviates from the last pushed value by `deviation`.
+    pub deviation: Permill,
+    /// The last pushed value and the block it was pushed at.
+    pub last_pushed: Option<(i64, BlockNumber)>,
+}
+
+/// Position of the ring of past combined values of a key in `History`.
+#[derive(Encode, Decode, Default, Clone, Copy, PartialEq, Eq, RuntimeDebug, TypeInfo, MaxEncodedLen)]
+pub struct HistoryCursor {
+    /// Slot the next value is written to.
+    pub next: u32,
+    /// Number of values kept, at most `cap`.
+    pub len: u32,
+    /// Timestamp of the newest value.
+    pub newest: u128,
+    /// Number of slots of the ring, the `MaxHistoryLen` it was laid out for.
+    pub cap: u32,
+}
+
+/// Map a signed delta to an unsigned one, small magnitudes of either sign getting a short
+/// compact encoding.
+pub fn zigzag_encode(delta: i64) -> u64 {
+    ((delta << 1) ^ (delta >> 63)) as u64
+}
+
+/// Inverse of [`zigzag_encode`].
+pub fn zigzag_decode(zigzag: u64) -> i64 {
+    ((zigzag >> 1) as i64) ^ -((zigzag & 1) as i64)
+}
+
+/// A feed due in the current offchain worker run.
+struct DueFeed<Key, BlockNumber> {
+    key: Key,
+    url: Vec<u8>,
+    vpath: Vec<u8>,
+    feed: ApiFeed<BlockNumber>,
+    schedule_key: Vec<u8>,
+    schedule: FeedSchedule<BlockNumber>,
+}
+
+/// Prefix of the offchain local storage entries holding the health of each feed endpoint.
+const ENDPOINT_HEALTH_PREFIX: &[u8] = b"kylin_oracle::endpoint_health::";
+/// Number of consecutive failures after which an endpoint is backed off.
+const ENDPOINT_BACKOFF_THRESHOLD: u32 = 3;
+/// Upper bound of the backoff, in blocks.
+const ENDPOINT_MAX_BACKOFF: u32 = 256;
+/// How often pending requests are polled, used as the resolution of the measured latency.
+const HTTP_POLL_INTERVAL_MS: u64 = 50;
+
+/// Health of a feed endpoint, kept in the offchain local storage.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct EndpointHealth<BlockNumber> {
+    /// Number of consecutive failed fetches.
+    pub consecutive_failures: u32,
+    /// Latency of the last fetch in milliseconds.
+    pub last_latency: u64,
+    /// The endpoint is not fetched before this block.
+    pub backoff_until: BlockNumber,
 }
 
 enum TransactionType {
@@ -204,14 +314,58 @@ pub mod pallet {
         #[pallet::constant]
 		type StrLimit: Get<u32>;
 
-		/// Maximum size of HasDispatched
+		/// Maximum size in bytes of an api feed response body.
+		#[pallet::constant]
+		type MaxResponseSize: Get<u32>;
+
+		/// Maximum number of raw values kept in the sorted window of a key.
+		#[pallet::constant]
+		type MaxFeedersPerKey: Get<u32>;
+
+		/// Maximum number of keys in a batched query.
 		#[pallet::constant]
-		type MaxHasDispatchedSize: Get<u32>;
+		type MaxQueryKeys: Get<u32>;
+
+		/// Maximum number of values of a compact feed, larger feeds being sent in full.
+		#[pallet::constant]
+		type MaxFeedValues: Get<u32>;
+
+		/// Maximum number of parachains subscribed to a key.
+		#[pallet::constant]
+		type MaxSubscribersPerKey: Get<u32>;
+
+		/// Maximum number of keys a parachain is subscribed to, which bounds the values pushed
+		/// to it in a block.
+		#[pallet::constant]
+		type MaxSubscriptionsPerPara: Get<u32>;
+
+		/// Number of past combined values kept for each key, zero keeping none.
+		///
+		/// The runtime upgrade changing it lays the kept values out again, see
+		/// [`migrations::resize_history`].
+		#[pallet::constant]
+		type MaxHistoryLen: Get<u32>;
+
+		/// Whether the offchain worker feeds with a single elected local account, the first one
+		/// which is a member, rather than with every local account.
+		#[pallet::constant]
+		type SingleFeeder: Get<bool>;
+
+		/// Maximum number of hot keys, whose values are read together in a single read.
+		#[pallet::constant]
+		type MaxHotKeys: Get<u32>;
+
+		/// Origin allowed to choose the hot keys.
+		type HotKeysOrigin: EnsureOrigin<<Self as frame_system::Config>::RuntimeOrigin>;
 
     }
 
+    /// The current storage version.
+    const STORAGE_VERSION: StorageVersion = StorageVersion::new(5);
+
     #[pallet::pallet]
     #[pallet::generate_store(trait Store)]
+    #[pallet::storage_version(STORAGE_VERSION)]
     #[pallet::without_storage_info]
     pub struct Pallet<T>(_);
 
@@ -225,11 +379,30 @@ pub mod pallet {
 	pub type ApiFeeds<T: Config> =
 		StorageDoubleMap<_, Twox64Concat, CreatorId<T::AccountId>, Twox64Concat, OracleKeyOf<T>, ApiFeed<T::BlockNumber>>;
 
-    /// Raw values for each oracle operators
+	/// Number of api feeds of each oracle key, so that its history is only cleared along with
+	/// its last feed.
+	#[pallet::storage]
+	pub(crate) type ApiFeedCount<T: Config> =
+		StorageMap<_, Twox64Concat, OracleKeyOf<T>, u32, ValueQuery>;
+
+    /// Raw values for each oracle operators, keyed by oracle key first so that
+	/// combining a key only has to walk the feeders of that key.
 	#[pallet::storage]
 	#[pallet::getter(fn raw_values)]
 	pub type RawValues<T: Config> =
-		StorageDoubleMap<_, Twox64Concat, CreatorId<T::AccountId>, Twox64Concat, OracleKeyOf<T>, TimestampedValueT>;
+		StorageDoubleMap<_, Twox64Concat, OracleKeyOf<T>, Twox64Concat, CreatorId<T::AccountId>, TimestampedValueT>;
+
+	/// Raw values of each oracle key sorted by value, kept in step with `RawValues` so that
+	/// combining a key is a single read of an already ordered window.
+	#[pallet::storage]
+	#[pallet::getter(fn sorted_raw_values)]
+	pub type SortedRawValues<T: Config> = StorageMap<
+		_,
+		Twox64Concat,
+		OracleKeyOf<T>,
+		BoundedSortedVec<TimestampedValueT, T::MaxFeedersPerKey>,
+		ValueQuery,
+	>;
 
 	/// Up to date combined value from Raw Values
 	#[pallet::storage]
@@ -237,10 +410,71 @@ pub mod pallet {
 	pub type Values<T: Config> =
 		StorageMap<_, Twox64Concat, OracleKeyOf<T>, TimestampedValueT>;
 
-	/// If an oracle operator has fed a value in this block
+	/// Latest combined values of the hot keys, sorted by key. They are also kept in `Values`,
+	/// but all of them are a single read here.
+	#[pallet::storage]
+	#[pallet::getter(fn hot_values)]
+	pub type HotValues<T: Config> = StorageValue<
+		_,
+		BoundedVec<(OracleKeyOf<T>, Option<TimestampedValueT>), T::MaxHotKeys>,
+		ValueQuery,
+	>;
+
+	/// Position of the ring of past combined values of each oracle key in `History`.
+	#[pallet::storage]
+	pub type HistoryCursors<T: Config> =
+		StorageMap<_, Twox64Concat, OracleKeyOf<T>, HistoryCursor, ValueQuery>;
+
+	/// The last `MaxHistoryLen` combined values of each oracle key, in a ring of slots written
+	/// in place so that recording a value never rewrites the older ones.
 	#[pallet::storage]
-	pub(crate) type HasDispatched<T: Config> =
-		StorageValue<_, OrderedSet<CreatorId<T::AccountId>, T::MaxHasDispatchedSize>, ValueQuery>;
+	pub type History<T: Config> =
+		StorageDoubleMap<_, Twox64Concat, OracleKeyOf<T>, Twox64Concat, u32, TimestampedValueT>;
+
+	/// The `MaxHistoryLen` the rings of `History` were last laid out for, so that the runtime
+	/// upgrade changing it lays them out again.
+	#[pallet::storage]
+	pub type HistoryLen<T: Config> = StorageValue<_, u32>;
+
+	/// Index of each oracle key with an api feed, by which compact feeds refer to the key.
+	#[pallet::storage]
+	pub type KeyIndices<T: Config> = StorageMap<_, Twox64Concat, OracleKeyOf<T>, u32>;
+
+	/// Oracle key of each index of `KeyIndices`.
+	#[pallet::storage]
+	pub type IndexedKeys<T: Config> = StorageMap<_, Twox64Concat, u32, OracleKeyOf<T>>;
+
+	/// Index given to the next indexed oracle key.
+	#[pallet::storage]
+	pub(crate) type NextKeyIndex<T: Config> = StorageValue<_, u32, ValueQuery>;
+
+	/// The last block each oracle operator has fed a value in, so that "has fed in this block"
+	/// is a single read that never has to be cleaned up.
+	#[pallet::storage]
+	pub(crate) type LastFedAt<T: Config> =
+		StorageMap<_, Twox64Concat, CreatorId<T::AccountId>, T::BlockNumber>;
+
+	/// Parachains subscribed to each oracle key, keyed by oracle key first so that an update
+	/// only walks the subscribers of its key.
+	#[pallet::storage]
+	#[pallet::getter(fn subscriptions)]
+	pub type Subscriptions<T: Config> =
+		StorageDoubleMap<_, Twox64Concat, OracleKeyOf<T>, Twox64Concat, ParaId, Subscription<T::BlockNumber>>;
+
+	/// Number of keys each parachain is subscribed to.
+	#[pallet::storage]
+	pub(crate) type SubscriptionCount<T: Config> = StorageMap<_, Twox64Concat, ParaId, u32, ValueQuery>;
+
+	/// Number of parachains subscribed to each oracle key.
+	#[pallet::storage]
+	pub(crate) type SubscriberCount<T: Config> =
+		StorageMap<_, Twox64Concat, OracleKeyOf<T>, u32, ValueQuery>;
+
+	/// Values updated in this block to push to each subscriber, in a single message per
+	/// subscriber. A subscriber has at most `MaxSubscriptionsPerPara` values pending.
+	#[pallet::storage]
+	pub(crate) type PendingPushes<T: Config> =
+		StorageMap<_, Twox64Concat, ParaId, Vec<(Vec<u8>, TimestampedValueT)>, ValueQuery>;
 
 	#[pallet::error]
     pub enum Error<T> {
@@ -252,6 +486,16 @@ pub mod pallet {
 		AlreadyFeeded,
         /// XCM Send error
         XcmSendError,
+        /// The key has reached the maximum number of subscribers
+        TooManySubscribers,
+        /// The parachain has reached the maximum number of subscriptions
+        TooManySubscriptions,
+        /// No api feed nor value has this key
+        UnknownKey,
+        /// No oracle key has this index
+        UnknownKeyIndex,
+        /// The feeder has fed since the block the deltas are based on
+        StaleDelta,
     }
 
     #[pallet::hooks]
@@ -259,14 +503,13 @@ pub mod pallet {
     where
         T::AccountId: AsRef<[u8]> + ToHex + Decode
     {
-        /// `on_initialize` to return the weight used in `on_finalize`.
-		fn on_initialize(_n: T::BlockNumber) -> Weight {
-			T::WeightInfo::on_finalize()
+		/// Push the values updated in this block to their subscribers with the weight left.
+		fn on_idle(_n: T::BlockNumber, remaining_weight: Weight) -> Weight {
+			Self::push_to_subscribers(remaining_weight)
 		}
 
-		fn on_finalize(_n: T::BlockNumber) {
-			// cleanup for next block
-			<HasDispatched<T>>::kill();
+		fn on_runtime_upgrade() -> Weight {
+			migrations::migrate::<T>()
 		}
 
         fn offchain_worker(block_number: T::BlockNumber) {
@@ -311,7 +554,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `NewFeedData`
-		#[pallet::weight(T::WeightInfo::feed_data(values.len() as u32))]
+		#[pallet::weight(T::WeightInfo::feed_data(values.len() as u32, T::MaxFeedersPerKey::get()))]
 		pub fn feed_data(
 			origin: OriginFor<T>,
 			values: Vec<(OracleKeyOf<T>, i64)>,
@@ -322,26 +565,9 @@ pub mod pallet {
             ensure!(T::Members::contains(&feeder), Error::<T>::NoPermission);
 
             // ensure account hasn't dispatched an updated yet
-            ensure!(
-                HasDispatched::<T>::mutate(|set| set.insert(cid.clone())),
-                Error::<T>::AlreadyFeeded
-            );
+            Self::mark_fed(&cid)?;
 
-            let now = T::UnixTime::now().as_millis();
-            for (key, value) in &values {
-                let timestamped = TimestampedValue {
-                    value: value.clone(),
-                    timestamp: now,
-                };
-                RawValues::<T>::insert(&cid, &key, timestamped);
-
-                // Update `Values` storage if `combined` yielded result.
-                if let Some(combined) = Self::combined(key) {
-                    <Values<T>>::insert(key, combined);
-                }
-            }
-
-            Self::deposit_event(Event::NewFeedData { sender: cid, values });
+            Self::feed_values(cid, values);
 			Ok(Pays::No.into())
 		}
 
@@ -354,7 +580,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `NewFeedData`
-        #[pallet::weight(T::WeightInfo::feed_data(values.len() as u32))]
+        #[pallet::weight(T::WeightInfo::feed_data(values.len() as u32, T::MaxFeedersPerKey::get()))]
 		pub fn xcm_feed_data(
 			origin: OriginFor<T>,
 			values: Vec<(OracleKeyOf<T>, i64)>,
@@ -366,27 +592,9 @@ pub mod pallet {
             // // ensure feeder is authorized
             // ensure!(T::Members::contains(&feeder), Error::<T>::NoPermission);
 
-            // ensure account hasn't dispatched an updated yet
-            ensure!(
-                HasDispatched::<T>::mutate(|set| set.insert(cid.clone())),
-                Error::<T>::AlreadyFeeded
-            );
-
-            let now = T::UnixTime::now().as_millis();
-            for (key, value) in &values {
-                let timestamped = TimestampedValue {
-                    value: value.clone(),
-                    timestamp: now,
-                };
-                RawValues::<T>::insert(&cid, &key, timestamped);
-
-                // Update `Values` storage if `combined` yielded result.
-                if let Some(combined) = Self::combined(key) {
-                    <Values<T>>::insert(key, combined);
-                }
-            }
-
-            Self::deposit_event(Event::NewFeedData { sender: cid, values });
+            // A reporter chain splits the values it forwards in a block into several messages,
+            // each within the weight bought for it, so it is not held to one feed per block.
+            Self::feed_values(cid, values);
 			Ok(Pays::No.into())
 		}
         
@@ -426,7 +634,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `NewApiFeed`
-        #[pallet::weight(T::WeightInfo::submit_api())]
+        #[pallet::weight(T::WeightInfo::submit_api().saturating_add(Self::index_key_weight()))]
         pub fn submit_api(
             origin: OriginFor<T>,
             key: OracleKeyOf<T>,
@@ -452,7 +660,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `ApiFeedRemoved`
-        #[pallet::weight(T::WeightInfo::remove_api())]
+        #[pallet::weight(T::WeightInfo::remove_api(T::MaxHistoryLen::get()))]
         pub fn remove_api(
             origin: OriginFor<T>,
             key: OracleKeyOf<T>,
@@ -480,7 +688,7 @@ pub mod pallet {
         ///  
 		/// # Emits
 		/// * `NewApiFeed`
-        #[pallet::weight(T::WeightInfo::submit_api())]
+        #[pallet::weight(T::WeightInfo::submit_api().saturating_add(Self::index_key_weight()))]
         pub fn xcm_submit_api(
             origin: OriginFor<T>,
             key: OracleKeyOf<T>,
@@ -507,7 +715,7 @@ pub mod pallet {
 		/// 
 		/// # Emits
 		/// * `ApiFeedRemoved`
-        #[pallet::weight(T::WeightInfo::remove_api())]
+        #[pallet::weight(T::WeightInfo::remove_api(T::MaxHistoryLen::get()))]
         pub fn xcm_remove_api(
             origin: OriginFor<T>,
             key: OracleKeyOf<T>,
@@ -522,7 +730,301 @@ pub mod pallet {
             Self::do_remove_api(cid, key)?;
             Ok(())
         }
-        
+
+        /// Set the refresh schedule of the feed.
+		///
+		/// Can be called by authorized origin.
+		///
+		/// # Parameter:
+		/// * `key` - key for the feed
+		/// * `update_interval` - the feed is fetched every `update_interval` blocks
+		/// * `heartbeat` - a fetched value is submitted at least every `heartbeat` blocks
+		/// * `deviation` - a fetched value is submitted as soon as it deviates from the last
+		///     submitted value by `deviation`
+		/// 
+		/// # Emits
+		/// * `ApiFeedScheduled`
+        #[pallet::weight(T::WeightInfo::submit_api())]
+        pub fn set_api_schedule(
+            origin: OriginFor<T>,
+            key: OracleKeyOf<T>,
+            update_interval: T::BlockNumber,
+            heartbeat: T::BlockNumber,
+            deviation: Permill,
+        ) -> DispatchResult {
+            let submitter = ensure_signed(origin)?;
+            let cid = CreatorId::AccountId(submitter.clone());
+
+            // ensure submitter is authorized
+            ensure!(T::Members::contains(&submitter), Error::<T>::NoPermission);
+
+            Self::do_set_api_schedule(cid, key, update_interval, heartbeat, deviation)
+        }
+
+        /// Set the refresh schedule of the feed.
+		///
+		/// Can be only XCM call from feed parachain.
+		///
+		/// # Parameter:
+		/// * `key` - key for the feed
+		/// * `update_interval` - the feed is fetched every `update_interval` blocks
+		/// * `heartbeat` - a fetched value is submitted at least every `heartbeat` blocks
+		/// * `deviation` - a fetched value is submitted as soon as it deviates from the last
+		///     submitted value by `deviation`
+		/// 
+		/// # Emits
+		/// * `ApiFeedScheduled`
+        #[pallet::weight(T::WeightInfo::submit_api())]
+        pub fn xcm_set_api_schedule(
+            origin: OriginFor<T>,
+            key: OracleKeyOf<T>,
+            update_interval: T::BlockNumber,
+            heartbeat: T::BlockNumber,
+            deviation: Permill,
+        ) -> DispatchResult {
+            let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+            let cid = CreatorId::ParaId(para_id);
+
+            Self::do_set_api_schedule(cid, key, update_interval, heartbeat, deviation)
+        }
+
+        /// Query the feed data of several keys at once.
+		///
+		/// Can be only XCM call from feed parachain. The values found, with their timestamps,
+		/// are sent back in a single message.
+		///
+		/// # Parameter:
+		/// * `keys` - keys for the feeds
+		/// 
+        #[pallet::weight(T::WeightInfo::query_data_batch(keys.len() as u32))]
+		pub fn xcm_query_data_batch(
+			origin: OriginFor<T>,
+			keys: BoundedVec<OracleKeyOf<T>, T::MaxQueryKeys>,
+		) -> DispatchResult {
+			let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            let values: Vec<(Vec<u8>, TimestampedValueT)> = keys
+                .into_iter()
+                .filter_map(|key| Self::get(&key).map(|val| (key.into(), val)))
+                .collect();
+            ensure!(!values.is_empty(), DispatchError::CannotLookup);
+
+            Self::send_qret_batch_to_parachain(para_id, values)
+		}
+
+        /// Subscribe to the feed data of keys.
+		///
+		/// Can be only XCM call from feed parachain. The values updated in a block are then
+		/// pushed in a single message, subject to the heartbeat and deviation rule.
+		///
+		/// # Parameter:
+		/// * `keys` - keys for the feeds
+		/// * `heartbeat` - an updated value is pushed at least every `heartbeat` blocks
+		/// * `deviation` - an updated value is pushed as soon as it deviates from the last
+		///     pushed value by `deviation`
+		/// 
+		/// # Emits
+		/// * `Subscribed`
+        #[pallet::weight(T::WeightInfo::submit_api()
+            .saturating_add(T::DbWeight::get().reads_writes(1, 1))
+            .saturating_mul(keys.len() as u64))]
+        pub fn xcm_subscribe(
+            origin: OriginFor<T>,
+            keys: BoundedVec<OracleKeyOf<T>, T::MaxQueryKeys>,
+            heartbeat: T::BlockNumber,
+            deviation: Permill,
+        ) -> DispatchResult {
+            let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            let mut count = SubscriptionCount::<T>::get(para_id);
+            for key in keys.iter() {
+                ensure!(
+                    KeyIndices::<T>::contains_key(key) || Values::<T>::contains_key(key),
+                    Error::<T>::UnknownKey
+                );
+                if !Subscriptions::<T>::contains_key(key, para_id) {
+                    let subscribers = SubscriberCount::<T>::get(key);
+                    ensure!(
+                        subscribers < T::MaxSubscribersPerKey::get(),
+                        Error::<T>::TooManySubscribers
+                    );
+                    ensure!(
+                        count < T::MaxSubscriptionsPerPara::get(),
+                        Error::<T>::TooManySubscriptions
+                    );
+                    SubscriberCount::<T>::insert(key, subscribers + 1);
+                    count += 1;
+                }
+                Subscriptions::<T>::insert(
+                    key,
+                    para_id,
+                    Subscription { heartbeat, deviation, last_pushed: None },
+                );
+            }
+
+            SubscriptionCount::<T>::insert(para_id, count);
+
+            Self::deposit_event(Event::Subscribed { para_id, keys: keys.into_inner() });
+            Ok(())
+        }
+
+        /// Unsubscribe from the feed data of keys.
+		///
+		/// Can be only XCM call from feed parachain.
+		///
+		/// # Parameter:
+		/// * `keys` - keys for the feeds
+		/// 
+		/// # Emits
+		/// * `Unsubscribed`
+        #[pallet::weight(T::WeightInfo::remove_api(0)
+            .saturating_add(T::DbWeight::get().reads_writes(1, 1))
+            .saturating_mul(keys.len() as u64))]
+        pub fn xcm_unsubscribe(
+            origin: OriginFor<T>,
+            keys: BoundedVec<OracleKeyOf<T>, T::MaxQueryKeys>,
+        ) -> DispatchResult {
+            let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            for key in keys.iter() {
+                if Subscriptions::<T>::take(key, para_id).is_some() {
+                    SubscriptionCount::<T>::mutate_exists(para_id, |count| {
+                        *count = count.map(|count| count.saturating_sub(1)).filter(|count| *count > 0);
+                    });
+                    SubscriberCount::<T>::mutate_exists(key, |count| {
+                        *count = count.map(|count| count.saturating_sub(1)).filter(|count| *count > 0);
+                    });
+                }
+            }
+
+            Self::deposit_event(Event::Unsubscribed { para_id, keys: keys.into_inner() });
+            Ok(())
+        }
+
+        /// Query the past combined values of a key.
+		///
+		/// Can be only XCM call from feed parachain. The values kept with a timestamp within
+		/// `from..=to` are sent back, oldest first, in a single message.
+		///
+		/// # Parameter:
+		/// * `key` - key for the feed
+		/// * `from` - start of the time range, in milliseconds
+		/// * `to` - end of the time range, in milliseconds
+		/// 
+        #[pallet::weight(T::WeightInfo::query_history(T::MaxHistoryLen::get()))]
+		pub fn xcm_query_history(
+			origin: OriginFor<T>,
+			key: OracleKeyOf<T>,
+			from: u128,
+			to: u128,
+		) -> DispatchResult {
+			let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            let values = Self::history(&key, from, to);
+            ensure!(!values.is_empty(), DispatchError::CannotLookup);
+
+            Self::send_to_feed(
+                para_id,
+                KylinMockFunc::xcm_feed_back_history { key: key.into(), values },
+            )
+		}
+
+        /// Feed the external value in compact form.
+		///
+		/// Each value refers to its key by its index in `KeyIndices`, and is the zigzag encoded
+		/// difference with the last value fed by the feeder for the key, or with zero if none.
+		///
+		/// Call by the offchain worker.
+		///
+		/// # Parameter:
+		/// * `last_fed_at` - the last block the feeder has fed in, which the deltas are based on
+		/// * `values` - key index and delta array for the feed
+		/// 
+		/// # Emits
+		/// * `NewFeedData`
+		#[pallet::weight(T::WeightInfo::feed_data_compact(values.len() as u32, T::MaxFeedersPerKey::get()))]
+		pub fn feed_data_compact(
+			origin: OriginFor<T>,
+			last_fed_at: Option<T::BlockNumber>,
+			values: BoundedVec<(Compact<u32>, Compact<u64>), T::MaxFeedValues>,
+		) -> DispatchResultWithPostInfo {
+			let feeder = ensure_signed(origin)?;
+            let cid = CreatorId::AccountId(feeder.clone());
+            // ensure feeder is authorized
+            ensure!(T::Members::contains(&feeder), Error::<T>::NoPermission);
+            // Deltas based on values fed since would not decode to the submitted values.
+            ensure!(LastFedAt::<T>::get(&cid) == last_fed_at, Error::<T>::StaleDelta);
+
+            let values = values
+                .into_iter()
+                .map(|(index, delta)| {
+                    let key = IndexedKeys::<T>::get(index.0).ok_or(Error::<T>::UnknownKeyIndex)?;
+                    let base = RawValues::<T>::get(&key, &cid).map_or(0, |raw| raw.value);
+                    Ok((key, base.wrapping_add(zigzag_decode(delta.0))))
+                })
+                .collect::<Result<Vec<_>, Error<T>>>()?;
+
+            // ensure account hasn't dispatched an updated yet
+            Self::mark_fed(&cid)?;
+
+            Self::feed_values(cid, values);
+			Ok(Pays::No.into())
+		}
+
+        /// Choose the hot keys, whose values are kept together and read at once.
+		///
+		/// Can be called by `HotKeysOrigin`, the long tail of keys staying in `Values` only.
+		///
+		/// # Parameter:
+		/// * `keys` - the hot keys, replacing the previous ones
+		/// 
+		/// # Emits
+		/// * `HotKeysSet`
+        #[pallet::weight(T::WeightInfo::set_hot_keys(keys.len() as u32))]
+        pub fn set_hot_keys(
+            origin: OriginFor<T>,
+            keys: BoundedVec<OracleKeyOf<T>, T::MaxHotKeys>,
+        ) -> DispatchResult {
+            T::HotKeysOrigin::ensure_origin(origin)?;
+
+            let mut keys = keys.into_inner();
+            keys.sort();
+            keys.dedup();
+            let hot_values: BoundedVec<_, T::MaxHotKeys> = keys
+                .iter()
+                .map(|key| (key.clone(), Self::values(key)))
+                .collect::<Vec<_>>()
+                .try_into()
+                .map_err(|_| Error::<T>::TooLarge)?;
+            HotValues::<T>::put(hot_values);
+
+            Self::deposit_event(Event::HotKeysSet { keys });
+            Ok(())
+        }
+
+        /// Query the feed data of every hot key.
+		///
+		/// Can be only XCM call from feed parachain. The values of the hot keys are read at once
+		/// and sent back in a single message, as for `xcm_query_data_batch`.
+		/// 
+        #[pallet::weight(T::WeightInfo::query_hot_values(T::MaxHotKeys::get()))]
+        pub fn xcm_query_hot_values(origin: OriginFor<T>) -> DispatchResult {
+            let para_id =
+                ensure_sibling_para(<T as Config>::RuntimeOrigin::from(origin))?;
+
+            let values: Vec<(Vec<u8>, TimestampedValueT)> = Self::hot_values()
+                .into_iter()
+                .filter_map(|(key, value)| value.map(|value| (key.into(), value)))
+                .collect();
+            ensure!(!values.is_empty(), DispatchError::CannotLookup);
+
+            Self::send_qret_batch_to_parachain(para_id, values)
+        }
     }
 
     // #[pallet::event where <T as frame_system::Config>:: AccountId: AsRef<[u8]> + ToHex + Decode + Serialize]
@@ -563,6 +1065,31 @@ pub mod pallet {
             key: OracleKeyOf<T>,
             feed: ApiFeed<T::BlockNumber>,
 		},
+        /// Apifeed schedule is updated.
+		ApiFeedScheduled {
+			sender: CreatorId<T::AccountId>,
+            key: OracleKeyOf<T>,
+            feed: ApiFeed<T::BlockNumber>,
+		},
+        /// Combined values are updated, along with the time elapsed since the previous combined
+        /// value of each key in milliseconds, zero for a new key.
+		ValuesCombined {
+			staleness: Vec<(OracleKeyOf<T>, u128)>,
+		},
+        /// Parachain subscribed to keys.
+		Subscribed {
+			para_id: ParaId,
+            keys: Vec<OracleKeyOf<T>>,
+		},
+        /// Parachain unsubscribed from keys.
+		Unsubscribed {
+			para_id: ParaId,
+            keys: Vec<OracleKeyOf<T>>,
+		},
+        /// Hot keys are chosen.
+		HotKeysSet {
+            keys: Vec<OracleKeyOf<T>>,
+		},
     }
 
     #[pallet::validate_unsigned]
@@ -663,93 +1190,394 @@ where T::AccountId: AsRef<[u8]>
                 "No local accounts available. Consider adding one via `author_insertKey` RPC.",
             )?;
         }
+        let started_at = sp_io::offchain::timestamp();
+
+        let mut feeds: Vec<DueFeed<OracleKeyOf<T>, T::BlockNumber>> =
+            <ApiFeeds<T> as IterableStorageDoubleMap<_, _, _>>::iter()
+                .filter_map(|(creator, key, feed)| {
+                    let (url, vpath) = match (feed.url.clone(), feed.vpath.clone()) {
+                        (Some(url), Some(vpath)) => (url, vpath),
+                        _ => return None,
+                    };
+                    let (schedule_key, schedule) =
+                        Self::feed_schedule(&creator, &key, &feed, block_number);
+                    if schedule.next_fetch > block_number {
+                        return None;
+                    }
+                    Some(DueFeed { key, url, vpath, feed, schedule_key, schedule })
+                })
+                // Endpoints that keep failing don't eat the deadline budget of every run.
+                .filter(|due| Self::endpoint_health(&due.url).backoff_until <= block_number)
+                .collect();
+
+        // The most overdue feeds go first, the rest is left to the next runs.
+        feeds.sort_by(|a, b| a.schedule.next_fetch.cmp(&b.schedule.next_fetch));
+        feeds.truncate(MAX_FEEDS_PER_RUN);
+        let due = feeds.len() as u32;
+
+        // Feeds sharing an endpoint are fetched and parsed only once, every vpath of the
+        // endpoint is extracted in the same pass over the response.
+        let mut url_indices = BTreeMap::<&[u8], usize>::new();
+        let mut urls: Vec<&[u8]> = Vec::new();
+        let mut url_vpaths: Vec<Vec<&[u8]>> = Vec::new();
+        let feed_slots: Vec<(usize, usize)> = feeds
+            .iter()
+            .map(|due| {
+                let url_index = *url_indices.entry(due.url.as_slice()).or_insert_with(|| {
+                    urls.push(due.url.as_slice());
+                    url_vpaths.push(Vec::new());
+                    urls.len() - 1
+                });
+                let vpaths = &mut url_vpaths[url_index];
+                vpaths.push(due.vpath.as_slice());
+                (url_index, vpaths.len() - 1)
+            })
+            .collect();
+
+        // Every request is sent up front so the worker only waits for the slowest endpoint.
+        // While the native fetcher of the node is running, it does the fetching instead and the
+        // values it fetched for the previous run are used. `None` stands for an endpoint whose
+        // values are not there yet, its feeds being left due.
+        let now = sp_io::offchain::timestamp().unix_millis();
+        let mut fetches = Vec::new();
+        let extracted: Vec<Option<Result<Vec<Option<i64>>, &'static str>>> =
+            if native_fetch::is_alive(now) {
+                let endpoints: Vec<(&[u8], Vec<&[u8]>)> =
+                    urls.iter().copied().zip(url_vpaths.iter().cloned()).collect();
+                let max_response_size = T::MaxResponseSize::get();
+                native_fetch::request(OFFCHAIN_NAMESPACE, &endpoints, max_response_size, now)
+                    .into_iter()
+                    .zip(urls.iter())
+                    .map(|(result, url)| {
+                        let (latency, ivals) = result?;
+                        Self::record_endpoint_health(url, block_number, latency, ivals.is_some());
+                        fetches.push(EndpointFetch {
+                            url: url.to_vec(),
+                            latency,
+                            success: ivals.is_some(),
+                            values: ivals.as_ref().map_or(0, |ivals| ivals.iter().flatten().count() as u32),
+                        });
+                        Some(ivals.ok_or("Failed fetch http"))
+                    })
+                    .collect()
+            } else {
+                let responses = Self::fetch_http_get_results(&urls);
+                urls.iter()
+                    .zip(url_vpaths.iter())
+                    .zip(responses)
+                    .map(|((url, vpaths), (response, latency))| {
+                        let fvals = response
+                            .map_err(|_| "Failed fetch http")
+                            .and_then(|response| Self::extract_feed_values(response, vpaths));
+                        Self::record_endpoint_health(url, block_number, latency, fvals.is_ok());
+                        fetches.push(EndpointFetch {
+                            url: url.to_vec(),
+                            latency,
+                            success: fvals.is_ok(),
+                            values: fvals.as_ref().map_or(0, |fvals| fvals.iter().flatten().count() as u32),
+                        });
+                        Some(fvals.map(|fvals| {
+                            fvals.into_iter().map(|fval| fval.map(native_fetch::to_fixed)).collect()
+                        }))
+                    })
+                    .collect()
+            };
 
+        // A failing feed is skipped, every value fetched successfully is still submitted.
         let mut values = Vec::<(OracleKeyOf<T>, i64)>::new();
-        for (_creator, key, val) in <ApiFeeds<T> as IterableStorageDoubleMap<_, _, _>>::iter() {
-            // let mut response :Vec<u8>;
-            if val.url.is_some() && val.vpath.is_some() {
-                let vpath = val.vpath.unwrap();
-                let response = Self::fetch_http_get_result(val.url.clone().unwrap())
-                    .map_err(|_| "Failed fetch http")?;
-                let res_json :JValue = serde_json::from_slice(&response)
-                    .map_err(|_| "Response JSON was not well-formatted")?;
-                let path = str::from_utf8(&vpath)
-                    .map_err(|_| "vpath contain invalid utf8 string")?;
-                let fval = res_json.pointer(path)
-                    .ok_or("vpath error")?
-                    .as_f64()
-                    .ok_or("vpath value type error")?;
-
-                // We only store int, so every float will be convert to int with 6 decimals pad
-                let ival :i64 = (fval * 1000000.0) as i64;
-                values.push((key.clone(), ival));
+        let mut submitting = Vec::new();
+        for (mut due, (url_index, vpath_index)) in feeds.into_iter().zip(feed_slots) {
+            let ival = match extracted.get(url_index) {
+                // Not fetched by the native fetcher yet, the feed is fetched again.
+                Some(None) => continue,
+                Some(Some(ivals)) => ivals
+                    .as_ref()
+                    .map_err(|e| *e)
+                    .and_then(|ivals| ivals.get(vpath_index).copied().flatten().ok_or("vpath error")),
+                None => Err("Missing response"),
+            };
+
+            due.schedule.next_fetch =
+                block_number + due.feed.update_interval.max(One::one());
+            match ival {
+                Ok(ival) => {
+                    // Values that barely moved are only submitted on heartbeat.
+                    if Self::should_submit(&due.feed, &due.schedule, ival, block_number) {
+                        values.push((due.key.clone(), ival));
+                        submitting.push((due.schedule_key.clone(), due.schedule.clone(), ival));
+                    }
+                },
+                Err(e) => log::warn!("Skip feed {:?}: {}", str::from_utf8(&due.key), e),
             }
+            StorageValueRef::persistent(&due.schedule_key).set(&due.schedule);
         }
 
+        let mut submitted = false;
         if values.len() > 0 {
-            let results = signer.send_signed_transaction(|_account| Call::feed_data {
-                values: values.clone(),
-            });
-            for (acc, res) in &results {
-                match res {
-                    Ok(()) => log::info!("[{:?}] Submitted data", acc.id),
-                    Err(e) => log::error!("[{:?}] Failed to submit transaction: {:?}", acc.id, e),
+            if T::SingleFeeder::get() {
+                // Only the first local member key feeds, the other keys are left idle.
+                let elected = Self::member_keys().into_iter().take(1).collect();
+                let signer = Signer::<T, T::AuthorityId>::any_account().with_filter(elected);
+                match signer.send_signed_transaction(|account| Self::feed_call(&account.id, &values)) {
+                    Some((acc, Ok(()))) => {
+                        log::info!("[{:?}] Submitted data", acc.id);
+                        submitted = true;
+                    },
+                    Some((acc, Err(e))) => log::error!("[{:?}] Failed to submit transaction: {:?}", acc.id, e),
+                    None => log::error!("No local account is an oracle member"),
                 }
+            } else {
+                let results = signer.send_signed_transaction(|account| Self::feed_call(&account.id, &values));
+                for (acc, res) in &results {
+                    match res {
+                        Ok(()) => {
+                            log::info!("[{:?}] Submitted data", acc.id);
+                            submitted = true;
+                        },
+                        Err(e) => log::error!("[{:?}] Failed to submit transaction: {:?}", acc.id, e),
+                    }
+                }
+            }
+        }
+
+        // The heartbeat and deviation are measured from the last value actually submitted, a
+        // failed submission leaves the values due for the next fetch.
+        if submitted {
+            for (schedule_key, mut schedule, ival) in submitting {
+                schedule.last_submitted = Some((ival, block_number));
+                StorageValueRef::persistent(&schedule_key).set(&schedule);
             }
         }
 
+        let finished_at = sp_io::offchain::timestamp();
+        offchain_metrics::record_run(
+            OFFCHAIN_NAMESPACE,
+            &WorkerRun {
+                finished_at: finished_at.unix_millis(),
+                duration: finished_at.diff(&started_at).millis(),
+                due,
+                submitted: if submitted { values.len() as u32 } else { 0 },
+                fetches,
+            },
+        );
+
         Ok(())
     }
+
+    /// Public keys of the local accounts which are oracle members.
+    fn member_keys() -> Vec<T::Public> {
+        <T::AuthorityId as AppCrypto<T::Public, T::Signature>>::RuntimeAppPublic::all()
+            .into_iter()
+            .map(|key| {
+                let public: T::Public =
+                    <T::AuthorityId as AppCrypto<T::Public, T::Signature>>::GenericPublic::from(key)
+                        .into();
+                public
+            })
+            .filter(|public| T::Members::contains(&public.clone().into_account()))
+            .collect()
+    }
+
+    /// The call feeding `values` as `who`, in compact form if every key has an index and there
+    /// are at most `MaxFeedValues` of them.
+    ///
+    /// The deltas are based on the values of `who` in the current state, and are rejected as
+    /// stale if `who` feeds again before the call is included.
+    fn feed_call(who: &T::AccountId, values: &[(OracleKeyOf<T>, i64)]) -> Call<T> {
+        let cid = CreatorId::AccountId(who.clone());
+        let compact = values
+            .iter()
+            .map(|(key, value)| {
+                let index = KeyIndices::<T>::get(key)?;
+                let base = RawValues::<T>::get(key, &cid).map_or(0, |raw| raw.value);
+                Some((Compact(index), Compact(zigzag_encode(value.wrapping_sub(base)))))
+            })
+            .collect::<Option<Vec<_>>>()
+            .and_then(|values| BoundedVec::try_from(values).ok());
+        match compact {
+            Some(values) => Call::feed_data_compact { last_fed_at: LastFedAt::<T>::get(&cid), values },
+            None => Call::feed_data { values: values.to_vec() },
+        }
+    }
     
-    /// Fetch current price and return the result in cents.
-    fn fetch_http_get_result(url: Vec<u8>) -> Result<Vec<u8>, http::Error> {
+    /// Fetch every url concurrently and return the responses in the same order, along with the
+    /// latency of each request in milliseconds.
+    ///
+    /// All requests are sent before any of them is awaited, and they share a single deadline,
+    /// so the worker wall time is bounded by the slowest endpoint rather than by their sum.
+    fn fetch_http_get_results(urls: &[&[u8]]) -> Vec<(Result<http::Response, http::Error>, u64)> {
         // We want to keep the offchain worker execution time reasonable, so we set a hard-coded
-        // deadline to 2s to complete the external call.
+        // deadline to 10s to complete all the external calls.
         // You can also wait idefinitely for the response, however you may still get a timeout
         // coming from the host machine.
-        let deadline = sp_io::offchain::timestamp().add(Duration::from_millis(10_000));
-        // Initiate an external HTTP GET request.
+        let start = sp_io::offchain::timestamp();
+        let deadline = start.add(Duration::from_millis(10_000));
+
+        // Initiate the external HTTP GET requests.
         // This is using high-level wrappers from `sp_runtime`, for the low-level calls that
         // you can find in `sp_io`. The API is trying to be similar to `reqwest`, but
         // since we are running in a custom WASM execution environment we can't simply
         // import the library here.
-        let request = http::Request::get(str::from_utf8(&url).unwrap());
-
-        // We set the deadline for sending of the request, note that awaiting response can§
-        // have a separate deadline. Next we send the request, before that it's also possible
-        // to alter request headers or stream body content in case of non-GET requests.
-        let pending = request
-            .deadline(deadline)
-            .send()
-            .map_err(|_| http::Error::IoError)?;
-
-        // The request is already being processed by the host, we are free to do anything
-        // else in the worker (we can send multiple concurrent requests too).
-        // At some point however we probably want to check the response though,
-        // so we can block current thread and wait for it to finish.
-        // Note that since the request is being driven by the host, we don't have to wait
-        // for the request to have it complete, we will just not read the response.
-        let response = pending
-            .try_wait(deadline)
-            .map_err(|_| http::Error::DeadlineReached)??;
+        // The requests are driven by the host, so they are processed concurrently while
+        // we keep on sending the next ones.
+        let mut results: Vec<(Result<http::Response, http::Error>, u64)> = Vec::with_capacity(urls.len());
+        let mut pending = Vec::with_capacity(urls.len());
+        for (index, url) in urls.iter().enumerate() {
+            let sent = str::from_utf8(url)
+                .map_err(|_| http::Error::Unknown)
+                .and_then(|url| {
+                    http::Request::get(url)
+                        .deadline(deadline)
+                        .send()
+                        .map_err(|_| http::Error::IoError)
+                });
+            match sent {
+                Ok(request) => {
+                    pending.push((index, request));
+                    results.push((Err(http::Error::DeadlineReached), 0));
+                },
+                Err(e) => results.push((Err(e), 0)),
+            }
+        }
+
+        // Wait for the requests in short rounds until all of them have completed or the shared
+        // deadline is reached, so the latency of every endpoint can be measured.
+        // Requests still pending at the deadline keep their `DeadlineReached` error.
+        while !pending.is_empty() {
+            let now = sp_io::offchain::timestamp();
+            if now >= deadline {
+                break;
+            }
+            let poll_until = now.add(Duration::from_millis(HTTP_POLL_INTERVAL_MS)).min(deadline);
+
+            let (indices, requests): (Vec<usize>, Vec<http::PendingRequest>) =
+                pending.into_iter().unzip();
+            let responses = http::PendingRequest::try_wait_all(requests, poll_until);
+            let latency = sp_io::offchain::timestamp().diff(&start).millis();
+
+            pending = Vec::new();
+            for (index, response) in indices.into_iter().zip(responses) {
+                match response {
+                    Ok(response) => results[index] = (response, latency),
+                    Err(request) => pending.push((index, request)),
+                }
+            }
+        }
+        for (index, _) in pending {
+            results[index].1 = deadline.diff(&start).millis();
+        }
 
+        results
+    }
+
+    /// Check the status code and extract the number at each of the `vpaths` of a JSON response.
+    ///
+    /// The body is streamed through the extractor rather than collected, so a response is never
+    /// held in memory and reading stops as soon as it exceeds `MaxResponseSize`.
+    fn extract_feed_values(
+        response: http::Response,
+        vpaths: &[&[u8]],
+    ) -> Result<Vec<Option<f64>>, &'static str> {
         // Let's check the status code before we proceed to reading the response.
         if response.code != 200 {
             log::info!("Unexpected status code: {}", response.code);
-            return Err(http::Error::Unknown);
+            return Err("Failed fetch http");
         }
 
-        // Next we want to fully read the response body and collect it to a vector of bytes.
-        // Note that the return object allows you to read the body in chunks as well
-        // with a way to control the deadline.
-        let body = response.body().collect::<Vec<u8>>();
-        // Create a str slice from the body.
-        let body_str = sp_std::str::from_utf8(&body).map_err(|_| {
-            log::info!("No UTF8 body");
-            http::Error::Unknown
-        })?;
+        let mut body = response.body();
+        let fvals = extract_numbers(&mut body, vpaths, T::MaxResponseSize::get() as usize);
+        if body.error().is_some() {
+            return Err("Failed fetch http");
+        }
+        fvals.map_err(|e| match e {
+            JsonError::TooLarge => "Response exceeds the maximum size",
+            JsonError::TooDeep | JsonError::Malformed => "Response JSON was not well-formatted",
+        })
+    }
+
+    /// Read the offchain schedule of a feed, along with its offchain storage key.
+    ///
+    /// A feed seen for the first time is due at a block derived from its hash within its
+    /// update interval, so that feeds sharing an interval are spread evenly across blocks.
+    fn feed_schedule(
+        creator: &CreatorId<T::AccountId>,
+        key: &OracleKeyOf<T>,
+        feed: &ApiFeed<T::BlockNumber>,
+        block_number: T::BlockNumber,
+    ) -> (Vec<u8>, FeedSchedule<T::BlockNumber>) {
+        let hash = (creator, key).using_encoded(sp_io::hashing::blake2_128);
+        let mut schedule_key = FEED_SCHEDULE_PREFIX.to_vec();
+        schedule_key.extend_from_slice(&hash);
+
+        let schedule = StorageValueRef::persistent(&schedule_key)
+            .get::<FeedSchedule<T::BlockNumber>>()
+            .ok()
+            .flatten()
+            .unwrap_or_else(|| {
+                let interval: u32 = feed.update_interval.unique_saturated_into();
+                let phase = u32::from_le_bytes([hash[0], hash[1], hash[2], hash[3]]) % interval.max(1);
+                FeedSchedule { next_fetch: block_number + phase.into(), last_submitted: None }
+            });
+        (schedule_key, schedule)
+    }
+
+    /// Whether a freshly fetched value must be submitted, i.e. if the heartbeat of the feed has
+    /// elapsed or the value deviates from the last submitted one by at least the feed deviation.
+    fn should_submit(
+        feed: &ApiFeed<T::BlockNumber>,
+        schedule: &FeedSchedule<T::BlockNumber>,
+        value: i64,
+        block_number: T::BlockNumber,
+    ) -> bool {
+        deviation::is_due(schedule.last_submitted, value, block_number, feed.heartbeat, feed.deviation)
+    }
+
+    fn endpoint_health_key(url: &[u8]) -> Vec<u8> {
+        let mut key = ENDPOINT_HEALTH_PREFIX.to_vec();
+        key.extend_from_slice(&sp_io::hashing::blake2_128(url));
+        key
+    }
 
-        Ok(body_str.clone().as_bytes().to_vec())
+    /// Read the health of the endpoint `url` from the offchain local storage.
+    pub fn endpoint_health(url: &[u8]) -> EndpointHealth<T::BlockNumber> {
+        let key = Self::endpoint_health_key(url);
+        StorageValueRef::persistent(&key)
+            .get::<EndpointHealth<T::BlockNumber>>()
+            .ok()
+            .flatten()
+            .unwrap_or_default()
+    }
+
+    /// Record the outcome of a fetch of `url` in the offchain local storage.
+    ///
+    /// After `ENDPOINT_BACKOFF_THRESHOLD` consecutive failures the endpoint is skipped for an
+    /// exponentially growing number of blocks, capped at `ENDPOINT_MAX_BACKOFF`.
+    fn record_endpoint_health(url: &[u8], block_number: T::BlockNumber, latency: u64, success: bool) {
+        let key = Self::endpoint_health_key(url);
+        let val = StorageValueRef::persistent(&key);
+        let res = val.mutate(
+            |health: Result<Option<EndpointHealth<T::BlockNumber>>, StorageRetrievalError>| {
+                let mut health = health.ok().flatten().unwrap_or_default();
+                health.last_latency = latency;
+                if success {
+                    health.consecutive_failures = 0;
+                } else {
+                    health.consecutive_failures = health.consecutive_failures.saturating_add(1);
+                    if health.consecutive_failures >= ENDPOINT_BACKOFF_THRESHOLD {
+                        let exponent = health.consecutive_failures - ENDPOINT_BACKOFF_THRESHOLD;
+                        let backoff = 1u32
+                            .checked_shl(exponent)
+                            .unwrap_or(ENDPOINT_MAX_BACKOFF)
+                            .min(ENDPOINT_MAX_BACKOFF);
+                        health.backoff_until = block_number + backoff.into();
+                    }
+                }
+                Ok::<_, ()>(health)
+            },
+        );
+        if res.is_err() {
+            log::debug!("Endpoint health concurrently modified, skip");
+        }
     }
 
     fn send_qret_to_parachain(para_id: ParaId, key: Vec<u8>, value: i64) -> DispatchResult {
@@ -776,6 +1604,138 @@ where T::AccountId: AsRef<[u8]>
         Ok(())
     }
 
+    /// Send `values` back to the feed pallet of `para_id`, in messages of at most
+    /// `MaxQueryKeys` values as the feed pallet accepts no more in one `xcm_feed_back_batch`.
+    fn send_qret_batch_to_parachain(
+        para_id: ParaId,
+        values: Vec<(Vec<u8>, TimestampedValueT)>,
+    ) -> DispatchResult {
+        for chunk in values.chunks(T::MaxQueryKeys::get().max(1) as usize) {
+            Self::send_to_feed(
+                para_id,
+                KylinMockFunc::xcm_feed_back_batch { values: chunk.to_vec() },
+            )?;
+        }
+
+        Ok(())
+    }
+
+    /// Send `func` to the feed pallet of `para_id`.
+    fn send_to_feed(para_id: ParaId, func: KylinMockFunc) -> DispatchResult {
+        let remark = KylinMockCall::KylinFeed(func);
+        T::XcmSender::send_xcm(
+            (
+                1,
+                Junction::Parachain(para_id.into()),
+            ),
+            Xcm(vec![Transact {
+                origin_type: OriginKind::Native,
+                require_weight_at_most: 1_000_000_000,
+                call: remark.encode().into(),
+            }]),
+        ).map_err(
+            |e| {
+                log::error!("Error: XcmSendError {:?}, {:?}", para_id, e);
+                Error::<T>::XcmSendError
+            }
+        )?;
+
+        Ok(())
+    }
+
+    /// Record that `cid` has fed a value in the current block, failing if it already has.
+    fn mark_fed(cid: &CreatorId<T::AccountId>) -> DispatchResult {
+        let block_number = <system::Pallet<T>>::block_number();
+        LastFedAt::<T>::try_mutate(cid, |last_fed_at| {
+            ensure!(*last_fed_at != Some(block_number), Error::<T>::AlreadyFeeded);
+            *last_fed_at = Some(block_number);
+            Ok(())
+        })
+    }
+
+    /// Queue the new combined value of `key` for every subscriber whose rule is met.
+    ///
+    /// A value updated several times in a block is pushed once, with its latest value. The
+    /// subscription records the pushed value once it is sent.
+    fn queue_pushes(key: &OracleKeyOf<T>, combined: TimestampedValueT) {
+        let block_number = <system::Pallet<T>>::block_number();
+        for (para_id, subscription) in Subscriptions::<T>::iter_prefix(key) {
+            if !Self::should_push(&subscription, combined.value, block_number) {
+                continue;
+            }
+            PendingPushes::<T>::mutate(para_id, |pending| {
+                match pending.iter_mut().find(|(k, _)| k.as_slice() == key.as_slice()) {
+                    Some((_, value)) => *value = combined,
+                    None => pending.push((key.to_vec(), combined)),
+                }
+            });
+        }
+    }
+
+    /// Whether the new combined value of a key must be pushed to a subscriber, by the same
+    /// heartbeat and deviation rule as the submission of fetched values.
+    fn should_push(
+        subscription: &Subscription<T::BlockNumber>,
+        value: i64,
+        block_number: T::BlockNumber,
+    ) -> bool {
+        deviation::is_due(
+            subscription.last_pushed,
+            value,
+            block_number,
+            subscription.heartbeat,
+            subscription.deviation,
+        )
+    }
+
+    /// Send the pending values of each subscriber in a single message, as long as the
+    /// `remaining_weight` allows. The subscribers left over are pushed in the next block.
+    ///
+    /// Only as many subscribers as the weight of their largest push fits in are read, and the
+    /// subscriptions of the values sent record them as pushed.
+    fn push_to_subscribers(remaining_weight: Weight) -> Weight {
+        let mut consumed = T::DbWeight::get().reads(1);
+        let max_len = T::MaxSubscriptionsPerPara::get();
+        let max_push = Self::push_weight(max_len);
+        let max_paras = remaining_weight.ref_time().saturating_sub(consumed.ref_time()) /
+            max_push.ref_time().max(1);
+        if max_paras == 0 {
+            return consumed
+        }
+
+        let para_ids: Vec<_> = PendingPushes::<T>::iter_keys().take(max_paras as usize).collect();
+        let block_number = <system::Pallet<T>>::block_number();
+        for para_id in para_ids {
+            let values = PendingPushes::<T>::take(para_id);
+            consumed = consumed.saturating_add(Self::push_weight(values.len() as u32));
+
+            let pushed: Vec<_> = values.iter().map(|(key, value)| (key.clone(), value.value)).collect();
+            match Self::send_qret_batch_to_parachain(para_id, values) {
+                Ok(()) => {
+                    for (key, value) in pushed {
+                        if let Ok(key) = OracleKeyOf::<T>::try_from(key) {
+                            Subscriptions::<T>::mutate_exists(&key, para_id, |subscription| {
+                                if let Some(subscription) = subscription {
+                                    subscription.last_pushed = Some((value, block_number));
+                                }
+                            });
+                        }
+                    }
+                    Self::deposit_event(Event::FeedDataSent(para_id));
+                },
+                Err(e) => log::error!("Failed to push values to {:?}: {:?}", para_id, e),
+            }
+        }
+        consumed
+    }
+
+    /// Weight of pushing `len` values to a subscriber: reading and sending them, then
+    /// recording them as pushed.
+    fn push_weight(len: u32) -> Weight {
+        T::WeightInfo::query_data_batch(len)
+            .saturating_add(T::DbWeight::get().reads_writes(1 + len as u64, 1 + len as u64))
+    }
+
     fn validate_transaction(block_number: &T::BlockNumber) -> TransactionValidity {
         // Now let's check if the transaction has any chance to succeed.
         let next_unsigned_at = <NextUnsignedAt<T>>::get();
@@ -794,23 +1754,11 @@ where T::AccountId: AsRef<[u8]>
             .build()
     }
 
+    /// Read the raw values of every feeder for `key`.
+    ///
+    /// Only the `key` prefix of `RawValues` is iterated, so the cost is O(feeders of `key`).
     pub fn read_raw_values(key: &OracleKeyOf<T>) -> Vec<TimestampedValueT> {
-		// let mut v0 :Vec<TimestampedValueOf<T>> = T::Members::sorted_members()
-		// 	.iter()
-		// 	.filter_map(|x| Self::raw_values(x, key))
-		// 	.collect();
-        
-        // let mut v1 :Vec<TimestampedValueOf<T>> = 
-        //     <PRawValues<T> as IterableStorageDoubleMap<_, _, _>>::iter()
-        //     .filter_map(|(_, k, val)| if *key == k { Some(val) } else { None })
-        //     .collect();
-        
-        // v0.append(&mut v1);
-        // v0
-
-        <RawValues<T> as IterableStorageDoubleMap<_, _, _>>::iter()
-            .filter_map(|(_, k, val)| if *key == k { Some(val) } else { None })
-            .collect()
+        <RawValues<T>>::iter_prefix_values(key).collect()
 	}
 
 	/// Fetch current combined value.
@@ -818,16 +1766,186 @@ where T::AccountId: AsRef<[u8]>
 		Self::values(key)
 	}
 
+	/// Past combined values of `key` with a timestamp within `from..=to`, oldest first.
+	///
+	/// Values are kept in timestamp order, the first one in range is found by binary search.
+	pub fn history(key: &OracleKeyOf<T>, from: u128, to: u128) -> Vec<TimestampedValueT> {
+		let cursor = HistoryCursors::<T>::get(key);
+		let (cap, len) = (cursor.cap, cursor.len.min(cursor.cap));
+		if len == 0 || from > to {
+			return Vec::new();
+		}
+		let oldest = (cursor.next % cap + cap - len) % cap;
+		let at = |i: u32| History::<T>::get(key, (oldest + i) % cap);
+
+		let (mut low, mut high) = (0, len);
+		while low < high {
+			let mid = low + (high - low) / 2;
+			match at(mid) {
+				Some(value) if value.timestamp < from => low = mid + 1,
+				_ => high = mid,
+			}
+		}
+		(low..len).map_while(at).take_while(|value| value.timestamp <= to).collect()
+	}
+
+	/// Combined values of the hot keys, sorted by key.
+	pub fn get_hot_values() -> Vec<(OracleKeyOf<T>, TimestampedValueT)> {
+		Self::hot_values()
+			.into_iter()
+			.filter_map(|(key, value)| value.map(|value| (key, value)))
+			.collect()
+	}
+
 	#[allow(clippy::complexity)]
 	pub fn get_all_values() -> Vec<(OracleKeyOf<T>, Option<TimestampedValueT>)> {
 		<Values<T>>::iter().map(|(k, v)| (k, Some(v))).collect()
 	}
 
+	/// Combine the raw values of `key`, which are handed to `CombineData` sorted by value.
 	fn combined(key: &OracleKeyOf<T>) -> Option<TimestampedValueT> {
-		let values = Self::read_raw_values(key);
+		let values = Self::sorted_raw_values(key).into();
 		T::CombineData::combine_data(key, values, Self::values(key))
 	}
 
+	/// Record `combined` in the history of `key`, overwriting its oldest value once full.
+	///
+	/// Values are recorded with the time they are combined at: a key combined several times in
+	/// the same block keeps a single entry with the latest value, and a value older than the
+	/// newest one is not kept, so that the ring stays in timestamp order.
+	fn record_history(key: &OracleKeyOf<T>, combined: TimestampedValueT) {
+		let cap = T::MaxHistoryLen::get();
+		if cap.is_zero() {
+			return;
+		}
+		HistoryCursors::<T>::mutate(key, |cursor| {
+			if cursor.cap != cap {
+				*cursor = Self::resize_history(key, *cursor, cap);
+			}
+			if cursor.len > 0 && cursor.newest >= combined.timestamp {
+				if cursor.newest == combined.timestamp {
+					History::<T>::insert(key, (cursor.next + cap - 1) % cap, combined);
+				}
+				return;
+			}
+			History::<T>::insert(key, cursor.next, combined);
+			cursor.next = (cursor.next + 1) % cap;
+			cursor.len = (cursor.len + 1).min(cap);
+			cursor.newest = combined.timestamp;
+		});
+	}
+
+	/// Lay the ring of `key` out again for `cap` slots, keeping its newest values.
+	///
+	/// Returns the new cursor, which is empty when `cap` is zero.
+	pub(crate) fn resize_history(
+		key: &OracleKeyOf<T>,
+		cursor: HistoryCursor,
+		cap: u32,
+	) -> HistoryCursor {
+		let len = cursor.len.min(cursor.cap);
+		let oldest = if len == 0 { 0 } else { (cursor.next % cursor.cap + cursor.cap - len) % cursor.cap };
+		let values: Vec<_> = (0..len)
+			.filter_map(|i| History::<T>::take(key, (oldest + i) % cursor.cap))
+			.collect();
+		let kept = &values[values.len().saturating_sub(cap as usize)..];
+		for (slot, value) in kept.iter().enumerate() {
+			History::<T>::insert(key, slot as u32, value);
+		}
+		let len = kept.len() as u32;
+		HistoryCursor { next: if cap.is_zero() { 0 } else { len % cap }, len, newest: cursor.newest, cap }
+	}
+
+	/// Remove the history of `key`.
+	fn clear_history(key: &OracleKeyOf<T>) {
+		let cursor = HistoryCursors::<T>::take(key);
+		let _ = History::<T>::clear_prefix(key, cursor.cap, None);
+	}
+
+	/// Store the raw `values` of a feeder and update the combined value of their keys.
+	///
+	/// The hot values are read once and written once for all the keys fed.
+	fn feed_values(cid: CreatorId<T::AccountId>, values: Vec<(OracleKeyOf<T>, i64)>) {
+		let now = T::UnixTime::now().as_millis();
+		let mut staleness = Vec::new();
+		let mut hot_values = HotValues::<T>::get();
+		let mut hot_updated = false;
+		for (key, value) in &values {
+			let timestamped = TimestampedValue { value: *value, timestamp: now };
+			Self::insert_raw_value(key, &cid, timestamped);
+
+			// Update `Values` storage if `combined` yielded result.
+			if let Some(combined) = Self::combined(key) {
+				let previous = <Values<T>>::mutate(key, |value| value.replace(combined));
+				let age = previous.map_or(0, |previous| combined.timestamp.saturating_sub(previous.timestamp));
+				staleness.push((key.clone(), age));
+				Self::record_history(key, TimestampedValue { value: combined.value, timestamp: now });
+				Self::queue_pushes(key, combined);
+
+				if let Ok(index) = hot_values.binary_search_by(|(hot_key, _)| hot_key.cmp(key)) {
+					if let Some((_, hot_value)) = hot_values.get_mut(index) {
+						*hot_value = Some(combined);
+						hot_updated = true;
+					}
+				}
+			}
+		}
+		if hot_updated {
+			HotValues::<T>::put(hot_values);
+		}
+
+		Self::deposit_event(Event::NewFeedData { sender: cid, values });
+		if !staleness.is_empty() {
+			Self::deposit_event(Event::ValuesCombined { staleness });
+		}
+	}
+
+	/// Weight of `index_key`, the index, the next index and the indexed key.
+	fn index_key_weight() -> Weight {
+		T::DbWeight::get().reads_writes(2, 3)
+	}
+
+	/// Give `key` the next index of `KeyIndices` if it has none yet.
+	pub(crate) fn index_key(key: &OracleKeyOf<T>) {
+		if KeyIndices::<T>::contains_key(key) {
+			return;
+		}
+		let index = NextKeyIndex::<T>::mutate(|next| {
+			let index = *next;
+			*next = next.saturating_add(1);
+			index
+		});
+		KeyIndices::<T>::insert(key, index);
+		IndexedKeys::<T>::insert(index, key);
+	}
+
+	/// Store the raw value of a feeder and update the sorted window of `key` in place.
+	///
+	/// The previous value of the feeder is found and replaced by binary search. A full window
+	/// makes room by dropping its stalest value.
+	pub(crate) fn insert_raw_value(
+		key: &OracleKeyOf<T>,
+		cid: &CreatorId<T::AccountId>,
+		timestamped: TimestampedValueT,
+	) {
+		let previous = RawValues::<T>::get(key, cid);
+		RawValues::<T>::insert(key, cid, timestamped);
+		SortedRawValues::<T>::mutate(key, |window| {
+			// The new value takes the slot of the previous one, or of the stalest one once the
+			// window is full, shifting only the values in between.
+			let timestamped = match previous.map(|previous| window.replace(&previous, timestamped)) {
+				Some(Ok(_)) => return,
+				Some(Err(timestamped)) | None => timestamped,
+			};
+			if let Err(timestamped) = window.try_insert(timestamped) {
+				let stalest = window.iter().min_by_key(|value| value.timestamp).copied();
+				if let Some(stalest) = stalest {
+					let _ = window.replace(&stalest, timestamped);
+				}
+			}
+		});
+	}
+
     pub fn do_submit_api(
         cid: CreatorId<T::AccountId>,
         key: OracleKeyOf<T>,
@@ -835,17 +1953,48 @@ where T::AccountId: AsRef<[u8]>
         vpath: Vec<u8>,
     ) -> DispatchResult {
         let block_number = <system::Pallet<T>>::block_number();
+        // Resubmitting a feed keeps its schedule.
+        let previous = match Self::api_feeds(&cid, &key) {
+            Some(previous) => previous,
+            None => {
+                ApiFeedCount::<T>::mutate(&key, |count| *count += 1);
+                Default::default()
+            },
+        };
         let feed = ApiFeed {
                 requested_block_number: block_number,
                 url: Some(url),
                 vpath: Some(vpath),
+                update_interval: previous.update_interval,
+                heartbeat: previous.heartbeat,
+                deviation: previous.deviation,
             };
         ApiFeeds::<T>::insert(&cid, &key, feed.clone());
+        Self::index_key(&key);
 
         Self::deposit_event(Event::NewApiFeed { sender: cid, key, feed });
         Ok(())
     }
 
+    pub fn do_set_api_schedule(
+        cid: CreatorId<T::AccountId>,
+        key: OracleKeyOf<T>,
+        update_interval: T::BlockNumber,
+        heartbeat: T::BlockNumber,
+        deviation: Permill,
+    ) -> DispatchResult {
+        let feed = ApiFeeds::<T>::try_mutate(&cid, &key, |maybe_feed| {
+            let feed = maybe_feed.as_mut().ok_or(DispatchError::CannotLookup)?;
+            feed.update_interval = update_interval;
+            feed.heartbeat = heartbeat;
+            feed.deviation = deviation;
+            Ok::<_, DispatchError>(feed.clone())
+        })?;
+
+        Self::deposit_event(Event::ApiFeedScheduled { sender: cid, key, feed });
+        Ok(())
+    }
+
     pub fn do_remove_api(
         cid: CreatorId<T::AccountId>,
         key: OracleKeyOf<T>,
@@ -854,6 +2003,14 @@ where T::AccountId: AsRef<[u8]>
         if feed_exists {
             let feed = Self::api_feeds(&cid, &key).unwrap();
             <ApiFeeds<T>>::remove(&cid, &key);
+            // The other feeds of the key keep its combined value and history.
+            let last = ApiFeedCount::<T>::mutate_exists(&key, |count| {
+                *count = count.map(|count| count.saturating_sub(1)).filter(|count| *count > 0);
+                count.is_none()
+            });
+            if last {
+                Self::clear_history(&key);
+            }
             Self::deposit_event(Event::ApiFeedRemoved { sender: cid, key, feed });
             Ok(())
         } else {
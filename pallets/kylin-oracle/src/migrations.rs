@@ -0,0 +1,172 @@
+//! Storage migrations for the kylin-oracle pallet.
+
+use super::*;
+use frame_support::traits::{GetStorageVersion, StorageVersion};
+
+/// Migrate the pallet storage to the current storage version.
+pub fn migrate<T: Config>() -> Weight
+where
+	T::AccountId: AsRef<[u8]> + ToHex + Decode,
+{
+	let on_chain = Pallet::<T>::on_chain_storage_version();
+	let mut weight = T::DbWeight::get().reads(1);
+
+	if on_chain < 1 {
+		weight = weight.saturating_add(v1::migrate::<T>());
+	}
+	if on_chain < 2 {
+		weight = weight.saturating_add(v2::migrate::<T>());
+	}
+	if on_chain < 3 {
+		weight = weight.saturating_add(v3::migrate::<T>());
+	}
+	if on_chain < 4 {
+		weight = weight.saturating_add(v4::migrate::<T>());
+	}
+	if on_chain < 5 {
+		weight = weight.saturating_add(v5::migrate::<T>());
+	}
+
+	if on_chain < Pallet::<T>::current_storage_version() {
+		Pallet::<T>::current_storage_version().put::<Pallet<T>>();
+		weight = weight.saturating_add(T::DbWeight::get().writes(1));
+	}
+	weight.saturating_add(resize_history::<T>())
+}
+
+/// Lay the rings of `History` out again if `MaxHistoryLen` changed since they were laid out,
+/// keeping the newest values of each key.
+pub fn resize_history<T: Config>() -> Weight
+where
+	T::AccountId: AsRef<[u8]> + ToHex + Decode,
+{
+	let cap = T::MaxHistoryLen::get();
+	if HistoryLen::<T>::get() == Some(cap) {
+		return T::DbWeight::get().reads(1)
+	}
+
+	let cursors: Vec<_> = HistoryCursors::<T>::iter().collect();
+	let (mut reads, mut writes) = (1u64 + cursors.len() as u64, 1u64);
+	for (key, cursor) in cursors.into_iter().filter(|(_, cursor)| cursor.cap != cap) {
+		reads += cursor.len as u64;
+		writes += cursor.len as u64 + cursor.len.min(cap) as u64 + 1;
+		let resized = Pallet::<T>::resize_history(&key, cursor, cap);
+		if resized.len == 0 {
+			HistoryCursors::<T>::remove(&key);
+		} else {
+			HistoryCursors::<T>::insert(&key, resized);
+		}
+	}
+	HistoryLen::<T>::put(cap);
+	log::info!("kylin-oracle: laid the history out for {} values", cap);
+	T::DbWeight::get().reads_writes(reads, writes)
+}
+
+/// `RawValues` used to be keyed by feeder first.
+pub mod v1 {
+	use super::*;
+
+	/// Raw values are refreshed by the feeders every round, so the old entries are dropped
+	/// instead of translated.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		let res = RawValues::<T>::clear(u32::MAX, None);
+		log::info!("kylin-oracle: migrated to v1, removed {} raw values", res.unique);
+		T::DbWeight::get().writes(res.unique as u64)
+	}
+}
+
+/// `ApiFeed` gained the `update_interval`, `heartbeat` and `deviation` schedule fields.
+pub mod v2 {
+	use super::*;
+
+	#[derive(Decode)]
+	struct OldApiFeed<BlockNumber> {
+		requested_block_number: BlockNumber,
+		url: Option<Vec<u8>>,
+		vpath: Option<Vec<u8>>,
+	}
+
+	/// Existing feeds keep being fetched and submitted on every block.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		let mut translated = 0u64;
+		ApiFeeds::<T>::translate::<OldApiFeed<T::BlockNumber>, _>(|_, _, old| {
+			translated += 1;
+			Some(ApiFeed {
+				requested_block_number: old.requested_block_number,
+				url: old.url,
+				vpath: old.vpath,
+				update_interval: Zero::zero(),
+				heartbeat: Zero::zero(),
+				deviation: Permill::zero(),
+			})
+		});
+		log::info!("kylin-oracle: migrated to v2, translated {} api feeds", translated);
+		T::DbWeight::get().reads_writes(translated, translated)
+	}
+}
+
+/// `SortedRawValues` was added alongside `RawValues`.
+pub mod v3 {
+	use super::*;
+
+	/// Build the sorted window of every key from the current raw values.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		let mut inserted = 0u64;
+		for (key, _, value) in RawValues::<T>::iter() {
+			inserted += 1;
+			SortedRawValues::<T>::mutate(&key, |window| {
+				if let Err(value) = window.try_insert(value) {
+					log::warn!("kylin-oracle: sorted window of {:?} is full, dropped {:?}", key, value);
+				}
+			});
+		}
+		log::info!("kylin-oracle: migrated to v3, sorted {} raw values", inserted);
+		T::DbWeight::get().reads_writes(inserted.saturating_mul(2), inserted)
+	}
+}
+
+/// `HasDispatched` was replaced by the per-feeder `LastFedAt` marker.
+pub mod v4 {
+	use super::*;
+	use frame_support::{storage::{storage_prefix, unhashed}, traits::PalletInfoAccess};
+
+	/// `HasDispatched` was killed every block, so at most a leftover value is removed.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		unhashed::kill(&storage_prefix(Pallet::<T>::name().as_bytes(), b"HasDispatched"));
+		log::info!("kylin-oracle: migrated to v4, removed HasDispatched");
+		T::DbWeight::get().writes(1)
+	}
+}
+
+/// `KeyIndices` was added for the compact feeds.
+pub mod v5 {
+	use super::*;
+
+	/// Index the keys of the existing api feeds.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		let mut feeds = 0u64;
+		let before = NextKeyIndex::<T>::get();
+		for (_, key, _) in ApiFeeds::<T>::iter() {
+			feeds += 1;
+			Pallet::<T>::index_key(&key);
+		}
+		let indexed = NextKeyIndex::<T>::get().saturating_sub(before) as u64;
+		log::info!("kylin-oracle: migrated to v5, indexed {} keys", indexed);
+		T::DbWeight::get().reads_writes(feeds.saturating_mul(2), indexed.saturating_mul(3))
+	}
+}
@@ -0,0 +1,142 @@
+use crate::{Config, OracleKeyOf, TimestampedValue, TimestampedValueT};
+use frame_support::traits::{Get, UnixTime};
+use orml_traits::CombineData;
+use sp_runtime::{PerThing, Percent};
+use sp_std::{marker, prelude::*};
+use hex::ToHex;
+
+// These combiners rely on the pallet handing over the raw values of a key sorted by value, as
+// read from `SortedRawValues`, so none of them has to sort.
+
+/// Drop the expired values, or return `None` if less than `MinimumCount` are left.
+fn fresh_values<T, MinimumCount, ExpiresIn>(mut values: Vec<TimestampedValueT>) -> Option<Vec<TimestampedValueT>>
+where
+	T: Config,
+	T::AccountId: AsRef<[u8]> + ToHex,
+	MinimumCount: Get<u32>,
+	ExpiresIn: Get<u128>,
+{
+	let expires_in = ExpiresIn::get();
+	let now = T::UnixTime::now().as_millis();
+
+	// `retain` keeps the order, so the values are still sorted.
+	values.retain(|x| x.timestamp + expires_in > now);
+
+	let count = values.len() as u32;
+	if count < MinimumCount::get() || count == 0 {
+		return None;
+	}
+	Some(values)
+}
+
+/// Returns median timestamped value of the sorted raw values.
+/// Returns prev_value if not enough valid values.
+pub struct MedianCombineData<T, MinimumCount, ExpiresIn>(marker::PhantomData<(T, MinimumCount, ExpiresIn)>);
+
+impl<T, MinimumCount, ExpiresIn> CombineData<OracleKeyOf<T>, TimestampedValueT>
+	for MedianCombineData<T, MinimumCount, ExpiresIn>
+where
+	T: Config,
+	T::AccountId: AsRef<[u8]> + ToHex,
+	MinimumCount: Get<u32>,
+	ExpiresIn: Get<u128>,
+{
+	fn combine_data(
+		_key: &OracleKeyOf<T>,
+		values: Vec<TimestampedValueT>,
+		prev_value: Option<TimestampedValueT>,
+	) -> Option<TimestampedValueT> {
+		let values = match fresh_values::<T, MinimumCount, ExpiresIn>(values) {
+			Some(values) => values,
+			None => return prev_value,
+		};
+		values.get(values.len() / 2).cloned().or(prev_value)
+	}
+}
+
+/// Returns the mean of the sorted raw values once the `Trim` lowest and `Trim` highest of them
+/// are dropped, timestamped with the newest value kept.
+/// Returns prev_value if not enough valid values.
+pub struct TrimmedMeanCombineData<T, MinimumCount, ExpiresIn, Trim>(
+	marker::PhantomData<(T, MinimumCount, ExpiresIn, Trim)>,
+);
+
+impl<T, MinimumCount, ExpiresIn, Trim> CombineData<OracleKeyOf<T>, TimestampedValueT>
+	for TrimmedMeanCombineData<T, MinimumCount, ExpiresIn, Trim>
+where
+	T: Config,
+	T::AccountId: AsRef<[u8]> + ToHex,
+	MinimumCount: Get<u32>,
+	ExpiresIn: Get<u128>,
+	Trim: Get<Percent>,
+{
+	fn combine_data(
+		_key: &OracleKeyOf<T>,
+		values: Vec<TimestampedValueT>,
+		prev_value: Option<TimestampedValueT>,
+	) -> Option<TimestampedValueT> {
+		let values = match fresh_values::<T, MinimumCount, ExpiresIn>(values) {
+			Some(values) => values,
+			None => return prev_value,
+		};
+
+		// Always keep at least the median.
+		let count = values.len();
+		let trim = Trim::get().mul_floor(count as u32) as usize;
+		let kept = values
+			.get(trim..count - trim)
+			.filter(|kept| !kept.is_empty())
+			.or_else(|| values.get(count / 2..count / 2 + 1))?;
+
+		let sum = kept.iter().fold(0i128, |sum, x| sum + x.value as i128);
+		Some(TimestampedValue {
+			value: (sum / kept.len() as i128) as i64,
+			timestamp: kept.iter().map(|x| x.timestamp).max()?,
+		})
+	}
+}
+
+/// Returns an exponential moving average of the median: the previous combined value is moved
+/// towards the median of the sorted raw values by the fraction of `Period` milliseconds elapsed
+/// since it was combined, the median being taken as is once a whole `Period` has elapsed.
+///
+/// This smooths the median the way a time weighted average would, without keeping the past
+/// medians, but it is not a TWAP: each step only weighs the previous average and the current
+/// median. A TWAP over a time range is read from the history of the combined values instead.
+/// Returns prev_value if not enough valid values.
+pub struct EmaCombineData<T, MinimumCount, ExpiresIn, Period>(
+	marker::PhantomData<(T, MinimumCount, ExpiresIn, Period)>,
+);
+
+impl<T, MinimumCount, ExpiresIn, Period> CombineData<OracleKeyOf<T>, TimestampedValueT>
+	for EmaCombineData<T, MinimumCount, ExpiresIn, Period>
+where
+	T: Config,
+	T::AccountId: AsRef<[u8]> + ToHex,
+	MinimumCount: Get<u32>,
+	ExpiresIn: Get<u128>,
+	Period: Get<u128>,
+{
+	fn combine_data(
+		key: &OracleKeyOf<T>,
+		values: Vec<TimestampedValueT>,
+		prev_value: Option<TimestampedValueT>,
+	) -> Option<TimestampedValueT> {
+		let median =
+			MedianCombineData::<T, MinimumCount, ExpiresIn>::combine_data(key, values, None);
+		let (median, prev) = match (median, prev_value) {
+			(Some(median), Some(prev)) => (median, prev),
+			(median, prev_value) => return median.or(prev_value),
+		};
+
+		let period = Period::get();
+		let now = T::UnixTime::now().as_millis();
+		let elapsed = now.saturating_sub(prev.timestamp).min(period);
+		if period == 0 || elapsed == period {
+			return Some(TimestampedValue { value: median.value, timestamp: now });
+		}
+
+		let delta = (median.value as i128 - prev.value as i128) * elapsed as i128 / period as i128;
+		Some(TimestampedValue { value: (prev.value as i128 + delta) as i64, timestamp: now })
+	}
+}
@@ -1,635 +1,833 @@
-
-use crate as kylin_oracle;
-use crate::*;
-use codec::Decode;
+use crate::{mock::*, *};
 use frame_support::{
-    parameter_types,
-    traits::Everything,
-    weights::{IdentityFee, Weight, ConstantMultiplier},
-};
-
-use sp_core::{
-    offchain::{testing, OffchainWorkerExt, TransactionPoolExt},
-    sr25519::Signature,
-    H256,
+	assert_noop, assert_ok,
+	traits::{ConstU128, ConstU32, Hooks},
 };
+use kylin_support::offchain_simulation::{Endpoint, RunReport, Simulation};
+use sp_io::TestExternalities;
 use sp_keystore::{testing::KeyStore, KeystoreExt, SyncCryptoStore};
-use sp_std::str;
-use sp_std::vec::Vec;
 use std::sync::Arc;
 
-use sp_runtime::{
-    testing::{Header, TestXt},
-    traits::{BlakeTwo256, Extrinsic as ExtrinsicT, IdentifyAccount, IdentityLookup, Verify},
-};
-use xcm_builder::{
-    AllowUnpaidExecutionFrom, EnsureXcmOrigin, FixedWeightBounds, SignedToAccountId32,
-    LocationInverter
-};
+fn feed(who: u8, values: &[(&str, i64)]) {
+	let values = values.iter().map(|(name, value)| (key(name), *value)).collect();
+	assert_ok!(KylinOracle::feed_data(RuntimeOrigin::signed(account(who)), values));
+}
 
-use xcm_executor::{
-    traits::{TransactAsset, WeightTrader},
-    Assets, XcmExecutor,
-};
+fn at(value: i64, millis: u64) -> TimestampedValueT {
+	TimestampedValue { value, timestamp: millis as u128 }
+}
+
+/// Test externalities whose offchain worker fetches from `endpoints`, along with a single local
+/// key which is an oracle member.
+fn worker_ext(endpoints: Vec<Endpoint>) -> (TestExternalities, Simulation, AccountId) {
+	let mut ext = new_test_ext();
+	let simulation = Simulation::new(endpoints, INIT_TIMESTAMP, 7);
+	simulation.register(&mut ext);
+	let keystore = KeyStore::new();
+	let feeder =
+		SyncCryptoStore::sr25519_generate_new(&keystore, KEY_TYPE, Some("//Alice")).unwrap();
+	ext.register_extension(KeystoreExt(Arc::new(keystore)));
+	ext.execute_with(|| set_members(vec![feeder, account(1)]));
+	(ext, simulation, feeder)
+}
+
+fn submit_feed(feeder: AccountId, name: &str, url: &str, vpath: &str) {
+	assert_ok!(KylinOracle::submit_api(
+		RuntimeOrigin::signed(feeder),
+		key(name),
+		url.as_bytes().to_vec(),
+		vpath.as_bytes().to_vec(),
+	));
+}
+
+/// Run the offchain worker of block `block_number`.
+fn run_worker(
+	ext: &mut TestExternalities,
+	simulation: &Simulation,
+	block_number: u64,
+) -> RunReport {
+	simulation.run(ext, || KylinOracle::fetch_api_and_feed_data(block_number).unwrap())
+}
+
+/// The values fed by each transaction of `report`, the deltas of the compact feeds being
+/// decoded against the current raw values of `feeder`.
+fn fed_values(
+	ext: &mut TestExternalities,
+	report: &RunReport,
+	feeder: AccountId,
+) -> Vec<Vec<(OracleKeyOf<Test>, i64)>> {
+	ext.execute_with(|| {
+		report
+			.transactions
+			.iter()
+			.map(|tx| match Extrinsic::decode(&mut &tx[..]).unwrap().call {
+				RuntimeCall::KylinOracle(Call::feed_data { values }) => values,
+				RuntimeCall::KylinOracle(Call::feed_data_compact { values, .. }) => values
+					.into_iter()
+					.map(|(index, delta)| {
+						let key = IndexedKeys::<Test>::get(index.0).unwrap();
+						let cid = CreatorId::AccountId(feeder);
+						let base = RawValues::<Test>::get(&key, cid).map_or(0, |raw| raw.value);
+						(key, base.wrapping_add(zigzag_decode(delta.0)))
+					})
+					.collect(),
+				call => panic!("unexpected call {:?}", call),
+			})
+			.collect()
+	})
+}
+
+#[test]
+fn raw_values_are_keyed_by_oracle_key_first() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100), ("eth", 10)]);
+		feed(2, &[("btc", 102)]);
+
+		let btc: Vec<_> = RawValues::<Test>::iter_prefix(key("btc")).collect();
+		assert_eq!(btc.len(), 2);
+		assert!(btc.contains(&(CreatorId::AccountId(account(2)), at(102, INIT_TIMESTAMP))));
+		assert_eq!(KylinOracle::read_raw_values(&key("eth")), vec![at(10, INIT_TIMESTAMP)]);
+		assert!(KylinOracle::read_raw_values(&key("dot")).is_empty());
+		assert_eq!(KylinOracle::get(&key("btc")).map(|v| v.value), Some(102));
+	});
+}
+
+#[test]
+fn feeding_again_replaces_the_raw_value_of_the_feeder() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		next_block(6_000);
+		feed(1, &[("btc", 90)]);
+
+		assert_eq!(KylinOracle::read_raw_values(&key("btc")), vec![at(90, INIT_TIMESTAMP + 6_000)]);
+		assert_eq!(KylinOracle::sorted_raw_values(key("btc")).len(), 1);
+	});
+}
+
+#[test]
+fn only_members_feed() {
+	new_test_ext().execute_with(|| {
+		assert_noop!(
+			KylinOracle::feed_data(RuntimeOrigin::signed(account(9)), vec![(key("btc"), 1)]),
+			Error::<Test>::NoPermission
+		);
+	});
+}
+
+#[test]
+fn upgrade_from_feeder_first_raw_values_drops_them() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		StorageVersion::new(0).put::<KylinOracle>();
+
+		KylinOracle::on_runtime_upgrade();
+
+		assert_eq!(RawValues::<Test>::iter().count(), 0);
+		assert_eq!(KylinOracle::on_chain_storage_version(), KylinOracle::current_storage_version());
+	});
+}
+
+#[test]
+fn feeds_are_fetched_every_update_interval() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![Endpoint::json("https://a.test", 1.5, 64)]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "btc", "https://a.test", "/value");
+		assert_ok!(KylinOracle::set_api_schedule(
+			RuntimeOrigin::signed(feeder),
+			key("btc"),
+			3,
+			0,
+			Permill::zero(),
+		));
+	});
+
+	let fetched_at: Vec<u64> = (1..=10)
+		.filter(|block_number| run_worker(&mut ext, &simulation, *block_number).requests > 0)
+		.collect();
+	assert!(fetched_at.len() >= 3, "fetched at {:?}", fetched_at);
+	assert!(fetched_at.windows(2).all(|w| w[1] - w[0] == 3), "fetched at {:?}", fetched_at);
+}
+
+#[test]
+fn barely_moved_values_wait_for_the_heartbeat() {
+	let url = "https://a.test";
+	let (mut ext, simulation, feeder) = worker_ext(vec![Endpoint::json(url, 100.0, 64)]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "btc", url, "/value");
+		assert_ok!(KylinOracle::set_api_schedule(
+			RuntimeOrigin::signed(feeder),
+			key("btc"),
+			1,
+			5,
+			Permill::from_percent(1),
+		));
+	});
+	let set_value = |value: f64| {
+		simulation.update_endpoints(|endpoints| endpoints[0] = Endpoint::json(url, value, 64));
+	};
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("btc"), 100_000_000)]]);
+
+	set_value(100.5);
+	for block_number in 2..6 {
+		assert!(run_worker(&mut ext, &simulation, block_number).transactions.is_empty());
+	}
+	let report = run_worker(&mut ext, &simulation, 6);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("btc"), 100_500_000)]]);
+
+	set_value(102.0);
+	let report = run_worker(&mut ext, &simulation, 7);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("btc"), 102_000_000)]]);
+}
+
+#[test]
+fn failed_submission_leaves_the_value_due() {
+	let url = "https://a.test";
+	let (mut ext, simulation, feeder) = worker_ext(vec![Endpoint::json(url, 100.0, 64)]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "btc", url, "/value");
+		assert_ok!(KylinOracle::set_api_schedule(
+			RuntimeOrigin::signed(feeder),
+			key("btc"),
+			1,
+			100,
+			Permill::from_percent(1),
+		));
+		// The single feeder is elected among the members, the local key no longer is one.
+		set_single_feeder(true);
+		set_members(vec![account(1)]);
+	});
+
+	assert!(run_worker(&mut ext, &simulation, 1).transactions.is_empty());
+
+	ext.execute_with(|| set_members(vec![feeder]));
+	let report = run_worker(&mut ext, &simulation, 2);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("btc"), 100_000_000)]]);
+	assert!(run_worker(&mut ext, &simulation, 3).transactions.is_empty());
+}
+
+/// `values` sorted by key, the order of the feeds in a run being unspecified.
+fn sorted(mut values: Vec<(OracleKeyOf<Test>, i64)>) -> Vec<(OracleKeyOf<Test>, i64)> {
+	values.sort();
+	values
+}
+
+#[test]
+fn feeds_are_fetched_concurrently() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![
+		Endpoint::json("https://a.test", 1.0, 64).with_latency(300),
+		Endpoint::json("https://b.test", 2.0, 64).with_latency(500),
+		Endpoint::json("https://c.test", 3.0, 64).with_latency(400),
+	]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "a", "https://a.test", "/value");
+		submit_feed(feeder, "b", "https://b.test", "/value");
+		submit_feed(feeder, "c", "https://c.test", "/value");
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(report.requests, 3);
+	// The run waits for the slowest endpoint only, not for the sum of the latencies.
+	assert!(
+		(500..500 + HTTP_POLL_INTERVAL_MS).contains(&report.wall_time),
+		"wall time {}",
+		report.wall_time
+	);
+	let fed = fed_values(&mut ext, &report, feeder);
+	assert_eq!(fed.len(), 1);
+	assert_eq!(
+		sorted(fed[0].clone()),
+		vec![(key("a"), 1_000_000), (key("b"), 2_000_000), (key("c"), 3_000_000)]
+	);
+}
+
+#[test]
+fn failing_endpoints_do_not_block_the_others() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![
+		Endpoint::json("https://a.test", 1.0, 64),
+		Endpoint::json("https://down.test", 2.0, 64).with_failure_rate(1.0),
+		Endpoint::json("https://slow.test", 3.0, 64).with_latency(20_000),
+	]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "a", "https://a.test", "/value");
+		submit_feed(feeder, "down", "https://down.test", "/value");
+		submit_feed(feeder, "slow", "https://slow.test", "/value");
+		submit_feed(feeder, "missing", "https://a.test", "/missing");
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(report.wall_time, 10_000);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("a"), 1_000_000)]]);
+	ext.execute_with(|| {
+		assert_eq!(KylinOracle::endpoint_health(b"https://a.test").consecutive_failures, 0);
+		assert_eq!(KylinOracle::endpoint_health(b"https://down.test").consecutive_failures, 1);
+		let slow = KylinOracle::endpoint_health(b"https://slow.test");
+		assert_eq!((slow.consecutive_failures, slow.last_latency), (1, 10_000));
+	});
+}
+
+#[test]
+fn failing_endpoints_are_backed_off() {
+	let url = "https://down.test";
+	let (mut ext, simulation, feeder) =
+		worker_ext(vec![Endpoint::json(url, 1.0, 64).with_failure_rate(1.0)]);
+	ext.execute_with(|| submit_feed(feeder, "down", url, "/value"));
+
+	// Skipped for a number of blocks doubling with each failure past the threshold.
+	let requests: Vec<u32> = (1..=10)
+		.map(|block_number| run_worker(&mut ext, &simulation, block_number).requests)
+		.collect();
+	assert_eq!(requests, vec![1, 1, 1, 1, 0, 1, 0, 0, 0, 1]);
+	ext.execute_with(|| {
+		let health = KylinOracle::endpoint_health(url.as_bytes());
+		assert_eq!((health.consecutive_failures, health.backoff_until), (6, 18));
+	});
+
+	simulation.update_endpoints(|endpoints| endpoints[0].failure_rate = 0.0);
+	let report = run_worker(&mut ext, &simulation, 18);
+	assert_eq!(fed_values(&mut ext, &report, feeder), vec![vec![(key("down"), 1_000_000)]]);
+	ext.execute_with(|| {
+		assert_eq!(KylinOracle::endpoint_health(url.as_bytes()).consecutive_failures, 0);
+	});
+}
+
+#[test]
+fn feeds_sharing_an_endpoint_fetch_it_once() {
+	let body = br#"{"btc":{"usd":30000.5},"eth":{"usd":2000.25}}"#.to_vec();
+	let endpoint =
+		Endpoint { url: "https://prices.test".into(), latency: 0, failure_rate: 0.0, body };
+	let len = endpoint.body.len() as u64;
+	let (mut ext, simulation, feeder) = worker_ext(vec![endpoint]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "btc", "https://prices.test", "/btc/usd");
+		submit_feed(feeder, "eth", "https://prices.test", "/eth/usd");
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!((report.requests, report.bytes_read), (1, len));
+	let fed = fed_values(&mut ext, &report, feeder);
+	assert_eq!(fed.len(), 1);
+	assert_eq!(
+		sorted(fed[0].clone()),
+		vec![(key("btc"), 30_000_500_000), (key("eth"), 2_000_250_000)]
+	);
+}
+
+#[test]
+fn a_loaded_worker_feeds_every_healthy_endpoint_within_the_deadline() {
+	// Endpoints of up to 900ms of latency, one in six failing half of the requests.
+	let endpoints: Vec<Endpoint> = (0..48)
+		.map(|i| {
+			Endpoint::json(format!("https://{}.test", i), i as f64, 512)
+				.with_latency(100 * (i % 10))
+				.with_failure_rate(if i % 6 == 0 { 0.5 } else { 0.0 })
+		})
+		.collect();
+	let (mut ext, simulation, feeder) = worker_ext(endpoints.clone());
+	ext.execute_with(|| {
+		for (i, endpoint) in endpoints.iter().enumerate() {
+			submit_feed(feeder, &format!("feed{}", i), &endpoint.url, "/value");
+		}
+	});
+
+	let reports = simulation.run_blocks(&mut ext, 1..=20, 6_000, |block_number| {
+		KylinOracle::fetch_api_and_feed_data(block_number).unwrap()
+	});
+	for report in &reports {
+		// Bounded by the slowest endpoint, whatever the number of endpoints.
+		assert!(
+			(900..900 + HTTP_POLL_INTERVAL_MS).contains(&report.wall_time),
+			"wall time {}",
+			report.wall_time
+		);
+		let fed = fed_values(&mut ext, report, feeder);
+		assert_eq!(fed.len(), 1);
+		for i in (0..48).filter(|i| i % 6 != 0) {
+			let value = (key(&format!("feed{}", i)), i as i64 * 1_000_000);
+			assert!(fed[0].contains(&value), "feed{} is not fed", i);
+		}
+	}
+	// The flaky endpoints are backed off rather than fetched by every run.
+	let requests: u32 = reports.iter().map(|report| report.requests).sum();
+	assert!(requests < 48 * 20, "{} requests", requests);
+}
+
+#[test]
+fn ema_moves_towards_the_median_by_the_elapsed_fraction_of_the_period() {
+	type Ema = EmaCombineData<Test, ConstU32<1>, ConstU128<600_000>, ConstU128<60_000>>;
+	new_test_ext().execute_with(|| {
+		let now = INIT_TIMESTAMP;
+		let values = vec![at(90, now), at(100, now), at(130, now)];
+
+		assert_eq!(Ema::combine_data(&key("btc"), values.clone(), None), Some(at(100, now)));
+		// A quarter of the period elapsed since the previous value of 200.
+		assert_eq!(
+			Ema::combine_data(&key("btc"), values.clone(), Some(at(200, now - 15_000))),
+			Some(at(175, now))
+		);
+		// A whole period elapsed, the median is taken as is.
+		assert_eq!(
+			Ema::combine_data(&key("btc"), values, Some(at(200, now - 60_000))),
+			Some(at(100, now))
+		);
+		// Not enough fresh values, the previous value is kept.
+		assert_eq!(
+			Ema::combine_data(&key("btc"), vec![at(1, 0)], Some(at(200, now - 15_000))),
+			Some(at(200, now - 15_000))
+		);
+	});
+}
+
+#[test]
+fn batched_query_sends_the_values_found_in_one_message() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100), ("eth", 10)]);
+		let keys = vec![key("btc"), key("dot"), key("eth")];
+
+		assert_ok!(KylinOracle::xcm_query_data_batch(sibling(2000), keys.try_into().unwrap()));
+
+		let values = vec![
+			(b"btc".to_vec(), KylinOracle::get(&key("btc")).unwrap()),
+			(b"eth".to_vec(), KylinOracle::get(&key("eth")).unwrap()),
+		];
+		assert_eq!(
+			sent_feeds(),
+			vec![(2000.into(), KylinMockFunc::xcm_feed_back_batch { values })]
+		);
+	});
+}
+
+#[test]
+fn batched_query_of_unknown_keys_fails() {
+	new_test_ext().execute_with(|| {
+		assert_noop!(
+			KylinOracle::xcm_query_data_batch(sibling(2000), vec![key("dot")].try_into().unwrap()),
+			DispatchError::CannotLookup
+		);
+		assert!(sent_feeds().is_empty());
+	});
+}
+
+#[test]
+fn batched_values_are_sent_max_query_keys_at_a_time() {
+	new_test_ext().execute_with(|| {
+		let values: Vec<_> = (0..6u8).map(|i| (vec![i], at(i as i64, INIT_TIMESTAMP))).collect();
+
+		assert_ok!(KylinOracle::send_qret_batch_to_parachain(2000.into(), values.clone()));
+
+		assert_eq!(
+			sent_feeds(),
+			vec![
+				(2000.into(), KylinMockFunc::xcm_feed_back_batch { values: values[..4].to_vec() }),
+				(2000.into(), KylinMockFunc::xcm_feed_back_batch { values: values[4..].to_vec() }),
+			]
+		);
+	});
+}
+
+fn subscribe(para_id: u32, names: &[&str]) -> DispatchResult {
+	let keys: Vec<_> = names.iter().map(|name| key(name)).collect();
+	KylinOracle::xcm_subscribe(sibling(para_id), keys.try_into().unwrap(), 10, Permill::zero())
+}
+
+fn push_all() {
+	KylinOracle::on_idle(System::block_number(), Weight::MAX);
+}
+
+#[test]
+fn subscribing_to_an_unknown_key_fails() {
+	new_test_ext().execute_with(|| {
+		assert_noop!(subscribe(2000, &["btc"]), Error::<Test>::UnknownKey);
+	});
+}
+
+#[test]
+fn subscriptions_of_a_parachain_are_bounded() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("a", 1), ("b", 2), ("c", 3), ("d", 4)]);
+
+		assert_ok!(subscribe(2000, &["a", "b", "c"]));
+		// Subscribing again to a key is no new subscription.
+		assert_ok!(subscribe(2000, &["a"]));
+		assert_noop!(subscribe(2000, &["d"]), Error::<Test>::TooManySubscriptions);
+		assert_ok!(subscribe(2001, &["d"]));
+
+		assert_ok!(KylinOracle::xcm_unsubscribe(sibling(2000), vec![key("a")].try_into().unwrap()));
+		assert_ok!(subscribe(2000, &["d"]));
+		assert_eq!(SubscriptionCount::<Test>::get(ParaId::from(2000)), 3);
+	});
+}
+
+#[test]
+fn subscribers_of_a_key_are_bounded() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+
+		assert_ok!(subscribe(2000, &["btc"]));
+		assert_ok!(subscribe(2001, &["btc"]));
+		// Subscribing again to a key is no new subscriber.
+		assert_ok!(subscribe(2001, &["btc"]));
+		assert_noop!(subscribe(2002, &["btc"]), Error::<Test>::TooManySubscribers);
+
+		assert_ok!(KylinOracle::xcm_unsubscribe(
+			sibling(2000),
+			vec![key("btc")].try_into().unwrap()
+		));
+		assert_ok!(subscribe(2002, &["btc"]));
+		assert_eq!(SubscriberCount::<Test>::get(key("btc")), 2);
+	});
+}
+
+#[test]
+fn values_are_recorded_as_pushed_once_sent() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		assert_ok!(subscribe(2000, &["btc"]));
+		let pushed =
+			|| Subscriptions::<Test>::get(key("btc"), ParaId::from(2000)).unwrap().last_pushed;
+
+		next_block(6_000);
+		feed(1, &[("btc", 110)]);
+		set_xcm_send_fails(true);
+		push_all();
+		assert_eq!(pushed(), None);
+
+		next_block(6_000);
+		feed(1, &[("btc", 120)]);
+		set_xcm_send_fails(false);
+		push_all();
+		assert_eq!(pushed(), Some((120, 3)));
+		assert_eq!(
+			sent_feeds(),
+			vec![(
+				2000.into(),
+				KylinMockFunc::xcm_feed_back_batch {
+					values: vec![(b"btc".to_vec(), KylinOracle::get(&key("btc")).unwrap())]
+				}
+			)]
+		);
+	});
+}
+
+#[test]
+fn subscribers_are_pushed_as_far_as_the_weight_allows() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		assert_ok!(subscribe(2000, &["btc"]));
+		assert_ok!(subscribe(2001, &["btc"]));
+		next_block(6_000);
+		feed(1, &[("btc", 110)]);
+
+		let one_push = <Test as frame_system::Config>::DbWeight::get()
+			.reads(1)
+			.saturating_add(KylinOracle::push_weight(3));
+		KylinOracle::on_idle(System::block_number(), one_push);
+		assert_eq!(sent_feeds().len(), 1);
+		assert_eq!(PendingPushes::<Test>::iter_keys().count(), 1);
+
+		push_all();
+		assert_eq!(sent_feeds().len(), 2);
+		assert_eq!(PendingPushes::<Test>::iter_keys().count(), 0);
+	});
+}
+
+#[test]
+fn a_feeder_feeds_once_per_block() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		// Another feeder is not held back.
+		feed(2, &[("btc", 101)]);
+		assert_noop!(
+			KylinOracle::feed_data(RuntimeOrigin::signed(account(1)), vec![(key("eth"), 10)]),
+			Error::<Test>::AlreadyFeeded
+		);
+		assert_eq!(LastFedAt::<Test>::get(CreatorId::AccountId(account(1))), Some(1));
+
+		// The marker of the previous block needs no clean up.
+		next_block(6_000);
+		feed(1, &[("eth", 10)]);
+		assert_eq!(LastFedAt::<Test>::get(CreatorId::AccountId(account(1))), Some(2));
+	});
+}
+
+#[test]
+fn every_message_a_reporter_chain_forwards_in_a_block_is_applied() {
+	new_test_ext().execute_with(|| {
+		let forward = |values: &[(&str, i64)]| {
+			let values = values.iter().map(|(name, value)| (key(name), *value)).collect();
+			assert_ok!(KylinOracle::xcm_feed_data(sibling(2001), values));
+		};
+		forward(&[("btc", 100), ("eth", 10)]);
+		forward(&[("dot", 5)]);
+
+		let cid = CreatorId::ParaId(2001.into());
+		for (name, value) in [("btc", 100), ("eth", 10), ("dot", 5)] {
+			assert_eq!(RawValues::<Test>::get(key(name), &cid).unwrap().value, value);
+		}
+	});
+}
+
+#[test]
+fn zigzag_keeps_small_deltas_of_either_sign_small() {
+	assert_eq!(
+		[0, -1, 1, -2, 2].iter().map(|delta| zigzag_encode(*delta)).collect::<Vec<_>>(),
+		vec![0, 1, 2, 3, 4]
+	);
+	for delta in [0, 1, -1, 1_000_000, -1_000_000, i64::MAX, i64::MIN] {
+		assert_eq!(zigzag_decode(zigzag_encode(delta)), delta);
+	}
+}
+
+fn feed_compact(who: u8, last_fed_at: Option<u64>, values: &[(&str, i64)]) -> DispatchResult {
+	let values: Vec<_> = values
+		.iter()
+		.map(|(name, delta)| {
+			(Compact(KeyIndices::<Test>::get(key(name)).unwrap()), Compact(zigzag_encode(*delta)))
+		})
+		.collect();
+	KylinOracle::feed_data_compact(
+		RuntimeOrigin::signed(account(who)),
+		last_fed_at,
+		values.try_into().unwrap(),
+	)
+	.map(|_| ())
+	.map_err(|e| e.error)
+}
+
+#[test]
+fn compact_feeds_are_deltas_from_the_last_raw_values() {
+	new_test_ext().execute_with(|| {
+		submit_feed(account(1), "btc", "https://prices.test", "/btc/usd");
+		submit_feed(account(1), "eth", "https://prices.test", "/eth/usd");
+		// Without a raw value, the delta is from zero.
+		assert_ok!(feed_compact(1, None, &[("btc", 100)]));
+
+		next_block(6_000);
+		assert_ok!(feed_compact(1, Some(1), &[("btc", -5), ("eth", 7)]));
+		let cid = CreatorId::AccountId(account(1));
+		assert_eq!(RawValues::<Test>::get(key("btc"), &cid).unwrap().value, 95);
+		assert_eq!(RawValues::<Test>::get(key("eth"), &cid).unwrap().value, 7);
+		assert_eq!(LastFedAt::<Test>::get(&cid), Some(2));
+	});
+}
+
+#[test]
+fn compact_feeds_based_on_a_stale_value_are_rejected() {
+	new_test_ext().execute_with(|| {
+		submit_feed(account(1), "btc", "https://prices.test", "/btc/usd");
+		assert_ok!(feed_compact(1, None, &[("btc", 100)]));
+
+		// The feeder fed again in block 2, the deltas based on block 1 would be wrong.
+		next_block(6_000);
+		feed(1, &[("btc", 120)]);
+		next_block(6_000);
+		assert_noop!(feed_compact(1, Some(1), &[("btc", 1)]), Error::<Test>::StaleDelta);
+		assert_ok!(feed_compact(1, Some(2), &[("btc", 1)]));
+		let cid = CreatorId::AccountId(account(1));
+		assert_eq!(RawValues::<Test>::get(key("btc"), &cid).unwrap().value, 121);
+
+		next_block(6_000);
+		let unknown = vec![(Compact(u32::MAX), Compact(0))].try_into().unwrap();
+		assert_noop!(
+			KylinOracle::feed_data_compact(RuntimeOrigin::signed(account(1)), Some(3), unknown),
+			Error::<Test>::UnknownKeyIndex
+		);
+	});
+}
 
-use sp_core::{ sr25519, Pair, Public};
-
-type UncheckedExtrinsic = frame_system::mocking::MockUncheckedExtrinsic<Test>;
-type Block = frame_system::mocking::MockBlock<Test>;
-type AccountPublic = <Signature as Verify>::Signer;
-
-frame_support::construct_runtime!(
-    pub enum Test where
-        Block = Block,
-        NodeBlock = Block,
-        UncheckedExtrinsic = UncheckedExtrinsic,
-    {
-        System: frame_system::{Pallet, Call, Config, Storage, Event<T>},
-        Balances: pallet_balances::{Pallet, Call, Storage, Config<T>, Event<T>},
-        KylinOracle: kylin_oracle::{Pallet, Call, Storage, Event<T>, ValidateUnsigned},
-        Timestamp: pallet_timestamp::{Pallet, Call, Storage, Inherent},
-        TransactionPayment: pallet_transaction_payment::{Pallet, Storage},
-        XcmPallet: pallet_xcm::{Pallet, Call, Storage, Event<T>, Origin} = 51,
-        CumulusXcm: cumulus_pallet_xcm::{Pallet, Call, Event<T>, Origin} = 52,
-
-    }
-);
-
-parameter_types! {
-    pub const TransactionByteFee: u64 = 1;
-    pub const OperationalFeeMultiplier: u8 = 5;
-}
-pub type Balance = u64;
-
-impl pallet_transaction_payment::Config for Test {
-    type OnChargeTransaction = pallet_transaction_payment::CurrencyAdapter<Balances, ()>;
-    type OperationalFeeMultiplier = OperationalFeeMultiplier;
-    type LengthToFee = ConstantMultiplier<Balance, TransactionByteFee>;
-    type WeightToFee = IdentityFee<u64>;
-    type FeeMultiplierUpdate = ();
-}
-
-parameter_types! {
-    pub const BlockHashCount: u64 = 250;
-    pub BlockWeights: frame_system::limits::BlockWeights =
-        frame_system::limits::BlockWeights::simple_max(1024);
-    pub Ancestry: MultiLocation = Here.into();
-}
-pub type LocalOriginToLocation = SignedToAccountId32<Origin, AccountId, RelayNetwork>;
-pub type Barrier = AllowUnpaidExecutionFrom<Everything>;
-
-impl frame_system::Config for Test {
-    type BaseCallFilter = frame_support::traits::Everything;
-    type BlockWeights = ();
-    type BlockLength = ();
-    type DbWeight = ();
-    type Origin = Origin;
-    type Call = Call;
-    type Index = u64;
-    type BlockNumber = u64;
-    type Hash = H256;
-    type Hashing = BlakeTwo256;
-    type AccountId = sp_core::sr25519::Public;
-    type Lookup = IdentityLookup<Self::AccountId>;
-    type Header = Header;
-    type Event = Event;
-    type BlockHashCount = BlockHashCount;
-    type Version = ();
-    type PalletInfo = PalletInfo;
-    type AccountData = pallet_balances::AccountData<u64>;
-    type OnNewAccount = ();
-    type OnKilledAccount = ();
-    type SystemWeightInfo = ();
-    type SS58Prefix = ();
-    type OnSetCode = ();
-    type MaxConsumers = frame_support::traits::ConstU32<16>;
-}
-
-type Extrinsic = TestXt<Call, ()>;
-type AccountId = <<Signature as Verify>::Signer as IdentifyAccount>::AccountId;
-
-impl frame_system::offchain::SigningTypes for Test {
-    type Public = <Signature as Verify>::Signer;
-    type Signature = Signature;
-}
-
-impl<LocalCall> frame_system::offchain::SendTransactionTypes<LocalCall> for Test
-where
-    Call: From<LocalCall>,
-{
-    type OverarchingCall = Call;
-    type Extrinsic = Extrinsic;
-}
-
-parameter_types! {
-    pub const GracePeriod: u64 = 5;
-    pub const UnsignedInterval: u64 = 128;
-    pub const UnsignedPriority: u64 = 1 << 20;
-}
-
-parameter_types! {
-    pub const ExistentialDeposit: u64 = 5;
-    pub const MaxReserves: u32 = 50;
-}
-
-impl pallet_balances::Config for Test {
-    type Balance = u64;
-    type Event = Event;
-    type DustRemoval = ();
-    type ExistentialDeposit = ExistentialDeposit;
-    type AccountStore = System;
-    type WeightInfo = ();
-    type MaxLocks = ();
-    type MaxReserves = MaxReserves;
-    type ReserveIdentifier = [u8; 8];
-}
-pub struct DoNothingRouter;
-impl SendXcm for DoNothingRouter {
-    fn send_xcm(_dest: impl Into<MultiLocation>, _msg: Xcm<()>) -> SendResult {
-        Ok(())
-    }
-}
-// For testing the module, we construct a mock runtime.
-
-parameter_types! {
-    pub const MinimumPeriod: u64 = 1;
-}
-impl pallet_timestamp::Config for Test {
-    type Moment = u64;
-    type OnTimestampSet = ();
-    type MinimumPeriod = MinimumPeriod;
-    type WeightInfo = ();
-}
-
-// pub trait Config: CreateSignedTransaction<Self> + frame_system::Config {}
-impl<LocalCall> frame_system::offchain::CreateSignedTransaction<LocalCall> for Test
-where
-    Call: From<LocalCall>,
-{
-    fn create_transaction<C: frame_system::offchain::AppCrypto<Self::Public, Self::Signature>>(
-        call: Call,
-        _public: <Signature as Verify>::Signer,
-        _account: AccountId,
-        nonce: u64,
-    ) -> Option<(Call, <Extrinsic as ExtrinsicT>::SignaturePayload)> {
-        Some((call, (nonce, ())))
-    }
-}
-
-parameter_types! {
-    // pub const RelayLocationson::X1(Parent);
-    pub const RelayNetwork: NetworkId = NetworkId::Kusama;
-    // pub RelayChainOrigin: Origin = cumulus_pallet_xcm::Origin::Relay.into();
-}
-impl kylin_oracle::Config for Test {
-    type Event = Event;
-    type AuthorityId = crypto::TestAuthId;
-    type Call = Call;
-    type Origin = Origin;
-    type XcmSender = DoNothingRouter;
-    type UnsignedPriority = UnsignedPriority;
-    type UnixTime = pallet_timestamp::Pallet<Test>;
-    type Currency = Balances;
-    type WeightInfo = ();
-    type EstimateCallFee = TransactionPayment;
-}
-
-parameter_types! {
-    pub const UnitWeightCost: u64 = 10;
-    pub const MaxInstructions: u32 = 100;
-}
-
-pub struct DummyWeightTrader;
-impl WeightTrader for DummyWeightTrader {
-    fn new() -> Self {
-        DummyWeightTrader
-    }
-
-    fn buy_weight(&mut self, _weight: Weight, _payment: Assets) -> Result<Assets, XcmError> {
-        Ok(Assets::default())
-    }
-}
-pub struct DummyAssetTransactor;
-impl TransactAsset for DummyAssetTransactor {
-    fn deposit_asset(_what: &MultiAsset, _who: &MultiLocation) -> XcmResult {
-        Ok(())
-    }
-
-    fn withdraw_asset(_what: &MultiAsset, _who: &MultiLocation) -> Result<Assets, XcmError> {
-        let asset: MultiAsset = (Parent, 100_000).into();
-        Ok(asset.into())
-    }
-}
-pub struct XcmConfig;
-impl xcm_executor::Config for XcmConfig {
-    type Call = Call;
-    type XcmSender = DoNothingRouter;
-    type AssetTransactor = DummyAssetTransactor;
-    type OriginConverter = pallet_xcm::XcmPassthrough<Origin>;
-    type IsReserve = ();
-    type IsTeleporter = ();
-    type LocationInverter = LocationInverter<Ancestry>;
-    type Barrier = Barrier;
-    type Weigher = FixedWeightBounds<UnitWeightCost, Call, MaxInstructions>;
-    type Trader = DummyWeightTrader;
-    type ResponseHandler = ();
-    type AssetTrap = XcmPallet;
-    type AssetClaims = XcmPallet;
-    type SubscriptionService = XcmPallet;
-}
-
-parameter_types! {
-    pub static AdvertisedXcmVersion: xcm::prelude::XcmVersion = 2;
-}
-
-impl pallet_xcm::Config for Test {
-    type Event = Event;
-    type SendXcmOrigin = EnsureXcmOrigin<Origin, LocalOriginToLocation>;
-    type XcmRouter = DoNothingRouter;
-    type LocationInverter = LocationInverter<Ancestry>;
-    type ExecuteXcmOrigin = EnsureXcmOrigin<Origin, LocalOriginToLocation>;
-    type XcmExecuteFilter = Everything;
-    type XcmExecutor = XcmExecutor<XcmConfig>;
-    type XcmTeleportFilter = Everything;
-    type Weigher = FixedWeightBounds<UnitWeightCost, Call, MaxInstructions>;
-    type XcmReserveTransferFilter = Everything;
-    type Origin = Origin;
-    type Call = Call;
-    const VERSION_DISCOVERY_QUEUE_SIZE: u32 = 100;
-    type AdvertisedXcmVersion = AdvertisedXcmVersion;
-}
-
-impl cumulus_pallet_xcm::Config for Test {
-    type Event = Event;
-    type XcmExecutor = XcmExecutor<XcmConfig>;
-}
-
-#[test]
-fn should_save_data_onchain_for_signed_data_submissions() {
-    const PHRASE: &str =
-        "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-
-    SyncCryptoStore::sr25519_generate_new(
-        &keystore,
-        kylin_oracle::KEY_TYPE,
-        Some(&format!("{}/hunter1", PHRASE)),
-    )
-    .unwrap();
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    mock_submit_response(&mut offchain_state.write());
-    let expected_response = br#"{"USD": 155.23}"#.to_vec();
-    t.execute_with(|| {
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_signed(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_signed {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, expected_response);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
-}
-
-#[test]
-fn should_save_data_onchain_for_unsigned_submissions() {
-    // const PHRASE: &str =
-    // "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    mock_submit_response(&mut offchain_state.write());
-    let expected_response = br#"{"USD": 155.23}"#.to_vec();
-    t.execute_with(|| {
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_raw_unsigned(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_unsigned {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, expected_response);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
-}
-
-#[test]
-fn should_write_data_onchain_directly_for_signed_requests() {
-    const PHRASE: &str =
-        "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, _offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-    let keystore = KeyStore::new();
-    SyncCryptoStore::sr25519_generate_new(
-        &keystore,
-        kylin_oracle::KEY_TYPE,
-        Some(&format!("{}/hunter1", PHRASE)),
-    )
-    .unwrap();
-
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    let feed_name = b"test_feed".to_vec();
-    let sample_data = b"{sample_data}".to_vec();
-    t.execute_with(|| {
-        KylinOracle::write_data_onchain(
-            Origin::signed(alice),
-            feed_name,
-            sample_data.clone(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_signed(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_signed {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, sample_data);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
-}
-
-fn get_from_seed<TPublic: Public>(seed: &str) -> <TPublic::Pair as Pair>::Public {
-    TPublic::Pair::from_string(&format!("//{}", seed), None)
-        .expect("static values are valid; qed")
-        .public()
-}
-
-fn get_account_id_from_seed<TPublic: Public>(seed: &str) -> AccountId
-where
-    AccountPublic: From<<TPublic::Pair as Pair>::Public>,
-{
-    AccountPublic::from(get_from_seed::<TPublic>(seed)).into_account()
-}
-
-
-fn mock_submit_response(state: &mut testing::OffchainState) {
-    state.expect_request(testing::PendingRequest {
-        method: "GET".into(),
-        uri: "https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".into(),
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    });
-
-}
-
-fn mock_post_response(state: &mut testing::OffchainState) {
-    
-
-    // state.expect_request(testing::PendingRequest {
-    //     method: "GET".into(),
-    //     uri: "https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".into(),
-    //     response: Some(br#"{"USD": 155.23}"#.to_vec()),
-    //     sent: true,
-    //     ..Default::default()
-    // });
-
-
-    let sample_body:Vec<u8> =  vec![123, 10, 32, 32, 32, 32, 34, 100, 97, 116, 97, 34, 58, 32, 123, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 97, 114, 97, 95, 105, 100, 34, 58, 32, 110, 117, 108, 108, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 97, 99, 99, 111, 117, 110, 116, 95, 105, 100, 34, 58, 32, 34, 100, 52, 51, 53, 57, 51, 99, 55, 49, 53, 102, 100, 100, 51, 49, 99, 54, 49, 49, 52, 49, 97, 98, 100, 48, 52, 97, 57, 57, 102, 100, 54, 56, 50, 50, 99, 56, 53, 53, 56, 56, 53, 52, 99, 99, 100, 101, 51, 57, 97, 53, 54, 56, 52, 101, 55, 97, 53, 54, 100, 97, 50, 55, 100, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 114, 101, 113, 117, 101, 115, 116, 101, 100, 95, 98, 108, 111, 99, 107, 95, 110, 117, 109, 98, 101, 114, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 114, 111, 99, 101, 115, 115, 101, 100, 95, 98, 108, 111, 99, 107, 95, 110, 117, 109, 98, 101, 114, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 114, 101, 113, 117, 101, 115, 116, 101, 100, 95, 116, 105, 109, 101, 115, 116, 97, 109, 112, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 114, 111, 99, 101, 115, 115, 101, 100, 95, 116, 105, 109, 101, 115, 116, 97, 109, 112, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 97, 121, 108, 111, 97, 100, 34, 58, 32, 34, 123, 115, 97, 109, 112, 108, 101, 95, 100, 97, 116, 97, 125, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 102, 101, 101, 100, 95, 110, 97, 109, 101, 34, 58, 32, 34, 112, 114, 105, 99, 101, 95, 102, 101, 101, 100, 105, 110, 103, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 117, 114, 108, 34, 58, 32, 34, 104, 116, 116, 112, 115, 58, 47, 47, 97, 112, 105, 46, 107, 121, 108, 105, 110, 45, 110, 111, 100, 101, 46, 99, 111, 46, 117, 107, 47, 112, 114, 105, 99, 101, 115, 63, 99, 117, 114, 114, 101, 110, 99, 121, 95, 112, 97, 105, 114, 115, 61, 98, 116, 99, 95, 117, 115, 100, 34, 10, 32, 32, 32, 32, 125, 44, 10, 32, 32, 32, 32, 34, 104, 97, 115, 104, 34, 58, 32, 34, 57, 57, 100, 48, 97, 51, 99, 97, 55, 98, 102, 53, 56, 57, 100, 99, 55, 57, 57, 51, 49, 97, 53, 101, 51, 49, 48, 98, 99, 101, 100, 51, 100, 57, 55, 55, 57, 48, 54, 98, 99, 50, 56, 57, 54, 101, 97, 49, 99, 101, 99, 97, 53, 97, 56, 50, 52, 101, 57, 49, 97, 57, 53, 49, 34, 10, 125];
-
-    let mut pending_request = testing::PendingRequest {
-        method: "POST".into(),
-        uri: "https://api.kylin-node.co.uk/submit".into(),
-        body: sample_body,
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    };
-
-    pending_request.headers.push(("x-api-key".into(), "test_api_key".into()));
-    pending_request.headers.push(("content-type".into(), "application/json".into()));
-    state.expect_request(pending_request);
-}
-
-fn mock_query_response(state: &mut testing::OffchainState) {
-    let pending_request = testing::PendingRequest {
-        // 99d0a3ca7bf589dc79931a5e310bced3d977906bc2896ea1ceca5a824e91a951
-        method: "GET".into(),
-        uri: "https://api.kylin-node.co.uk/query?hash=99d0a3ca7bf589dc79931a5e310bced3d977906bc2896ea1ceca5a824e91a951".into(),
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    };
-    state.expect_request(pending_request);
-}
-
-#[test]
-fn should_award_query_fees() {
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-    let bob = get_account_id_from_seed::<sr25519::Public>("Bob");
-    let additional_amount = 10_000;
-    let query_reward_fee = 126743754;
-    let free_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance;
-
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, _pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    t.execute_with(|| {
-        let _ = <pallet_balances::Pallet<Test> as Currency<AccountId>>::deposit_creating(
-                        &alice,
-                        additional_amount
-        );
-
-        let _ =  <pallet_balances::Pallet<Test> as Currency<AccountId>>::deposit_creating(
-                        &bob,
-                        additional_amount
-                    );
-        
-        let initial_alice_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance(&alice);
-        let initial_bob_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance(&bob);
-
-        let sample_data = b"{sample_data}".to_vec();
-        let mut processed_requests: Vec<u64> = Vec::new();
-        let mut key = 10000000u64;
-        let mut alice_fee = 0;
-        let mut bob_fee = 0;
-        processed_requests.push(key);
-
-        // key = 10000000u64, data index = 10000000u64 weight = 65_955_000 + 100 * 3 + 1000 * 3
-        //     (65_955_000 as Weight)
-        //         .saturating_add(RocksDbWeight::get().reads(3 as Weight))
-        //         .saturating_add(RocksDbWeight::get().writes(3 as Weight))
-        let submit_price_feed_fee = 65_955_000 + 100 * 3 + 1000 * 3;
-        alice_fee += submit_price_feed_fee;
-        println!("alice: submit_price_feed fee {}", submit_price_feed_fee);
-        mock_submit_response(&mut offchain_state.write());       
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-
-        println!("alice step0 balance: {}", free_balance(&alice));
-
-        // (65_955_000 as Weight)
-        // .saturating_add(T::DbWeight::get().reads(3 as Weight))
-        // .saturating_add(T::DbWeight::get().writes(3 as Weight))
-        let submit_data_signed_feed_fee = 65_955_000 + 100 * 3 + 1000 * 3;
-        alice_fee += submit_data_signed_feed_fee;
-        println!("alice: submit_price_feed fee {}", submit_data_signed_feed_fee);
-        KylinOracle::submit_data_signed(
-            Origin::signed(alice),
-            1,
-            key,
-            sample_data.clone()
-        )
-        .unwrap();
-
-        println!("alice step1 balance: {}", free_balance(&alice));
-
-
-        KylinOracle::fetch_data_and_send_raw_unsigned(1).unwrap();
-        KylinOracle::clear_processed_requests_unsigned(
-            Origin::none(),
-            1,
-            processed_requests.clone(),
-        )
-        .unwrap();
-
-        mock_post_response(&mut offchain_state.write());
-        KylinOracle::fetch_data_and_send_raw_unsigned(2).unwrap();
-    
-        // key = 10000001u64, data index = 10000001u64
-        key = 10000001u64;
-        mock_query_response(&mut offchain_state.write());
-
-        println!("alice step2 balance: {}", free_balance(&alice));
-
-        // (121_180_000 as Weight) // Standard Error: 0
-        // .saturating_add(RocksDbWeight::get().reads(4 as Weight))
-        // .saturating_add(RocksDbWeight::get().writes(2 as Weight))
-        // base_fee + len_fee + adjested_weight_fee
-        let query_data_fee = 121_180_000 + 100 * 4 + 1000 * 2;
-        bob_fee += query_data_fee;
-        println!("bob: query_data fee {}", query_data_fee);
-        KylinOracle::query_data(
-            Origin::signed(bob),
-            None,
-            str::from_utf8(b"price_feeding").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-
-        println!("alice step3 balance: {}", free_balance(&alice));
-
-        // (20_716_000 as Weight) // Standard Error: 0
-        // .saturating_add(RocksDbWeight::get().reads(2 as Weight))
-        // .saturating_add(RocksDbWeight::get().writes(1 as Weight))
-        let submit_data_signed_fee = 20_716_000 + 100 * 2 + 1000 * 1;
-        bob_fee += submit_data_signed_fee;
-        println!("bob: submit_data_signed fee {}", submit_data_signed_fee);
-        KylinOracle::submit_data_signed(
-            Origin::signed(bob),
-            2,
-            key,
-            sample_data.clone()
-        )
-        .unwrap();
-        KylinOracle::clear_api_queue_unsigned(
-            Origin::none(),
-            2,
-            processed_requests.clone(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_raw_unsigned(3).unwrap();
-        println!("alice step4 balance: {}", free_balance(&alice));
-
-
-        let free_alice_balance = free_balance(&alice);
-        let free_bob_balance = free_balance(&bob);
-
-        println!("init alice balance {}, free alice balance {}", initial_alice_balance, free_alice_balance);
-        println!("init bob balance {}, free bob balance {}", initial_bob_balance, free_bob_balance);
-        println!("alice fee used {}, bob fee used {}", alice_fee, bob_fee);
-
-        assert_eq!(
-            free_alice_balance,
-            initial_alice_balance + query_reward_fee,
-        );
-    });
-
-}
\ No newline at end of file
+#[test]
+fn feeds_beyond_max_feed_values_are_sent_in_full() {
+	new_test_ext().execute_with(|| {
+		let names: Vec<_> = (0..9).map(|i| format!("key{}", i)).collect();
+		for name in &names {
+			submit_feed(account(1), name, "https://prices.test", "/price");
+		}
+		let values: Vec<_> = names.iter().map(|name| (key(name), 1)).collect();
+
+		assert!(matches!(
+			KylinOracle::feed_call(&account(1), &values[..8]),
+			Call::feed_data_compact { .. }
+		));
+		assert!(matches!(KylinOracle::feed_call(&account(1), &values), Call::feed_data { .. }));
+	});
+}
+
+/// The history of `name`, with timestamps relative to `INIT_TIMESTAMP`.
+fn history(name: &str) -> Vec<(i64, u128)> {
+	KylinOracle::history(&key(name), 0, u128::MAX)
+		.into_iter()
+		.map(|value| (value.value, value.timestamp - INIT_TIMESTAMP as u128))
+		.collect()
+}
+
+#[test]
+fn history_keeps_the_last_max_history_len_values() {
+	new_test_ext().execute_with(|| {
+		for value in 1..=6 {
+			next_block(1_000);
+			feed(1, &[("btc", value)]);
+		}
+
+		assert_eq!(history("btc"), vec![(3, 3_000), (4, 4_000), (5, 5_000), (6, 6_000)]);
+		let start = INIT_TIMESTAMP as u128;
+		let values: Vec<_> = KylinOracle::history(&key("btc"), start + 3_500, start + 5_000)
+			.into_iter()
+			.map(|value| value.value)
+			.collect();
+		assert_eq!(values, vec![4, 5]);
+		assert!(KylinOracle::history(&key("btc"), start + 7_000, u128::MAX).is_empty());
+	});
+}
+
+#[test]
+fn history_is_recorded_at_the_time_values_are_combined() {
+	new_test_ext().execute_with(|| {
+		set_members(vec![account(1), account(2)]);
+		next_block(1_000);
+		feed(1, &[("btc", 100)]);
+		feed(2, &[("btc", 200)]);
+
+		// A single entry per block, with the latest combined value.
+		let combined = KylinOracle::get(&key("btc")).unwrap().value;
+		assert_eq!(history("btc"), vec![(combined, 1_000)]);
+
+		// A value older than the newest one would break the order of the ring.
+		KylinOracle::record_history(&key("btc"), at(1, INIT_TIMESTAMP));
+		assert_eq!(history("btc"), vec![(combined, 1_000)]);
+	});
+}
+
+#[test]
+fn history_is_laid_out_again_when_its_length_changes() {
+	new_test_ext().execute_with(|| {
+		for value in 1..=6 {
+			next_block(1_000);
+			feed(1, &[("btc", value)]);
+		}
+		// As if the ring had been laid out for a longer `MaxHistoryLen`.
+		let cursor = HistoryCursors::<Test>::get(key("btc"));
+		HistoryCursors::<Test>::insert(
+			key("btc"),
+			KylinOracle::resize_history(&key("btc"), cursor, 8),
+		);
+		HistoryLen::<Test>::put(8);
+		next_block(1_000);
+		feed(1, &[("btc", 7)]);
+		assert_eq!(HistoryCursors::<Test>::get(key("btc")).cap, 4);
+		assert_eq!(history("btc"), vec![(4, 4_000), (5, 5_000), (6, 6_000), (7, 7_000)]);
+
+		let cursor = HistoryCursors::<Test>::get(key("btc"));
+		HistoryCursors::<Test>::insert(
+			key("btc"),
+			KylinOracle::resize_history(&key("btc"), cursor, 2),
+		);
+		migrations::resize_history::<Test>();
+
+		assert_eq!(HistoryLen::<Test>::get(), Some(4));
+		assert_eq!(history("btc"), vec![(6, 6_000), (7, 7_000)]);
+		assert_eq!(History::<Test>::iter_prefix(key("btc")).count(), 2);
+	});
+}
+
+#[test]
+fn removing_a_feed_removes_its_history() {
+	new_test_ext().execute_with(|| {
+		submit_feed(account(1), "btc", "https://prices.test", "/btc/usd");
+		next_block(1_000);
+		feed(1, &[("btc", 100)]);
+		assert_eq!(history("btc").len(), 1);
+
+		assert_ok!(KylinOracle::remove_api(RuntimeOrigin::signed(account(1)), key("btc")));
+		assert!(!HistoryCursors::<Test>::contains_key(key("btc")));
+		assert_eq!(History::<Test>::iter_prefix(key("btc")).count(), 0);
+	});
+}
+
+#[test]
+fn removing_one_of_the_feeds_of_a_key_keeps_its_history() {
+	new_test_ext().execute_with(|| {
+		submit_feed(account(1), "btc", "https://prices.test", "/btc/usd");
+		submit_feed(account(2), "btc", "https://other-prices.test", "/btc");
+		next_block(1_000);
+		feed(1, &[("btc", 100)]);
+
+		assert_ok!(KylinOracle::remove_api(RuntimeOrigin::signed(account(1)), key("btc")));
+		assert_eq!(history("btc").len(), 1);
+		assert!(KylinOracle::get(&key("btc")).is_some());
+
+		assert_ok!(KylinOracle::remove_api(RuntimeOrigin::signed(account(2)), key("btc")));
+		assert!(history("btc").is_empty());
+		assert!(!ApiFeedCount::<Test>::contains_key(key("btc")));
+	});
+}
+
+fn set_hot_keys(names: &[&str]) {
+	let keys: Vec<_> = names.iter().map(|name| key(name)).collect();
+	assert_ok!(KylinOracle::set_hot_keys(RuntimeOrigin::root(), keys.try_into().unwrap()));
+}
+
+#[test]
+fn hot_keys_are_set_sorted_with_their_current_values() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 100)]);
+		assert_noop!(
+			KylinOracle::set_hot_keys(
+				RuntimeOrigin::signed(account(1)),
+				vec![key("btc")].try_into().unwrap()
+			),
+			DispatchError::BadOrigin
+		);
+
+		set_hot_keys(&["eth", "btc"]);
+		assert_eq!(
+			KylinOracle::hot_values().into_inner(),
+			vec![(key("btc"), KylinOracle::get(&key("btc"))), (key("eth"), None)]
+		);
+		assert_eq!(
+			last_event(),
+			Event::<Test>::HotKeysSet { keys: vec![key("btc"), key("eth")] }.into()
+		);
+	});
+}
+
+#[test]
+fn setting_hot_keys_replaces_the_previous_ones() {
+	new_test_ext().execute_with(|| {
+		set_hot_keys(&["btc", "eth"]);
+		set_hot_keys(&["dot"]);
+
+		assert_eq!(KylinOracle::hot_values().into_inner(), vec![(key("dot"), None)]);
+	});
+}
+
+#[test]
+fn feeding_a_hot_key_updates_its_hot_value() {
+	new_test_ext().execute_with(|| {
+		set_hot_keys(&["btc"]);
+		feed(1, &[("btc", 100), ("eth", 10)]);
+		next_block(6_000);
+		feed(2, &[("btc", 102)]);
+
+		let btc = KylinOracle::get(&key("btc")).unwrap();
+		assert_eq!(KylinOracle::hot_values().into_inner(), vec![(key("btc"), Some(btc))]);
+		assert_eq!(KylinOracle::get_hot_values(), vec![(key("btc"), btc)]);
+	});
+}
+
+#[test]
+fn hot_values_are_sent_in_one_message() {
+	new_test_ext().execute_with(|| {
+		set_hot_keys(&["btc", "eth"]);
+		assert_noop!(KylinOracle::xcm_query_hot_values(sibling(2000)), DispatchError::CannotLookup);
+
+		feed(1, &[("btc", 100), ("dot", 5)]);
+		assert_ok!(KylinOracle::xcm_query_hot_values(sibling(2000)));
+
+		let values = vec![(b"btc".to_vec(), KylinOracle::get(&key("btc")).unwrap())];
+		assert_eq!(
+			sent_feeds(),
+			vec![(2000.into(), KylinMockFunc::xcm_feed_back_batch { values })]
+		);
+	});
+}
@@ -1,8 +1,8 @@
-//! Autogenerated weights for kylin_oracle
+//! Weights for kylin_oracle
 //!
-//! THIS FILE WAS AUTO-GENERATED USING THE SUBSTRATE BENCHMARK CLI VERSION 4.0.0-dev
-//! DATE: 2021-11-28, STEPS: `100`, REPEAT: 200, LOW RANGE: `[]`, HIGH RANGE: `[]`
-//! EXECUTION: Some(Wasm), WASM-EXECUTION: Compiled, CHAIN: Some("pichiu-chachacha"), DB CACHE: 128
+//! Only `query_data` and `submit_api` come from the benchmark run below, of 2021-11-28 on
+//! pichiu-chachacha. Every other weight is an estimate from the storage accesses of its call,
+//! marked as such, to be replaced by the output of the same command.
 
 // Executed Command:
 // target/release/kylin-collator
@@ -30,10 +30,14 @@ use sp_std::marker::PhantomData;
 /// Weight functions needed for kylin_oracle.
 pub trait WeightInfo {
     fn query_data() -> Weight;
-    fn feed_data(c: u32) -> Weight;
-    fn on_finalize() -> Weight;
+    fn query_data_batch(k: u32) -> Weight;
+    fn query_history(n: u32) -> Weight;
+    fn query_hot_values(k: u32) -> Weight;
+    fn set_hot_keys(k: u32) -> Weight;
+    fn feed_data(c: u32, f: u32) -> Weight;
+    fn feed_data_compact(c: u32, f: u32) -> Weight;
     fn submit_api() -> Weight;
-    fn remove_api() -> Weight;
+    fn remove_api(n: u32) -> Weight;
 }
 
 /// Weights for kylin_oracle using the Substrate node and recommended hardware.
@@ -44,27 +48,73 @@ impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
             .saturating_add(T::DbWeight::get().reads(4 as u64))
             .saturating_add(T::DbWeight::get().writes(2 as u64))
     }
-    fn feed_data(c: u32, ) -> Weight {
+	// Not benchmarked: estimated from `query_data`, with a read and an encoding per key.
+	fn query_data_batch(k: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(3_600_000).saturating_mul(k as u64))
+            .saturating_add(T::DbWeight::get().reads(3 as u64))
+            .saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(k as u64)))
+            .saturating_add(T::DbWeight::get().writes(2 as u64))
+    }
+	// Not benchmarked: estimated from `query_data`, with a read and an encoding per value of
+	// the `n` long history.
+	fn query_history(n: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(1_800_000).saturating_mul(n as u64))
+            .saturating_add(T::DbWeight::get().reads(1 as u64))
+            .saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(n as u64)))
+            .saturating_add(T::DbWeight::get().writes(2 as u64))
+    }
+	// Not benchmarked: estimated from `query_data`, the values of the hot keys being a single
+	// read whatever their number, with an encoding per value.
+	fn query_hot_values(k: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(1_200_000).saturating_mul(k as u64))
+            .saturating_add(T::DbWeight::get().reads(3 as u64))
+            .saturating_add(T::DbWeight::get().writes(2 as u64))
+    }
+	// Not benchmarked: estimated from a read of the combined value of each key and the write of
+	// the hot values.
+	fn set_hot_keys(k: u32, ) -> Weight {
+        Weight::from_ref_time(9_400_000)
+			.saturating_add(Weight::from_ref_time(2_100_000).saturating_mul(k as u64))
+            .saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(k as u64)))
+            .saturating_add(T::DbWeight::get().writes(1 as u64))
+    }
+	// Not benchmarked: estimated from the storage accesses of each value, the sorted window of
+	// `f` raw values of its key, its subscribers and the hot values.
+    fn feed_data(c: u32, f: u32, ) -> Weight {
         Weight::from_ref_time(16_800_000)
-			// Standard Error: 84_000
-			.saturating_add(Weight::from_ref_time(3_600_000).saturating_mul(c as u64))
-			.saturating_add(T::DbWeight::get().reads(3 as u64))
-			.saturating_add(T::DbWeight::get().writes(1 as u64))
-			.saturating_add(T::DbWeight::get().writes((2 as u64).saturating_mul(c as u64)))
+			.saturating_add(Weight::from_ref_time(9_800_000).saturating_mul(c as u64))
+			.saturating_add(Weight::from_ref_time(6_100_000).saturating_mul(f as u64))
+			.saturating_add(T::DbWeight::get().reads(36 as u64))
+			.saturating_add(T::DbWeight::get().reads((37 as u64).saturating_mul(c as u64)))
+			.saturating_add(T::DbWeight::get().writes(34 as u64))
+			.saturating_add(T::DbWeight::get().writes((37 as u64).saturating_mul(c as u64)))
 	}
-	fn on_finalize() -> Weight {
-        Weight::from_ref_time(3_000_000)
-			.saturating_add(T::DbWeight::get().writes(1 as u64))
+	// Not benchmarked: estimated from `feed_data`, with one more read per value for its key
+	// index.
+    fn feed_data_compact(c: u32, f: u32, ) -> Weight {
+        Weight::from_ref_time(17_400_000)
+			.saturating_add(Weight::from_ref_time(10_300_000).saturating_mul(c as u64))
+			.saturating_add(Weight::from_ref_time(6_100_000).saturating_mul(f as u64))
+			.saturating_add(T::DbWeight::get().reads(36 as u64))
+			.saturating_add(T::DbWeight::get().reads((39 as u64).saturating_mul(c as u64)))
+			.saturating_add(T::DbWeight::get().writes(34 as u64))
+			.saturating_add(T::DbWeight::get().writes((37 as u64).saturating_mul(c as u64)))
 	}
     fn submit_api() -> Weight {
         Weight::from_ref_time(66_168_000)
             .saturating_add(T::DbWeight::get().reads(3 as u64))
             .saturating_add(T::DbWeight::get().writes(3 as u64))
     }
-    fn remove_api() -> Weight {
+	// Not benchmarked: estimated from the storage accesses, the history of the key, at most `n`
+	// values, being removed with the feed.
+    fn remove_api(n: u32, ) -> Weight {
         Weight::from_ref_time(66_168_000)
-            .saturating_add(T::DbWeight::get().reads(3 as u64))
-            .saturating_add(T::DbWeight::get().writes(3 as u64))
+            .saturating_add(T::DbWeight::get().reads(4 as u64))
+            .saturating_add(T::DbWeight::get().writes(4 as u64))
+            .saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(n as u64)))
     }
 }
 
@@ -75,26 +125,64 @@ impl WeightInfo for () {
             .saturating_add(RocksDbWeight::get().reads(4 as u64))
             .saturating_add(RocksDbWeight::get().writes(2 as u64))
     }
-    fn feed_data(c: u32, ) -> Weight {
-		Weight::from_ref_time(16_800_000)
-			// Standard Error: 84_000
-			.saturating_add(Weight::from_ref_time(3_600_000).saturating_mul(c as u64))
-			.saturating_add(RocksDbWeight::get().reads(3 as u64))
-			.saturating_add(RocksDbWeight::get().writes(1 as u64))
-			.saturating_add(RocksDbWeight::get().writes((2 as u64).saturating_mul(c as u64)))
+	// Not benchmarked: estimated from `query_data`, with a read and an encoding per key.
+	fn query_data_batch(k: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(3_600_000).saturating_mul(k as u64))
+            .saturating_add(RocksDbWeight::get().reads(3 as u64))
+            .saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(k as u64)))
+            .saturating_add(RocksDbWeight::get().writes(2 as u64))
+    }
+	fn query_history(n: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(1_800_000).saturating_mul(n as u64))
+            .saturating_add(RocksDbWeight::get().reads(1 as u64))
+            .saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(n as u64)))
+            .saturating_add(RocksDbWeight::get().writes(2 as u64))
+    }
+	// Not benchmarked: estimated from `query_data`, the values of the hot keys being a single
+	// read whatever their number, with an encoding per value.
+	fn query_hot_values(k: u32, ) -> Weight {
+        Weight::from_ref_time(121_180_000)
+			.saturating_add(Weight::from_ref_time(1_200_000).saturating_mul(k as u64))
+            .saturating_add(RocksDbWeight::get().reads(3 as u64))
+            .saturating_add(RocksDbWeight::get().writes(2 as u64))
+    }
+	// Not benchmarked: estimated from a read of the combined value of each key and the write of
+	// the hot values.
+	fn set_hot_keys(k: u32, ) -> Weight {
+        Weight::from_ref_time(9_400_000)
+			.saturating_add(Weight::from_ref_time(2_100_000).saturating_mul(k as u64))
+            .saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(k as u64)))
+            .saturating_add(RocksDbWeight::get().writes(1 as u64))
+    }
+    fn feed_data(c: u32, f: u32, ) -> Weight {
+        Weight::from_ref_time(16_800_000)
+			.saturating_add(Weight::from_ref_time(9_800_000).saturating_mul(c as u64))
+			.saturating_add(Weight::from_ref_time(6_100_000).saturating_mul(f as u64))
+			.saturating_add(RocksDbWeight::get().reads(36 as u64))
+			.saturating_add(RocksDbWeight::get().reads((37 as u64).saturating_mul(c as u64)))
+			.saturating_add(RocksDbWeight::get().writes(34 as u64))
+			.saturating_add(RocksDbWeight::get().writes((37 as u64).saturating_mul(c as u64)))
 	}
-	fn on_finalize() -> Weight {
-		Weight::from_ref_time(3_000_000)
-			.saturating_add(RocksDbWeight::get().writes(1 as u64))
+    fn feed_data_compact(c: u32, f: u32, ) -> Weight {
+        Weight::from_ref_time(17_400_000)
+			.saturating_add(Weight::from_ref_time(10_300_000).saturating_mul(c as u64))
+			.saturating_add(Weight::from_ref_time(6_100_000).saturating_mul(f as u64))
+			.saturating_add(RocksDbWeight::get().reads(36 as u64))
+			.saturating_add(RocksDbWeight::get().reads((39 as u64).saturating_mul(c as u64)))
+			.saturating_add(RocksDbWeight::get().writes(34 as u64))
+			.saturating_add(RocksDbWeight::get().writes((37 as u64).saturating_mul(c as u64)))
 	}
     fn submit_api() -> Weight {
         Weight::from_ref_time(66_168_000)
             .saturating_add(RocksDbWeight::get().reads(3 as u64))
             .saturating_add(RocksDbWeight::get().writes(3 as u64))
     }
-    fn remove_api() -> Weight {
+    fn remove_api(n: u32, ) -> Weight {
         Weight::from_ref_time(66_168_000)
-            .saturating_add(RocksDbWeight::get().reads(3 as u64))
-            .saturating_add(RocksDbWeight::get().writes(3 as u64))
+            .saturating_add(RocksDbWeight::get().reads(4 as u64))
+            .saturating_add(RocksDbWeight::get().writes(4 as u64))
+            .saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(n as u64)))
     }
 }
@@ -0,0 +1,31 @@
+use crate::TimestampedValue;
+use frame_support::traits::Get;
+use orml_traits::CombineData;
+use sp_std::{marker, prelude::*};
+
+/// Median of the values fed for a key within a block, the values being fed by the members of
+/// the reporter chain.
+/// Returns prev_value if not enough values were fed.
+pub struct MedianCombineData<MinimumCount>(marker::PhantomData<MinimumCount>);
+
+impl<MinimumCount> CombineData<Vec<u8>, TimestampedValue> for MedianCombineData<MinimumCount>
+where
+	MinimumCount: Get<u32>,
+{
+	fn combine_data(
+		_key: &Vec<u8>,
+		mut values: Vec<TimestampedValue>,
+		prev_value: Option<TimestampedValue>,
+	) -> Option<TimestampedValue> {
+		let count = values.len() as u32;
+		if count < MinimumCount::get() || count == 0 {
+			return prev_value
+		}
+
+		let mid_index = count / 2;
+		// Won't panic as `values` ensured not empty.
+		let (_, value, _) =
+			values.select_nth_unstable_by(mid_index as usize, |a, b| a.value.cmp(&b.value));
+		Some(value.clone())
+	}
+}
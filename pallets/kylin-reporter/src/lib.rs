@@ -26,8 +26,15 @@ use frame_system::{
     Config as SystemConfig,
 };
 use hex::ToHex;
-use serde_json::{Value as JValue};
+use kylin_support::{
+    json::{extract_numbers, JsonError},
+    math::deviation,
+    native_fetch,
+    offchain_metrics::{self, EndpointFetch, WorkerRun},
+};
+use orml_traits::CombineData;
 use scale_info::TypeInfo;
+use sp_std::collections::btree_map::BTreeMap;
 use sp_std::{borrow::ToOwned, convert::TryFrom, convert::TryInto, prelude::*, str, vec, vec::Vec};
 
 use sp_core::crypto::KeyTypeId;
@@ -37,12 +44,15 @@ use sp_runtime::{
         storage::{MutateStorageError, StorageRetrievalError, StorageValueRef},
         Duration,
     },
-    traits::{Hash, UniqueSaturatedInto, Zero},
+    traits::{Hash, One, UniqueSaturatedInto, Zero},
+    Permill,
 };
 use xcm::latest::{prelude::*, Junction, OriginKind, SendXcm, Xcm};
 
 pub use pallet::*;
 #[cfg(test)]
+mod mock;
+#[cfg(test)]
 mod tests;
 
 // Runtime benchmarking features
@@ -51,6 +61,9 @@ mod benchmarking;
 
 pub mod weights;
 pub use weights::*;
+pub mod migrations;
+mod combine_data;
+pub use combine_data::MedianCombineData;
 type BalanceOf<T> =
     <<T as Config>::Currency as Currency<<T as frame_system::Config>::AccountId>>::Balance;
 
@@ -142,10 +155,47 @@ pub mod pallet {
         /// Oracle operators.
 		type Members: SortedMembers<Self::AccountId>;
 
+		/// Maximum size in bytes of an api feed response body.
+		#[pallet::constant]
+		type MaxResponseSize: Get<u32>;
+
+		/// Time the fed values are stamped with.
+		type UnixTime: UnixTime;
+
+		/// Combines the values fed for a key within a block into the value forwarded to the
+		/// Kylin Oracle chain.
+		type CombineData: CombineData<Vec<u8>, TimestampedValue>;
+
+		/// A combined value is forwarded as soon as it deviates from the last forwarded value
+		/// by `ForwardDeviation`...
+		#[pallet::constant]
+		type ForwardDeviation: Get<Permill>;
+
+		/// ...or at least every `ForwardHeartbeat` blocks.
+		#[pallet::constant]
+		type ForwardHeartbeat: Get<Self::BlockNumber>;
+
+		/// Weight of `xcm_feed_data` on the Kylin Oracle chain per forwarded value.
+		#[pallet::constant]
+		type XcmWeightPerValue: Get<u64>;
+
+		/// Weight budget of a single XCM message forwarding values, the values of a block are
+		/// packed into as few messages as the budget allows.
+		#[pallet::constant]
+		type XcmWeightBudget: Get<u64>;
+
+		/// Maximum number of values fed within a block, by all the members and for all the keys,
+		/// which bounds the values combined and forwarded on finalize.
+		#[pallet::constant]
+		type MaxPendingValues: Get<u32>;
     }
 
+    /// The current storage version.
+    const STORAGE_VERSION: StorageVersion = StorageVersion::new(1);
+
     #[pallet::pallet]
     #[pallet::generate_store(trait Store)]
+    #[pallet::storage_version(STORAGE_VERSION)]
     #[pallet::without_storage_info]
     pub struct Pallet<T>(_);
 
@@ -157,6 +207,8 @@ pub mod pallet {
 		NoPermission,
 		/// Feeder has already feeded at this block
 		AlreadyFeeded,
+		/// More than `MaxPendingValues` values would be fed in the block
+		TooManyPendingValues,
     }
 
     #[pallet::hooks]
@@ -164,6 +216,24 @@ pub mod pallet {
     where
         T::AccountId: AsRef<[u8]> + ToHex + Decode
     {
+        fn on_runtime_upgrade() -> Weight {
+            migrations::migrate::<T>()
+        }
+
+        /// Charge the heartbeats due in the block, forwarded on finalize.
+        fn on_initialize(block_number: T::BlockNumber) -> Weight {
+            let due = HeartbeatDue::<T>::decode_len(block_number).unwrap_or(0) as u32;
+            T::DbWeight::get()
+                .reads(1)
+                .saturating_add(<T as Config>::WeightInfo::forward_values(due))
+        }
+
+        /// The values fed in the block are forwarded here, once combined, along with the
+        /// heartbeats due in the block. Forwarding the fed values is charged by `feed_data`.
+        fn on_finalize(block_number: T::BlockNumber) {
+            Self::forward_pending_values(block_number);
+        }
+
         fn offchain_worker(block_number: T::BlockNumber) {
             // Note that having logs compiled to WASM may cause the size of the blob to increase
             // significantly. You can use `RuntimeDebug` custom derive to hide details of the types
@@ -219,13 +289,19 @@ pub mod pallet {
 
         /// Feed the external value.
 		///
-		/// Call by the offchain worker.
+		/// Call by the offchain worker. The values fed by the members within a block are
+		/// combined and only forwarded to the Oracle chain at the end of the block if they
+		/// deviate from the last forwarded values or on heartbeat.
 		///
 		/// # Parameter:
         /// * `para_id` - parachain ID of the Oracle chain
 		/// * `values` - value array for the feed
 		/// 
-        #[pallet::weight(T::DbWeight::get().reads_writes(1,1).ref_time().saturating_add(10_000))]
+        #[pallet::weight({
+            let c = values.len() as u32;
+            <T as Config>::WeightInfo::feed_data(c)
+                .saturating_add(<T as Config>::WeightInfo::forward_values(c))
+        })]
         pub fn feed_data(
             origin: OriginFor<T>,
             para_id: ParaId,
@@ -235,7 +311,15 @@ pub mod pallet {
             // ensure submitter is authorized
             ensure!(T::Members::contains(&submitter), Error::<T>::NoPermission);
 
-            Self::feed_data_to_parachain(para_id, values)
+            let pending = PendingCount::<T>::get().saturating_add(values.len() as u32);
+            ensure!(pending <= T::MaxPendingValues::get(), Error::<T>::TooManyPendingValues);
+            PendingCount::<T>::put(pending);
+
+            let timestamp = T::UnixTime::now().as_millis();
+            for (key, value) in values {
+                PendingValues::<T>::append(para_id, key, TimestampedValue { value, timestamp });
+            }
+            Ok(())
         }
 
         /// Submit the URL Endpoint for the feed.
@@ -263,10 +347,15 @@ pub mod pallet {
             ensure!(T::Members::contains(&submitter), Error::<T>::NoPermission);
 
             let block_number = <system::Pallet<T>>::block_number();
+            // Resubmitting a feed keeps its schedule.
+            let previous = Self::api_feeds(&submitter, &key).unwrap_or_default();
             let feed = ApiFeed {
                     requested_block_number: block_number,
                     url: Some(url),
                     vpath: Some(vpath),
+                    update_interval: previous.update_interval,
+                    heartbeat: previous.heartbeat,
+                    deviation: previous.deviation,
                 };
             ApiFeeds::<T>::insert(&submitter, &key, feed.clone());
 
@@ -303,6 +392,42 @@ pub mod pallet {
             }
         }
 
+        /// Set the refresh schedule of the feed.
+		///
+		/// Can be called by authorized origin.
+		///
+		/// # Parameter:
+		/// * `key` - key for the feed
+		/// * `update_interval` - the feed is fetched every `update_interval` blocks
+		/// * `heartbeat` - a fetched value is submitted at least every `heartbeat` blocks
+		/// * `deviation` - a fetched value is submitted as soon as it deviates from the last
+		///     submitted value by `deviation`
+		/// 
+		/// # Emits
+		/// * `FeedScheduled`
+        #[pallet::weight(<T as Config>::WeightInfo::submit_api())]
+        pub fn set_api_schedule(
+            origin: OriginFor<T>,
+            key: Vec<u8>,
+            update_interval: T::BlockNumber,
+            heartbeat: T::BlockNumber,
+            deviation: Permill,
+        ) -> DispatchResult {
+            let submitter = ensure_signed(origin)?;
+            // ensure submitter is authorized
+            ensure!(T::Members::contains(&submitter), Error::<T>::NoPermission);
+
+            let feed = ApiFeeds::<T>::try_mutate(&submitter, &key, |maybe_feed| {
+                let feed = maybe_feed.as_mut().ok_or(DispatchError::CannotLookup)?;
+                feed.update_interval = update_interval;
+                feed.heartbeat = heartbeat;
+                feed.deviation = deviation;
+                Ok::<_, DispatchError>(feed.clone())
+            })?;
+
+            Self::deposit_event(Event::FeedScheduled { sender: submitter, key, feed });
+            Ok(())
+        }
     }
 
     // #[pallet::event where <T as frame_system::Config>:: AccountId: AsRef<[u8]> + ToHex + Decode + Serialize]
@@ -334,6 +459,12 @@ pub mod pallet {
             key: Vec<u8>,
             feed: ApiFeed<T::BlockNumber>,
 		},
+        /// Feed schedule is updated.
+		FeedScheduled {
+			sender: T::AccountId,
+            key: Vec<u8>,
+            feed: ApiFeed<T::BlockNumber>,
+		},
     }
 
     #[pallet::validate_unsigned]
@@ -365,6 +496,39 @@ pub mod pallet {
 	pub type ApiFeeds<T: Config> =
 		StorageDoubleMap<_, Twox64Concat, T::AccountId, Twox64Concat, Vec<u8>, ApiFeed<T::BlockNumber>>;
 
+    /// Values fed in the current block for each Oracle chain and key, forwarded on finalize
+    #[pallet::storage]
+	pub(super) type PendingValues<T: Config> =
+		StorageDoubleMap<_, Twox64Concat, ParaId, Blake2_128Concat, Vec<u8>, Vec<TimestampedValue>, ValueQuery>;
+
+    /// Number of values fed in the current block, up to `MaxPendingValues`
+    #[pallet::storage]
+	pub(super) type PendingCount<T: Config> = StorageValue<_, u32, ValueQuery>;
+
+    /// Last value forwarded to each Oracle chain for each key, and the block it was forwarded at
+    #[pallet::storage]
+	#[pallet::getter(fn forwarded)]
+	pub type Forwarded<T: Config> =
+		StorageDoubleMap<_, Twox64Concat, ParaId, Blake2_128Concat, Vec<u8>, (TimestampedValue, T::BlockNumber)>;
+
+    /// Latest value combined for each Oracle chain and key since it was last forwarded, held
+    /// back for being within `ForwardDeviation` of the forwarded one
+    #[pallet::storage]
+	pub(super) type Unforwarded<T: Config> =
+		StorageDoubleMap<_, Twox64Concat, ParaId, Blake2_128Concat, Vec<u8>, TimestampedValue>;
+
+    /// Keys whose heartbeat is due at a block, `ForwardHeartbeat` blocks after they were forwarded
+    #[pallet::storage]
+	pub(super) type HeartbeatDue<T: Config> =
+		StorageMap<_, Twox64Concat, T::BlockNumber, Vec<(ParaId, Vec<u8>)>, ValueQuery>;
+
+}
+
+/// A combined value, stamped with the time it was fed at.
+#[derive(Encode, Decode, Default, Clone, Copy, PartialEq, Eq, RuntimeDebug, TypeInfo)]
+pub struct TimestampedValue {
+    pub value: i64,
+    pub timestamp: u128,
 }
 
 /// Feed URL Endpoint data structure
@@ -374,6 +538,60 @@ pub struct ApiFeed<BlockNumber> {
     requested_block_number: BlockNumber,
     url: Option<Vec<u8>>,
     vpath: Option<Vec<u8>>,
+    /// The feed is fetched every `update_interval` blocks, zero means every block.
+    update_interval: BlockNumber,
+    /// A fetched value is submitted at least every `heartbeat` blocks...
+    heartbeat: BlockNumber,
+    /// ...or as soon as it deviates from the last submitted value by `deviation`. A zero
+    /// heartbeat or deviation submits every fetched value.
+    deviation: Permill,
+}
+
+/// Namespace of the offchain local storage entries shared with the node.
+const OFFCHAIN_NAMESPACE: &[u8] = b"kylin_reporter";
+/// Prefix of the offchain local storage entries holding the schedule of each feed.
+const FEED_SCHEDULE_PREFIX: &[u8] = b"kylin_reporter::feed_schedule::";
+/// Maximum number of feeds fetched by a single offchain worker run, the feeds left over are
+/// fetched by the next runs.
+const MAX_FEEDS_PER_RUN: usize = 64;
+
+/// Offchain schedule of a feed, kept in the offchain local storage.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct FeedSchedule<BlockNumber> {
+    /// The feed is due from this block on.
+    pub next_fetch: BlockNumber,
+    /// The last submitted value and the block it was submitted at.
+    pub last_submitted: Option<(i64, BlockNumber)>,
+}
+
+/// A feed due in the current offchain worker run.
+struct DueFeed<Key, BlockNumber> {
+    key: Key,
+    url: Vec<u8>,
+    vpath: Vec<u8>,
+    feed: ApiFeed<BlockNumber>,
+    schedule_key: Vec<u8>,
+    schedule: FeedSchedule<BlockNumber>,
+}
+
+/// Prefix of the offchain local storage entries holding the health of each feed endpoint.
+const ENDPOINT_HEALTH_PREFIX: &[u8] = b"kylin_reporter::endpoint_health::";
+/// Number of consecutive failures after which an endpoint is backed off.
+const ENDPOINT_BACKOFF_THRESHOLD: u32 = 3;
+/// Upper bound of the backoff, in blocks.
+const ENDPOINT_MAX_BACKOFF: u32 = 256;
+/// How often pending requests are polled, used as the resolution of the measured latency.
+const HTTP_POLL_INTERVAL_MS: u64 = 50;
+
+/// Health of a feed endpoint, kept in the offchain local storage.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct EndpointHealth<BlockNumber> {
+    /// Number of consecutive failed fetches.
+    pub consecutive_failures: u32,
+    /// Latency of the last fetch in milliseconds.
+    pub last_latency: u64,
+    /// The endpoint is not fetched before this block.
+    pub backoff_until: BlockNumber,
 }
 
 enum TransactionType {
@@ -395,29 +613,129 @@ where T::AccountId: AsRef<[u8]>
                 "No local accounts available. Consider adding one via `author_insertKey` RPC.",
             )?;
         }
+        let started_at = sp_io::offchain::timestamp();
+
+        let mut feeds: Vec<DueFeed<Vec<u8>, T::BlockNumber>> =
+            <ApiFeeds<T> as IterableStorageDoubleMap<_, _, _>>::iter()
+                .filter_map(|(creator, key, feed)| {
+                    let (url, vpath) = match (feed.url.clone(), feed.vpath.clone()) {
+                        (Some(url), Some(vpath)) => (url, vpath),
+                        _ => return None,
+                    };
+                    let (schedule_key, schedule) =
+                        Self::feed_schedule(&creator, &key, &feed, block_number);
+                    if schedule.next_fetch > block_number {
+                        return None;
+                    }
+                    Some(DueFeed { key, url, vpath, feed, schedule_key, schedule })
+                })
+                // Endpoints that keep failing don't eat the deadline budget of every run.
+                .filter(|due| Self::endpoint_health(&due.url).backoff_until <= block_number)
+                .collect();
 
+        // The most overdue feeds go first, the rest is left to the next runs.
+        feeds.sort_by(|a, b| a.schedule.next_fetch.cmp(&b.schedule.next_fetch));
+        feeds.truncate(MAX_FEEDS_PER_RUN);
+        let due = feeds.len() as u32;
+
+        // Feeds sharing an endpoint are fetched and parsed only once, every vpath of the
+        // endpoint is extracted in the same pass over the response.
+        let mut url_indices = BTreeMap::<&[u8], usize>::new();
+        let mut urls: Vec<&[u8]> = Vec::new();
+        let mut url_vpaths: Vec<Vec<&[u8]>> = Vec::new();
+        let feed_slots: Vec<(usize, usize)> = feeds
+            .iter()
+            .map(|due| {
+                let url_index = *url_indices.entry(due.url.as_slice()).or_insert_with(|| {
+                    urls.push(due.url.as_slice());
+                    url_vpaths.push(Vec::new());
+                    urls.len() - 1
+                });
+                let vpaths = &mut url_vpaths[url_index];
+                vpaths.push(due.vpath.as_slice());
+                (url_index, vpaths.len() - 1)
+            })
+            .collect();
+
+        // Every request is sent up front so the worker only waits for the slowest endpoint.
+        // While the native fetcher of the node is running, it does the fetching instead and the
+        // values it fetched for the previous run are used. `None` stands for an endpoint whose
+        // values are not there yet, its feeds being left due.
+        let now = sp_io::offchain::timestamp().unix_millis();
+        let mut fetches = Vec::new();
+        let extracted: Vec<Option<Result<Vec<Option<i64>>, &'static str>>> =
+            if native_fetch::is_alive(now) {
+                let endpoints: Vec<(&[u8], Vec<&[u8]>)> =
+                    urls.iter().copied().zip(url_vpaths.iter().cloned()).collect();
+                let max_response_size = T::MaxResponseSize::get();
+                native_fetch::request(OFFCHAIN_NAMESPACE, &endpoints, max_response_size, now)
+                    .into_iter()
+                    .zip(urls.iter())
+                    .map(|(result, url)| {
+                        let (latency, ivals) = result?;
+                        Self::record_endpoint_health(url, block_number, latency, ivals.is_some());
+                        fetches.push(EndpointFetch {
+                            url: url.to_vec(),
+                            latency,
+                            success: ivals.is_some(),
+                            values: ivals.as_ref().map_or(0, |ivals| ivals.iter().flatten().count() as u32),
+                        });
+                        Some(ivals.ok_or("Failed fetch http"))
+                    })
+                    .collect()
+            } else {
+                let responses = Self::fetch_http_get_results(&urls);
+                urls.iter()
+                    .zip(url_vpaths.iter())
+                    .zip(responses)
+                    .map(|((url, vpaths), (response, latency))| {
+                        let fvals = response
+                            .map_err(|_| "Failed fetch http")
+                            .and_then(|response| Self::extract_feed_values(response, vpaths));
+                        Self::record_endpoint_health(url, block_number, latency, fvals.is_ok());
+                        fetches.push(EndpointFetch {
+                            url: url.to_vec(),
+                            latency,
+                            success: fvals.is_ok(),
+                            values: fvals.as_ref().map_or(0, |fvals| fvals.iter().flatten().count() as u32),
+                        });
+                        Some(fvals.map(|fvals| {
+                            fvals.into_iter().map(|fval| fval.map(native_fetch::to_fixed)).collect()
+                        }))
+                    })
+                    .collect()
+            };
+
+        // A failing feed is skipped, every value fetched successfully is still submitted.
         let mut values = Vec::<(Vec<u8>, i64)>::new();
-        for (acc, key, val) in <ApiFeeds<T> as IterableStorageDoubleMap<_, _, _>>::iter() {
-            // let mut response :Vec<u8>;
-            if val.url.is_some() && val.vpath.is_some() {
-                let vpath = val.vpath.unwrap();
-                let response = Self::fetch_http_get_result(val.url.clone().unwrap())
-                    .map_err(|_| "Failed fetch http")?;
-                let res_json :JValue = serde_json::from_slice(&response)
-                    .map_err(|_| "Response JSON was not well-formatted")?;
-                let path = str::from_utf8(&vpath)
-                    .map_err(|_| "vpath contain invalid utf8 string")?;
-                let fval = res_json.pointer(path)
-                    .ok_or("vpath error")?
-                    .as_f64()
-                    .ok_or("vpath value type error")?;
-
-                // We only store int, so every float will be convert to int with 6 decimals pad
-                let ival :i64 = (fval * 1000000.0) as i64;
-                values.push((key.clone(), ival));
+        let mut submitting = Vec::new();
+        for (mut due, (url_index, vpath_index)) in feeds.into_iter().zip(feed_slots) {
+            let ival = match extracted.get(url_index) {
+                // Not fetched by the native fetcher yet, the feed is fetched again.
+                Some(None) => continue,
+                Some(Some(ivals)) => ivals
+                    .as_ref()
+                    .map_err(|e| *e)
+                    .and_then(|ivals| ivals.get(vpath_index).copied().flatten().ok_or("vpath error")),
+                None => Err("Missing response"),
+            };
+
+            due.schedule.next_fetch =
+                block_number + due.feed.update_interval.max(One::one());
+            match ival {
+                Ok(ival) => {
+                    // Values that barely moved are only submitted on heartbeat.
+                    if Self::should_submit(&due.feed, &due.schedule, ival, block_number) {
+                        values.push((due.key.clone(), ival));
+                        submitting.push((due.schedule_key.clone(), due.schedule.clone(), ival));
+                    }
+                },
+                Err(e) => log::warn!("Skip feed {:?}: {}", str::from_utf8(&due.key), e),
             }
+            StorageValueRef::persistent(&due.schedule_key).set(&due.schedule);
         }
 
+        let mut submitted = false;
         if values.len() > 0 {
             if let Some(para_id) = <KylinParaId<T>>::get() {
                 // write data to chain
@@ -427,90 +745,318 @@ where T::AccountId: AsRef<[u8]>
                 });
                 for (acc, res) in &results {
                     match res {
-                        Ok(()) => log::info!("[{:?}] Submitted data", acc.id),
+                        Ok(()) => {
+                            log::info!("[{:?}] Submitted data", acc.id);
+                            submitted = true;
+                        },
                         Err(e) => log::error!("[{:?}] Failed to submit transaction: {:?}", acc.id, e),
                     }
                 }
             }
         }
 
+        // The heartbeat and deviation are measured from the last value actually submitted, a
+        // failed submission leaves the values due for the next fetch.
+        if submitted {
+            for (schedule_key, mut schedule, ival) in submitting {
+                schedule.last_submitted = Some((ival, block_number));
+                StorageValueRef::persistent(&schedule_key).set(&schedule);
+            }
+        }
+
+        let finished_at = sp_io::offchain::timestamp();
+        offchain_metrics::record_run(
+            OFFCHAIN_NAMESPACE,
+            &WorkerRun {
+                finished_at: finished_at.unix_millis(),
+                duration: finished_at.diff(&started_at).millis(),
+                due,
+                submitted: if submitted { values.len() as u32 } else { 0 },
+                fetches,
+            },
+        );
+
         Ok(())
     }
 
-    fn fetch_http_get_result(url: Vec<u8>) -> Result<Vec<u8>, http::Error> {
+    /// Fetch every url concurrently and return the responses in the same order, along with the
+    /// latency of each request in milliseconds.
+    ///
+    /// All requests are sent before any of them is awaited, and they share a single deadline,
+    /// so the worker wall time is bounded by the slowest endpoint rather than by their sum.
+    fn fetch_http_get_results(urls: &[&[u8]]) -> Vec<(Result<http::Response, http::Error>, u64)> {
         // We want to keep the offchain worker execution time reasonable, so we set a hard-coded
-        // deadline to 2s to complete the external call.
+        // deadline to 10s to complete all the external calls.
         // You can also wait idefinitely for the response, however you may still get a timeout
         // coming from the host machine.
-        let deadline = sp_io::offchain::timestamp().add(Duration::from_millis(10_000));
-        // Initiate an external HTTP GET request.
+        let start = sp_io::offchain::timestamp();
+        let deadline = start.add(Duration::from_millis(10_000));
+
+        // Initiate the external HTTP GET requests.
         // This is using high-level wrappers from `sp_runtime`, for the low-level calls that
         // you can find in `sp_io`. The API is trying to be similar to `reqwest`, but
         // since we are running in a custom WASM execution environment we can't simply
         // import the library here.
-        let request = http::Request::get(str::from_utf8(&url).unwrap());
-
-        // We set the deadline for sending of the request, note that awaiting response can§
-        // have a separate deadline. Next we send the request, before that it's also possible
-        // to alter request headers or stream body content in case of non-GET requests.
-        let pending = request
-            .deadline(deadline)
-            .send()
-            .map_err(|_| http::Error::IoError)?;
-
-        // The request is already being processed by the host, we are free to do anything
-        // else in the worker (we can send multiple concurrent requests too).
-        // At some point however we probably want to check the response though,
-        // so we can block current thread and wait for it to finish.
-        // Note that since the request is being driven by the host, we don't have to wait
-        // for the request to have it complete, we will just not read the response.
-        let response = pending
-            .try_wait(deadline)
-            .map_err(|_| http::Error::DeadlineReached)??;
+        // The requests are driven by the host, so they are processed concurrently while
+        // we keep on sending the next ones.
+        let mut results: Vec<(Result<http::Response, http::Error>, u64)> = Vec::with_capacity(urls.len());
+        let mut pending = Vec::with_capacity(urls.len());
+        for (index, url) in urls.iter().enumerate() {
+            let sent = str::from_utf8(url)
+                .map_err(|_| http::Error::Unknown)
+                .and_then(|url| {
+                    http::Request::get(url)
+                        .deadline(deadline)
+                        .send()
+                        .map_err(|_| http::Error::IoError)
+                });
+            match sent {
+                Ok(request) => {
+                    pending.push((index, request));
+                    results.push((Err(http::Error::DeadlineReached), 0));
+                },
+                Err(e) => results.push((Err(e), 0)),
+            }
+        }
+
+        // Wait for the requests in short rounds until all of them have completed or the shared
+        // deadline is reached, so the latency of every endpoint can be measured.
+        // Requests still pending at the deadline keep their `DeadlineReached` error.
+        while !pending.is_empty() {
+            let now = sp_io::offchain::timestamp();
+            if now >= deadline {
+                break;
+            }
+            let poll_until = now.add(Duration::from_millis(HTTP_POLL_INTERVAL_MS)).min(deadline);
+
+            let (indices, requests): (Vec<usize>, Vec<http::PendingRequest>) =
+                pending.into_iter().unzip();
+            let responses = http::PendingRequest::try_wait_all(requests, poll_until);
+            let latency = sp_io::offchain::timestamp().diff(&start).millis();
+
+            pending = Vec::new();
+            for (index, response) in indices.into_iter().zip(responses) {
+                match response {
+                    Ok(response) => results[index] = (response, latency),
+                    Err(request) => pending.push((index, request)),
+                }
+            }
+        }
+        for (index, _) in pending {
+            results[index].1 = deadline.diff(&start).millis();
+        }
+
+        results
+    }
 
+    /// Check the status code and extract the number at each of the `vpaths` of a JSON response.
+    ///
+    /// The body is streamed through the extractor rather than collected, so a response is never
+    /// held in memory and reading stops as soon as it exceeds `MaxResponseSize`.
+    fn extract_feed_values(
+        response: http::Response,
+        vpaths: &[&[u8]],
+    ) -> Result<Vec<Option<f64>>, &'static str> {
         // Let's check the status code before we proceed to reading the response.
         if response.code != 200 {
             log::info!("Unexpected status code: {}", response.code);
-            return Err(http::Error::Unknown);
+            return Err("Failed fetch http");
         }
 
-        // Next we want to fully read the response body and collect it to a vector of bytes.
-        // Note that the return object allows you to read the body in chunks as well
-        // with a way to control the deadline.
-        let body = response.body().collect::<Vec<u8>>();
-        // Create a str slice from the body.
-        let body_str = sp_std::str::from_utf8(&body).map_err(|_| {
-            log::info!("No UTF8 body");
-            http::Error::Unknown
-        })?;
-
-        Ok(body_str.clone().as_bytes().to_vec())
+        let mut body = response.body();
+        let fvals = extract_numbers(&mut body, vpaths, T::MaxResponseSize::get() as usize);
+        if body.error().is_some() {
+            return Err("Failed fetch http");
+        }
+        fvals.map_err(|e| match e {
+            JsonError::TooLarge => "Response exceeds the maximum size",
+            JsonError::TooDeep | JsonError::Malformed => "Response JSON was not well-formatted",
+        })
     }
 
-    fn feed_data_to_parachain(para_id: ParaId, values: Vec<(Vec<u8>, i64)>) -> DispatchResult {
-        let remark = KylinXcmCall::KylinOraclePallet(KylinOracleFunc::xcm_feed_data {
-            values,
-        });
-        match T::XcmSender::send_xcm(
-            (
-                1,
-                Junction::Parachain(para_id.into()),
-            ),
-            Xcm(vec![Transact {
-                origin_type: OriginKind::Native,
-                require_weight_at_most: 1_000_000_000,
-                call: remark.encode().into(),
-            }]),
-        ) {
-            Ok(()) => {
-                Self::deposit_event(Event::FeedDataSent(para_id))
-            },
-            Err(e) => {
-                Self::deposit_event(Event::FeedDataError(e, para_id))
+    /// Read the offchain schedule of a feed, along with its offchain storage key.
+    ///
+    /// A feed seen for the first time is due at a block derived from its hash within its
+    /// update interval, so that feeds sharing an interval are spread evenly across blocks.
+    fn feed_schedule(
+        creator: &T::AccountId,
+        key: &Vec<u8>,
+        feed: &ApiFeed<T::BlockNumber>,
+        block_number: T::BlockNumber,
+    ) -> (Vec<u8>, FeedSchedule<T::BlockNumber>) {
+        let hash = (creator, key).using_encoded(sp_io::hashing::blake2_128);
+        let mut schedule_key = FEED_SCHEDULE_PREFIX.to_vec();
+        schedule_key.extend_from_slice(&hash);
+
+        let schedule = StorageValueRef::persistent(&schedule_key)
+            .get::<FeedSchedule<T::BlockNumber>>()
+            .ok()
+            .flatten()
+            .unwrap_or_else(|| {
+                let interval: u32 = feed.update_interval.unique_saturated_into();
+                let phase = u32::from_le_bytes([hash[0], hash[1], hash[2], hash[3]]) % interval.max(1);
+                FeedSchedule { next_fetch: block_number + phase.into(), last_submitted: None }
+            });
+        (schedule_key, schedule)
+    }
+
+    /// Whether a freshly fetched value must be submitted, i.e. if the heartbeat of the feed has
+    /// elapsed or the value deviates from the last submitted one by at least the feed deviation.
+    fn should_submit(
+        feed: &ApiFeed<T::BlockNumber>,
+        schedule: &FeedSchedule<T::BlockNumber>,
+        value: i64,
+        block_number: T::BlockNumber,
+    ) -> bool {
+        deviation::is_due(schedule.last_submitted, value, block_number, feed.heartbeat, feed.deviation)
+    }
+
+    /// Combine the values fed in the block and forward to each Oracle chain the ones that
+    /// deviate from the last forwarded value or whose heartbeat elapsed, then the values combined
+    /// but held back of the keys whose heartbeat is due in the block.
+    ///
+    /// A key fed no value since it was last forwarded has no heartbeat, so that the Oracle chain
+    /// sees its source go quiet. It is forwarded again once a value is fed.
+    fn forward_pending_values(block_number: T::BlockNumber) {
+        let mut forwarded = BTreeMap::<ParaId, Vec<(Vec<u8>, i64)>>::new();
+        for (para_id, key, values) in PendingValues::<T>::drain() {
+            let last = Forwarded::<T>::get(para_id, &key);
+            let combined = match T::CombineData::combine_data(&key, values, last.map(|(last, _)| last)) {
+                Some(combined) => combined,
+                None => continue,
+            };
+            let due = match last {
+                None => true,
+                // Not enough values to combine, the last value is not forwarded again.
+                Some((last, _)) if last == combined => false,
+                Some((last, at)) => deviation::is_due(
+                    Some((last.value, at)),
+                    combined.value,
+                    block_number,
+                    T::ForwardHeartbeat::get(),
+                    T::ForwardDeviation::get(),
+                ),
+            };
+            if due {
+                Self::record_forwarded(&mut forwarded, para_id, key, combined, block_number);
+            } else if last.map_or(false, |(last, _)| last != combined) {
+                Unforwarded::<T>::insert(para_id, &key, combined);
+            }
+        }
+        PendingCount::<T>::kill();
+
+        let heartbeat = T::ForwardHeartbeat::get();
+        for (para_id, key) in HeartbeatDue::<T>::take(block_number) {
+            match Forwarded::<T>::get(para_id, &key) {
+                Some((_, at)) if at + heartbeat == block_number => {
+                    if let Some(value) = Unforwarded::<T>::take(para_id, &key) {
+                        Self::record_forwarded(&mut forwarded, para_id, key, value, block_number)
+                    }
+                },
+                // Forwarded again since, its heartbeat is due later.
+                _ => (),
+            }
+        }
+
+        for (para_id, values) in forwarded {
+            Self::feed_data_to_parachain(para_id, values);
+        }
+    }
+
+    /// Record `value` as forwarded for `key` to `para_id` in the block, and schedule its
+    /// heartbeat.
+    fn record_forwarded(
+        forwarded: &mut BTreeMap<ParaId, Vec<(Vec<u8>, i64)>>,
+        para_id: ParaId,
+        key: Vec<u8>,
+        value: TimestampedValue,
+        block_number: T::BlockNumber,
+    ) {
+        Forwarded::<T>::insert(para_id, &key, (value, block_number));
+        Unforwarded::<T>::remove(para_id, &key);
+        let heartbeat = T::ForwardHeartbeat::get();
+        if !heartbeat.is_zero() {
+            HeartbeatDue::<T>::append(block_number + heartbeat, (para_id, key.clone()));
+        }
+        forwarded.entry(para_id).or_default().push((key, value.value));
+    }
+
+    fn endpoint_health_key(url: &[u8]) -> Vec<u8> {
+        let mut key = ENDPOINT_HEALTH_PREFIX.to_vec();
+        key.extend_from_slice(&sp_io::hashing::blake2_128(url));
+        key
+    }
+
+    /// Read the health of the endpoint `url` from the offchain local storage.
+    pub fn endpoint_health(url: &[u8]) -> EndpointHealth<T::BlockNumber> {
+        let key = Self::endpoint_health_key(url);
+        StorageValueRef::persistent(&key)
+            .get::<EndpointHealth<T::BlockNumber>>()
+            .ok()
+            .flatten()
+            .unwrap_or_default()
+    }
+
+    /// Record the outcome of a fetch of `url` in the offchain local storage.
+    ///
+    /// After `ENDPOINT_BACKOFF_THRESHOLD` consecutive failures the endpoint is skipped for an
+    /// exponentially growing number of blocks, capped at `ENDPOINT_MAX_BACKOFF`.
+    fn record_endpoint_health(url: &[u8], block_number: T::BlockNumber, latency: u64, success: bool) {
+        let key = Self::endpoint_health_key(url);
+        let val = StorageValueRef::persistent(&key);
+        let res = val.mutate(
+            |health: Result<Option<EndpointHealth<T::BlockNumber>>, StorageRetrievalError>| {
+                let mut health = health.ok().flatten().unwrap_or_default();
+                health.last_latency = latency;
+                if success {
+                    health.consecutive_failures = 0;
+                } else {
+                    health.consecutive_failures = health.consecutive_failures.saturating_add(1);
+                    if health.consecutive_failures >= ENDPOINT_BACKOFF_THRESHOLD {
+                        let exponent = health.consecutive_failures - ENDPOINT_BACKOFF_THRESHOLD;
+                        let backoff = 1u32
+                            .checked_shl(exponent)
+                            .unwrap_or(ENDPOINT_MAX_BACKOFF)
+                            .min(ENDPOINT_MAX_BACKOFF);
+                        health.backoff_until = block_number + backoff.into();
+                    }
+                }
+                Ok::<_, ()>(health)
             },
+        );
+        if res.is_err() {
+            log::debug!("Endpoint health concurrently modified, skip");
         }
+    }
 
-        Ok(())
+    /// Send `values` to the Oracle chain `para_id`, packed into messages of at most
+    /// `XcmWeightBudget` each.
+    fn feed_data_to_parachain(para_id: ParaId, values: Vec<(Vec<u8>, i64)>) {
+        let weight_per_value = T::XcmWeightPerValue::get().max(1);
+        let values_per_message = (T::XcmWeightBudget::get() / weight_per_value).max(1) as usize;
+        for values in values.chunks(values_per_message) {
+            let remark = KylinXcmCall::KylinOraclePallet(KylinOracleFunc::xcm_feed_data {
+                values: values.to_vec(),
+            });
+            match T::XcmSender::send_xcm(
+                (
+                    1,
+                    Junction::Parachain(para_id.into()),
+                ),
+                Xcm(vec![Transact {
+                    origin_type: OriginKind::Native,
+                    require_weight_at_most: weight_per_value.saturating_mul(values.len() as u64),
+                    call: remark.encode().into(),
+                }]),
+            ) {
+                Ok(()) => {
+                    Self::deposit_event(Event::FeedDataSent(para_id))
+                },
+                Err(e) => {
+                    Self::deposit_event(Event::FeedDataError(e, para_id))
+                },
+            }
+        }
     }
 
 }
@@ -0,0 +1,56 @@
+//! Storage migrations for the kylin-reporter pallet.
+
+use super::*;
+use frame_support::traits::{GetStorageVersion, StorageVersion};
+
+/// Migrate the pallet storage to the current storage version.
+pub fn migrate<T: Config>() -> Weight
+where
+	T::AccountId: AsRef<[u8]> + ToHex + Decode,
+{
+	let on_chain = Pallet::<T>::on_chain_storage_version();
+	let mut weight = T::DbWeight::get().reads(1);
+
+	if on_chain < 1 {
+		weight = weight.saturating_add(v1::migrate::<T>());
+	}
+
+	if on_chain < Pallet::<T>::current_storage_version() {
+		Pallet::<T>::current_storage_version().put::<Pallet<T>>();
+		weight = weight.saturating_add(T::DbWeight::get().writes(1));
+	}
+	weight
+}
+
+/// `ApiFeed` gained the `update_interval`, `heartbeat` and `deviation` schedule fields.
+pub mod v1 {
+	use super::*;
+
+	#[derive(Decode)]
+	struct OldApiFeed<BlockNumber> {
+		requested_block_number: BlockNumber,
+		url: Option<Vec<u8>>,
+		vpath: Option<Vec<u8>>,
+	}
+
+	/// Existing feeds keep being fetched and submitted on every block.
+	pub fn migrate<T: Config>() -> Weight
+	where
+		T::AccountId: AsRef<[u8]> + ToHex + Decode,
+	{
+		let mut translated = 0u64;
+		ApiFeeds::<T>::translate::<OldApiFeed<T::BlockNumber>, _>(|_, _, old| {
+			translated += 1;
+			Some(ApiFeed {
+				requested_block_number: old.requested_block_number,
+				url: old.url,
+				vpath: old.vpath,
+				update_interval: Zero::zero(),
+				heartbeat: Zero::zero(),
+				deviation: Permill::zero(),
+			})
+		});
+		log::info!("kylin-reporter: migrated to v1, translated {} api feeds", translated);
+		T::DbWeight::get().reads_writes(translated, translated)
+	}
+}
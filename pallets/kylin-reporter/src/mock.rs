@@ -0,0 +1,230 @@
+use crate as kylin_reporter;
+use crate::*;
+use frame_support::{
+	parameter_types,
+	traits::{ConstU16, ConstU32, ConstU64, Everything},
+};
+use sp_core::{
+	sr25519::{self, Signature},
+	H256,
+};
+use sp_runtime::{
+	testing::{Header, TestXt},
+	traits::{BlakeTwo256, Extrinsic as ExtrinsicT, IdentityLookup, Verify},
+};
+use std::cell::RefCell;
+
+type UncheckedExtrinsic = frame_system::mocking::MockUncheckedExtrinsic<Test>;
+type Block = frame_system::mocking::MockBlock<Test>;
+
+pub type AccountId = sr25519::Public;
+pub type Balance = u64;
+pub type Extrinsic = TestXt<RuntimeCall, ()>;
+
+/// Timestamp of the first block of the tests, in milliseconds.
+pub const INIT_TIMESTAMP: u64 = 1_000_000;
+/// Parachain ID of the Kylin Oracle chain of the tests.
+pub const KYLIN_ID: u32 = 2000;
+
+// Configure a mock runtime to test the pallet.
+frame_support::construct_runtime!(
+	pub enum Test where
+		Block = Block,
+		NodeBlock = Block,
+		UncheckedExtrinsic = UncheckedExtrinsic,
+	{
+		System: frame_system::{Pallet, Call, Config, Storage, Event<T>},
+		Balances: pallet_balances::{Pallet, Call, Storage, Config<T>, Event<T>},
+		Timestamp: pallet_timestamp::{Pallet, Call, Storage, Inherent},
+		CumulusXcm: cumulus_pallet_xcm::{Pallet, Event<T>, Origin},
+		KylinReporter: kylin_reporter::{Pallet, Call, Storage, Event<T>, ValidateUnsigned},
+	}
+);
+
+impl frame_system::Config for Test {
+	type BaseCallFilter = Everything;
+	type BlockWeights = ();
+	type BlockLength = ();
+	type DbWeight = ();
+	type RuntimeOrigin = RuntimeOrigin;
+	type RuntimeCall = RuntimeCall;
+	type Index = u64;
+	type BlockNumber = u64;
+	type Hash = H256;
+	type Hashing = BlakeTwo256;
+	type AccountId = AccountId;
+	type Lookup = IdentityLookup<Self::AccountId>;
+	type Header = Header;
+	type RuntimeEvent = RuntimeEvent;
+	type BlockHashCount = ConstU64<250>;
+	type Version = ();
+	type PalletInfo = PalletInfo;
+	type AccountData = pallet_balances::AccountData<Balance>;
+	type OnNewAccount = ();
+	type OnKilledAccount = ();
+	type SystemWeightInfo = ();
+	type SS58Prefix = ConstU16<42>;
+	type OnSetCode = ();
+	type MaxConsumers = ConstU32<16>;
+}
+
+impl pallet_balances::Config for Test {
+	type Balance = Balance;
+	type RuntimeEvent = RuntimeEvent;
+	type DustRemoval = ();
+	type ExistentialDeposit = ConstU64<1>;
+	type AccountStore = System;
+	type WeightInfo = ();
+	type MaxLocks = ();
+	type MaxReserves = ConstU32<50>;
+	type ReserveIdentifier = [u8; 8];
+}
+
+impl pallet_timestamp::Config for Test {
+	type Moment = u64;
+	type OnTimestampSet = ();
+	type MinimumPeriod = ConstU64<1>;
+	type WeightInfo = ();
+}
+
+impl cumulus_pallet_xcm::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type XcmExecutor = ();
+}
+
+impl frame_system::offchain::SigningTypes for Test {
+	type Public = <Signature as Verify>::Signer;
+	type Signature = Signature;
+}
+
+impl<LocalCall> frame_system::offchain::SendTransactionTypes<LocalCall> for Test
+where
+	RuntimeCall: From<LocalCall>,
+{
+	type OverarchingCall = RuntimeCall;
+	type Extrinsic = Extrinsic;
+}
+
+impl<LocalCall> frame_system::offchain::CreateSignedTransaction<LocalCall> for Test
+where
+	RuntimeCall: From<LocalCall>,
+{
+	fn create_transaction<C: frame_system::offchain::AppCrypto<Self::Public, Self::Signature>>(
+		call: RuntimeCall,
+		_public: <Signature as Verify>::Signer,
+		_account: AccountId,
+		nonce: u64,
+	) -> Option<(RuntimeCall, <Extrinsic as ExtrinsicT>::SignaturePayload)> {
+		Some((call, (nonce, ())))
+	}
+}
+
+thread_local! {
+	static MEMBERS: RefCell<Vec<AccountId>> = RefCell::new(Vec::new());
+	static SENT_XCM: RefCell<Vec<(MultiLocation, Xcm<()>)>> = RefCell::new(Vec::new());
+}
+
+/// Oracle operators, as set by `set_members`.
+pub struct Members;
+impl SortedMembers<AccountId> for Members {
+	fn sorted_members() -> Vec<AccountId> {
+		MEMBERS.with(|members| members.borrow().clone())
+	}
+
+	#[cfg(feature = "runtime-benchmarks")]
+	fn add(who: &AccountId) {
+		let mut members = Self::sorted_members();
+		members.push(who.clone());
+		set_members(members);
+	}
+}
+
+pub fn set_members(mut members: Vec<AccountId>) {
+	members.sort();
+	MEMBERS.with(|m| *m.borrow_mut() = members);
+}
+
+/// Records every message sent.
+pub struct TestSendXcm;
+impl SendXcm for TestSendXcm {
+	fn send_xcm(dest: impl Into<MultiLocation>, msg: Xcm<()>) -> SendResult {
+		SENT_XCM.with(|sent| sent.borrow_mut().push((dest.into(), msg)));
+		Ok(())
+	}
+}
+
+/// The values forwarded so far by each message to the Oracle chains, oldest first.
+pub fn sent_feeds() -> Vec<(ParaId, Vec<(Vec<u8>, i64)>)> {
+	SENT_XCM.with(|sent| {
+		sent.borrow()
+			.iter()
+			.map(|(dest, msg)| {
+				let para_id = match dest {
+					MultiLocation { parents: 1, interior: X1(Parachain(id)) } => ParaId::from(*id),
+					_ => panic!("unexpected destination {:?}", dest),
+				};
+				let call = match msg.0.as_slice() {
+					[Transact { call, .. }] => call.clone().into_encoded(),
+					_ => panic!("unexpected message {:?}", msg),
+				};
+				match KylinXcmCall::decode(&mut &call[..]).expect("a kylin-oracle call") {
+					KylinXcmCall::KylinOraclePallet(KylinOracleFunc::xcm_feed_data { values }) => {
+						(para_id, values)
+					},
+					call => panic!("unexpected call {:?}", call),
+				}
+			})
+			.collect()
+	})
+}
+
+pub fn clear_sent_xcm() {
+	SENT_XCM.with(|sent| sent.borrow_mut().clear());
+}
+
+parameter_types! {
+	pub const ForwardDeviation: Permill = Permill::from_percent(1);
+}
+
+impl kylin_reporter::Config for Test {
+	type RuntimeEvent = RuntimeEvent;
+	type AuthorityId = crypto::TestAuthId;
+	type RuntimeCall = RuntimeCall;
+	type RuntimeOrigin = RuntimeOrigin;
+	type XcmSender = TestSendXcm;
+	type WeightInfo = ();
+	type Currency = Balances;
+	type Members = Members;
+	type MaxResponseSize = ConstU32<1024>;
+	type UnixTime = Timestamp;
+	type CombineData = MedianCombineData<ConstU32<1>>;
+	type ForwardDeviation = ForwardDeviation;
+	type ForwardHeartbeat = ConstU64<5>;
+	// Messages of three values at most.
+	type XcmWeightPerValue = ConstU64<1_000>;
+	type XcmWeightBudget = ConstU64<3_000>;
+	type MaxPendingValues = ConstU32<8>;
+}
+
+pub fn account(seed: u8) -> AccountId {
+	sr25519::Public::from_raw([seed; 32])
+}
+
+/// Move to the next block, `millis` later.
+pub fn next_block(millis: u64) {
+	System::set_block_number(System::block_number() + 1);
+	Timestamp::set_timestamp(Timestamp::now() + millis);
+}
+
+// Build genesis storage according to the mock runtime.
+pub fn new_test_ext() -> sp_io::TestExternalities {
+	let t = frame_system::GenesisConfig::default().build_storage::<Test>().unwrap();
+	let mut ext = sp_io::TestExternalities::new(t);
+	ext.execute_with(|| {
+		set_members(vec![account(1), account(2), account(3)]);
+		clear_sent_xcm();
+		System::set_block_number(1);
+		Timestamp::set_timestamp(INIT_TIMESTAMP);
+	});
+	ext
+}
@@ -1,635 +1,390 @@
-
-use crate as kylin_oracle;
-use crate::*;
-use codec::Decode;
+use crate::{mock::*, *};
 use frame_support::{
-    parameter_types,
-    traits::Everything,
-    weights::{IdentityFee, Weight, ConstantMultiplier},
-};
-
-use sp_core::{
-    offchain::{testing, OffchainWorkerExt, TransactionPoolExt},
-    sr25519::Signature,
-    H256,
+	assert_noop, assert_ok,
+	traits::{ConstU32, Hooks},
 };
+use kylin_support::offchain_simulation::{Endpoint, RunReport, Simulation};
+use sp_io::TestExternalities;
 use sp_keystore::{testing::KeyStore, KeystoreExt, SyncCryptoStore};
-use sp_std::str;
-use sp_std::vec::Vec;
 use std::sync::Arc;
 
-use sp_runtime::{
-    testing::{Header, TestXt},
-    traits::{BlakeTwo256, Extrinsic as ExtrinsicT, IdentifyAccount, IdentityLookup, Verify},
-};
-use xcm_builder::{
-    AllowUnpaidExecutionFrom, EnsureXcmOrigin, FixedWeightBounds, SignedToAccountId32,
-    LocationInverter
-};
-
-use xcm_executor::{
-    traits::{TransactAsset, WeightTrader},
-    Assets, XcmExecutor,
-};
-
-use sp_core::{ sr25519, Pair, Public};
-
-type UncheckedExtrinsic = frame_system::mocking::MockUncheckedExtrinsic<Test>;
-type Block = frame_system::mocking::MockBlock<Test>;
-type AccountPublic = <Signature as Verify>::Signer;
-
-frame_support::construct_runtime!(
-    pub enum Test where
-        Block = Block,
-        NodeBlock = Block,
-        UncheckedExtrinsic = UncheckedExtrinsic,
-    {
-        System: frame_system::{Pallet, Call, Config, Storage, Event<T>},
-        Balances: pallet_balances::{Pallet, Call, Storage, Config<T>, Event<T>},
-        KylinOracle: kylin_oracle::{Pallet, Call, Storage, Event<T>, ValidateUnsigned},
-        Timestamp: pallet_timestamp::{Pallet, Call, Storage, Inherent},
-        TransactionPayment: pallet_transaction_payment::{Pallet, Storage},
-        XcmPallet: pallet_xcm::{Pallet, Call, Storage, Event<T>, Origin} = 51,
-        CumulusXcm: cumulus_pallet_xcm::{Pallet, Call, Event<T>, Origin} = 52,
-
-    }
-);
-
-parameter_types! {
-    pub const TransactionByteFee: u64 = 1;
-    pub const OperationalFeeMultiplier: u8 = 5;
-}
-pub type Balance = u64;
-
-impl pallet_transaction_payment::Config for Test {
-    type OnChargeTransaction = pallet_transaction_payment::CurrencyAdapter<Balances, ()>;
-    type OperationalFeeMultiplier = OperationalFeeMultiplier;
-    type LengthToFee = ConstantMultiplier<Balance, TransactionByteFee>;
-    type WeightToFee = IdentityFee<u64>;
-    type FeeMultiplierUpdate = ();
-}
-
-parameter_types! {
-    pub const BlockHashCount: u64 = 250;
-    pub BlockWeights: frame_system::limits::BlockWeights =
-        frame_system::limits::BlockWeights::simple_max(1024);
-    pub Ancestry: MultiLocation = Here.into();
-}
-pub type LocalOriginToLocation = SignedToAccountId32<Origin, AccountId, RelayNetwork>;
-pub type Barrier = AllowUnpaidExecutionFrom<Everything>;
-
-impl frame_system::Config for Test {
-    type BaseCallFilter = frame_support::traits::Everything;
-    type BlockWeights = ();
-    type BlockLength = ();
-    type DbWeight = ();
-    type Origin = Origin;
-    type Call = Call;
-    type Index = u64;
-    type BlockNumber = u64;
-    type Hash = H256;
-    type Hashing = BlakeTwo256;
-    type AccountId = sp_core::sr25519::Public;
-    type Lookup = IdentityLookup<Self::AccountId>;
-    type Header = Header;
-    type Event = Event;
-    type BlockHashCount = BlockHashCount;
-    type Version = ();
-    type PalletInfo = PalletInfo;
-    type AccountData = pallet_balances::AccountData<u64>;
-    type OnNewAccount = ();
-    type OnKilledAccount = ();
-    type SystemWeightInfo = ();
-    type SS58Prefix = ();
-    type OnSetCode = ();
-    type MaxConsumers = frame_support::traits::ConstU32<16>;
-}
-
-type Extrinsic = TestXt<Call, ()>;
-type AccountId = <<Signature as Verify>::Signer as IdentifyAccount>::AccountId;
-
-impl frame_system::offchain::SigningTypes for Test {
-    type Public = <Signature as Verify>::Signer;
-    type Signature = Signature;
+fn worker_ext(endpoints: Vec<Endpoint>) -> (TestExternalities, Simulation, AccountId) {
+	let mut ext = new_test_ext();
+	let simulation = Simulation::new(endpoints, INIT_TIMESTAMP, 7);
+	simulation.register(&mut ext);
+	let keystore = KeyStore::new();
+	let feeder =
+		SyncCryptoStore::sr25519_generate_new(&keystore, KEY_TYPE, Some("//Alice")).unwrap();
+	ext.register_extension(KeystoreExt(Arc::new(keystore)));
+	ext.execute_with(|| {
+		set_members(vec![feeder, account(1)]);
+		assert_ok!(KylinReporter::set_kylin_id(RuntimeOrigin::signed(feeder), KYLIN_ID.into()));
+	});
+	(ext, simulation, feeder)
 }
 
-impl<LocalCall> frame_system::offchain::SendTransactionTypes<LocalCall> for Test
-where
-    Call: From<LocalCall>,
-{
-    type OverarchingCall = Call;
-    type Extrinsic = Extrinsic;
+fn submit_feed(feeder: AccountId, key: &str, url: &str, vpath: &str) {
+	assert_ok!(KylinReporter::submit_api(
+		RuntimeOrigin::signed(feeder),
+		key.as_bytes().to_vec(),
+		url.as_bytes().to_vec(),
+		vpath.as_bytes().to_vec(),
+	));
 }
 
-parameter_types! {
-    pub const GracePeriod: u64 = 5;
-    pub const UnsignedInterval: u64 = 128;
-    pub const UnsignedPriority: u64 = 1 << 20;
+/// Run the offchain worker of block `block_number`.
+fn run_worker(
+	ext: &mut TestExternalities,
+	simulation: &Simulation,
+	block_number: u64,
+) -> RunReport {
+	simulation.run(ext, || KylinReporter::fetch_api_and_feed_data(block_number).unwrap())
 }
 
-parameter_types! {
-    pub const ExistentialDeposit: u64 = 5;
-    pub const MaxReserves: u32 = 50;
+/// The Oracle chain and the values fed by each transaction of `report`, the values sorted by key.
+fn fed_values(report: &RunReport) -> Vec<(ParaId, Vec<(Vec<u8>, i64)>)> {
+	report
+		.transactions
+		.iter()
+		.map(|tx| match Extrinsic::decode(&mut &tx[..]).unwrap().call {
+			RuntimeCall::KylinReporter(Call::feed_data { para_id, mut values }) => {
+				values.sort();
+				(para_id, values)
+			},
+			call => panic!("unexpected call {:?}", call),
+		})
+		.collect()
 }
 
-impl pallet_balances::Config for Test {
-    type Balance = u64;
-    type Event = Event;
-    type DustRemoval = ();
-    type ExistentialDeposit = ExistentialDeposit;
-    type AccountStore = System;
-    type WeightInfo = ();
-    type MaxLocks = ();
-    type MaxReserves = MaxReserves;
-    type ReserveIdentifier = [u8; 8];
+fn fed(values: &[(&str, i64)]) -> Vec<(ParaId, Vec<(Vec<u8>, i64)>)> {
+	let values = values.iter().map(|(key, value)| (key.as_bytes().to_vec(), *value)).collect();
+	vec![(KYLIN_ID.into(), values)]
 }
-pub struct DoNothingRouter;
-impl SendXcm for DoNothingRouter {
-    fn send_xcm(_dest: impl Into<MultiLocation>, _msg: Xcm<()>) -> SendResult {
-        Ok(())
-    }
-}
-// For testing the module, we construct a mock runtime.
 
-parameter_types! {
-    pub const MinimumPeriod: u64 = 1;
-}
-impl pallet_timestamp::Config for Test {
-    type Moment = u64;
-    type OnTimestampSet = ();
-    type MinimumPeriod = MinimumPeriod;
-    type WeightInfo = ();
+#[test]
+fn only_members_feed() {
+	new_test_ext().execute_with(|| {
+		assert_noop!(
+			KylinReporter::feed_data(
+				RuntimeOrigin::signed(account(9)),
+				KYLIN_ID.into(),
+				vec![(b"btc".to_vec(), 1)]
+			),
+			Error::<Test>::NoPermission
+		);
+	});
 }
 
-// pub trait Config: CreateSignedTransaction<Self> + frame_system::Config {}
-impl<LocalCall> frame_system::offchain::CreateSignedTransaction<LocalCall> for Test
-where
-    Call: From<LocalCall>,
-{
-    fn create_transaction<C: frame_system::offchain::AppCrypto<Self::Public, Self::Signature>>(
-        call: Call,
-        _public: <Signature as Verify>::Signer,
-        _account: AccountId,
-        nonce: u64,
-    ) -> Option<(Call, <Extrinsic as ExtrinsicT>::SignaturePayload)> {
-        Some((call, (nonce, ())))
-    }
+fn feed(who: u8, values: &[(&str, i64)]) {
+	let values = values.iter().map(|(key, value)| (key.as_bytes().to_vec(), *value)).collect();
+	assert_ok!(KylinReporter::feed_data(
+		RuntimeOrigin::signed(account(who)),
+		KYLIN_ID.into(),
+		values
+	));
 }
 
-parameter_types! {
-    // pub const RelayLocationson::X1(Parent);
-    pub const RelayNetwork: NetworkId = NetworkId::Kusama;
-    // pub RelayChainOrigin: Origin = cumulus_pallet_xcm::Origin::Relay.into();
-}
-impl kylin_oracle::Config for Test {
-    type Event = Event;
-    type AuthorityId = crypto::TestAuthId;
-    type Call = Call;
-    type Origin = Origin;
-    type XcmSender = DoNothingRouter;
-    type UnsignedPriority = UnsignedPriority;
-    type UnixTime = pallet_timestamp::Pallet<Test>;
-    type Currency = Balances;
-    type WeightInfo = ();
-    type EstimateCallFee = TransactionPayment;
+/// Finalize the current block and move to the next one.
+fn finalize() {
+	KylinReporter::on_finalize(System::block_number());
+	next_block(6_000);
 }
 
-parameter_types! {
-    pub const UnitWeightCost: u64 = 10;
-    pub const MaxInstructions: u32 = 100;
+fn forwarded(key: &str) -> Option<(i64, u64)> {
+	KylinReporter::forwarded(ParaId::from(KYLIN_ID), key.as_bytes().to_vec())
+		.map(|(last, at)| (last.value, at))
 }
 
-pub struct DummyWeightTrader;
-impl WeightTrader for DummyWeightTrader {
-    fn new() -> Self {
-        DummyWeightTrader
-    }
-
-    fn buy_weight(&mut self, _weight: Weight, _payment: Assets) -> Result<Assets, XcmError> {
-        Ok(Assets::default())
-    }
-}
-pub struct DummyAssetTransactor;
-impl TransactAsset for DummyAssetTransactor {
-    fn deposit_asset(_what: &MultiAsset, _who: &MultiLocation) -> XcmResult {
-        Ok(())
-    }
-
-    fn withdraw_asset(_what: &MultiAsset, _who: &MultiLocation) -> Result<Assets, XcmError> {
-        let asset: MultiAsset = (Parent, 100_000).into();
-        Ok(asset.into())
-    }
-}
-pub struct XcmConfig;
-impl xcm_executor::Config for XcmConfig {
-    type Call = Call;
-    type XcmSender = DoNothingRouter;
-    type AssetTransactor = DummyAssetTransactor;
-    type OriginConverter = pallet_xcm::XcmPassthrough<Origin>;
-    type IsReserve = ();
-    type IsTeleporter = ();
-    type LocationInverter = LocationInverter<Ancestry>;
-    type Barrier = Barrier;
-    type Weigher = FixedWeightBounds<UnitWeightCost, Call, MaxInstructions>;
-    type Trader = DummyWeightTrader;
-    type ResponseHandler = ();
-    type AssetTrap = XcmPallet;
-    type AssetClaims = XcmPallet;
-    type SubscriptionService = XcmPallet;
+#[test]
+fn values_fed_in_a_block_are_forwarded_combined_on_finalize() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 10_000)]);
+		feed(2, &[("btc", 10_200)]);
+		feed(3, &[("btc", 10_100), ("eth", 500)]);
+		assert!(sent_feeds().is_empty());
+
+		finalize();
+		let mut sent = sent_feeds();
+		sent[0].1.sort();
+		assert_eq!(sent, fed(&[("btc", 10_100), ("eth", 500)]));
+		assert_eq!(forwarded("btc"), Some((10_100, 1)));
+		assert_eq!(PendingValues::<Test>::iter().count(), 0);
+	});
 }
 
-parameter_types! {
-    pub static AdvertisedXcmVersion: xcm::prelude::XcmVersion = 2;
+#[test]
+fn values_within_the_deviation_are_not_forwarded() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 10_000)]);
+		finalize();
+		clear_sent_xcm();
+
+		// 0.5% off the last forwarded value.
+		feed(1, &[("btc", 10_050)]);
+		finalize();
+		assert!(sent_feeds().is_empty());
+		assert_eq!(forwarded("btc"), Some((10_000, 1)));
+
+		// 2% off.
+		feed(1, &[("btc", 10_200)]);
+		finalize();
+		assert_eq!(sent_feeds(), fed(&[("btc", 10_200)]));
+	});
 }
 
-impl pallet_xcm::Config for Test {
-    type Event = Event;
-    type SendXcmOrigin = EnsureXcmOrigin<Origin, LocalOriginToLocation>;
-    type XcmRouter = DoNothingRouter;
-    type LocationInverter = LocationInverter<Ancestry>;
-    type ExecuteXcmOrigin = EnsureXcmOrigin<Origin, LocalOriginToLocation>;
-    type XcmExecuteFilter = Everything;
-    type XcmExecutor = XcmExecutor<XcmConfig>;
-    type XcmTeleportFilter = Everything;
-    type Weigher = FixedWeightBounds<UnitWeightCost, Call, MaxInstructions>;
-    type XcmReserveTransferFilter = Everything;
-    type Origin = Origin;
-    type Call = Call;
-    const VERSION_DISCOVERY_QUEUE_SIZE: u32 = 100;
-    type AdvertisedXcmVersion = AdvertisedXcmVersion;
+#[test]
+fn a_held_back_value_is_forwarded_on_heartbeat() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 10_000)]);
+		finalize();
+		finalize();
+		// 0.5% off the last forwarded value.
+		feed(1, &[("btc", 10_050)]);
+		finalize();
+		clear_sent_xcm();
+
+		for _ in 4..6 {
+			finalize();
+		}
+		assert!(sent_feeds().is_empty());
+		// The heartbeat is charged at the start of the block it is due in.
+		assert!(
+			KylinReporter::on_initialize(6).ref_time() > KylinReporter::on_initialize(5).ref_time()
+		);
+
+		finalize();
+		assert_eq!(sent_feeds(), fed(&[("btc", 10_050)]));
+		assert_eq!(forwarded("btc"), Some((10_050, 6)));
+	});
 }
 
-impl cumulus_pallet_xcm::Config for Test {
-    type Event = Event;
-    type XcmExecutor = XcmExecutor<XcmConfig>;
+#[test]
+fn a_key_fed_no_value_is_not_forwarded_again() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 10_000)]);
+		finalize();
+		clear_sent_xcm();
+
+		// The heartbeat of block 1 is due at block 6, the source being quiet since.
+		for _ in 2..12 {
+			finalize();
+		}
+		assert!(sent_feeds().is_empty());
+		assert_eq!(forwarded("btc"), Some((10_000, 1)));
+		assert_eq!(HeartbeatDue::<Test>::iter().count(), 0);
+
+		// Once fed again, the value is forwarded as its heartbeat elapsed.
+		feed(1, &[("btc", 10_000)]);
+		finalize();
+		assert_eq!(sent_feeds(), fed(&[("btc", 10_000)]));
+		assert_eq!(forwarded("btc"), Some((10_000, 12)));
+	});
 }
 
 #[test]
-fn should_save_data_onchain_for_signed_data_submissions() {
-    const PHRASE: &str =
-        "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-
-    SyncCryptoStore::sr25519_generate_new(
-        &keystore,
-        kylin_oracle::KEY_TYPE,
-        Some(&format!("{}/hunter1", PHRASE)),
-    )
-    .unwrap();
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    mock_submit_response(&mut offchain_state.write());
-    let expected_response = br#"{"USD": 155.23}"#.to_vec();
-    t.execute_with(|| {
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_signed(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_signed {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, expected_response);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
+fn a_forwarded_deviation_postpones_the_heartbeat() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("btc", 10_000)]);
+		finalize();
+		finalize();
+		feed(1, &[("btc", 10_200)]);
+		finalize();
+		// Held back, 0.25% off the last forwarded value.
+		feed(1, &[("btc", 10_225)]);
+		finalize();
+		clear_sent_xcm();
+
+		// Blocks 5 to 7, the heartbeat of block 1 being due at block 6.
+		for _ in 5..8 {
+			finalize();
+		}
+		assert!(sent_feeds().is_empty());
+
+		finalize();
+		assert_eq!(sent_feeds(), fed(&[("btc", 10_225)]));
+		assert_eq!(forwarded("btc"), Some((10_225, 8)));
+	});
 }
 
 #[test]
-fn should_save_data_onchain_for_unsigned_submissions() {
-    // const PHRASE: &str =
-    // "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    mock_submit_response(&mut offchain_state.write());
-    let expected_response = br#"{"USD": 155.23}"#.to_vec();
-    t.execute_with(|| {
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_raw_unsigned(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_unsigned {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, expected_response);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
+fn forwarded_values_are_packed_into_messages_of_the_weight_budget() {
+	new_test_ext().execute_with(|| {
+		let values = [("a", 1), ("b", 2), ("c", 3), ("d", 4), ("e", 5), ("f", 6), ("g", 7)];
+		feed(1, &values);
+		finalize();
+
+		// Three values per message in the mock.
+		let sent = sent_feeds();
+		assert_eq!(sent.iter().map(|(_, values)| values.len()).collect::<Vec<_>>(), vec![3, 3, 1]);
+		assert!(sent.iter().all(|(para_id, _)| *para_id == ParaId::from(KYLIN_ID)));
+		let mut all: Vec<_> = sent.into_iter().flat_map(|(_, values)| values).collect();
+		all.sort();
+		assert_eq!(vec![(ParaId::from(KYLIN_ID), all)], fed(&values));
+	});
 }
 
 #[test]
-fn should_write_data_onchain_directly_for_signed_requests() {
-    const PHRASE: &str =
-        "news slush supreme milk chapter athlete soap sausage put clutch what kitten";
-    let (offchain, _offchain_state) = testing::TestOffchainExt::new();
-    let (pool, pool_state) = testing::TestTransactionPoolExt::new();
-    let keystore = KeyStore::new();
-    SyncCryptoStore::sr25519_generate_new(
-        &keystore,
-        kylin_oracle::KEY_TYPE,
-        Some(&format!("{}/hunter1", PHRASE)),
-    )
-    .unwrap();
-
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-
-    let feed_name = b"test_feed".to_vec();
-    let sample_data = b"{sample_data}".to_vec();
-    t.execute_with(|| {
-        KylinOracle::write_data_onchain(
-            Origin::signed(alice),
-            feed_name,
-            sample_data.clone(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_signed(1).unwrap();
-
-        let tx1 = pool_state.write().transactions.pop().unwrap();
-        let tx2 = pool_state.write().transactions.pop().unwrap();
-
-        let tx1 = Extrinsic::decode(&mut &*tx1).unwrap();
-        let tx2 = Extrinsic::decode(&mut &*tx2).unwrap();
-
-        if let Call::KylinOracle(crate::Call::submit_data_signed {
-            block_number: _block_number,
-            key: _key,
-            data: response,
-        }) = tx2.call
-        {
-            assert_eq!(response, sample_data);
-        }
-
-        if let Call::KylinOracle(crate::Call::clear_processed_requests_unsigned {
-            block_number: _block_number,
-            processed_requests,
-        }) = tx1.call
-        {
-            assert_eq!(1, processed_requests.len());
-        }
-    });
+fn values_fed_in_a_block_are_bounded() {
+	new_test_ext().execute_with(|| {
+		feed(1, &[("a", 1), ("b", 2), ("c", 3), ("d", 4), ("e", 5)]);
+		feed(2, &[("a", 1), ("b", 2), ("c", 3)]);
+		assert_noop!(
+			KylinReporter::feed_data(
+				RuntimeOrigin::signed(account(3)),
+				KYLIN_ID.into(),
+				vec![(b"a".to_vec(), 1)]
+			),
+			Error::<Test>::TooManyPendingValues
+		);
+
+		finalize();
+		feed(3, &[("a", 1)]);
+	});
 }
 
-fn get_from_seed<TPublic: Public>(seed: &str) -> <TPublic::Pair as Pair>::Public {
-    TPublic::Pair::from_string(&format!("//{}", seed), None)
-        .expect("static values are valid; qed")
-        .public()
+#[test]
+fn median_of_fewer_values_than_the_minimum_count_is_the_previous_value() {
+	type Median = MedianCombineData<ConstU32<3>>;
+	let at = |value| TimestampedValue { value, timestamp: 0 };
+	let key = b"btc".to_vec();
+	let previous = Some(at(7));
+
+	assert_eq!(Median::combine_data(&key, vec![at(1), at(5)], previous), previous);
+	assert_eq!(Median::combine_data(&key, vec![at(9), at(1), at(5)], previous), Some(at(5)));
+	// The upper median of an even number of values.
+	assert_eq!(Median::combine_data(&key, vec![at(9), at(1), at(5), at(3)], None), Some(at(5)));
+	assert_eq!(MedianCombineData::<ConstU32<0>>::combine_data(&key, vec![], previous), previous);
 }
 
-fn get_account_id_from_seed<TPublic: Public>(seed: &str) -> AccountId
-where
-    AccountPublic: From<<TPublic::Pair as Pair>::Public>,
-{
-    AccountPublic::from(get_from_seed::<TPublic>(seed)).into_account()
+#[test]
+fn feeds_are_fetched_concurrently() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![
+		Endpoint::json("https://a.test", 1.0, 64).with_latency(300),
+		Endpoint::json("https://b.test", 2.0, 64).with_latency(500),
+		Endpoint::json("https://c.test", 3.0, 64).with_latency(400),
+	]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "a", "https://a.test", "/value");
+		submit_feed(feeder, "b", "https://b.test", "/value");
+		submit_feed(feeder, "c", "https://c.test", "/value");
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(report.requests, 3);
+	// The run waits for the slowest endpoint only, not for the sum of the latencies.
+	assert!(
+		(500..500 + HTTP_POLL_INTERVAL_MS).contains(&report.wall_time),
+		"wall time {}",
+		report.wall_time
+	);
+	assert_eq!(fed_values(&report), fed(&[("a", 1_000_000), ("b", 2_000_000), ("c", 3_000_000)]));
 }
 
-
-fn mock_submit_response(state: &mut testing::OffchainState) {
-    state.expect_request(testing::PendingRequest {
-        method: "GET".into(),
-        uri: "https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".into(),
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    });
-
+#[test]
+fn nothing_is_fed_until_the_oracle_chain_is_set() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![Endpoint::json("https://a.test", 1.0, 64)]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "a", "https://a.test", "/value");
+		KylinParaId::<Test>::kill();
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(report.requests, 1);
+	assert!(report.transactions.is_empty());
 }
 
-fn mock_post_response(state: &mut testing::OffchainState) {
-    
-
-    // state.expect_request(testing::PendingRequest {
-    //     method: "GET".into(),
-    //     uri: "https://api.kylin-node.co.uk/prices?currency_pairs=btc_usd".into(),
-    //     response: Some(br#"{"USD": 155.23}"#.to_vec()),
-    //     sent: true,
-    //     ..Default::default()
-    // });
-
-
-    let sample_body:Vec<u8> =  vec![123, 10, 32, 32, 32, 32, 34, 100, 97, 116, 97, 34, 58, 32, 123, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 97, 114, 97, 95, 105, 100, 34, 58, 32, 110, 117, 108, 108, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 97, 99, 99, 111, 117, 110, 116, 95, 105, 100, 34, 58, 32, 34, 100, 52, 51, 53, 57, 51, 99, 55, 49, 53, 102, 100, 100, 51, 49, 99, 54, 49, 49, 52, 49, 97, 98, 100, 48, 52, 97, 57, 57, 102, 100, 54, 56, 50, 50, 99, 56, 53, 53, 56, 56, 53, 52, 99, 99, 100, 101, 51, 57, 97, 53, 54, 56, 52, 101, 55, 97, 53, 54, 100, 97, 50, 55, 100, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 114, 101, 113, 117, 101, 115, 116, 101, 100, 95, 98, 108, 111, 99, 107, 95, 110, 117, 109, 98, 101, 114, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 114, 111, 99, 101, 115, 115, 101, 100, 95, 98, 108, 111, 99, 107, 95, 110, 117, 109, 98, 101, 114, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 114, 101, 113, 117, 101, 115, 116, 101, 100, 95, 116, 105, 109, 101, 115, 116, 97, 109, 112, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 114, 111, 99, 101, 115, 115, 101, 100, 95, 116, 105, 109, 101, 115, 116, 97, 109, 112, 34, 58, 32, 48, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 112, 97, 121, 108, 111, 97, 100, 34, 58, 32, 34, 123, 115, 97, 109, 112, 108, 101, 95, 100, 97, 116, 97, 125, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 102, 101, 101, 100, 95, 110, 97, 109, 101, 34, 58, 32, 34, 112, 114, 105, 99, 101, 95, 102, 101, 101, 100, 105, 110, 103, 34, 44, 10, 32, 32, 32, 32, 32, 32, 32, 32, 34, 117, 114, 108, 34, 58, 32, 34, 104, 116, 116, 112, 115, 58, 47, 47, 97, 112, 105, 46, 107, 121, 108, 105, 110, 45, 110, 111, 100, 101, 46, 99, 111, 46, 117, 107, 47, 112, 114, 105, 99, 101, 115, 63, 99, 117, 114, 114, 101, 110, 99, 121, 95, 112, 97, 105, 114, 115, 61, 98, 116, 99, 95, 117, 115, 100, 34, 10, 32, 32, 32, 32, 125, 44, 10, 32, 32, 32, 32, 34, 104, 97, 115, 104, 34, 58, 32, 34, 57, 57, 100, 48, 97, 51, 99, 97, 55, 98, 102, 53, 56, 57, 100, 99, 55, 57, 57, 51, 49, 97, 53, 101, 51, 49, 48, 98, 99, 101, 100, 51, 100, 57, 55, 55, 57, 48, 54, 98, 99, 50, 56, 57, 54, 101, 97, 49, 99, 101, 99, 97, 53, 97, 56, 50, 52, 101, 57, 49, 97, 57, 53, 49, 34, 10, 125];
-
-    let mut pending_request = testing::PendingRequest {
-        method: "POST".into(),
-        uri: "https://api.kylin-node.co.uk/submit".into(),
-        body: sample_body,
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    };
-
-    pending_request.headers.push(("x-api-key".into(), "test_api_key".into()));
-    pending_request.headers.push(("content-type".into(), "application/json".into()));
-    state.expect_request(pending_request);
+#[test]
+fn failing_endpoints_do_not_block_the_others() {
+	let (mut ext, simulation, feeder) = worker_ext(vec![
+		Endpoint::json("https://a.test", 1.0, 64),
+		Endpoint::json("https://down.test", 2.0, 64).with_failure_rate(1.0),
+		Endpoint::json("https://slow.test", 3.0, 64).with_latency(20_000),
+	]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "a", "https://a.test", "/value");
+		submit_feed(feeder, "down", "https://down.test", "/value");
+		submit_feed(feeder, "slow", "https://slow.test", "/value");
+		submit_feed(feeder, "missing", "https://a.test", "/missing");
+	});
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(report.wall_time, 10_000);
+	assert_eq!(fed_values(&report), fed(&[("a", 1_000_000)]));
+	ext.execute_with(|| {
+		assert_eq!(KylinReporter::endpoint_health(b"https://down.test").consecutive_failures, 1);
+		let slow = KylinReporter::endpoint_health(b"https://slow.test");
+		assert_eq!((slow.consecutive_failures, slow.last_latency), (1, 10_000));
+	});
 }
 
-fn mock_query_response(state: &mut testing::OffchainState) {
-    let pending_request = testing::PendingRequest {
-        // 99d0a3ca7bf589dc79931a5e310bced3d977906bc2896ea1ceca5a824e91a951
-        method: "GET".into(),
-        uri: "https://api.kylin-node.co.uk/query?hash=99d0a3ca7bf589dc79931a5e310bced3d977906bc2896ea1ceca5a824e91a951".into(),
-        response: Some(br#"{"USD": 155.23}"#.to_vec()),
-        sent: true,
-        ..Default::default()
-    };
-    state.expect_request(pending_request);
+#[test]
+fn barely_moved_values_wait_for_the_heartbeat() {
+	let url = "https://a.test";
+	let (mut ext, simulation, feeder) = worker_ext(vec![Endpoint::json(url, 100.0, 64)]);
+	ext.execute_with(|| {
+		submit_feed(feeder, "btc", url, "/value");
+		assert_ok!(KylinReporter::set_api_schedule(
+			RuntimeOrigin::signed(feeder),
+			b"btc".to_vec(),
+			1,
+			5,
+			Permill::from_percent(1),
+		));
+	});
+	let set_value = |value: f64| {
+		simulation.update_endpoints(|endpoints| endpoints[0] = Endpoint::json(url, value, 64));
+	};
+
+	let report = run_worker(&mut ext, &simulation, 1);
+	assert_eq!(fed_values(&report), fed(&[("btc", 100_000_000)]));
+
+	set_value(100.5);
+	for block_number in 2..6 {
+		assert!(run_worker(&mut ext, &simulation, block_number).transactions.is_empty());
+	}
+	let report = run_worker(&mut ext, &simulation, 6);
+	assert_eq!(fed_values(&report), fed(&[("btc", 100_500_000)]));
+
+	set_value(102.0);
+	let report = run_worker(&mut ext, &simulation, 7);
+	assert_eq!(fed_values(&report), fed(&[("btc", 102_000_000)]));
 }
 
 #[test]
-fn should_award_query_fees() {
-    let alice = get_account_id_from_seed::<sr25519::Public>("Alice");
-    let bob = get_account_id_from_seed::<sr25519::Public>("Bob");
-    let additional_amount = 10_000;
-    let query_reward_fee = 126743754;
-    let free_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance;
-
-    let (offchain, offchain_state) = testing::TestOffchainExt::new();
-    let (pool, _pool_state) = testing::TestTransactionPoolExt::new();
-
-    let keystore = KeyStore::new();
-    let mut t = sp_io::TestExternalities::default();
-    t.register_extension(OffchainWorkerExt::new(offchain));
-    t.register_extension(TransactionPoolExt::new(pool));
-    t.register_extension(KeystoreExt(Arc::new(keystore)));
-    t.execute_with(|| {
-        let _ = <pallet_balances::Pallet<Test> as Currency<AccountId>>::deposit_creating(
-                        &alice,
-                        additional_amount
-        );
-
-        let _ =  <pallet_balances::Pallet<Test> as Currency<AccountId>>::deposit_creating(
-                        &bob,
-                        additional_amount
-                    );
-        
-        let initial_alice_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance(&alice);
-        let initial_bob_balance = <pallet_balances::Pallet<Test> as Currency<AccountId>>::free_balance(&bob);
-
-        let sample_data = b"{sample_data}".to_vec();
-        let mut processed_requests: Vec<u64> = Vec::new();
-        let mut key = 10000000u64;
-        let mut alice_fee = 0;
-        let mut bob_fee = 0;
-        processed_requests.push(key);
-
-        // key = 10000000u64, data index = 10000000u64 weight = 65_955_000 + 100 * 3 + 1000 * 3
-        //     (65_955_000 as Weight)
-        //         .saturating_add(RocksDbWeight::get().reads(3 as Weight))
-        //         .saturating_add(RocksDbWeight::get().writes(3 as Weight))
-        let submit_price_feed_fee = 65_955_000 + 100 * 3 + 1000 * 3;
-        alice_fee += submit_price_feed_fee;
-        println!("alice: submit_price_feed fee {}", submit_price_feed_fee);
-        mock_submit_response(&mut offchain_state.write());       
-        KylinOracle::submit_price_feed(
-            Origin::signed(alice),
-            None,
-            str::from_utf8(b"btc_usd").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-
-        println!("alice step0 balance: {}", free_balance(&alice));
-
-        // (65_955_000 as Weight)
-        // .saturating_add(T::DbWeight::get().reads(3 as Weight))
-        // .saturating_add(T::DbWeight::get().writes(3 as Weight))
-        let submit_data_signed_feed_fee = 65_955_000 + 100 * 3 + 1000 * 3;
-        alice_fee += submit_data_signed_feed_fee;
-        println!("alice: submit_price_feed fee {}", submit_data_signed_feed_fee);
-        KylinOracle::submit_data_signed(
-            Origin::signed(alice),
-            1,
-            key,
-            sample_data.clone()
-        )
-        .unwrap();
-
-        println!("alice step1 balance: {}", free_balance(&alice));
-
-
-        KylinOracle::fetch_data_and_send_raw_unsigned(1).unwrap();
-        KylinOracle::clear_processed_requests_unsigned(
-            Origin::none(),
-            1,
-            processed_requests.clone(),
-        )
-        .unwrap();
-
-        mock_post_response(&mut offchain_state.write());
-        KylinOracle::fetch_data_and_send_raw_unsigned(2).unwrap();
-    
-        // key = 10000001u64, data index = 10000001u64
-        key = 10000001u64;
-        mock_query_response(&mut offchain_state.write());
-
-        println!("alice step2 balance: {}", free_balance(&alice));
-
-        // (121_180_000 as Weight) // Standard Error: 0
-        // .saturating_add(RocksDbWeight::get().reads(4 as Weight))
-        // .saturating_add(RocksDbWeight::get().writes(2 as Weight))
-        // base_fee + len_fee + adjested_weight_fee
-        let query_data_fee = 121_180_000 + 100 * 4 + 1000 * 2;
-        bob_fee += query_data_fee;
-        println!("bob: query_data fee {}", query_data_fee);
-        KylinOracle::query_data(
-            Origin::signed(bob),
-            None,
-            str::from_utf8(b"price_feeding").unwrap().as_bytes().to_vec(),
-        )
-        .unwrap();
-
-        println!("alice step3 balance: {}", free_balance(&alice));
-
-        // (20_716_000 as Weight) // Standard Error: 0
-        // .saturating_add(RocksDbWeight::get().reads(2 as Weight))
-        // .saturating_add(RocksDbWeight::get().writes(1 as Weight))
-        let submit_data_signed_fee = 20_716_000 + 100 * 2 + 1000 * 1;
-        bob_fee += submit_data_signed_fee;
-        println!("bob: submit_data_signed fee {}", submit_data_signed_fee);
-        KylinOracle::submit_data_signed(
-            Origin::signed(bob),
-            2,
-            key,
-            sample_data.clone()
-        )
-        .unwrap();
-        KylinOracle::clear_api_queue_unsigned(
-            Origin::none(),
-            2,
-            processed_requests.clone(),
-        )
-        .unwrap();
-        KylinOracle::fetch_data_and_send_raw_unsigned(3).unwrap();
-        println!("alice step4 balance: {}", free_balance(&alice));
-
-
-        let free_alice_balance = free_balance(&alice);
-        let free_bob_balance = free_balance(&bob);
-
-        println!("init alice balance {}, free alice balance {}", initial_alice_balance, free_alice_balance);
-        println!("init bob balance {}, free bob balance {}", initial_bob_balance, free_bob_balance);
-        println!("alice fee used {}, bob fee used {}", alice_fee, bob_fee);
-
-        assert_eq!(
-            free_alice_balance,
-            initial_alice_balance + query_reward_fee,
-        );
-    });
-
-}
\ No newline at end of file
+fn a_loaded_worker_feeds_every_healthy_endpoint_within_the_deadline() {
+	// Endpoints of up to 900ms of latency, one in six failing half of the requests.
+	let endpoints: Vec<Endpoint> = (0..48)
+		.map(|i| {
+			Endpoint::json(format!("https://{}.test", i), i as f64, 512)
+				.with_latency(100 * (i % 10))
+				.with_failure_rate(if i % 6 == 0 { 0.5 } else { 0.0 })
+		})
+		.collect();
+	let (mut ext, simulation, feeder) = worker_ext(endpoints.clone());
+	ext.execute_with(|| {
+		for (i, endpoint) in endpoints.iter().enumerate() {
+			submit_feed(feeder, &format!("feed{}", i), &endpoint.url, "/value");
+		}
+	});
+
+	let reports = simulation.run_blocks(&mut ext, 1..=20, 6_000, |block_number| {
+		KylinReporter::fetch_api_and_feed_data(block_number).unwrap()
+	});
+	for report in &reports {
+		// Bounded by the slowest endpoint, whatever the number of endpoints.
+		assert!(
+			(900..900 + HTTP_POLL_INTERVAL_MS).contains(&report.wall_time),
+			"wall time {}",
+			report.wall_time
+		);
+		let fed = fed_values(report);
+		assert_eq!(fed.len(), 1);
+		for i in (0..48).filter(|i| i % 6 != 0) {
+			let value = (format!("feed{}", i).into_bytes(), i as i64 * 1_000_000);
+			assert!(fed[0].1.contains(&value), "feed{} is not fed", i);
+		}
+	}
+	// The flaky endpoints are backed off rather than fetched by every run.
+	let requests: u32 = reports.iter().map(|report| report.requests).sum();
+	assert!(requests < 48 * 20, "{} requests", requests);
+}
@@ -29,6 +29,8 @@ use sp_std::marker::PhantomData;
 
 /// Weight functions needed for kylin_oracle.
 pub trait WeightInfo {
+    fn feed_data(c: u32) -> Weight;
+    fn forward_values(c: u32) -> Weight;
     fn submit_api() -> Weight;
     fn remove_api() -> Weight;
 }
@@ -36,6 +38,24 @@ pub trait WeightInfo {
 /// Weights for kylin_oracle using the Substrate node and recommended hardware.
 pub struct SubstrateWeight<T>(PhantomData<T>);
 impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
+    // Estimated: the membership check, the pending count and the append of each value to
+    // `PendingValues`. Forwarding the values on finalize is charged by `forward_values`.
+    fn feed_data(c: u32, ) -> Weight {
+        Weight::from_ref_time(14_600_000)
+            .saturating_add(Weight::from_ref_time(3_900_000).saturating_mul(c as u64))
+            .saturating_add(T::DbWeight::get().reads(3 as u64))
+            .saturating_add(T::DbWeight::get().reads((1 as u64).saturating_mul(c as u64)))
+            .saturating_add(T::DbWeight::get().writes(1 as u64))
+            .saturating_add(T::DbWeight::get().writes((1 as u64).saturating_mul(c as u64)))
+    }
+    // Estimated: for each value, its pending values, its last forwarded and held back values,
+    // its heartbeat and, at worst, an XCM message of its own through the router.
+    fn forward_values(c: u32, ) -> Weight {
+        Weight::from_ref_time(5_000_000)
+            .saturating_add(Weight::from_ref_time(25_000_000).saturating_mul(c as u64))
+            .saturating_add(T::DbWeight::get().reads((5 as u64).saturating_mul(c as u64)))
+            .saturating_add(T::DbWeight::get().writes((5 as u64).saturating_mul(c as u64)))
+    }
 	fn submit_api() -> Weight {
         Weight::from_ref_time(6_284_000)
             .saturating_add(T::DbWeight::get().writes(1 as u64))
@@ -50,6 +70,20 @@ impl<T: frame_system::Config> WeightInfo for SubstrateWeight<T> {
 
 // For backwards compatibility and tests
 impl WeightInfo for () {
+    fn feed_data(c: u32, ) -> Weight {
+        Weight::from_ref_time(14_600_000)
+            .saturating_add(Weight::from_ref_time(3_900_000).saturating_mul(c as u64))
+            .saturating_add(RocksDbWeight::get().reads(3 as u64))
+            .saturating_add(RocksDbWeight::get().reads((1 as u64).saturating_mul(c as u64)))
+            .saturating_add(RocksDbWeight::get().writes(1 as u64))
+            .saturating_add(RocksDbWeight::get().writes((1 as u64).saturating_mul(c as u64)))
+    }
+    fn forward_values(c: u32, ) -> Weight {
+        Weight::from_ref_time(5_000_000)
+            .saturating_add(Weight::from_ref_time(25_000_000).saturating_mul(c as u64))
+            .saturating_add(RocksDbWeight::get().reads((5 as u64).saturating_mul(c as u64)))
+            .saturating_add(RocksDbWeight::get().writes((5 as u64).saturating_mul(c as u64)))
+    }
 	fn submit_api() -> Weight {
         Weight::from_ref_time(6_284_000)
             .saturating_add(RocksDbWeight::get().writes(1 as u64))
@@ -1,11 +1,12 @@
 use codec::{Decode, Encode, FullCodec, MaxEncodedLen};
 use frame_support::{
-	pallet_prelude::{OptionQuery, StorageMap, StorageValue},
+	pallet_prelude::{ConstU32, OptionQuery, StorageMap, StorageValue},
 	storage::types::QueryKindTrait,
 	traits::{Get, StorageInstance},
-	ReversibleStorageHasher, StorageHasher,
+	BoundedVec, ReversibleStorageHasher, StorageHasher,
 };
 use scale_info::TypeInfo;
+use sp_io::MultiRemovalResults;
 
 /// Fold over a storage, block per block.
 pub trait FoldStorage<S, K, V> {
@@ -134,14 +135,83 @@ impl<S, K> BlockFold<S, K> {
 	}
 }
 
+/// Maximum length of a storage key cursor kept in between two fold steps.
+pub const MAX_CURSOR_LEN: u32 = 256;
+
+/// Raw storage key returned by `clear_prefix` to resume a removal.
+pub type StorageCursor = BoundedVec<u8, ConstU32<MAX_CURSOR_LEN>>;
+
+/// Multi-block removal of a storage prefix, the state being the number of removed keys.
+pub type ClearPrefixFold = BlockFold<u32, StorageCursor>;
+
+/// Execute a step of a multi-block prefix removal. `clear` is given the chunk size of the
+/// strategy and the cursor of the previous step, and is expected to forward them to the
+/// `clear_prefix` of the storage being removed.
+///
+/// A cursor that does not fit [`StorageCursor`] is dropped: it is only required to skip keys
+/// already removed in the same block, the next step simply restarts from the prefix.
+pub fn clear_prefix_step(
+	fold: ClearPrefixFold,
+	clear: impl FnOnce(u32, Option<&[u8]>) -> MultiRemovalResults,
+) -> ClearPrefixFold {
+	let (strategy, removed, result) = match fold {
+		BlockFold::Init { strategy: strategy @ FoldStrategy::Chunk { number_of_elements }, state } =>
+			(strategy, state, clear(number_of_elements, None)),
+		BlockFold::Cont {
+			strategy: strategy @ FoldStrategy::Chunk { number_of_elements },
+			state,
+			previous_key,
+		} => (strategy, state, clear(number_of_elements, Some(&previous_key))),
+		d @ BlockFold::Done { .. } => return d,
+	};
+	let state = removed.saturating_add(result.unique);
+	match result.maybe_cursor {
+		None => BlockFold::Done { state },
+		Some(cursor) => match StorageCursor::try_from(cursor) {
+			Ok(previous_key) => BlockFold::Cont { strategy, state, previous_key },
+			Err(_) => BlockFold::Init { strategy, state },
+		},
+	}
+}
+
 #[cfg(all(test, feature = "std"))]
 mod tests {
+	use super::{clear_prefix_step, BlockFold, ClearPrefixFold, FoldStrategy};
 	use frame_support::Identity;
 	use sp_io::TestExternalities;
 
 	#[frame_support::storage_alias]
 	type QueueStorageMap = StorageMap<Prefix, Identity, u64, u64>;
 
+	#[frame_support::storage_alias]
+	type NestedStorageMap = StorageDoubleMap<Prefix, Identity, u64, Identity, u64, u64>;
+
+	#[test]
+	fn clear_prefix_step_removes_chunk_per_step() {
+		let mut ext = TestExternalities::default();
+		ext.execute_with(|| {
+			(0..5).for_each(|i| NestedStorageMap::insert(1, i, i));
+			NestedStorageMap::insert(2, 0, 0);
+		});
+		// Removal limits only apply to the backend, not to the overlay.
+		ext.commit_all().expect("commit to the in-memory backend never fails; qed");
+		ext.execute_with(|| {
+			let mut fold: ClearPrefixFold = BlockFold::new(FoldStrategy::new_chunk(2), 0);
+			let mut steps = 0;
+			while !matches!(fold, BlockFold::Done { .. }) {
+				fold = clear_prefix_step(fold, |limit, cursor| {
+					NestedStorageMap::clear_prefix(1, limit, cursor)
+				});
+				steps += 1;
+			}
+
+			assert_eq!(fold, BlockFold::Done { state: 5 });
+			assert_eq!(steps, 3);
+			assert_eq!(NestedStorageMap::iter_prefix(1).count(), 0);
+			assert_eq!(NestedStorageMap::get(2, 0), Some(0));
+		});
+	}
+
 	/// based on tests from frame_support, but there is no such test to show off partial drain
 	/// and docs do not tell that drain happens if you iterate element, not just by calling
 	/// drain
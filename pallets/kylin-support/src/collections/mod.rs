@@ -1,3 +1,20 @@
 pub mod vec;
 
 // pub use vec::BoundedSortedVec;
+
+/// Length peek of the collections put into storage as a raw value, map or double-map.
+///
+/// The length is read from the `Compact` prefix of the encoded value, without decoding (or even
+/// reading) any of its elements. This is the counterpart of
+/// `frame_support::storage::StorageDecodeLength`, which is sealed to the `frame_support` types.
+pub trait StoragePeekLength: codec::DecodeLength {
+	/// Length of the collection stored under the raw storage `key`, `None` if there is no value
+	/// or it is not a valid encoding.
+	fn peek_len(key: &[u8]) -> Option<usize> {
+		// the longest `Compact<u32>`
+		let mut data = [0u8; 5];
+		let len = sp_io::storage::read(key, &mut data, 0)?;
+		let len = data.len().min(len as usize);
+		<Self as codec::DecodeLength>::len(data.get(..len)?).ok()
+	}
+}
@@ -36,6 +36,18 @@ impl<T: Decode + MaxEncodedLen, const L: usize, const U: usize> MaxEncodedLen
 	}
 }
 
+impl<T, const L: usize, const U: usize> codec::DecodeLength for BiBoundedVec<T, L, U> {
+	fn len(self_encoded: &[u8]) -> Result<usize, codec::Error> {
+		// `BiBoundedVec<T, _, _>` encodes as its inner `Vec<T>`
+		<Vec<T> as codec::DecodeLength>::len(self_encoded)
+	}
+}
+
+impl<T, const L: usize, const U: usize> crate::collections::StoragePeekLength
+	for BiBoundedVec<T, L, U>
+{
+}
+
 /// BiBoundedVec errors
 #[derive(PartialEq, Eq, Debug, Clone)]
 pub enum BiBoundedVecOutOfBounds {
@@ -276,6 +288,25 @@ impl<T, const L: usize, const U: usize> BiBoundedVec<T, L, U> {
 		self.inner.iter_mut()
 	}
 
+	/// Appends an element, returning it as an `Err` (and being a noop) if the new length exceeds
+	/// U (upper bound)
+	pub fn try_push(&mut self, element: T) -> Result<(), T> {
+		if self.inner.len() < U {
+			self.inner.push(element);
+			Ok(())
+		} else {
+			Err(element)
+		}
+	}
+
+	/// Whether the vector stored under the raw storage `key` holds between L and U items, read
+	/// from its length prefix only. `None` if there is no value.
+	pub fn peek_within_bounds(key: &[u8]) -> Option<bool> {
+		use crate::collections::StoragePeekLength;
+
+		Self::peek_len(key).map(|len| (L..=U).contains(&len))
+	}
+
 	/// Returns the last and all the rest of the elements
 	pub fn split_last(&self) -> Option<(&T, &[T])> {
 		self.inner.split_last()
@@ -382,6 +413,26 @@ mod tests {
 		assert!(BiBoundedVec::<u8, 1, 2>::from_vec(vec![1, 2, 3]).is_err());
 	}
 
+	#[test]
+	fn try_push() {
+		let mut data: BiBoundedVec<_, 1, 2> = vec![1u8].try_into().unwrap();
+		assert_eq!(data.try_push(2), Ok(()));
+		assert_eq!(data.try_push(3), Err(3));
+		assert_eq!(data.as_vec(), &vec![1u8, 2]);
+	}
+
+	#[test]
+	fn peek_within_bounds() {
+		sp_io::TestExternalities::default().execute_with(|| {
+			let key = b"bi_bounded_vec";
+			assert_eq!(BiBoundedVec::<u8, 2, 3>::peek_within_bounds(key), None);
+
+			sp_io::storage::set(key, &vec![1u8, 2].encode());
+			assert_eq!(BiBoundedVec::<u8, 2, 3>::peek_within_bounds(key), Some(true));
+			assert_eq!(BiBoundedVec::<u8, 3, 4>::peek_within_bounds(key), Some(false));
+		});
+	}
+
 	#[test]
 	fn is_empty() {
 		let data: BiBoundedVec<_, 2, 8> = vec![1u8, 2].try_into().unwrap();
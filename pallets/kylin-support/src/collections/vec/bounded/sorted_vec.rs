@@ -5,6 +5,7 @@ use core::{
 	slice::SliceIndex,
 };
 use frame_support::{traits::Get, BoundedVec};
+use scale_info::TypeInfo;
 use sp_std::{convert::TryFrom, marker::PhantomData, prelude::*};
 
 /// A bounded, sorted vector.
@@ -14,7 +15,8 @@ use sp_std::{convert::TryFrom, marker::PhantomData, prelude::*};
 ///
 /// As the name suggests, the length of the queue is always bounded and sorted. All internal
 /// operations ensure this bound is respected and order is maintained.
-#[derive(Encode)]
+#[derive(Encode, TypeInfo)]
+#[scale_info(skip_type_params(S))]
 pub struct BoundedSortedVec<T: Ord, S>(SortedVec<T>, PhantomData<S>);
 
 impl<T: Decode + Ord, S: Get<u32>> Decode for BoundedSortedVec<T, S> {
@@ -70,11 +72,24 @@ impl<T: Ord, S> BoundedSortedVec<T, S> {
 		self.0.remove(index)
 	}
 
+	/// Remove an element equal to `item`, found by binary search.
+	#[inline]
+	pub fn remove_item(&mut self, item: &T) -> Option<T> {
+		self.0.remove_item(item)
+	}
+
 	/// Exactly the same semantics as [`Vec::retain`].
 	#[inline]
 	pub fn retain<F: FnMut(&T) -> bool>(&mut self, f: F) {
 		self.0.retain(f)
 	}
+
+	/// Replace an element equal to `old` by `new` in place, see [`SortedVec::replace`]. The
+	/// length is unchanged.
+	#[inline]
+	pub fn replace(&mut self, old: &T, new: T) -> Result<T, T> {
+		self.0.replace(old, new)
+	}
 }
 
 impl<T: Ord, S: Get<u32>> From<BoundedSortedVec<T, S>> for Vec<T> {
@@ -112,6 +127,44 @@ impl<T: Ord, S: Get<u32>> BoundedSortedVec<T, S> {
 		}
 	}
 
+	/// Same as [`Self::try_insert`], returning the order index at which the element was placed.
+	#[inline]
+	pub fn try_insert_at(&mut self, element: T) -> Result<usize, T> {
+		if self.len() < Self::bound() {
+			Ok(self.0.insert(element))
+		} else {
+			Err(element)
+		}
+	}
+
+	/// Merge the already sorted `items` into the vector in O(n + m), see
+	/// [`SortedVec::try_extend_sorted`]. Returns them as an `Err` (and is a noop) if they are not
+	/// sorted or the new length of the vector exceeds `S`.
+	pub fn try_extend_sorted(&mut self, items: Vec<T>) -> Result<(), Vec<T>> {
+		if self.len().saturating_add(items.len()) > Self::bound() {
+			return Err(items)
+		}
+		self.0.try_extend_sorted(items)
+	}
+
+	/// Merge `other` into the vector in O(n + m), returning it as an `Err` (and being a noop) if
+	/// the new length of the vector exceeds `S`.
+	pub fn try_merge(&mut self, other: SortedVec<T>) -> Result<(), SortedVec<T>> {
+		if self.len().saturating_add(other.len()) > Self::bound() {
+			return Err(other)
+		}
+		self.0.merge(other);
+		Ok(())
+	}
+
+	/// Whether the vector stored under the raw storage `key` is below its bound, read from its
+	/// length prefix only. An absent value has room.
+	pub fn peek_has_room(key: &[u8]) -> bool {
+		use crate::collections::StoragePeekLength;
+
+		Self::peek_len(key).map_or(true, |len| len < Self::bound())
+	}
+
 	/// Exactly the same semantics as [`Vec::push`], but returns an `Err` (and is a noop) if the
 	/// new length of the vector exceeds `S`.
 	///
@@ -229,6 +282,8 @@ impl<T: Ord, S> codec::DecodeLength for BoundedSortedVec<T, S> {
 	}
 }
 
+impl<T: Ord, S> crate::collections::StoragePeekLength for BoundedSortedVec<T, S> {}
+
 /// Allows for comparing vectors with different bounds.
 impl<T, S1: Get<u32>, S2: Get<u32>> PartialEq<BoundedSortedVec<T, S2>> for BoundedSortedVec<T, S1>
 where
@@ -311,6 +366,64 @@ pub mod test {
 		bounded.try_insert(9).unwrap();
 	}
 
+	#[test]
+	fn try_extend_sorted_works() {
+		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 4].try_into().unwrap();
+		assert_eq!(bounded.try_extend_sorted(vec![3, 2]), Err(vec![3, 2]));
+		assert_eq!(bounded.try_extend_sorted(vec![0, 2, 5]), Err(vec![0, 2, 5]));
+		assert_eq!(*bounded, vec![1, 4]);
+
+		bounded.try_extend_sorted(vec![2, 5]).unwrap();
+		assert_eq!(*bounded, vec![1, 2, 4, 5]);
+	}
+
+	#[test]
+	fn try_merge_works() {
+		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 4].try_into().unwrap();
+		let other = SortedVec::from_unsorted(vec![3, 0, 2]);
+		let other = bounded.try_merge(other).unwrap_err();
+		assert_eq!(*bounded, vec![1, 4]);
+
+		bounded.try_merge(SortedVec::from_unsorted(other[1..].to_vec())).unwrap();
+		assert_eq!(*bounded, vec![1, 2, 3, 4]);
+	}
+
+	#[test]
+	fn replace_works() {
+		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 2, 3, 4].try_into().unwrap();
+		assert_eq!(bounded.replace(&1, 5), Ok(1));
+		assert_eq!(*bounded, vec![2, 3, 4, 5]);
+		assert_eq!(bounded.replace(&1, 0), Err(0));
+	}
+
+	#[test]
+	fn try_insert_at_works() {
+		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 3, 5].try_into().unwrap();
+		assert_eq!(bounded.try_insert_at(4), Ok(2));
+		assert_eq!(bounded.try_insert_at(0), Err(0));
+	}
+
+	#[test]
+	fn peek_works() {
+		use crate::collections::StoragePeekLength;
+
+		TestExternalities::default().execute_with(|| {
+			let key = Foo::hashed_key();
+			assert_eq!(BoundedSortedVec::<u32, Seven>::peek_len(&key), None);
+			assert!(BoundedSortedVec::<u32, Seven>::peek_has_room(&key));
+
+			let bounded: BoundedSortedVec<u32, Seven> = vec![1, 2, 3].try_into().unwrap();
+			Foo::put(bounded);
+			assert_eq!(BoundedSortedVec::<u32, Seven>::peek_len(&key), Some(3));
+			assert!(BoundedSortedVec::<u32, Seven>::peek_has_room(&key));
+
+			let full: BoundedSortedVec<u32, Seven> = (1..=7).collect::<Vec<_>>().try_into().unwrap();
+			Foo::put(full);
+			assert_eq!(BoundedSortedVec::<u32, Seven>::peek_len(&key), Some(7));
+			assert!(!BoundedSortedVec::<u32, Seven>::peek_has_room(&key));
+		});
+	}
+
 	#[test]
 	fn try_push_works() {
 		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 2, 3].try_into().unwrap();
@@ -320,6 +433,16 @@ pub mod test {
 		assert!(bounded.try_push(9).is_err());
 	}
 
+	#[test]
+	fn remove_item_works() {
+		let mut bounded: BoundedSortedVec<u32, Four> = vec![1, 2, 2, 3].try_into().unwrap();
+		assert_eq!(bounded.remove_item(&2), Some(2));
+		assert_eq!(*bounded, vec![1, 2, 3]);
+
+		assert_eq!(bounded.remove_item(&9), None);
+		assert_eq!(*bounded, vec![1, 2, 3]);
+	}
+
 	#[test]
 	fn deref_coercion_works() {
 		let bounded: BoundedSortedVec<u32, Seven> = vec![1, 2, 3].try_into().unwrap();
@@ -7,13 +7,14 @@
 use codec::{Decode, Encode, EncodeLike, WrapperTypeEncode};
 use core::hash::Hash;
 use frame_support::RuntimeDebug;
+use scale_info::TypeInfo;
 #[cfg(feature = "serde")]
 use serde::{Deserialize, Serialize};
-use sp_std::prelude::*;
+use sp_std::{prelude::*, ptr};
 
 #[cfg_attr(feature = "serde", derive(Serialize, Deserialize))]
 #[cfg_attr(all(feature = "serde", not(feature = "serde-nontransparent")), serde(transparent))]
-#[derive(Clone, RuntimeDebug, Eq, Ord, PartialEq, PartialOrd, Hash)]
+#[derive(Clone, RuntimeDebug, Eq, Ord, PartialEq, PartialOrd, Hash, TypeInfo)]
 pub struct SortedVec<T: Ord> {
 	#[cfg_attr(feature = "serde", serde(deserialize_with = "parse_vec"))]
 	#[cfg_attr(feature = "serde", serde(bound(deserialize = "T : serde::Deserialize <'de>")))]
@@ -130,6 +131,60 @@ impl<T: Ord> SortedVec<T> {
 		})
 	}
 
+	/// Replace an element equal to `old` by `new`, returning the replaced element, or `new` as
+	/// an `Err` if there is no such element.
+	///
+	/// The vector is updated in place: only the elements between the positions of `old` and
+	/// `new` are shifted, by one.
+	pub fn replace(&mut self, old: &T, new: T) -> Result<T, T> {
+		let from = match self.vec.binary_search(old) {
+			Ok(from) => from,
+			Err(_) => return Err(new),
+		};
+		let to = match self.vec.binary_search(&new) {
+			Ok(to) | Err(to) => to,
+		};
+		let replaced = match self.vec.get_mut(from) {
+			Some(slot) => sp_std::mem::replace(slot, new),
+			None => return Err(new),
+		};
+		if to > from {
+			// `to` is past `old`, which leaves room for `new` right before it
+			if let Some(shifted) = self.vec.get_mut(from..to) {
+				shifted.rotate_left(1);
+			}
+		} else if let Some(shifted) = self.vec.get_mut(to..=from) {
+			shifted.rotate_right(1);
+		}
+		Ok(replaced)
+	}
+
+	/// Merge the elements of `other` into the vector in O(n + m), the elements of `other`
+	/// coming after the equal elements of `self`.
+	///
+	/// The vector grows at most once, to the merged length, and nothing else is allocated.
+	pub fn merge(&mut self, mut other: SortedVec<T>) {
+		match (self.vec.last(), other.vec.first()) {
+			(_, None) => {},
+			(None, _) => self.vec = other.vec,
+			// Disjoint runs are concatenated, without any comparison
+			(Some(last), Some(first)) if last <= first => self.vec.append(&mut other.vec),
+			_ => merge_from_back(&mut self.vec, &mut other.vec),
+		}
+	}
+
+	/// Merge the already sorted `items` into the vector in O(n + m), returning them as an
+	/// `Err` (and being a noop) if they are not sorted.
+	pub fn try_extend_sorted(&mut self, items: Vec<T>) -> Result<(), Vec<T>> {
+		use is_sorted::IsSorted;
+
+		if !IsSorted::is_sorted(&mut items.iter()) {
+			return Err(items)
+		}
+		self.merge(Self::unchecked_from(items));
+		Ok(())
+	}
+
 	#[inline]
 	pub fn remove_item(&mut self, item: &T) -> Option<T> {
 		match self.vec.binary_search(item) {
@@ -207,6 +262,16 @@ impl<T: Ord> SortedVec<T> {
 	}
 }
 
+impl<T: Ord> codec::DecodeLength for SortedVec<T> {
+	#[inline]
+	fn len(self_encoded: &[u8]) -> Result<usize, codec::Error> {
+		// `SortedVec<T>` encodes as a `Vec<T>`.
+		<Vec<T> as codec::DecodeLength>::len(self_encoded)
+	}
+}
+
+impl<T: Ord> crate::collections::StoragePeekLength for SortedVec<T> {}
+
 impl<T: Ord> Default for SortedVec<T> {
 	fn default() -> Self {
 		Self::new()
@@ -261,11 +326,21 @@ impl<T: Ord> SortedSet<T> {
 	}
 
 	/// Insert an element into sorted position, returning the order index at which
-	/// it was placed.
+	/// it was placed. An equal element is replaced in place.
 	#[inline]
 	pub fn insert(&mut self, element: T) -> usize {
-		let _ = self.remove_item(&element);
-		self.set.insert(element)
+		match self.set.vec.binary_search(&element) {
+			Ok(index) => {
+				if let Some(slot) = self.set.vec.get_mut(index) {
+					*slot = element;
+				}
+				index
+			},
+			Err(index) => {
+				self.set.vec.insert(index, element);
+				index
+			},
+		}
 	}
 
 	/// Find the element and return the index with `Ok`, otherwise insert the
@@ -362,6 +437,62 @@ impl<T: Ord> Extend<T> for SortedSet<T> {
 	}
 }
 
+/// Merge the sorted `src` into the sorted `dst` from the back, into the room reserved past the
+/// elements of `dst`, leaving `src` empty.
+///
+/// The gap between the elements of `dst` left to merge and the merged ones is always as long as
+/// the elements of `src` left to merge. These are moved into it once merged, or if a comparison
+/// panics, so that every element is still owned exactly once.
+fn merge_from_back<T: Ord>(dst: &mut Vec<T>, src: &mut Vec<T>) {
+	struct Gap<'a, T> {
+		dst: &'a mut Vec<T>,
+		src: *const T,
+		dst_left: usize,
+		src_left: usize,
+		len: usize,
+	}
+
+	impl<T> Drop for Gap<'_, T> {
+		fn drop(&mut self) {
+			// SAFETY: the first `src_left` elements of `src` are not moved yet, and the gap they
+			// are moved to is within the room reserved in `dst`.
+			unsafe {
+				ptr::copy_nonoverlapping(
+					self.src,
+					self.dst.as_mut_ptr().add(self.dst_left),
+					self.src_left,
+				);
+				self.dst.set_len(self.len);
+			}
+		}
+	}
+
+	let len = dst.len() + src.len();
+	dst.reserve(src.len());
+	let mut gap = Gap { src: src.as_ptr(), dst_left: dst.len(), src_left: src.len(), len, dst };
+	// SAFETY: the elements of `src` are all moved out by `gap`, `src` only frees its buffer.
+	unsafe { src.set_len(0) };
+
+	while gap.dst_left > 0 && gap.src_left > 0 {
+		let base = gap.dst.as_mut_ptr();
+		// SAFETY: both elements compared are not moved yet, and the last slot of the gap is
+		// past them and within the room reserved.
+		unsafe {
+			let last_dst = base.add(gap.dst_left - 1);
+			let last_src = gap.src.add(gap.src_left - 1);
+			let to = base.add(gap.dst_left + gap.src_left - 1);
+			if *last_dst > *last_src {
+				ptr::copy_nonoverlapping(last_dst, to, 1);
+				gap.dst_left -= 1;
+			} else {
+				ptr::copy_nonoverlapping(last_src, to, 1);
+				gap.src_left -= 1;
+			}
+		}
+	}
+	// Dropping `gap` moves the elements of `src` left, which are the smallest, to the front.
+}
+
 #[cfg(test)]
 mod tests {
 	use super::*;
@@ -454,6 +585,107 @@ mod tests {
 		let _ = serde_json::from_str::<SortedVec<i32>>(s).unwrap();
 	}
 
+	#[test]
+	fn replace_works() {
+		let mut v = SortedVec::from_unsorted(vec![1, 3, 5, 7, 9]);
+		assert_eq!(v.replace(&3, 8), Ok(3));
+		assert_eq!(*v, vec![1, 5, 7, 8, 9]);
+		assert_eq!(v.replace(&8, 0), Ok(8));
+		assert_eq!(*v, vec![0, 1, 5, 7, 9]);
+		assert_eq!(v.replace(&5, 6), Ok(5));
+		assert_eq!(*v, vec![0, 1, 6, 7, 9]);
+		assert_eq!(v.replace(&9, 10), Ok(9));
+		assert_eq!(*v, vec![0, 1, 6, 7, 10]);
+		assert_eq!(v.replace(&7, 7), Ok(7));
+		assert_eq!(*v, vec![0, 1, 6, 7, 10]);
+		assert_eq!(v.replace(&4, 2), Err(2));
+		assert_eq!(*v, vec![0, 1, 6, 7, 10]);
+	}
+
+	#[test]
+	fn merge_works() {
+		let mut v = SortedVec::from_unsorted(vec![1, 4, 4, 9]);
+		v.merge(SortedVec::from_unsorted(vec![0, 4, 5, 10]));
+		assert_eq!(*v, vec![0, 1, 4, 4, 4, 5, 9, 10]);
+
+		v.merge(SortedVec::from_unsorted(vec![11, 12]));
+		assert_eq!(*v, vec![0, 1, 4, 4, 4, 5, 9, 10, 11, 12]);
+
+		let mut empty = SortedVec::new();
+		empty.merge(SortedVec::from_unsorted(vec![2, 1]));
+		assert_eq!(*empty, vec![1, 2]);
+		empty.merge(SortedVec::new());
+		assert_eq!(*empty, vec![1, 2]);
+	}
+
+	std::thread_local! {
+		static DROPPED: core::cell::Cell<usize> = core::cell::Cell::new(0);
+	}
+
+	/// Ordered by key only, counting its drops, and panicking when compared with `u32::MAX`.
+	#[derive(Debug)]
+	struct Keyed(u32, &'static str);
+
+	impl Drop for Keyed {
+		fn drop(&mut self) {
+			DROPPED.with(|dropped| dropped.set(dropped.get() + 1));
+		}
+	}
+
+	impl PartialEq for Keyed {
+		fn eq(&self, other: &Self) -> bool {
+			self.0 == other.0
+		}
+	}
+
+	impl Eq for Keyed {}
+
+	impl PartialOrd for Keyed {
+		fn partial_cmp(&self, other: &Self) -> Option<core::cmp::Ordering> {
+			Some(self.cmp(other))
+		}
+	}
+
+	impl Ord for Keyed {
+		fn cmp(&self, other: &Self) -> core::cmp::Ordering {
+			assert!(self.0 != u32::MAX && other.0 != u32::MAX, "compared a poisoned element");
+			self.0.cmp(&other.0)
+		}
+	}
+
+	#[test]
+	fn merge_keeps_equal_elements_of_self_first() {
+		let mut v = SortedVec::from_unsorted(vec![Keyed(1, "a"), Keyed(3, "a"), Keyed(5, "a")]);
+		v.merge(SortedVec::from_unsorted(vec![Keyed(0, "b"), Keyed(3, "b"), Keyed(5, "b")]));
+		let merged: Vec<_> = v.iter().map(|k| (k.0, k.1)).collect();
+		assert_eq!(merged, vec![(0, "b"), (1, "a"), (3, "a"), (3, "b"), (5, "a"), (5, "b")]);
+	}
+
+	#[test]
+	fn merge_keeps_every_element_once_when_a_comparison_panics() {
+		let mut v = SortedVec::unchecked_from(vec![Keyed(2, "a"), Keyed(6, "a")]);
+		let other =
+			SortedVec::unchecked_from(vec![Keyed(1, "b"), Keyed(u32::MAX, "b"), Keyed(7, "b")]);
+		DROPPED.with(|dropped| dropped.set(0));
+		// 7 is merged, then comparing 6 with the poisoned element panics.
+		let merged = std::panic::catch_unwind(std::panic::AssertUnwindSafe(move || {
+			v.merge(other);
+			v
+		}));
+		assert!(merged.is_err());
+		assert_eq!(DROPPED.with(|dropped| dropped.get()), 5);
+	}
+
+	#[test]
+	fn try_extend_sorted_works() {
+		let mut v = SortedVec::from_unsorted(vec![1, 5]);
+		assert_eq!(v.try_extend_sorted(vec![2, 3, 6]), Ok(()));
+		assert_eq!(*v, vec![1, 2, 3, 5, 6]);
+
+		assert_eq!(v.try_extend_sorted(vec![3, 2]), Err(vec![3, 2]));
+		assert_eq!(*v, vec![1, 2, 3, 5, 6]);
+	}
+
 	#[test]
 	fn unsorted_fail_to_decode() {
 		let v: Vec<u32> = vec![1, 2, 5, 4];
@@ -0,0 +1,410 @@
+//! Streaming extraction of values from JSON documents.
+//!
+//! The document is read byte per byte and never materialized: only the values addressed by a set
+//! of [RFC 6901](https://www.rfc-editor.org/rfc/rfc6901) JSON pointers are decoded, everything
+//! else is skipped. Memory use is bounded by the depth of the pointers, not by the size of the
+//! document.
+use sp_std::{vec, vec::Vec};
+
+/// Maximum nesting depth of a document.
+pub const MAX_DEPTH: usize = 128;
+
+/// Maximum length of a number literal.
+const MAX_NUMBER_LEN: usize = 64;
+
+/// Errors while extracting values from a JSON document.
+#[derive(Debug, PartialEq, Eq, Clone, Copy)]
+pub enum JsonError {
+	/// The document is larger than the allowed length.
+	TooLarge,
+	/// The document nests deeper than [`MAX_DEPTH`].
+	TooDeep,
+	/// The document is not well-formed JSON.
+	Malformed,
+}
+
+/// Extract the numbers addressed by `pointers` from the JSON document read from `input`.
+///
+/// Returns, for each pointer and in the same order, `Some` number if the pointer resolves to a
+/// number, `None` if it is not a valid pointer, doesn't resolve or resolves to another kind of
+/// value. Reading more than `max_len` bytes fails with [`JsonError::TooLarge`].
+///
+/// The values which are not on the path of any pointer are scanned without being decoded nor
+/// validated.
+pub fn extract_numbers<I, P>(
+	input: I,
+	pointers: &[P],
+	max_len: usize,
+) -> Result<Vec<Option<f64>>, JsonError>
+where
+	I: IntoIterator<Item = u8>,
+	P: AsRef<[u8]>,
+{
+	let pointers: Vec<Option<Vec<Vec<u8>>>> =
+		pointers.iter().map(|pointer| parse_pointer(pointer.as_ref())).collect();
+	let mut extractor = Extractor {
+		input: input.into_iter(),
+		peeked: None,
+		read: 0,
+		max_len,
+		pointers: &pointers,
+		path: Vec::new(),
+		found: vec![None; pointers.len()],
+	};
+
+	extractor.value()?;
+	extractor.skip_whitespace()?;
+	if extractor.peek()?.is_some() {
+		return Err(JsonError::Malformed)
+	}
+	Ok(extractor.found)
+}
+
+/// Split a JSON pointer into its unescaped reference tokens, `None` if it is not a valid pointer.
+fn parse_pointer(pointer: &[u8]) -> Option<Vec<Vec<u8>>> {
+	match pointer.split_first() {
+		None => Some(Vec::new()),
+		Some((b'/', tokens)) => tokens
+			.split(|b| *b == b'/')
+			.map(|token| {
+				let mut unescaped = Vec::with_capacity(token.len());
+				let mut bytes = token.iter();
+				while let Some(b) = bytes.next() {
+					match b {
+						b'~' => match bytes.next() {
+							Some(b'0') => unescaped.push(b'~'),
+							Some(b'1') => unescaped.push(b'/'),
+							_ => return None,
+						},
+						b => unescaped.push(*b),
+					}
+				}
+				Some(unescaped)
+			})
+			.collect(),
+		Some(_) => None,
+	}
+}
+
+/// Decimal representation of an array index, as found in pointer tokens.
+fn decimal(mut index: u32) -> Vec<u8> {
+	let mut digits = Vec::new();
+	loop {
+		digits.push(b'0' + (index % 10) as u8);
+		index /= 10;
+		if index == 0 {
+			break
+		}
+	}
+	digits.reverse();
+	digits
+}
+
+struct Extractor<'p, I> {
+	input: I,
+	peeked: Option<u8>,
+	read: usize,
+	max_len: usize,
+	pointers: &'p [Option<Vec<Vec<u8>>>],
+	/// Reference tokens of the value being read.
+	path: Vec<Vec<u8>>,
+	found: Vec<Option<f64>>,
+}
+
+impl<'p, I: Iterator<Item = u8>> Extractor<'p, I> {
+	fn peek(&mut self) -> Result<Option<u8>, JsonError> {
+		if self.peeked.is_none() {
+			self.peeked = self.input.next();
+			if self.peeked.is_some() {
+				self.read = self.read.saturating_add(1);
+				if self.read > self.max_len {
+					return Err(JsonError::TooLarge)
+				}
+			}
+		}
+		Ok(self.peeked)
+	}
+
+	fn next(&mut self) -> Result<u8, JsonError> {
+		let b = self.peek()?.ok_or(JsonError::Malformed)?;
+		self.peeked = None;
+		Ok(b)
+	}
+
+	fn expect(&mut self, expected: u8) -> Result<(), JsonError> {
+		if self.next()? == expected {
+			Ok(())
+		} else {
+			Err(JsonError::Malformed)
+		}
+	}
+
+	fn skip_whitespace(&mut self) -> Result<(), JsonError> {
+		while let Some(b' ' | b'\t' | b'\n' | b'\r') = self.peek()? {
+			self.peeked = None;
+		}
+		Ok(())
+	}
+
+	/// Whether the value being read is on the path of at least one pointer.
+	fn is_wanted(&self) -> bool {
+		self.pointers.iter().flatten().any(|tokens| tokens.starts_with(&self.path))
+	}
+
+	fn value(&mut self) -> Result<(), JsonError> {
+		if self.path.len() > MAX_DEPTH {
+			return Err(JsonError::TooDeep)
+		}
+		self.skip_whitespace()?;
+		if !self.is_wanted() {
+			return self.skip_value()
+		}
+		match self.peek()?.ok_or(JsonError::Malformed)? {
+			b'{' => self.object(),
+			b'[' => self.array(),
+			b'-' | b'0'..=b'9' => {
+				let number = self.number()?;
+				for (tokens, found) in self.pointers.iter().zip(self.found.iter_mut()) {
+					if tokens.as_ref() == Some(&self.path) {
+						*found = Some(number);
+					}
+				}
+				Ok(())
+			},
+			_ => self.skip_value(),
+		}
+	}
+
+	fn object(&mut self) -> Result<(), JsonError> {
+		self.expect(b'{')?;
+		self.skip_whitespace()?;
+		if self.peek()? == Some(b'}') {
+			self.peeked = None;
+			return Ok(())
+		}
+		loop {
+			self.skip_whitespace()?;
+			let key = self.string()?;
+			self.skip_whitespace()?;
+			self.expect(b':')?;
+			self.path.push(key);
+			self.value()?;
+			self.path.pop();
+			self.skip_whitespace()?;
+			match self.next()? {
+				b',' => continue,
+				b'}' => return Ok(()),
+				_ => return Err(JsonError::Malformed),
+			}
+		}
+	}
+
+	fn array(&mut self) -> Result<(), JsonError> {
+		self.expect(b'[')?;
+		self.skip_whitespace()?;
+		if self.peek()? == Some(b']') {
+			self.peeked = None;
+			return Ok(())
+		}
+		let mut index = 0_u32;
+		loop {
+			self.path.push(decimal(index));
+			self.value()?;
+			self.path.pop();
+			self.skip_whitespace()?;
+			match self.next()? {
+				b',' => index = index.saturating_add(1),
+				b']' => return Ok(()),
+				_ => return Err(JsonError::Malformed),
+			}
+		}
+	}
+
+	fn number(&mut self) -> Result<f64, JsonError> {
+		let mut literal = [0_u8; MAX_NUMBER_LEN];
+		let mut len = 0;
+		while let Some(b @ (b'-' | b'+' | b'.' | b'e' | b'E' | b'0'..=b'9')) = self.peek()? {
+			*literal.get_mut(len).ok_or(JsonError::Malformed)? = b;
+			len += 1;
+			self.peeked = None;
+		}
+		literal
+			.get(..len)
+			.and_then(|literal| core::str::from_utf8(literal).ok())
+			.and_then(|literal| literal.parse::<f64>().ok())
+			.ok_or(JsonError::Malformed)
+	}
+
+	/// Read and unescape a string.
+	fn string(&mut self) -> Result<Vec<u8>, JsonError> {
+		self.expect(b'"')?;
+		let mut unescaped = Vec::new();
+		loop {
+			match self.next()? {
+				b'"' => return Ok(unescaped),
+				b'\\' => match self.next()? {
+					b @ (b'"' | b'\\' | b'/') => unescaped.push(b),
+					b'b' => unescaped.push(0x08),
+					b'f' => unescaped.push(0x0c),
+					b'n' => unescaped.push(b'\n'),
+					b'r' => unescaped.push(b'\r'),
+					b't' => unescaped.push(b'\t'),
+					b'u' => {
+						let mut utf8 = [0_u8; 4];
+						unescaped.extend_from_slice(
+							self.unicode_escape()?.encode_utf8(&mut utf8).as_bytes(),
+						);
+					},
+					_ => return Err(JsonError::Malformed),
+				},
+				b => unescaped.push(b),
+			}
+		}
+	}
+
+	fn hex4(&mut self) -> Result<u32, JsonError> {
+		let mut code = 0;
+		for _ in 0..4 {
+			let digit = (self.next()? as char).to_digit(16).ok_or(JsonError::Malformed)?;
+			code = code * 16 + digit;
+		}
+		Ok(code)
+	}
+
+	/// Decode the code point of a `\u` escape, including surrogate pairs.
+	fn unicode_escape(&mut self) -> Result<char, JsonError> {
+		let high = self.hex4()?;
+		let code = if (0xD800..0xDC00).contains(&high) {
+			self.expect(b'\\')?;
+			self.expect(b'u')?;
+			let low = self.hex4()?;
+			if !(0xDC00..0xE000).contains(&low) {
+				return Err(JsonError::Malformed)
+			}
+			0x10000 + ((high - 0xD800) << 10) + (low - 0xDC00)
+		} else {
+			high
+		};
+		char::from_u32(code).ok_or(JsonError::Malformed)
+	}
+
+	/// Skip the string whose opening quote has already been read.
+	fn skip_string(&mut self) -> Result<(), JsonError> {
+		loop {
+			match self.next()? {
+				b'"' => return Ok(()),
+				b'\\' => {
+					self.next()?;
+				},
+				_ => {},
+			}
+		}
+	}
+
+	/// Skip the next value without decoding it.
+	fn skip_value(&mut self) -> Result<(), JsonError> {
+		let mut depth = 0_usize;
+		loop {
+			self.skip_whitespace()?;
+			match self.next()? {
+				b'{' | b'[' => {
+					depth += 1;
+					if self.path.len().saturating_add(depth) > MAX_DEPTH {
+						return Err(JsonError::TooDeep)
+					}
+				},
+				b'}' | b']' => depth = depth.checked_sub(1).ok_or(JsonError::Malformed)?,
+				b'"' => self.skip_string()?,
+				b',' | b':' if depth > 0 => continue,
+				b'-' | b'0'..=b'9' | b't' | b'f' | b'n' => {
+					while let Some(b'a'..=b'z' | b'0'..=b'9' | b'-' | b'+' | b'.' | b'E') =
+						self.peek()?
+					{
+						self.peeked = None;
+					}
+				},
+				_ => return Err(JsonError::Malformed),
+			}
+			if depth == 0 {
+				return Ok(())
+			}
+		}
+	}
+}
+
+#[cfg(test)]
+mod tests {
+	use super::*;
+
+	const TICKER: &[u8] = br#"{
+		"data": {"BTC": {"USD": 19034.5, "EUR": 1.9e4}, "ETH": {"USD": -1337}},
+		"list": [{"p": 1}, {"p": 2.5}, {"p": "3"}],
+		"meta": {"name": "tick\"er", "a/b": 7, "m~n": 8, "\u00e9": 9, "ok": true, "none": null}
+	}"#;
+
+	fn extract(pointers: &[&str]) -> Result<Vec<Option<f64>>, JsonError> {
+		extract_numbers(TICKER.iter().copied(), pointers, TICKER.len())
+	}
+
+	#[test]
+	fn extracts_many_pointers_in_one_pass() {
+		assert_eq!(
+			extract(&["/data/BTC/USD", "/data/BTC/EUR", "/data/ETH/USD", "/list/1/p"]),
+			Ok(vec![Some(19034.5), Some(19000.0), Some(-1337.0), Some(2.5)]),
+		);
+	}
+
+	#[test]
+	fn unresolved_or_non_number_pointers_are_none() {
+		assert_eq!(
+			extract(&["/data/BTC/GBP", "/list/2/p", "/list/9/p", "/meta/ok", "/data", "data"]),
+			Ok(vec![None, None, None, None, None, None]),
+		);
+	}
+
+	#[test]
+	fn escaped_tokens_and_keys_resolve() {
+		assert_eq!(
+			extract(&["/meta/a~1b", "/meta/m~0n", "/meta/\u{e9}", "/meta/m~2n"]),
+			Ok(vec![Some(7.0), Some(8.0), Some(9.0), None]),
+		);
+	}
+
+	#[test]
+	fn root_pointer_resolves_a_number_document() {
+		assert_eq!(extract_numbers(b" 42 ".iter().copied(), &[""], 4), Ok(vec![Some(42.0)]));
+	}
+
+	#[test]
+	fn too_large_document_fails() {
+		assert_eq!(
+			extract_numbers(TICKER.iter().copied(), &["/data/BTC/USD"], TICKER.len() - 1),
+			Err(JsonError::TooLarge),
+		);
+	}
+
+	#[test]
+	fn malformed_document_fails() {
+		assert_eq!(
+			extract_numbers(br#"{"a": 1,}"#.iter().copied(), &["/a"], 64),
+			Err(JsonError::Malformed),
+		);
+		assert_eq!(
+			extract_numbers(br#"{"a": 1} x"#.iter().copied(), &["/a"], 64),
+			Err(JsonError::Malformed),
+		);
+		assert_eq!(
+			extract_numbers(br#"{"a": [1, 2"#.iter().copied(), &["/b"], 64),
+			Err(JsonError::Malformed),
+		);
+	}
+
+	#[test]
+	fn too_deep_document_fails() {
+		let deep = [b'['; MAX_DEPTH + 2];
+		assert_eq!(
+			extract_numbers(deep.iter().copied(), &["/0"], deep.len()),
+			Err(JsonError::TooDeep),
+		);
+	}
+}
@@ -14,7 +14,12 @@
 
 pub mod abstractions;
 pub mod collections;
+pub mod json;
 pub mod math;
+pub mod native_fetch;
+pub mod offchain_metrics;
+#[cfg(feature = "std")]
+pub mod offchain_simulation;
 pub mod rpc_helpers;
 pub mod signature_verification;
 pub mod types;
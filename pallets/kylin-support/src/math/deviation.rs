@@ -0,0 +1,51 @@
+use sp_runtime::{traits::Saturating, Permill};
+
+/// Whether `value` deviates from `last` by at least `deviation`, a zero deviation being met by
+/// any value.
+pub fn deviates(last: i64, value: i64, deviation: Permill) -> bool {
+	let diff = (value as i128 - last as i128).unsigned_abs();
+	diff * 1_000_000 >= deviation.deconstruct() as u128 * (last as i128).unsigned_abs()
+}
+
+/// Whether a new `value` is due at block `now`, `last` being the last value sent and the block
+/// it was sent at: it is if none was sent yet, if `heartbeat` blocks elapsed since, or if it
+/// deviates from the last one by at least `deviation`.
+pub fn is_due<BlockNumber>(
+	last: Option<(i64, BlockNumber)>,
+	value: i64,
+	now: BlockNumber,
+	heartbeat: BlockNumber,
+	deviation: Permill,
+) -> bool
+where
+	BlockNumber: Saturating + PartialOrd + Copy,
+{
+	match last {
+		None => true,
+		Some((last, at)) => now >= at.saturating_add(heartbeat) || deviates(last, value, deviation),
+	}
+}
+
+#[cfg(test)]
+mod tests {
+	use super::*;
+
+	#[test]
+	fn deviation_is_relative_to_the_last_value() {
+		assert!(deviates(1_000, 1_010, Permill::from_percent(1)));
+		assert!(deviates(1_000, 990, Permill::from_percent(1)));
+		assert!(!deviates(1_000, 1_009, Permill::from_percent(1)));
+		assert!(deviates(1_000, 1_000, Permill::zero()));
+		assert!(deviates(0, 1, Permill::from_percent(50)));
+	}
+
+	#[test]
+	fn due_on_first_value_heartbeat_or_deviation() {
+		let deviation = Permill::from_percent(1);
+		assert!(is_due::<u32>(None, 1_000, 1, 10, deviation));
+		assert!(!is_due(Some((1_000, 1u32)), 1_001, 10, 10, deviation));
+		assert!(is_due(Some((1_000, 1u32)), 1_001, 11, 10, deviation));
+		assert!(is_due(Some((1_000, 1u32)), 1_100, 2, 10, deviation));
+		assert!(is_due(Some((1_000, u32::MAX)), 1_000, u32::MAX, 10, deviation));
+	}
+}
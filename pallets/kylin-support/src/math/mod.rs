@@ -1,2 +1,3 @@
+pub mod deviation;
 pub mod safe;
 pub mod wrapping_next;
@@ -0,0 +1,133 @@
+//! Hand-off of the HTTP fetches of offchain workers to the native fetcher of the node.
+//!
+//! An offchain worker [`request`]s the endpoints it is due to fetch, along with the JSON pointers
+//! of the values to extract from their response, in the offchain local storage. The native
+//! fetcher of the node fetches every endpoint once per request and writes its [`FetchResult`]
+//! next to it, where the worker picks it up in its next run. Values are thus submitted a run
+//! later than when fetched in wasm, in exchange for the worker doing no HTTP nor JSON work.
+//!
+//! The worker keeps fetching on its own while the fetcher is not [`is_alive`].
+use codec::{Decode, Encode};
+use sp_runtime::{offchain::storage::StorageValueRef, RuntimeDebug};
+use sp_std::vec::Vec;
+
+/// Key of the time the native fetcher was last alive at, in Unix milliseconds.
+pub const ALIVE_KEY: &[u8] = b"kylin_support::native_fetch::alive";
+
+/// Time after which a silent native fetcher is considered gone, in milliseconds.
+pub const ALIVE_TIMEOUT_MS: u64 = 30_000;
+
+/// Namespaces of the pallets whose requests are served by the native fetcher.
+pub const NAMESPACES: &[&[u8]] = &[b"kylin_oracle", b"kylin_reporter"];
+
+/// Endpoints to fetch, written by an offchain worker.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct FetchRequests {
+	/// Time the endpoints were requested at, in Unix milliseconds.
+	pub requested_at: u64,
+	/// Responses larger than this many bytes are rejected.
+	pub max_response_size: u32,
+	/// Each endpoint, with the JSON pointers of the values to extract from its response.
+	pub endpoints: Vec<(Vec<u8>, Vec<Vec<u8>>)>,
+}
+
+/// Outcome of the fetch of an endpoint, written by the native fetcher.
+#[derive(Encode, Decode, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct FetchResult {
+	/// Time the endpoint was fetched at, in Unix milliseconds.
+	pub fetched_at: u64,
+	/// Latency of the fetch in milliseconds.
+	pub latency: u64,
+	/// Each requested pointer with its [`to_fixed`] value, or `None` if the fetch failed.
+	pub values: Option<Vec<(Vec<u8>, Option<i64>)>>,
+}
+
+/// Key of the requests of `namespace`.
+pub fn requests_key(namespace: &[u8]) -> Vec<u8> {
+	let mut key = namespace.to_vec();
+	key.extend_from_slice(b"::native_fetch::requests");
+	key
+}
+
+/// Key of the result of the fetch of `url` requested by `namespace`.
+pub fn result_key(namespace: &[u8], url: &[u8]) -> Vec<u8> {
+	let mut key = namespace.to_vec();
+	key.extend_from_slice(b"::native_fetch::result::");
+	key.extend_from_slice(&sp_io::hashing::blake2_128(url));
+	key
+}
+
+/// Fixed point representation of a fetched number: values are only stored as integers, with
+/// 6 decimals.
+pub fn to_fixed(value: f64) -> i64 {
+	(value * 1_000_000.0) as i64
+}
+
+/// Whether the native fetcher showed a sign of life recently, `now` being in Unix milliseconds.
+pub fn is_alive(now: u64) -> bool {
+	StorageValueRef::persistent(ALIVE_KEY)
+		.get::<u64>()
+		.ok()
+		.flatten()
+		.map_or(false, |alive| alive.saturating_add(ALIVE_TIMEOUT_MS) >= now)
+}
+
+/// Request the fetch of `endpoints` on behalf of `namespace`, and return the results of the
+/// previous request for each of them.
+///
+/// Each endpoint comes with its pointers, and gets back the value at each of them. `None` stands
+/// for an endpoint not fetched since the previous request, or fetched for other pointers, which
+/// is to be requested again.
+pub fn request<U, P>(
+	namespace: &[u8],
+	endpoints: &[(U, Vec<P>)],
+	max_response_size: u32,
+	now: u64,
+) -> Vec<Option<(u64, Option<Vec<Option<i64>>>)>>
+where
+	U: AsRef<[u8]>,
+	P: AsRef<[u8]>,
+{
+	let requests = StorageValueRef::persistent(&requests_key(namespace));
+	let previous = requests.get::<FetchRequests>().ok().flatten();
+
+	let results = endpoints
+		.iter()
+		.map(|(url, pointers)| {
+			let requested_at = previous.as_ref()?.requested_at;
+			let result = StorageValueRef::persistent(&result_key(namespace, url.as_ref()))
+				.get::<FetchResult>()
+				.ok()
+				.flatten()
+				.filter(|result| result.fetched_at >= requested_at)?;
+			let values = match result.values {
+				Some(values) => Some(
+					pointers
+						.iter()
+						.map(|pointer| {
+							values
+								.iter()
+								.find(|(fetched, _)| fetched.as_slice() == pointer.as_ref())
+								.map(|(_, value)| *value)
+						})
+						.collect::<Option<Vec<_>>>()?,
+				),
+				None => None,
+			};
+			Some((result.latency, values))
+		})
+		.collect();
+
+	requests.set(&FetchRequests {
+		requested_at: now,
+		max_response_size,
+		endpoints: endpoints
+			.iter()
+			.map(|(url, pointers)| {
+				let pointers = pointers.iter().map(|pointer| pointer.as_ref().to_vec()).collect();
+				(url.as_ref().to_vec(), pointers)
+			})
+			.collect(),
+	});
+	results
+}
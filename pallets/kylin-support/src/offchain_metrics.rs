@@ -0,0 +1,48 @@
+//! Metrics of the offchain workers, recorded in the offchain local storage for the node to
+//! export.
+//!
+//! Each worker overwrites the [`WorkerRun`] of its namespace at the end of every run, the node
+//! exporting every run it has not seen yet.
+use codec::{Decode, Encode};
+use sp_runtime::{offchain::storage::StorageValueRef, RuntimeDebug};
+use sp_std::vec::Vec;
+
+/// Fetch of an endpoint in a run.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct EndpointFetch {
+	/// Url of the endpoint.
+	pub url: Vec<u8>,
+	/// Latency of the fetch in milliseconds.
+	pub latency: u64,
+	/// Whether the response was fetched and parsed.
+	pub success: bool,
+	/// Number of values extracted from the response.
+	pub values: u32,
+}
+
+/// Outcome of an offchain worker run.
+#[derive(Encode, Decode, Default, Clone, PartialEq, Eq, RuntimeDebug)]
+pub struct WorkerRun {
+	/// Time the run finished at, in Unix milliseconds.
+	pub finished_at: u64,
+	/// Wall time of the run in milliseconds.
+	pub duration: u64,
+	/// Number of feeds due in the run.
+	pub due: u32,
+	/// Number of values submitted by the run, zero if no transaction was accepted.
+	pub submitted: u32,
+	/// Endpoints whose fetch completed in the run.
+	pub fetches: Vec<EndpointFetch>,
+}
+
+/// Key of the last run of `namespace`.
+pub fn last_run_key(namespace: &[u8]) -> Vec<u8> {
+	let mut key = namespace.to_vec();
+	key.extend_from_slice(b"::metrics::last_run");
+	key
+}
+
+/// Record `run` as the last run of `namespace`.
+pub fn record_run(namespace: &[u8], run: &WorkerRun) {
+	StorageValueRef::persistent(&last_run_key(namespace)).set(run);
+}
@@ -0,0 +1,515 @@
+//! Simulation of the HTTP endpoints and the clock of offchain workers, to load test them.
+//!
+//! A [`Simulation`] registers offchain externalities with a `TestExternalities` whose HTTP
+//! requests are answered by simulated [`Endpoint`]s, each with its own latency, failure rate and
+//! response body. The offchain local storage is the one of `sp_core::offchain::testing`, the
+//! clock only advances when the worker waits on requests or sleeps, and transactions are
+//! recorded instead of being submitted. Every run yields a [`RunReport`], so that changes to the
+//! fetch pipeline are measured against the same load rather than guessed.
+use std::{
+	alloc::{GlobalAlloc, Layout, System},
+	collections::BTreeMap,
+	sync::{
+		atomic::{AtomicUsize, Ordering},
+		Arc, Mutex, MutexGuard,
+	},
+	time::{Duration, Instant},
+};
+
+use sp_core::offchain::{
+	testing::TestOffchainExt, DbExternalities, Externalities, HttpError, HttpRequestId,
+	HttpRequestStatus, OffchainDbExt, OffchainWorkerExt, OpaqueNetworkState, OpaquePeerId,
+	StorageKind, Timestamp, TransactionPool, TransactionPoolExt,
+};
+use sp_io::TestExternalities;
+
+/// Behaviour of a simulated HTTP endpoint.
+#[derive(Clone, Debug, PartialEq)]
+pub struct Endpoint {
+	/// Url the endpoint answers to.
+	pub url: String,
+	/// Time from the start of a request to its response, in milliseconds.
+	pub latency: u64,
+	/// Fraction of the requests answered with a 500 error, from 0 to 1.
+	pub failure_rate: f64,
+	/// Body of the successful responses.
+	pub body: Vec<u8>,
+}
+
+impl Endpoint {
+	/// An endpoint answering `{"value":<value>}` at once, padded to `size` bytes.
+	///
+	/// The value is at the `/value` JSON pointer.
+	pub fn json(url: impl Into<String>, value: f64, size: usize) -> Self {
+		let value = format!("{{\"value\":{},\"padding\":\"", value);
+		let padding = size.saturating_sub(value.len() + 2);
+		let mut body = value.into_bytes();
+		body.resize(body.len() + padding, b'x');
+		body.extend_from_slice(b"\"}");
+		Self { url: url.into(), latency: 0, failure_rate: 0.0, body }
+	}
+
+	/// The same endpoint, answering after `latency` milliseconds.
+	pub fn with_latency(mut self, latency: u64) -> Self {
+		self.latency = latency;
+		self
+	}
+
+	/// The same endpoint, failing this fraction of the requests.
+	pub fn with_failure_rate(mut self, failure_rate: f64) -> Self {
+		self.failure_rate = failure_rate;
+		self
+	}
+}
+
+/// Outcome of a simulated offchain worker run.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct RunReport {
+	/// Simulated wall time of the run, in milliseconds.
+	pub wall_time: u64,
+	/// Host time spent running the worker.
+	pub cpu_time: Duration,
+	/// HTTP requests started by the run.
+	pub requests: u32,
+	/// Requests that failed, or were made to an unknown url.
+	pub failures: u32,
+	/// Response bytes read by the run.
+	pub bytes_read: u64,
+	/// Transactions submitted by the run, encoded.
+	pub transactions: Vec<Vec<u8>>,
+	/// Peak heap usage of the run above the usage it started with, in bytes, only measured if
+	/// [`PeakAllocator`] is the global allocator.
+	pub heap_peak: usize,
+}
+
+/// Global allocator keeping track of the peak heap usage, for the [`RunReport`]s.
+///
+/// Installed by a test crate with:
+/// ```ignore
+/// #[global_allocator]
+/// static ALLOCATOR: PeakAllocator = PeakAllocator;
+/// ```
+pub struct PeakAllocator;
+
+static HEAP_IN_USE: AtomicUsize = AtomicUsize::new(0);
+static HEAP_PEAK: AtomicUsize = AtomicUsize::new(0);
+
+unsafe impl GlobalAlloc for PeakAllocator {
+	unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+		let ptr = System.alloc(layout);
+		if !ptr.is_null() {
+			let in_use = HEAP_IN_USE.fetch_add(layout.size(), Ordering::Relaxed) + layout.size();
+			HEAP_PEAK.fetch_max(in_use, Ordering::Relaxed);
+		}
+		ptr
+	}
+
+	unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+		System.dealloc(ptr, layout);
+		HEAP_IN_USE.fetch_sub(layout.size(), Ordering::Relaxed);
+	}
+}
+
+/// A request in flight.
+struct Request {
+	/// Index of the endpoint answering it, `None` for an unknown url.
+	endpoint: Option<usize>,
+	/// Time the response is available at, in Unix milliseconds.
+	done_at: u64,
+	failed: bool,
+	/// Bytes of the body read so far.
+	read: usize,
+}
+
+#[derive(Default)]
+struct State {
+	endpoints: Vec<Endpoint>,
+	/// Simulated clock, in Unix milliseconds.
+	now: u64,
+	/// State of the xorshift generator drawing the failures.
+	rng: u64,
+	requests: BTreeMap<u16, Request>,
+	next_request: u16,
+	report: RunReport,
+}
+
+impl State {
+	/// Uniform draw in `[0, 1)`.
+	fn draw(&mut self) -> f64 {
+		self.rng ^= self.rng << 13;
+		self.rng ^= self.rng >> 7;
+		self.rng ^= self.rng << 17;
+		(self.rng >> 11) as f64 / (1u64 << 53) as f64
+	}
+}
+
+/// Simulated HTTP endpoints and clock, shared by the externalities of a [`Simulation`].
+#[derive(Clone)]
+pub struct Simulation {
+	state: Arc<Mutex<State>>,
+}
+
+impl Simulation {
+	/// A simulation of `endpoints` starting at `now`, in Unix milliseconds, the failures being
+	/// drawn from `seed`.
+	pub fn new(endpoints: Vec<Endpoint>, now: u64, seed: u64) -> Self {
+		let state = State { endpoints, now, rng: seed.max(1), ..Default::default() };
+		Self { state: Arc::new(Mutex::new(state)) }
+	}
+
+	fn state(&self) -> MutexGuard<'_, State> {
+		self.state.lock().unwrap_or_else(|poisoned| poisoned.into_inner())
+	}
+
+	/// Register the simulated offchain worker, offchain database and transaction pool with
+	/// `ext`.
+	pub fn register(&self, ext: &mut TestExternalities) {
+		let (storage, _) = TestOffchainExt::new();
+		let offchain = SimulatedOffchainExt { simulation: self.clone(), storage };
+		ext.register_extension(OffchainWorkerExt::new(offchain.clone()));
+		ext.register_extension(OffchainDbExt::new(offchain));
+		ext.register_extension(TransactionPoolExt::new(self.clone()));
+	}
+
+	/// Current time of the simulated clock, in Unix milliseconds.
+	pub fn now(&self) -> u64 {
+		self.state().now
+	}
+
+	/// Advance the simulated clock by `millis`, e.g. between blocks.
+	pub fn advance(&self, millis: u64) {
+		let mut state = self.state();
+		state.now = state.now.saturating_add(millis);
+	}
+
+	/// Change the behaviour of the endpoints, e.g. to degrade them in the middle of a run of
+	/// blocks.
+	pub fn update_endpoints(&self, update: impl FnOnce(&mut Vec<Endpoint>)) {
+		update(&mut self.state().endpoints)
+	}
+
+	/// Run `worker` in `ext` and report on the run.
+	pub fn run(&self, ext: &mut TestExternalities, worker: impl FnOnce()) -> RunReport {
+		let started_at = {
+			let mut state = self.state();
+			state.report = RunReport::default();
+			state.now
+		};
+		let heap_at_start = HEAP_IN_USE.load(Ordering::Relaxed);
+		HEAP_PEAK.store(heap_at_start, Ordering::Relaxed);
+
+		let start = Instant::now();
+		ext.execute_with(worker);
+		let cpu_time = start.elapsed();
+
+		let heap_peak = HEAP_PEAK.load(Ordering::Relaxed).saturating_sub(heap_at_start);
+		let mut state = self.state();
+		let wall_time = state.now.saturating_sub(started_at);
+		state.requests.clear();
+		RunReport { wall_time, cpu_time, heap_peak, ..std::mem::take(&mut state.report) }
+	}
+
+	/// Run `worker` for each of `blocks`, starting `block_time` milliseconds apart, and report
+	/// on each run.
+	///
+	/// A run longer than `block_time` delays the next one, as an overloaded worker would.
+	pub fn run_blocks<B>(
+		&self,
+		ext: &mut TestExternalities,
+		blocks: impl IntoIterator<Item = B>,
+		block_time: u64,
+		mut worker: impl FnMut(B),
+	) -> Vec<RunReport> {
+		blocks
+			.into_iter()
+			.map(|block| {
+				let report = self.run(ext, || worker(block));
+				self.advance(block_time.saturating_sub(report.wall_time));
+				report
+			})
+			.collect()
+	}
+}
+
+impl TransactionPool for Simulation {
+	fn submit_transaction(&mut self, extrinsic: Vec<u8>) -> Result<(), ()> {
+		self.state().report.transactions.push(extrinsic);
+		Ok(())
+	}
+}
+
+/// Offchain externalities answering HTTP requests from a [`Simulation`], the rest being those
+/// of `sp_core::offchain::testing`.
+#[derive(Clone)]
+struct SimulatedOffchainExt {
+	simulation: Simulation,
+	storage: TestOffchainExt,
+}
+
+impl Externalities for SimulatedOffchainExt {
+	fn is_validator(&self) -> bool {
+		self.storage.is_validator()
+	}
+
+	fn network_state(&self) -> Result<OpaqueNetworkState, ()> {
+		self.storage.network_state()
+	}
+
+	fn timestamp(&mut self) -> Timestamp {
+		Timestamp::from_unix_millis(self.simulation.now())
+	}
+
+	fn sleep_until(&mut self, deadline: Timestamp) {
+		let mut state = self.simulation.state();
+		state.now = state.now.max(deadline.unix_millis());
+	}
+
+	fn random_seed(&mut self) -> [u8; 32] {
+		self.storage.random_seed()
+	}
+
+	fn http_request_start(
+		&mut self,
+		_method: &str,
+		uri: &str,
+		_meta: &[u8],
+	) -> Result<HttpRequestId, ()> {
+		let mut state = self.simulation.state();
+		let endpoint = state.endpoints.iter().position(|endpoint| endpoint.url == uri);
+		let (latency, failure_rate) = endpoint
+			.and_then(|index| state.endpoints.get(index))
+			.map_or((0, 1.0), |endpoint| (endpoint.latency, endpoint.failure_rate));
+		let failed = endpoint.is_none() || state.draw() < failure_rate;
+
+		let id = state.next_request;
+		state.next_request = id.wrapping_add(1);
+		let done_at = state.now.saturating_add(latency);
+		state.requests.insert(id, Request { endpoint, done_at, failed, read: 0 });
+		state.report.requests += 1;
+		if failed {
+			state.report.failures += 1;
+		}
+		Ok(HttpRequestId(id))
+	}
+
+	fn http_request_add_header(
+		&mut self,
+		request_id: HttpRequestId,
+		_name: &str,
+		_value: &str,
+	) -> Result<(), ()> {
+		self.simulation.state().requests.get(&request_id.0).map(|_| ()).ok_or(())
+	}
+
+	fn http_request_write_body(
+		&mut self,
+		request_id: HttpRequestId,
+		_chunk: &[u8],
+		_deadline: Option<Timestamp>,
+	) -> Result<(), HttpError> {
+		self.simulation.state().requests.get(&request_id.0).map(|_| ()).ok_or(HttpError::Invalid)
+	}
+
+	fn http_response_wait(
+		&mut self,
+		ids: &[HttpRequestId],
+		deadline: Option<Timestamp>,
+	) -> Vec<HttpRequestStatus> {
+		let mut state = self.simulation.state();
+		// Waiting lasts until every response is in, or until the deadline.
+		let last_done_at =
+			ids.iter().filter_map(|id| state.requests.get(&id.0)).map(|request| request.done_at).max();
+		if let Some(last_done_at) = last_done_at {
+			let until = deadline.map_or(last_done_at, |deadline| deadline.unix_millis().min(last_done_at));
+			state.now = state.now.max(until);
+		}
+
+		let now = state.now;
+		ids.iter()
+			.map(|id| match state.requests.get(&id.0) {
+				None => HttpRequestStatus::Invalid,
+				Some(request) if request.done_at > now => HttpRequestStatus::DeadlineReached,
+				Some(request) if request.failed => HttpRequestStatus::Finished(500),
+				Some(_) => HttpRequestStatus::Finished(200),
+			})
+			.collect()
+	}
+
+	fn http_response_headers(&mut self, _request_id: HttpRequestId) -> Vec<(Vec<u8>, Vec<u8>)> {
+		Vec::new()
+	}
+
+	fn http_response_read_body(
+		&mut self,
+		request_id: HttpRequestId,
+		buffer: &mut [u8],
+		_deadline: Option<Timestamp>,
+	) -> Result<usize, HttpError> {
+		let mut state = self.simulation.state();
+		let State { endpoints, requests, report, .. } = &mut *state;
+		let request = requests.get_mut(&request_id.0).ok_or(HttpError::Invalid)?;
+		let body = match request.endpoint.and_then(|index| endpoints.get(index)) {
+			Some(endpoint) if !request.failed => endpoint.body.as_slice(),
+			_ => b"".as_slice(),
+		};
+
+		let remaining = body.get(request.read..).unwrap_or_default();
+		let len = remaining.len().min(buffer.len());
+		if let (Some(to), Some(from)) = (buffer.get_mut(..len), remaining.get(..len)) {
+			to.copy_from_slice(from);
+		}
+		request.read += len;
+		report.bytes_read += len as u64;
+		Ok(len)
+	}
+
+	fn set_authorized_nodes(&mut self, nodes: Vec<OpaquePeerId>, authorized_only: bool) {
+		self.storage.set_authorized_nodes(nodes, authorized_only)
+	}
+}
+
+impl DbExternalities for SimulatedOffchainExt {
+	fn local_storage_set(&mut self, kind: StorageKind, key: &[u8], value: &[u8]) {
+		self.storage.local_storage_set(kind, key, value)
+	}
+
+	fn local_storage_clear(&mut self, kind: StorageKind, key: &[u8]) {
+		self.storage.local_storage_clear(kind, key)
+	}
+
+	fn local_storage_compare_and_set(
+		&mut self,
+		kind: StorageKind,
+		key: &[u8],
+		old_value: Option<&[u8]>,
+		new_value: &[u8],
+	) -> bool {
+		self.storage.local_storage_compare_and_set(kind, key, old_value, new_value)
+	}
+
+	fn local_storage_get(&mut self, kind: StorageKind, key: &[u8]) -> Option<Vec<u8>> {
+		self.storage.local_storage_get(kind, key)
+	}
+}
+
+#[cfg(test)]
+mod tests {
+	use super::*;
+	use sp_runtime::offchain::{http, Duration as OffchainDuration};
+
+	/// Fetch every url with a shared deadline, as the offchain workers do, and submit the
+	/// length of each body read.
+	fn fetch_all(urls: &[String], timeout: u64) -> Vec<Result<usize, http::Error>> {
+		let deadline = sp_io::offchain::timestamp().add(OffchainDuration::from_millis(timeout));
+		let requests: Vec<_> = urls
+			.iter()
+			.map(|url| http::Request::get(url).deadline(deadline).send().unwrap())
+			.collect();
+		let results: Vec<_> = http::PendingRequest::try_wait_all(requests, Some(deadline))
+			.into_iter()
+			.map(|response| match response {
+				Ok(Ok(response)) if response.code == 200 => Ok(response.body().count()),
+				Ok(Ok(_)) => Err(http::Error::IoError),
+				Ok(Err(e)) => Err(e),
+				Err(_) => Err(http::Error::DeadlineReached),
+			})
+			.collect();
+		let lengths: Vec<u32> =
+			results.iter().filter_map(|result| result.as_ref().ok()).map(|len| *len as u32).collect();
+		sp_io::offchain::submit_transaction(codec::Encode::encode(&lengths)).unwrap();
+		results
+	}
+
+	fn urls(simulation: &Simulation) -> Vec<String> {
+		simulation.state().endpoints.iter().map(|endpoint| endpoint.url.clone()).collect()
+	}
+
+	#[test]
+	fn json_endpoint_has_requested_size() {
+		let endpoint = Endpoint::json("https://a.test", 1.5, 64);
+		assert_eq!(endpoint.body.len(), 64);
+		assert!(endpoint.body.starts_with(b"{\"value\":1.5,"));
+	}
+
+	#[test]
+	fn concurrent_requests_take_the_slowest_latency() {
+		let simulation = Simulation::new(
+			vec![
+				Endpoint::json("https://a.test", 1.0, 100).with_latency(100),
+				Endpoint::json("https://b.test", 2.0, 1_000).with_latency(300),
+			],
+			1_000,
+			7,
+		);
+		let mut ext = TestExternalities::default();
+		simulation.register(&mut ext);
+		let urls = urls(&simulation);
+
+		let report = simulation.run(&mut ext, || {
+			assert_eq!(fetch_all(&urls, 10_000), vec![Ok(100), Ok(1_000)]);
+		});
+		assert_eq!(report.wall_time, 300);
+		assert_eq!(report.requests, 2);
+		assert_eq!(report.failures, 0);
+		assert_eq!(report.bytes_read, 1_100);
+		assert_eq!(report.transactions, vec![codec::Encode::encode(&vec![100u32, 1_000])]);
+	}
+
+	#[test]
+	fn deadline_cuts_slow_and_failing_endpoints() {
+		let simulation = Simulation::new(
+			vec![
+				Endpoint::json("https://a.test", 1.0, 10).with_latency(50),
+				Endpoint::json("https://slow.test", 1.0, 10).with_latency(20_000),
+				Endpoint::json("https://down.test", 1.0, 10).with_failure_rate(1.0),
+			],
+			0,
+			7,
+		);
+		let mut ext = TestExternalities::default();
+		simulation.register(&mut ext);
+		let urls = urls(&simulation);
+
+		let report = simulation.run(&mut ext, || {
+			let results = fetch_all(&urls, 10_000);
+			assert_eq!(results[0], Ok(10));
+			assert_eq!(results[1], Err(http::Error::DeadlineReached));
+			assert_eq!(results[2], Err(http::Error::IoError));
+		});
+		assert_eq!(report.wall_time, 10_000);
+		assert_eq!(report.failures, 1);
+	}
+
+	#[test]
+	fn failure_rate_is_drawn_per_request() {
+		let endpoints = (0..100)
+			.map(|i| Endpoint::json(format!("https://{}.test", i), 1.0, 10).with_failure_rate(0.3))
+			.collect();
+		let simulation = Simulation::new(endpoints, 0, 42);
+		let mut ext = TestExternalities::default();
+		simulation.register(&mut ext);
+		let urls = urls(&simulation);
+
+		let reports = simulation.run_blocks(&mut ext, 0..10, 6_000, |_| {
+			fetch_all(&urls, 10_000);
+		});
+		let failures: u32 = reports.iter().map(|report| report.failures).sum();
+		assert!((200..400).contains(&failures), "{} failures out of 1000", failures);
+		assert_eq!(simulation.now(), 60_000);
+	}
+
+	#[test]
+	fn offchain_storage_persists_across_runs() {
+		let simulation = Simulation::new(Vec::new(), 0, 1);
+		let mut ext = TestExternalities::default();
+		simulation.register(&mut ext);
+
+		simulation.run(&mut ext, || {
+			sp_io::offchain::local_storage_set(StorageKind::PERSISTENT, b"key", b"value");
+		});
+		simulation.run(&mut ext, || {
+			let value = sp_io::offchain::local_storage_get(StorageKind::PERSISTENT, b"key");
+			assert_eq!(value, Some(b"value".to_vec()));
+		});
+	}
+}
@@ -231,6 +231,7 @@ parameter_types! {
 	pub const EnactmentPeriod: BlockNumber = 30 * 24 * 60 * MINUTES;
 	pub const CooloffPeriod: BlockNumber = 28 * 24 * 60 * MINUTES;
 	pub const MaxProposals: u32 = 100;
+	pub MaxBakingWeight: Weight = Perbill::from_percent(10) * RuntimeBlockWeights::get().max_block;
 }
 
 impl kylin_democracy::Config for Runtime {
@@ -282,6 +283,7 @@ impl kylin_democracy::Config for Runtime {
 	type MaxVotes = frame_support::traits::ConstU32<100>;
 	type WeightInfo = kylin_democracy::weights::SubstrateWeight<Runtime>;
 	type MaxProposals = MaxProposals;
+	type MaxBakingWeight = MaxBakingWeight;
 }
 
 
@@ -1290,6 +1292,29 @@ impl_runtime_apis! {
 		}
 	}
 
+	impl kylin_oracle_runtime_api::KylinOracleApi<Block> for Runtime {
+		// This chain hosts no oracle, the API is only there for the node to serve every runtime.
+		fn get(_key: Vec<u8>) -> Option<(i64, u128)> {
+			None
+		}
+
+		fn get_many(keys: Vec<Vec<u8>>) -> Vec<Option<(i64, u128)>> {
+			keys.iter().map(|_| None).collect()
+		}
+
+		fn get_all_values() -> Vec<(Vec<u8>, (i64, u128))> {
+			Vec::new()
+		}
+
+		fn get_hot_values() -> Vec<(Vec<u8>, (i64, u128))> {
+			Vec::new()
+		}
+
+		fn get_history(_key: Vec<u8>, _from: u128, _to: u128) -> Vec<(i64, u128)> {
+			Vec::new()
+		}
+	}
+
 	impl cumulus_primitives_core::CollectCollationInfo<Block> for Runtime {
 		fn collect_collation_info(header: &<Block as BlockT>::Header) -> cumulus_primitives_core::CollationInfo {
 			ParachainSystem::collect_collation_info(header)
@@ -227,6 +227,7 @@ parameter_types! {
 	pub const EnactmentPeriod: BlockNumber = 30 * 24 * 60 * MINUTES;
 	pub const CooloffPeriod: BlockNumber = 28 * 24 * 60 * MINUTES;
 	pub const MaxProposals: u32 = 100;
+	pub MaxBakingWeight: Weight = Perbill::from_percent(10) * RuntimeBlockWeights::get().max_block;
 }
 
 impl kylin_democracy::Config for Runtime {
@@ -278,6 +279,7 @@ impl kylin_democracy::Config for Runtime {
 	type MaxVotes = frame_support::traits::ConstU32<100>;
 	type WeightInfo = kylin_democracy::weights::SubstrateWeight<Runtime>;
 	type MaxProposals = MaxProposals;
+	type MaxBakingWeight = MaxBakingWeight;
 }
 
 
@@ -636,6 +638,11 @@ impl cumulus_pallet_dmp_queue::Config for Runtime {
 	type ExecuteOverweightOrigin = frame_system::EnsureRoot<AccountId>;
 }
 
+parameter_types! {
+	pub const ReporterForwardDeviation: Permill = Permill::from_parts(5_000);
+	pub const ReporterForwardHeartbeat: BlockNumber = HOURS;
+}
+
 impl kylin_reporter::Config for Runtime {
 	type RuntimeEvent = RuntimeEvent;
 	type AuthorityId = kylin_reporter::crypto::TestAuthId;
@@ -645,6 +652,15 @@ impl kylin_reporter::Config for Runtime {
 	type WeightInfo = kylin_reporter::weights::SubstrateWeight<Runtime>;
 	type Currency = Balances;
 	type Members = OracleProvider;
+	type MaxResponseSize = ConstU32<{ 1024 * 1024 }>;
+	type UnixTime = Timestamp;
+	type CombineData = kylin_reporter::MedianCombineData<ConstU32<1>>;
+	type ForwardDeviation = ReporterForwardDeviation;
+	type ForwardHeartbeat = ReporterForwardHeartbeat;
+	// `xcm_feed_data` weight per value on the oracle chain
+	type XcmWeightPerValue = ConstU64<5_000_000_000>;
+	type XcmWeightBudget = ConstU64<100_000_000_000>;
+	type MaxPendingValues = ConstU32<200>;
 }
 
 parameter_types! {
@@ -1126,6 +1142,7 @@ impl kylin_feed::Config for Runtime {
 	type RuntimeOrigin = RuntimeOrigin;
 	type UnixTime = Timestamp;
 	type StringLimit = FeedStringLimit;
+	type MaxQueryKeys = ConstU32<64>;
 	type XcmSender = XcmRouter;
 }
 construct_runtime! {
@@ -1328,6 +1345,29 @@ impl_runtime_apis! {
 		}
 	}
 
+	impl kylin_oracle_runtime_api::KylinOracleApi<Block> for Runtime {
+		// This chain hosts no oracle, the API is only there for the node to serve every runtime.
+		fn get(_key: Vec<u8>) -> Option<(i64, u128)> {
+			None
+		}
+
+		fn get_many(keys: Vec<Vec<u8>>) -> Vec<Option<(i64, u128)>> {
+			keys.iter().map(|_| None).collect()
+		}
+
+		fn get_all_values() -> Vec<(Vec<u8>, (i64, u128))> {
+			Vec::new()
+		}
+
+		fn get_hot_values() -> Vec<(Vec<u8>, (i64, u128))> {
+			Vec::new()
+		}
+
+		fn get_history(_key: Vec<u8>, _from: u128, _to: u128) -> Vec<(i64, u128)> {
+			Vec::new()
+		}
+	}
+
 	impl cumulus_primitives_core::CollectCollationInfo<Block> for Runtime {
 		fn collect_collation_info(header: &<Block as BlockT>::Header) -> cumulus_primitives_core::CollationInfo {
 			ParachainSystem::collect_collation_info(header)
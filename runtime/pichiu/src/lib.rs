@@ -39,7 +39,7 @@ pub use frame_support::{
     dispatch::DispatchClass,
     ensure, match_types, parameter_types,
     traits::{
-        ConstU128, ConstU32, ConstU64, Contains, EitherOfDiverse, EqualPrivilegeOnly, Everything,
+        ConstBool, ConstU128, ConstU32, ConstU64, Contains, EitherOfDiverse, EqualPrivilegeOnly, Everything,
         IsInVec, Nothing, Randomness,
     },
     weights::{
@@ -72,7 +72,7 @@ use xcm_builder::{
     SignedToAccountId32, SovereignSignedViaLocation, TakeWeightCredit,
 };
 
-use kylin_oracle::DefaultCombineData;
+use kylin_oracle::MedianCombineData;
 
 /// common types for the runtime.
 pub use runtime_common::*;
@@ -225,6 +225,7 @@ parameter_types! {
     pub const EnactmentPeriod: BlockNumber = 60 * MINUTES;
     pub const CooloffPeriod: BlockNumber = 60 * MINUTES;
     pub const MaxProposals: u32 = 100;
+    pub MaxBakingWeight: Weight = Perbill::from_percent(10) * RuntimeBlockWeights::get().max_block;
 }
 
 impl kylin_democracy::Config for Runtime {
@@ -276,6 +277,7 @@ impl kylin_democracy::Config for Runtime {
     type MaxVotes = frame_support::traits::ConstU32<100>;
     type WeightInfo = kylin_democracy::weights::SubstrateWeight<Runtime>;
     type MaxProposals = MaxProposals;
+    type MaxBakingWeight = MaxBakingWeight;
 }
 
 parameter_types! {
@@ -294,6 +296,8 @@ impl kylin_distribution::Config for Runtime {
     type Time = Timestamp;
     type PalletId = DistributionPalletId;
     type Stake = DistributionStake;
+    type DeletionChunkSize = ConstU32<128>;
+    type MaxProofLen = ConstU32<32>;
     type WeightInfo = kylin_distribution::weights::SubstrateWeight<Runtime>;
 }
 
@@ -662,10 +666,19 @@ impl kylin_oracle::Config for Runtime {
     type EstimateCallFee = TransactionPayment;
     type Currency = Balances;
 
-    type CombineData = DefaultCombineData<Self, ConstU32<1>, ConstU128<600>>;
+    type CombineData = MedianCombineData<Self, ConstU32<1>, ConstU128<600>>;
     type Members = OracleProvider;
     type StrLimit = ConstU32<512>;
-    type MaxHasDispatchedSize = ConstU32<100>;
+    type MaxResponseSize = ConstU32<{ 1024 * 1024 }>;
+    type MaxFeedersPerKey = ConstU32<100>;
+    type MaxQueryKeys = ConstU32<64>;
+    type MaxFeedValues = ConstU32<100>;
+    type MaxSubscribersPerKey = ConstU32<32>;
+    type MaxSubscriptionsPerPara = ConstU32<64>;
+    type MaxHistoryLen = ConstU32<256>;
+    type SingleFeeder = ConstBool<true>;
+    type MaxHotKeys = ConstU32<32>;
+    type HotKeysOrigin = EnsureRootOrHalfCouncil;
 }
 
 parameter_types! {
@@ -1225,6 +1238,9 @@ impl kylin_feed_api::Config for Runtime {
     type CollectionSymbolLimit = CollectionSymbolLimit;
     type MaxResourcesOnMint = MaxResourcesOnMint;
     type XcmSender = XcmRouter;
+    type DeletionChunkSize = ConstU32<128>;
+    type MaxDescendants = ConstU32<100>;
+    type WeightInfo = kylin_feed_api::weights::SubstrateWeight<Runtime>;
 }
 
 construct_runtime! {
@@ -1429,6 +1445,62 @@ impl_runtime_apis! {
         }
     }
 
+    impl kylin_oracle_runtime_api::KylinOracleApi<Block> for Runtime {
+        fn get(key: Vec<u8>) -> Option<(i64, u128)> {
+            let key = key.try_into().ok()?;
+            KylinOraclePallet::get(&key).map(|v| (v.value, v.timestamp))
+        }
+
+        fn get_many(keys: Vec<Vec<u8>>) -> Vec<Option<(i64, u128)>> {
+            keys.into_iter()
+                .map(|key| {
+                    let key = key.try_into().ok()?;
+                    KylinOraclePallet::get(&key).map(|v| (v.value, v.timestamp))
+                })
+                .collect()
+        }
+
+        fn get_all_values() -> Vec<(Vec<u8>, (i64, u128))> {
+            KylinOraclePallet::get_all_values()
+                .into_iter()
+                .filter_map(|(key, v)| v.map(|v| (key.into_inner(), (v.value, v.timestamp))))
+                .collect()
+        }
+
+        fn get_hot_values() -> Vec<(Vec<u8>, (i64, u128))> {
+            KylinOraclePallet::get_hot_values()
+                .into_iter()
+                .map(|(key, v)| (key.into_inner(), (v.value, v.timestamp)))
+                .collect()
+        }
+
+        fn get_history(key: Vec<u8>, from: u128, to: u128) -> Vec<(i64, u128)> {
+            match key.try_into() {
+                Ok(key) => KylinOraclePallet::history(&key, from, to)
+                    .into_iter()
+                    .map(|v| (v.value, v.timestamp))
+                    .collect(),
+                Err(_) => Vec::new(),
+            }
+        }
+    }
+
+    impl kylin_feed_api_runtime_api::KylinFeedApi<Block, AccountId> for Runtime {
+        fn feed_by_key(
+            collection_id: u32,
+            key: Vec<u8>,
+        ) -> Option<kylin_feed_api_runtime_api::FeedDetails<AccountId>> {
+            KylinFeedApi::feed_by_key(collection_id, key).map(|(collection_id, nft_id, owner, value)| {
+                kylin_feed_api_runtime_api::FeedDetails {
+                    collection_id,
+                    nft_id,
+                    owner,
+                    value: value.map(|v| (v.value, v.timestamp)),
+                }
+            })
+        }
+    }
+
     impl cumulus_primitives_core::CollectCollationInfo<Block> for Runtime {
         fn collect_collation_info(header: &<Block as BlockT>::Header) -> cumulus_primitives_core::CollationInfo {
             ParachainSystem::collect_collation_info(header)
@@ -1459,6 +1531,7 @@ impl_runtime_apis! {
             let params = (&config, &whitelist);
 
             add_benchmark!(params, batches, kylin_oracle, KylinOraclePallet);
+            add_benchmark!(params, batches, kylin_feed_api, KylinFeedApi);
 
             if batches.is_empty() { return Err("Benchmark not found for this pallet.".into()) }
             Ok(batches)
@@ -1474,6 +1547,7 @@ impl_runtime_apis! {
             let mut list = Vec::<BenchmarkList>::new();
 
             list_benchmark!(list, extra, kylin_oracle, KylinOraclePallet);
+            list_benchmark!(list, extra, kylin_feed_api, KylinFeedApi);
 
             let storage_info = AllPalletsWithSystem::storage_info();
 